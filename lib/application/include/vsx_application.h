@@ -98,6 +98,7 @@ public:
        "    -dq                       Print how many displays are available and exit\n"
        "                              [id] is a value between 1 and number of displays\n"
        "    -gl_debug                 Enable OpenGL debug callback\n"
+       "    -hidden                   Hidden window, no vsync\n"
        "\n"
        "    Examples:\n"
        "      -f -s 1920x1080         Fullscreen, Full HD resolution\n"
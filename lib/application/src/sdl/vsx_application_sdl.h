@@ -167,6 +167,10 @@ class vsx_application_sdl
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
 
+    // hidden window: a GL context for offscreen work, no vsync
+    bool hidden = vsx_argvector::get_instance()->has_param("hidden");
+    Uint32 visibility = hidden ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN;
+
     // borderless window, taking up one full desktop
     if (
       vsx_argvector::get_instance()->has_param("d")
@@ -187,7 +191,7 @@ class vsx_application_sdl
         display_bounds[chosen_display].h,
         SDL_WINDOW_OPENGL
         | SDL_WINDOW_ALLOW_HIGHDPI
-        | SDL_WINDOW_SHOWN
+        | visibility
         | SDL_WINDOW_BORDERLESS
       );
     }
@@ -209,7 +213,7 @@ class vsx_application_sdl
         SDL_WINDOW_OPENGL
         | SDL_WINDOW_ALLOW_HIGHDPI
         | SDL_WINDOW_FULLSCREEN_DESKTOP
-        | SDL_WINDOW_SHOWN
+        | visibility
       );
 
     // real fullscreen, custom resolution
@@ -229,7 +233,7 @@ class vsx_application_sdl
         SDL_WINDOW_OPENGL
         | SDL_WINDOW_ALLOW_HIGHDPI
         | SDL_WINDOW_FULLSCREEN
-        | SDL_WINDOW_SHOWN
+        | visibility
       );
 
     // regular window, custom resolution, borderless optional
@@ -245,7 +249,7 @@ class vsx_application_sdl
         SDL_WINDOW_OPENGL
         | SDL_WINDOW_RESIZABLE
         | SDL_WINDOW_ALLOW_HIGHDPI
-        | SDL_WINDOW_SHOWN
+        | visibility
         | SDL_WINDOW_BORDERLESS * (vsx_argvector::get_instance()->has_param("bl") ? 1 : 0)
       );
 
@@ -269,7 +273,7 @@ class vsx_application_sdl
 
 
     /* This makes our buffer swap syncronized with the monitor's vertical refresh */
-    SDL_GL_SetSwapInterval(1);
+    SDL_GL_SetSwapInterval(hidden ? 0 : 1);
 
     glewInit();
 
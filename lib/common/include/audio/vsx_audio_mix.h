@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stddef.h>
+#include <inttypes.h>
+#include <math.h>
+
+/*
+  Block kernels for the audio mixer, working on planar float buffers
+  (one buffer per side).
+
+  SSE2 is part of every x86-64 target and NEON of every aarch64 one, so the
+  implementation is picked at compile time. Pointers need no particular
+  alignment, the tail is done in plain C++.
+*/
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define VSX_AUDIO_MIX_SSE
+  #include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  #define VSX_AUDIO_MIX_NEON
+  #include <arm_neon.h>
+#endif
+
+namespace vsx_audio_mix
+{
+
+// destination[i] += source[i] * (gain + gain_step * i)
+inline void add_ramp(float* destination, const float* source, float gain, float gain_step, size_t count)
+{
+  size_t i = 0;
+
+  #if defined(VSX_AUDIO_MIX_SSE)
+    __m128 g = _mm_add_ps(_mm_set1_ps(gain), _mm_mul_ps(_mm_set1_ps(gain_step), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f)));
+    __m128 g_step = _mm_set1_ps(gain_step * 4.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+      __m128 d = _mm_loadu_ps(destination + i);
+      __m128 s = _mm_loadu_ps(source + i);
+      _mm_storeu_ps(destination + i, _mm_add_ps(d, _mm_mul_ps(s, g)));
+      g = _mm_add_ps(g, g_step);
+    }
+  #elif defined(VSX_AUDIO_MIX_NEON)
+    const float offsets[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    float32x4_t g = vmlaq_n_f32(vdupq_n_f32(gain), vld1q_f32(offsets), gain_step);
+    float32x4_t g_step = vdupq_n_f32(gain_step * 4.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+      vst1q_f32(destination + i, vmlaq_f32(vld1q_f32(destination + i), vld1q_f32(source + i), g));
+      g = vaddq_f32(g, g_step);
+    }
+  #endif
+
+  for (; i < count; i++)
+    destination[i] += source[i] * (gain + gain_step * (float)i);
+}
+
+// clamps to [-1, 1] and writes interleaved 16-bit stereo frames
+inline void to_int16_interleaved(const float* left, const float* right, int16_t* destination, size_t count)
+{
+  size_t i = 0;
+
+  #if defined(VSX_AUDIO_MIX_SSE)
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 minus_one = _mm_set1_ps(-1.0f);
+    __m128 scale = _mm_set1_ps(32767.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+      __m128 l = _mm_mul_ps(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(left + i), one), minus_one), scale);
+      __m128 r = _mm_mul_ps(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(right + i), one), minus_one), scale);
+      // l0 l1 l2 l3 r0 r1 r2 r3 -> l0 r0 l1 r1 l2 r2 l3 r3
+      __m128i lr = _mm_packs_epi32(_mm_cvtps_epi32(l), _mm_cvtps_epi32(r));
+      _mm_storeu_si128((__m128i*)(destination + i * 2), _mm_unpacklo_epi16(lr, _mm_srli_si128(lr, 8)));
+    }
+  #elif defined(VSX_AUDIO_MIX_NEON)
+    float32x4_t one = vdupq_n_f32(1.0f);
+    float32x4_t minus_one = vdupq_n_f32(-1.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+      float32x4_t l = vmulq_n_f32(vmaxq_f32(vminq_f32(vld1q_f32(left + i), one), minus_one), 32767.0f);
+      float32x4_t r = vmulq_n_f32(vmaxq_f32(vminq_f32(vld1q_f32(right + i), one), minus_one), 32767.0f);
+      int16x4x2_t lr;
+      lr.val[0] = vqmovn_s32(vcvtnq_s32_f32(l));
+      lr.val[1] = vqmovn_s32(vcvtnq_s32_f32(r));
+      vst2_s16(destination + i * 2, lr);
+    }
+  #endif
+
+  for (; i < count; i++)
+  {
+    float l = left[i];
+    float r = right[i];
+    l = l > 1.0f ? 1.0f : (l < -1.0f ? -1.0f : l);
+    r = r > 1.0f ? 1.0f : (r < -1.0f ? -1.0f : r);
+    destination[i * 2] = (int16_t)lrintf(l * 32767.0f);
+    destination[i * 2 + 1] = (int16_t)lrintf(r * 32767.0f);
+  }
+}
+
+}
@@ -1,123 +1,110 @@
+#pragma once
+
+#include <string.h>
+#include <container/vsx_ma_vector.h>
 #include <audio/vsx_audio_mixer_channel.h>
 #include <audio/vsx_audio_constants.h>
-#include <math.h>
+#include <audio/vsx_audio_mix.h>
 
 class vsx_audio_mixer
 {
-  vsx_ma_vector<vsx_audio_mixer_channel*> mixing_channels;
-
 public:
 
-  inline int16_t consume_left()
-  {
-    // accumulator
-    float current_value = 0.0f;
-
-    // active channels
-    size_t active_channels = 0;
-
-    for (size_t i = 0; i < mixing_channels.size(); i++)
-    {
-      // ignore deleted samples
-      if (!mixing_channels[i])
-        continue;
-
-      // is this channel playing?
-      if (!mixing_channels[i]->is_active())
-        continue;
-
-      // grab channel value
-      int16_t cval = mixing_channels[i]->consume_left();
-
-      // increase active channels
-      active_channels++;
+  // frames mixed per pass; longer requests are done in several passes
+  static const size_t block_frames = 256;
 
-      // convert cval to float (val)
-      float val = (float)cval * one_div_32768;
+private:
 
-      // apply gain
-      val *= mixing_channels[i]->get_gain();
-
-      // accumulate in current_value
-      current_value += val;
-    }
+  struct mixer_slot
+  {
+    vsx_audio_mixer_channel* channel;
 
-    if (active_channels == 0)
-      return 0;
+    // gain applied at the end of the last block, the next block ramps from
+    // this to the channel's current gain so gain changes don't click
+    float gain;
+    bool active;
+  };
 
-    // safeguard
-    if (current_value > 1.0)
-      current_value = 1.0f;
+  vsx_ma_vector<mixer_slot> mixing_channels;
 
-    if (current_value < -1.0)
-      current_value = -1.0f;
+  // planar scratch buffers, no allocations on the audio thread
+  float channel_left[block_frames];
+  float channel_right[block_frames];
+  float mix_left[block_frames];
+  float mix_right[block_frames];
 
-    return
-      (int16_t) round(current_value * 32767.0);
-  }
-
-  inline int16_t consume_right()
+  void mix(size_t frames)
   {
-
-    // accumulator
-    float current_value = 0.0f;
-
-    // active channels
-    size_t active_channels = 0;
+    memset(mix_left, 0, sizeof(float) * frames);
+    memset(mix_right, 0, sizeof(float) * frames);
 
     for (size_t i = 0; i < mixing_channels.size(); i++)
     {
+      mixer_slot& slot = mixing_channels[i];
+
       // ignore deleted samples
-      if (!mixing_channels[i])
+      if (!slot.channel)
         continue;
 
       // is this channel playing?
-      if (!mixing_channels[i]->is_active())
+      if (!slot.channel->is_active())
+      {
+        slot.active = false;
         continue;
+      }
 
-      // grab channel value
-      int16_t cval = mixing_channels[i]->consume_right();
-
-      // increase active channels
-      active_channels++;
+      slot.channel->consume_block(channel_left, channel_right, frames);
 
-      // convert cval to float (val)
-      float val = (float)cval * one_div_32768;
+      float gain = slot.channel->get_gain();
 
-      // apply gain
-      val *= mixing_channels[i]->get_gain();
+      // a channel starting to play starts at its gain
+      if (!slot.active)
+      {
+        slot.gain = gain;
+        slot.active = true;
+      }
 
-      // accumulate in current_value
-      current_value += val;
+      float gain_step = (gain - slot.gain) / (float)frames;
+      vsx_audio_mix::add_ramp(mix_left, channel_left, slot.gain, gain_step, frames);
+      vsx_audio_mix::add_ramp(mix_right, channel_right, slot.gain, gain_step, frames);
+      slot.gain = gain;
     }
+  }
 
-    if (active_channels == 0)
-      return 0;
-
-    // safeguard
-    if (current_value > 1.0)
-      current_value = 1.0f;
-
-    if (current_value < -1.0)
-      current_value = -1.0f;
+public:
 
-    return
-      (int16_t) round(current_value * 32767.0);
+  // Renders frames interleaved 16-bit stereo frames into output.
+  // Channels are mixed in float and clamped once at the end.
+  void consume_block(int16_t* output, size_t frames)
+  {
+    while (frames)
+    {
+      size_t count = frames < block_frames ? frames : block_frames;
+      mix(count);
+      vsx_audio_mix::to_int16_interleaved(mix_left, mix_right, output, count);
+      output += count * 2;
+      frames -= count;
+    }
   }
 
   void register_channel( vsx_audio_mixer_channel* ns )
   {
+    mixer_slot slot;
+    slot.channel = ns;
+    slot.gain = 0.0f;
+    slot.active = false;
+
     // recycle unused channels
     for (size_t i = 0; i < mixing_channels.size(); i++)
     {
-      if (mixing_channels[i] == 0x0)
+      if (mixing_channels[i].channel == 0x0)
       {
         // recycle this channel
-        mixing_channels[i] = ns;
+        mixing_channels[i] = slot;
         return;
       }
     }
-    mixing_channels.push_back( ns );
+    mixing_channels.push_back( slot );
   }
 
   void unregister_channel( vsx_audio_mixer_channel* us )
@@ -125,10 +112,10 @@ public:
     // set channel pointer to zero
     for (size_t i = 0; i < mixing_channels.size(); i++)
     {
-      if (mixing_channels[i] == us)
+      if (mixing_channels[i].channel == us)
       {
         // disable this channel
-        mixing_channels[i] = 0x0;
+        mixing_channels[i].channel = 0x0;
         return;
       }
     }
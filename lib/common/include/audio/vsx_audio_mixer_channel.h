@@ -5,7 +5,9 @@
 // Register this in the mixer like so:
 // mixer->
 
+#include <stddef.h>
 #include <inttypes.h>
+#include <audio/vsx_audio_constants.h>
 
 class vsx_audio_mixer_channel
 {
@@ -26,6 +28,19 @@ public:
   virtual int16_t consume_left() = 0;
   virtual int16_t consume_right() = 0;
 
+  // called by the mixer, renders frames samples per side in the [-1, 1]
+  // range, without gain. Override to avoid the two virtual calls per frame.
+  virtual void consume_block(float* left, float* right, size_t frames)
+  {
+    for (size_t i = 0; i < frames; i++)
+    {
+      left[i] = (float)consume_left() * one_div_32768;
+      right[i] = (float)consume_right() * one_div_32768;
+    }
+  }
+
+  virtual ~vsx_audio_mixer_channel()
+  {}
 };
 
 #endif
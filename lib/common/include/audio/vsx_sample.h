@@ -220,6 +220,74 @@ public:
       (int16_t) ( res * 32767.0f );
   }
 
+  // consume_left and consume_right for a whole block, reading the data
+  // directly instead of through the (growing) vector operator
+  virtual void consume_block(float* left, float* right, size_t frames)
+  {
+    size_t data_size = data.size();
+    if (!data_size)
+    {
+      for (size_t i = 0; i < frames; i++)
+        left[i] = right[i] = 0.0f;
+      return;
+    }
+
+    const int16_t* d = data.get_pointer();
+    const double stride = (double)stereo_type;
+    const double position_max = (double)data_size - (2.0 + DRIFT * stride);
+    const double read_ahead = DRIFT * stride * (double)state;
+    const float scale = ONE_DIV_32767;
+
+    for (size_t i = 0; i < frames; i++)
+    {
+      if (state == VSX_SAMPLE_STATE_STOPPED)
+      {
+        float value = 0.0f;
+        if (play_bit > -1.0f)
+        {
+          play_bit -= 1.0f;
+          size_t index = (size_t)round(position + (PB_LENGTH - play_bit) * stride);
+          if (index < data_size)
+            value = (float)d[index] * scale;
+        }
+        left[i] = value;
+        right[i] = stereo_type == VSX_SAMPLE_MONO ? value : 0.0f;
+        continue;
+      }
+
+      position += pitch_bend * stride;
+
+      if (position < 0.0)
+      {
+        position = 0.0;
+        left[i] = right[i] = 0.0f;
+        continue;
+      }
+
+      if (position > position_max)
+      {
+        position = position_max;
+        left[i] = right[i] = 0.0f;
+        continue;
+      }
+
+      double i_pos = position + read_ahead;
+      if (i_pos < 0.0)
+        i_pos = 0.0;
+
+      size_t index_start = (size_t)floor(i_pos);
+      size_t index_end = (size_t)ceil(i_pos);
+      float factor = (float)(i_pos - (double)index_start);
+
+      left[i] = (factor * d[index_end] + (1.0f - factor) * d[index_start]) * scale;
+
+      if (stereo_type == VSX_SAMPLE_MONO)
+        right[i] = left[i];
+      else
+        right[i] = (factor * d[index_end + 1] + (1.0f - factor) * d[index_start + 1]) * scale;
+    }
+  }
+
 
   virtual void load_filename(vsx_string<>filename) = 0;
 
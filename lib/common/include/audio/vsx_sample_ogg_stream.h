@@ -0,0 +1,98 @@
+#ifndef VSX_SAMPLE_OGG_STREAM_H
+#define VSX_SAMPLE_OGG_STREAM_H
+
+#include <filesystem/vsx_filesystem.h>
+#include <audio/vsx_sample_stream.h>
+
+// stb_vorbis is built into each sound plugin (ogg_vorbis.c, included by its
+// vsx_sample_ogg.h), include that first
+#ifndef STB_VORBIS_INCLUDE_STB_VORBIS_H
+#error "vsx_sample_ogg_stream.h needs stb_vorbis, include vsx_sample_ogg.h before it"
+#endif
+
+// stb_vorbis over the compressed file, which it needs to keep in memory
+class vsx_sample_ogg_stream_decoder : public vsx_sample_stream_decoder
+{
+  vsx_ma_vector<unsigned char> compressed;
+  stb_vorbis* vorbis = 0x0;
+  uint64_t length = 0;
+
+public:
+
+  bool open(vsx::filesystem* filesystem, const vsx_string<>& filename)
+  {
+    vsx::file *fp = filesystem->f_open(filename.c_str());
+    reqrv(fp, false);
+
+    size_t file_size = filesystem->f_get_size(fp);
+    if (file_size)
+    {
+      compressed.allocate(file_size - 1);
+      filesystem->f_read( compressed.get_pointer(), file_size, fp);
+    }
+    filesystem->f_close(fp);
+    reqrv(file_size, false);
+
+    int error;
+    vorbis = stb_vorbis_open_memory(compressed.get_pointer(), (int)compressed.size(), &error, 0x0);
+    reqrv(vorbis, false);
+    length = stb_vorbis_stream_length_in_samples(vorbis);
+    return true;
+  }
+
+  uint64_t get_length()
+  {
+    return length;
+  }
+
+  bool seek(uint64_t frame)
+  {
+    reqrv(frame < length, false);
+    if (!frame)
+    {
+      stb_vorbis_seek_start(vorbis);
+      return true;
+    }
+    return stb_vorbis_seek(vorbis, (unsigned int)frame) != 0;
+  }
+
+  // mono files come out on both channels
+  size_t decode(int16_t* buffer, size_t frames)
+  {
+    return (size_t)stb_vorbis_get_samples_short_interleaved(vorbis, 2, buffer, (int)frames * 2);
+  }
+
+  ~vsx_sample_ogg_stream_decoder()
+  {
+    if (vorbis)
+      stb_vorbis_close(vorbis);
+  }
+};
+
+
+class vsx_sample_ogg_stream : public vsx_sample_stream
+{
+  vsx::filesystem* filesystem = 0x0;
+
+public:
+
+  void set_filesystem(vsx::filesystem* n)
+  {
+    filesystem = n;
+  }
+
+  void load_filename(vsx_string<>filename)
+  {
+    req(filesystem);
+
+    vsx_sample_ogg_stream_decoder* decoder = new vsx_sample_ogg_stream_decoder;
+    if (!decoder->open(filesystem, filename))
+    {
+      delete decoder;
+      return;
+    }
+    load(decoder);
+  }
+};
+
+#endif // VSX_SAMPLE_OGG_STREAM_H
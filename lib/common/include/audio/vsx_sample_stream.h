@@ -0,0 +1,455 @@
+#ifndef VSX_SAMPLE_STREAM_H
+#define VSX_SAMPLE_STREAM_H
+
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <thread>
+#include <container/vsx_nw_vector.h>
+#include <container/vsx_ma_vector.h>
+#include <string/vsx_string.h>
+#include <tools/vsx_fifo_mt.h>
+#include <tools/vsx_align.h>
+#include <tools/vsx_semaphore.h>
+#include <audio/vsx_sample.h>
+
+/*
+  Sample player for long, compressed files, decoded while playing.
+
+  A worker thread decodes ahead of the playing position into a lock free
+  ring of chunks (VSX_SAMPLE_STREAM_CHUNKS, about 1.5 seconds at 44.1 kHz),
+  the mixer only copies out of the chunks and never waits for the decoder.
+  When the ring is full the worker sleeps until the mixer has taken a chunk
+  or a new position is requested. The last chunk of the ring is kept for the
+  first chunk of a new position, so a seek doesn't wait for the mixer to drop
+  the old ones.
+
+  Seeking (goto_time, rewind) posts a new position with a new serial. The
+  audio thread moves to it at the start of its next block and drops chunks
+  of older serials, the worker seeks the decoder and decodes from there.
+  Until the first chunks arrive the channel plays silence.
+
+  The first VSX_SAMPLE_STREAM_PREROLL_CHUNKS of the file are decoded when
+  loading and kept, so starting from the beginning (and seeking back to it)
+  needs no decoding at all.
+
+  Frames are always stereo, 44.1 kHz 16-bit, as vsx_sample.
+*/
+
+#define VSX_SAMPLE_STREAM_CHUNK_FRAMES 2048
+#define VSX_SAMPLE_STREAM_CHUNKS 32
+#define VSX_SAMPLE_STREAM_PREROLL_CHUNKS 4
+
+// seek requests: serial in the top 16 bits, frame below
+#define VSX_SAMPLE_STREAM_SERIAL_SHIFT 48
+#define VSX_SAMPLE_STREAM_FRAME_MASK ((1ULL << VSX_SAMPLE_STREAM_SERIAL_SHIFT) - 1)
+
+// the source of a stream, used from the worker thread only (after load)
+class vsx_sample_stream_decoder
+{
+public:
+  // length in frames
+  virtual uint64_t get_length() = 0;
+
+  // next decode starts at frame
+  virtual bool seek(uint64_t frame) = 0;
+
+  // decodes interleaved stereo frames, all of them unless the file ends
+  // first; returns how many, 0 at the end
+  virtual size_t decode(int16_t* buffer, size_t frames) = 0;
+
+  virtual ~vsx_sample_stream_decoder()
+  {}
+};
+
+struct vsx_sample_stream_chunk
+{
+  uint64_t start;
+  uint32_t frames;
+  uint32_t serial;
+  int16_t data[VSX_SAMPLE_STREAM_CHUNK_FRAMES * 2];
+};
+
+class vsx_sample_stream : public vsx_audio_mixer_channel
+{
+  // decoded chunks, worker to audio thread; the fifo is 64 byte aligned,
+  // held out of line so the stream can be a member of anything
+  class chunk_fifo
+      : public vsx_fifo_mt<vsx_sample_stream_chunk, VSX_SAMPLE_STREAM_CHUNKS>,
+        public vsx::aligned_new_delete<512>
+  {};
+  chunk_fifo* ahead;
+
+  // the start of the file, decoded on load
+  vsx_nw_vector<vsx_sample_stream_chunk*> preroll;
+  uint64_t preroll_end = 0;
+
+  vsx_sample_stream_decoder* decoder = 0x0;
+
+  // shared
+  std::atomic<uint64_t> seek_request;
+  std::atomic<uint64_t> played_frame;
+  std::atomic<uint32_t> played_serial;
+  std::atomic<int> state;
+  std::atomic<int> stereo_type;
+  std::atomic<int> preview;
+  std::atomic<bool> previewed;
+  std::atomic<float> gain_value;
+
+  // render thread
+  uint32_t request_serial = 0;
+
+  // audio thread
+  vsx_sample_stream_chunk current;
+  bool current_valid = false;
+  uint32_t serial = 0;
+  uint64_t frame = 0;
+  int16_t right_value = 0;
+  bool chunk_consumed = false;
+
+  // worker
+  std::atomic<bool> running;
+  std::thread worker;
+  vsx_semaphore wake;
+
+  inline void request(uint64_t target)
+  {
+    request_serial = (request_serial + 1) & 0xffff;
+    seek_request = ((uint64_t)request_serial << VSX_SAMPLE_STREAM_SERIAL_SHIFT) | (target & VSX_SAMPLE_STREAM_FRAME_MASK);
+    wake.post();
+  }
+
+  // audio thread: the frame at the playing position, 0x0 if not decoded yet
+  inline const int16_t* get_frame()
+  {
+    while (!current_valid || frame >= current.start + current.frames)
+    {
+      if (!ahead->consume(current))
+      {
+        current_valid = false;
+        return 0x0;
+      }
+      chunk_consumed = true;
+      current_valid = current.serial == serial;
+    }
+
+    if (frame < current.start)
+      return 0x0;
+
+    return &current.data[ (frame - current.start) * 2 ];
+  }
+
+  void run()
+  {
+    // no request has this serial
+    uint32_t worker_serial = 0x10000;
+    uint64_t next = 0;
+    bool decoder_positioned = false;
+    bool ended = false;
+    bool new_position = false;
+    vsx_sample_stream_chunk* chunk = new vsx_sample_stream_chunk;
+
+    while (running)
+    {
+      uint64_t seek = seek_request;
+      uint32_t seek_serial = (uint32_t)(seek >> VSX_SAMPLE_STREAM_SERIAL_SHIFT);
+      if (seek_serial != worker_serial)
+      {
+        worker_serial = seek_serial;
+        next = seek & VSX_SAMPLE_STREAM_FRAME_MASK;
+        decoder_positioned = false;
+        ended = false;
+        new_position = true;
+      }
+
+      // far enough ahead (a chunk is 46 ms of audio), or waiting for a seek
+      uint64_t room = VSX_SAMPLE_STREAM_CHUNKS - ahead->live_count_get();
+      if (ended || !room || (room == 1 && !new_position))
+      {
+        wake.wait();
+        continue;
+      }
+
+      if (next < preroll_end)
+      {
+        *chunk = *preroll[ next / VSX_SAMPLE_STREAM_CHUNK_FRAMES ];
+        chunk->serial = worker_serial;
+        next = chunk->start + chunk->frames;
+        decoder_positioned = false;
+        new_position = false;
+        ahead->produce(*chunk);
+        continue;
+      }
+
+      if (!decoder_positioned)
+      {
+        decoder_positioned = true;
+        ended = !decoder->seek(next);
+        if (ended)
+          continue;
+      }
+
+      chunk->frames = (uint32_t)decoder->decode(chunk->data, VSX_SAMPLE_STREAM_CHUNK_FRAMES);
+      if (!chunk->frames)
+      {
+        ended = true;
+        continue;
+      }
+      chunk->start = next;
+      chunk->serial = worker_serial;
+      next += chunk->frames;
+      new_position = false;
+      ahead->produce(*chunk);
+    }
+
+    delete chunk;
+  }
+
+  void stop_worker()
+  {
+    if (!worker.joinable())
+      return;
+    running = false;
+    wake.post();
+    worker.join();
+  }
+
+  void clear_preroll()
+  {
+    foreach (preroll, i)
+      delete preroll[i];
+    preroll.reset_used(0);
+    preroll_end = 0;
+  }
+
+public:
+
+  vsx_sample_stream()
+    :
+    ahead(new chunk_fifo)
+  {
+    seek_request = 0;
+    played_frame = 0;
+    played_serial = 0;
+    state = VSX_SAMPLE_STATE_STOPPED;
+    stereo_type = VSX_SAMPLE_STEREO;
+    preview = 0;
+    previewed = false;
+    gain_value = 1.0f;
+    running = false;
+    current.start = 0;
+    current.frames = 0;
+    current.serial = 0;
+  }
+
+  ~vsx_sample_stream()
+  {
+    stop_worker();
+    clear_preroll();
+    if (decoder)
+      delete decoder;
+    delete ahead;
+  }
+
+  // render thread: takes over the decoder, decodes the preroll and starts
+  // decoding ahead from the current position
+  void load(vsx_sample_stream_decoder* new_decoder)
+  {
+    stop_worker();
+    clear_preroll();
+    if (decoder)
+      delete decoder;
+    decoder = new_decoder;
+    req(decoder);
+
+    decoder->seek(0);
+    for (size_t i = 0; i < VSX_SAMPLE_STREAM_PREROLL_CHUNKS; i++)
+    {
+      vsx_sample_stream_chunk* chunk = new vsx_sample_stream_chunk;
+      chunk->start = preroll_end;
+      chunk->frames = (uint32_t)decoder->decode(chunk->data, VSX_SAMPLE_STREAM_CHUNK_FRAMES);
+      if (!chunk->frames)
+      {
+        delete chunk;
+        break;
+      }
+      preroll_end += chunk->frames;
+      preroll.push_back(chunk);
+
+      // only the last chunk may be short, the worker indexes them by frame
+      if (chunk->frames < VSX_SAMPLE_STREAM_CHUNK_FRAMES)
+        break;
+    }
+
+    // drop whatever was decoded from the previous file
+    request( (uint64_t)(get_time() * 44100.0f + DRIFT) );
+
+    running = true;
+    worker = std::thread([this](){ run(); });
+  }
+
+  uint64_t get_length()
+  {
+    reqrv(decoder, 0);
+    return decoder->get_length();
+  }
+
+  inline float get_gain()
+  {
+    return gain_value;
+  }
+
+  inline void set_gain(float n)
+  {
+    gain_value = n;
+  }
+
+  // mixed while playing, previewing or moving to a new position
+  int is_active()
+  {
+    if (state == VSX_SAMPLE_STATE_PLAYING || preview > 0)
+      return 1;
+    return played_serial != (uint32_t)(seek_request >> VSX_SAMPLE_STREAM_SERIAL_SHIFT);
+  }
+
+  inline int get_state()
+  {
+    return state;
+  }
+
+  inline void play()
+  {
+    // a preview has taken the audio thread past the position
+    if (state == VSX_SAMPLE_STATE_STOPPED && previewed)
+    {
+      previewed = false;
+      goto_time( get_time() );
+    }
+    state = VSX_SAMPLE_STATE_PLAYING;
+  }
+
+  inline void stop()
+  {
+    state = VSX_SAMPLE_STATE_STOPPED;
+  }
+
+  inline void rewind()
+  {
+    state = VSX_SAMPLE_STATE_STOPPED;
+    request( (uint64_t)DRIFT );
+  }
+
+  // as vsx_sample, a short preview is played when moving while stopped
+  inline void goto_time(float t)
+  {
+    if (t < 0.0f)
+      t = 0.0f;
+    request( (uint64_t)(t * 44100.0f) + (uint64_t)DRIFT );
+
+    if (state == VSX_SAMPLE_STATE_STOPPED && preview <= 0)
+    {
+      preview = (int)PB_LENGTH;
+      previewed = true;
+    }
+  }
+
+  // the requested position until the audio thread has moved there
+  inline float get_time()
+  {
+    uint64_t seek = seek_request;
+    uint64_t position =
+      played_serial == (uint32_t)(seek >> VSX_SAMPLE_STREAM_SERIAL_SHIFT)
+      ?
+        played_frame.load()
+      :
+        seek & VSX_SAMPLE_STREAM_FRAME_MASK;
+
+    if (position < (uint64_t)DRIFT)
+      return 0.0f;
+    return (float)(position - (uint64_t)DRIFT) / 44100.0f;
+  }
+
+  // mono plays the left channel on both sides
+  inline void set_stereo_type(int n)
+  {
+    stereo_type = n;
+  }
+
+  int16_t consume_left()
+  {
+    float left, right;
+    consume_block(&left, &right, 1);
+    right_value = (int16_t)(right * 32767.0f);
+    return (int16_t)(left * 32767.0f);
+  }
+
+  int16_t consume_right()
+  {
+    return right_value;
+  }
+
+  void consume_block(float* left, float* right, size_t frames)
+  {
+    uint64_t seek = seek_request;
+    uint32_t seek_serial = (uint32_t)(seek >> VSX_SAMPLE_STREAM_SERIAL_SHIFT);
+    if (seek_serial != serial)
+    {
+      serial = seek_serial;
+      frame = seek & VSX_SAMPLE_STREAM_FRAME_MASK;
+      played_frame = frame;
+
+      // make room for the worker, which is likely to have started on the new position already
+      current_valid = false;
+      while (!current_valid && ahead->consume(current))
+      {
+        chunk_consumed = true;
+        current_valid = current.serial == serial;
+      }
+    }
+
+    const bool playing = state == VSX_SAMPLE_STATE_PLAYING;
+    const bool mono = stereo_type == VSX_SAMPLE_MONO;
+    const float scale = ONE_DIV_32767;
+    int preview_start = preview;
+    int preview_left = preview_start;
+
+    for (size_t i = 0; i < frames; i++)
+    {
+      if (!playing)
+      {
+        if (preview_left <= 0)
+        {
+          left[i] = right[i] = 0.0f;
+          continue;
+        }
+        preview_left--;
+      }
+
+      const int16_t* d = get_frame();
+      frame++;
+      if (!d)
+      {
+        left[i] = right[i] = 0.0f;
+        continue;
+      }
+      left[i] = (float)d[0] * scale;
+      right[i] = mono ? left[i] : (float)d[1] * scale;
+    }
+
+    // unless goto_time has started a new preview meanwhile
+    if (!playing)
+      preview.compare_exchange_strong(preview_start, preview_left);
+    else
+      played_frame = frame;
+    played_serial = serial;
+
+    // once per block, the worker only needs to know there is room again
+    if (chunk_consumed)
+    {
+      chunk_consumed = false;
+      wake.post();
+    }
+  }
+};
+
+#endif
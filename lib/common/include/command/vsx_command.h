@@ -65,6 +65,13 @@ COMMON_DLLIMPORT extern std::vector<vsx_command_s*> vsx_command_garbage_list; //
 COMMON_DLLIMPORT void vsx_command_process_garbage();
 COMMON_DLLIMPORT void vsx_command_process_garbage_exit();
 
+// Command ids. Names registered by whoever handles the commands (the engine)
+// get a small, dense id; commands look theirs up once when parsed so the
+// handler can dispatch through a table. 0 = not registered.
+// Thread safety: YES
+COMMON_DLLIMPORT uint32_t vsx_command_id_register(const vsx_string<>& name);
+COMMON_DLLIMPORT uint32_t vsx_command_id_find(const vsx_string<>& name);
+
 
 COMMON_DLLIMPORT class vsx_command_s
 {
@@ -90,6 +97,9 @@ public:
   // primary part of the command
   vsx_string<> cmd;
 
+  // id of cmd, see vsx_command_id_find
+  uint32_t cmd_id = 0;
+
   // parameter (for simple commands)
   vsx_string<> cmd_data;
 
@@ -116,6 +126,7 @@ public:
     type = t->type;
     title = t->title;
     cmd = t->cmd;
+    cmd_id = t->cmd_id;
     cmd_data = t->cmd_data;
     raw = t->raw;
     parts = t->parts;
@@ -165,6 +176,7 @@ T* vsx_command_parse(vsx_string<>& cmd_raw, bool garbage_collect = false)
   vsx_string<> deli = " ";
   vsx_string_helper::explode(cmd_raw, deli, command_parts);
   t->cmd = command_parts[0];
+  t->cmd_id = vsx_command_id_find(t->cmd);
   if (command_parts.size() > 1)
     t->cmd_data = command_parts[1];
 
@@ -173,6 +185,30 @@ T* vsx_command_parse(vsx_string<>& cmd_raw, bool garbage_collect = false)
   return t;
 }
 
+// command already split into parts, i.e. from the binary protocol
+template<class T>
+T* vsx_command_from_parts(vsx_nw_vector< vsx_string<> >& command_parts, bool garbage_collect = false)
+{
+  T* t = new T;
+  if (garbage_collect)
+    t->gc();
+
+  foreach (command_parts, i)
+  {
+    if (i)
+      t->raw.push_back(' ');
+    t->raw += command_parts[i];
+  }
+  t->cmd = command_parts[0];
+  t->cmd_id = vsx_command_id_find(t->cmd);
+  if (command_parts.size() > 1)
+    t->cmd_data = command_parts[1];
+
+  t->parts = command_parts;
+  t->parsed = true;
+  return t;
+}
+
 
 
 #endif
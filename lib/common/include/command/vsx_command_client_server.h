@@ -40,6 +40,7 @@
 #include <string/vsx_string.h>
 #include "vsx_command.h"
 #include "vsx_command_list.h"
+#include "vsx_command_protocol.h"
 
 #define VSX_COMMAND_CLIENT_NEVER_CONNECTED 0
 #define VSX_COMMAND_CLIENT_CONNECTED 1
@@ -47,13 +48,40 @@
 
 class vsx_command_list_server
 {
+  class connection
+  {
+  public:
+    int sock = -1;
+    vsx_command_protocol_reader reader;
+
+    // not yet accepted by the socket
+    vsx_ma_vector<char> outgoing;
+    size_t outgoing_sent = 0;
+  };
+
   std::thread worker_thread;
   vsx_command_list* cmd_in;
   vsx_command_list* cmd_out;
 
+  vsx_nw_vector<connection*> connections;
+
+  // epoll instance on linux, other platforms poll() the connections
+  int epoll_fd = -1;
+
+  // written to when cmd_out gets commands, so the worker can block
+  int wakeup_pipe[2] = {-1, -1};
+
   // internal worker method
   void server_worker();
 
+  connection* connection_get(int sock);
+  void connection_accept(int listen_sock);
+  // false when the connection is to be closed
+  bool connection_read(connection* c);
+  bool connection_send(connection* c, const char* data, size_t size);
+  bool connection_flush(connection* c);
+  void connection_close(connection* c);
+
 public:
   vsx_command_list_server();
   // set the command lists on which the server class operates
@@ -71,10 +99,16 @@ class vsx_command_list_client
 
   // internal server address
   vsx_string<>server_address;
-  
+
+  // written to when cmd_out gets commands, so the worker can block
+  int wakeup_pipe[2] = {-1, -1};
+
   // internal worker method
   void client_worker();
   int connected;
+
+  // send commands batched in binary frames
+  bool binary = false;
 public:
   vsx_command_list_client();
   // set the command lists on which the server class operates
@@ -86,6 +120,12 @@ public:
 
   // get connection status
   int get_connection_status();
+
+  // use the binary protocol for outgoing commands, set before connecting
+  void set_binary(bool value)
+  {
+    binary = value;
+  }
 };
 
 #endif
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <map>
 #include <list>
 #include <vector>
+#include <functional>
 #include <container/vsx_ma_vector.h>
 
 #include "vsx_command.h"
@@ -30,6 +31,15 @@ class vsx_command_buffer_broker
 
   vsx::filesystem* filesystem = 0x0;
 
+  // called after every add, from the adding thread
+  std::function<void()> add_notify;
+
+  inline void notify()
+  {
+    if (add_notify)
+      add_notify();
+  }
+
   int accept_commands = 1;  // 1 accepts, 0 won't accept
   vsx_nw_vector <T*> commands; // results of commands
   size_t commands_iterator = 0;
@@ -47,6 +57,12 @@ public:
     accept_commands = new_value;
   }
 
+  // i.e. to wake up a thread waiting for commands, set before sharing the list
+  void set_add_notify(std::function<void()> new_notify)
+  {
+    add_notify = new_notify;
+  }
+
   // add copy of command at the end of the list
   T* addc(T* cmd, bool garbage_collect = false)
   {
@@ -63,6 +79,7 @@ public:
     get_lock();
       commands.push_back(t);
     release_lock();
+    notify();
     return t;
   }
 
@@ -102,6 +119,28 @@ public:
 
 
 
+  // add a command already split into parts to the end of the list
+  T* add_parts(vsx_nw_vector< vsx_string<> >& parts, bool garbage_collect = false)
+  {
+    if (!accept_commands)
+      return 0;
+
+    if (!parts.size())
+      return 0;
+
+    return
+      add
+      (
+        vsx_command_from_parts<T>
+        (
+          parts, garbage_collect
+        )
+      )
+    ;
+  }
+
+
+
   // add & parse a command to the beginning of the list
   T* add_raw_front(vsx_string<>r)
   {
@@ -133,6 +172,7 @@ public:
     get_lock();
       commands.push_back(cmd);
     release_lock();
+    notify();
 
     return cmd;
   }
@@ -151,6 +191,7 @@ public:
     get_lock();
       commands.push_front(cmd);
     release_lock();
+    notify();
 
     return cmd;
   }
@@ -165,11 +206,13 @@ public:
 
     T* t = new T;
     t->cmd = cmd;
+    t->cmd_id = vsx_command_id_find(cmd);
     t->cmd_data = cmd_data;
     t->parts.push_back(cmd);
     t->parts.push_back(cmd_data);
     t->raw = cmd+" "+cmd_data;
     commands.push_back(t);
+    notify();
   }
 
 
@@ -181,6 +224,7 @@ public:
 
     T* t = new T;
     t->cmd = cmd;
+    t->cmd_id = vsx_command_id_find(cmd);
     t->cmd_data = vsx_string_helper::i2s(cmd_data);
 
     if (garbage_collect)
@@ -189,6 +233,7 @@ public:
     get_lock();
       commands.push_back(t);
     release_lock();
+    notify();
   }
 
 
@@ -200,6 +245,7 @@ public:
     t->type = tp;
     t->title = std::move(title);
     t->cmd = cmd;
+    t->cmd_id = vsx_command_id_find(cmd);
     t->cmd_data = std::move(cmd_data);
 
     t->parts.move_back(std::move(cmd));
@@ -213,6 +259,7 @@ public:
     t->raw = t->cmd+" "+t->cmd_data;
 
     commands.push_back(t);
+    notify();
   }
 
   void add_action(int type, vsx_string<> title, std::function<void()> action)
@@ -223,6 +270,7 @@ public:
     t->title = std::move(title);
     t->action = action;
     commands.push_back(t);
+    notify();
   }
 
   void clear_normal()
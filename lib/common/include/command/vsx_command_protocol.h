@@ -0,0 +1,320 @@
+/**
+* Project: VSXu Engine: Realtime modular visual programming engine.
+*
+* This file is part of Vovoid VSXu Engine.
+*
+* @author Jonatan Wallmander, Robert Wenzel, Vovoid Media Technologies AB Copyright (C) 2003-2013
+* @see The GNU Lesser General Public License (LGPL)
+*
+* VSXu Engine is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#pragma once
+
+#include <string.h>
+#include <stdint.h>
+#include <container/vsx_nw_vector.h>
+#include <container/vsx_ma_vector.h>
+#include <string/vsx_string.h>
+#include <tools/vsx_req.h>
+
+/*
+  Wire format of the command server.
+
+  Text mode is one command per line, parts separated by spaces:
+
+    param_set my_comp my_param 1.0,2.0,3.0\n
+
+  Binary mode batches many commands in one length-prefixed frame, with every
+  command already split into parts so the receiver never has to tokenize:
+
+    frame:   u8 VSX_COMMAND_PROTOCOL_FRAME_START, u32 payload size, payload
+    payload: command, command, ...
+    command: u32 part count, part, part, ...
+    part:    u32 size, bytes
+
+  All integers are little endian. A frame can only start where a line could
+  start, so both modes can be mixed on the same connection.
+
+  A payload is at most VSX_COMMAND_PROTOCOL_FRAME_MAX_SIZE bytes. The writer
+  splits bigger batches into several frames and sends a command too big for
+  any frame as a text line.
+*/
+
+#define VSX_COMMAND_PROTOCOL_FRAME_START 0x02
+#define VSX_COMMAND_PROTOCOL_FRAME_HEADER_SIZE 5
+#define VSX_COMMAND_PROTOCOL_FRAME_MAX_SIZE (16 * 1024 * 1024)
+
+class vsx_command_protocol_writer
+{
+  // finished frames and text lines, then the frame being filled
+  vsx_ma_vector<unsigned char> data;
+  size_t frame_offset = 0;
+  bool frame_open = false;
+
+  inline void write_u32(size_t value)
+  {
+    data.push_back( (unsigned char)(value & 0xff) );
+    data.push_back( (unsigned char)((value >> 8) & 0xff) );
+    data.push_back( (unsigned char)((value >> 16) & 0xff) );
+    data.push_back( (unsigned char)((value >> 24) & 0xff) );
+  }
+
+  inline void write_bytes(const char* bytes, size_t size)
+  {
+    if (!size)
+      return;
+    size_t offset = data.size();
+    data.allocate(offset + size - 1);
+    memcpy(data.get_pointer() + offset, bytes, size);
+  }
+
+  void frame_end()
+  {
+    req(frame_open);
+    frame_open = false;
+    size_t payload_size = data.size() - frame_offset - VSX_COMMAND_PROTOCOL_FRAME_HEADER_SIZE;
+    unsigned char* h = data.get_pointer() + frame_offset;
+    h[0] = VSX_COMMAND_PROTOCOL_FRAME_START;
+    h[1] = (unsigned char)(payload_size & 0xff);
+    h[2] = (unsigned char)((payload_size >> 8) & 0xff);
+    h[3] = (unsigned char)((payload_size >> 16) & 0xff);
+    h[4] = (unsigned char)((payload_size >> 24) & 0xff);
+  }
+
+  // room for a command of this many bytes, in a new frame if the current one is full
+  bool frame_reserve(size_t size)
+  {
+    if (size > VSX_COMMAND_PROTOCOL_FRAME_MAX_SIZE)
+      return false;
+
+    if (frame_open && data.size() - frame_offset - VSX_COMMAND_PROTOCOL_FRAME_HEADER_SIZE + size > VSX_COMMAND_PROTOCOL_FRAME_MAX_SIZE)
+      frame_end();
+
+    if (!frame_open)
+    {
+      frame_open = true;
+      frame_offset = data.size();
+      for (size_t i = 0; i < VSX_COMMAND_PROTOCOL_FRAME_HEADER_SIZE; i++)
+        data.push_back(0);
+    }
+    return true;
+  }
+
+public:
+
+  void clear()
+  {
+    data.reset_used(0);
+    frame_open = false;
+  }
+
+  bool has_commands()
+  {
+    return data.size() > 0;
+  }
+
+  void add(vsx_nw_vector< vsx_string<> >& parts)
+  {
+    size_t command_size = 4;
+    foreach (parts, i)
+      command_size += 4 + parts[i].size();
+
+    if (!frame_reserve(command_size))
+    {
+      // too big for a frame, send it as text
+      if (frame_open)
+        frame_end();
+      foreach (parts, i)
+      {
+        if (i)
+          data.push_back(' ');
+        write_bytes( parts[i].get_pointer(), parts[i].size() );
+      }
+      data.push_back('\n');
+      return;
+    }
+
+    write_u32( parts.size() );
+    foreach (parts, i)
+    {
+      write_u32( parts[i].size() );
+      write_bytes( parts[i].get_pointer(), parts[i].size() );
+    }
+  }
+
+  // splits a text command on spaces
+  void add(vsx_string<>& raw)
+  {
+    size_t size = raw.size();
+    size_t spaces = 0;
+    for (size_t i = 0; i < size; i++)
+      if (raw[i] == ' ')
+        spaces++;
+
+    if (!frame_reserve(4 + 4 * (spaces + 1) + size - spaces))
+    {
+      // too big for a frame, send it as text
+      if (frame_open)
+        frame_end();
+      write_bytes( raw.get_pointer(), size );
+      data.push_back('\n');
+      return;
+    }
+
+    write_u32(spaces + 1);
+    size_t start = 0;
+    for (size_t i = 0; i <= size; i++)
+    {
+      if (i < size && raw[i] != ' ')
+        continue;
+      write_u32( i - start );
+      write_bytes( raw.get_pointer() + start, i - start );
+      start = i + 1;
+    }
+  }
+
+  // finished frames, ready to be sent
+  vsx_ma_vector<unsigned char>& get_frames()
+  {
+    if (frame_open)
+      frame_end();
+    return data;
+  }
+};
+
+/*
+  Incremental parser for one connection, text and binary.
+  Bytes are fed as they arrive, complete commands are handed to the callbacks:
+
+    on_line(vsx_string<>& line)
+    on_parts(vsx_nw_vector< vsx_string<> >& parts)
+
+  feed() returns false on a malformed frame, the connection should be dropped.
+*/
+class vsx_command_protocol_reader
+{
+  vsx_string<> line;
+  vsx_ma_vector<unsigned char> frame;
+
+  // bytes still missing from the current frame, header included
+  size_t frame_remaining = 0;
+  bool in_frame = false;
+
+  static inline size_t read_u32(unsigned char* p)
+  {
+    return (size_t)p[0] | ((size_t)p[1] << 8) | ((size_t)p[2] << 16) | ((size_t)p[3] << 24);
+  }
+
+  template<typename P>
+  bool parse_frame(P on_parts)
+  {
+    unsigned char* p = frame.get_pointer() + VSX_COMMAND_PROTOCOL_FRAME_HEADER_SIZE;
+    unsigned char* end = frame.get_pointer() + frame.size();
+    vsx_nw_vector< vsx_string<> > parts;
+    while (p < end)
+    {
+      if ((size_t)(end - p) < 4)
+        return false;
+      size_t part_count = read_u32(p);
+      p += 4;
+
+      parts.reset_used(0);
+      for (size_t i = 0; i < part_count; i++)
+      {
+        if ((size_t)(end - p) < 4)
+          return false;
+        size_t size = read_u32(p);
+        p += 4;
+        if (size > (size_t)(end - p))
+          return false;
+        parts.push_back( vsx_string<>((char*)p, size) );
+        p += size;
+      }
+
+      if (parts.size())
+        on_parts(parts);
+    }
+    return true;
+  }
+
+public:
+
+  template<typename L, typename P>
+  bool feed(const char* data, size_t size, L on_line, P on_parts)
+  {
+    size_t i = 0;
+    while (i < size)
+    {
+      if (in_frame)
+      {
+        size_t take = size - i;
+        if (take > frame_remaining)
+          take = frame_remaining;
+
+        size_t offset = frame.size();
+        frame.allocate(offset + take - 1);
+        memcpy(frame.get_pointer() + offset, data + i, take);
+        i += take;
+        frame_remaining -= take;
+
+        // header complete, now we know the payload size
+        if (frame.size() == VSX_COMMAND_PROTOCOL_FRAME_HEADER_SIZE && !frame_remaining)
+        {
+          unsigned char* h = frame.get_pointer();
+          uint32_t payload_size = (uint32_t)h[1] | ((uint32_t)h[2] << 8) | ((uint32_t)h[3] << 16) | ((uint32_t)h[4] << 24);
+          if (payload_size > VSX_COMMAND_PROTOCOL_FRAME_MAX_SIZE)
+            return false;
+          frame_remaining = payload_size;
+        }
+
+        if (!frame_remaining && frame.size() >= VSX_COMMAND_PROTOCOL_FRAME_HEADER_SIZE)
+        {
+          in_frame = false;
+          bool ok = parse_frame(on_parts);
+          frame.reset_used(0);
+          if (!ok)
+            return false;
+        }
+        continue;
+      }
+
+      if (!line.size() && (unsigned char)data[i] == VSX_COMMAND_PROTOCOL_FRAME_START)
+      {
+        in_frame = true;
+        frame.reset_used(0);
+        frame_remaining = VSX_COMMAND_PROTOCOL_FRAME_HEADER_SIZE;
+        continue;
+      }
+
+      // copy everything up to the end of the line at once
+      size_t line_end = i;
+      while (line_end < size && data[line_end] != '\n' && data[line_end] != '\r')
+        line_end++;
+
+      if (line_end > i)
+        line += vsx_string<>(data + i, line_end - i);
+
+      if (line_end == size)
+        break;
+
+      if (line.size())
+        on_line(line);
+      line.clear();
+      i = line_end + 1;
+    }
+    return true;
+  }
+};
@@ -0,0 +1,423 @@
+#pragma once
+
+#include <string.h>
+#include <stdint.h>
+#include <map>
+#include <container/vsx_nw_vector.h>
+#include <container/vsx_ma_vector.h>
+#include <string/vsx_string.h>
+#include <string/vsx_string_helper.h>
+
+/*
+  Compiled state, the binary form of a state command list.
+
+  Text states are loaded by splitting every line, matching the command
+  against the engine's handlers one by one and base64 decoding values.
+  The compiled form is made once (vsxz -cs) and keeps the commands that
+  make up almost all of a state as typed records:
+
+    header:  "VSXB", u32 version, u32 string count, u32 record count
+    strings: u32 size, bytes (every name and value is stored once)
+    records: u8 type, fields, in the order of the text state
+    trailer: "BXSV"
+
+  Fields are u32 indices into the strings unless noted:
+
+    component_create  module, component, f32 x, f32 y
+    param_set         component, param, value (ps64 values stored decoded)
+    param_connect     in-comp, in-param, out-comp, out-param
+    param_alias       p_def, component, param, source comp, source param,
+                      u8 direction (0 = in, 1 = out)
+    command           u16 part count, parts
+
+  Everything else (macros, sequences, notes, meta...) and everything after
+  the first "break" is kept as a command, to be handled like the text one.
+
+  All integers are little endian.
+*/
+
+#define VSX_COMMAND_STATE_BINARY_VERSION 1
+
+struct vsx_command_state_binary_record
+{
+  enum record_type
+  {
+    component_create = 1,
+    param_set = 2,
+    param_connect = 3,
+    param_alias = 4,
+    command = 5
+  };
+
+  uint8_t type;
+
+  // param_alias: 1 for out params
+  uint8_t direction;
+
+  // field_count string indices, starting at field_offset in the reader's fields
+  uint32_t field_offset;
+  uint32_t field_count;
+
+  // component_create position
+  float x;
+  float y;
+};
+
+class vsx_command_state_binary_writer
+{
+  vsx_ma_vector<unsigned char> records;
+  vsx_nw_vector< vsx_string<> > strings;
+  std::map< vsx_string<>, uint32_t > string_index;
+  uint32_t record_count = 0;
+
+  // after a break the rest is left to the command queue
+  bool deferred = false;
+
+  static inline void write_u32(vsx_ma_vector<unsigned char>& data, uint32_t value)
+  {
+    data.push_back( (unsigned char)(value & 0xff) );
+    data.push_back( (unsigned char)((value >> 8) & 0xff) );
+    data.push_back( (unsigned char)((value >> 16) & 0xff) );
+    data.push_back( (unsigned char)((value >> 24) & 0xff) );
+  }
+
+  static inline void write_bytes(vsx_ma_vector<unsigned char>& data, const char* bytes, size_t size)
+  {
+    if (!size)
+      return;
+    size_t offset = data.size();
+    data.allocate(offset + size - 1);
+    memcpy(data.get_pointer() + offset, bytes, size);
+  }
+
+  inline void write_string(const vsx_string<>& value)
+  {
+    std::map< vsx_string<>, uint32_t >::iterator it = string_index.find(value);
+    if (it != string_index.end())
+    {
+      write_u32(records, it->second);
+      return;
+    }
+    uint32_t index = (uint32_t)strings.size();
+    strings.push_back(value);
+    string_index[value] = index;
+    write_u32(records, index);
+  }
+
+  inline void write_float(float value)
+  {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    write_u32(records, bits);
+  }
+
+  inline void begin_record(uint8_t type)
+  {
+    records.push_back(type);
+    record_count++;
+  }
+
+public:
+
+  void add(vsx_nw_vector< vsx_string<> >& parts)
+  {
+    if (!parts.size())
+      return;
+
+    vsx_string<>& cmd = parts[0];
+
+    if (cmd == "break")
+      deferred = true;
+
+    if (!deferred)
+    {
+      if (cmd == "component_create" && parts.size() == 5)
+      {
+        begin_record(vsx_command_state_binary_record::component_create);
+        write_string(parts[1]);
+        write_string(parts[2]);
+        write_float( vsx_string_helper::s2f(parts[3]) );
+        write_float( vsx_string_helper::s2f(parts[4]) );
+        return;
+      }
+
+      if ((cmd == "param_set" || cmd == "ps") && parts.size() == 4)
+      {
+        begin_record(vsx_command_state_binary_record::param_set);
+        write_string(parts[1]);
+        write_string(parts[2]);
+        write_string(parts[3]);
+        return;
+      }
+
+      if (cmd == "ps64" && parts.size() == 4)
+      {
+        begin_record(vsx_command_state_binary_record::param_set);
+        write_string(parts[1]);
+        write_string(parts[2]);
+        write_string( vsx_string_helper::base64_decode(parts[3]) );
+        return;
+      }
+
+      // with a 6th part the command is not volatile, only matters to a client
+      if (cmd == "param_connect" && parts.size() == 5)
+      {
+        begin_record(vsx_command_state_binary_record::param_connect);
+        for (size_t i = 1; i < 5; i++)
+          write_string(parts[i]);
+        return;
+      }
+
+      if (cmd == "param_alias" && parts.size() == 7)
+      {
+        begin_record(vsx_command_state_binary_record::param_alias);
+        write_string(parts[1]);
+        for (size_t i = 3; i < 7; i++)
+          write_string(parts[i]);
+        records.push_back( parts[2] == "-1" ? 0 : 1 );
+        return;
+      }
+    }
+
+    begin_record(vsx_command_state_binary_record::command);
+    records.push_back( (unsigned char)(parts.size() & 0xff) );
+    records.push_back( (unsigned char)((parts.size() >> 8) & 0xff) );
+    foreach (parts, i)
+      write_string(parts[i]);
+  }
+
+  // one line of a text state
+  void add_raw(const vsx_string<>& line)
+  {
+    vsx_string<> trimmed = line;
+    trimmed.trim_lf();
+    if (!trimmed.size())
+      return;
+
+    vsx_nw_vector< vsx_string<> > parts;
+    vsx_string<> deli = " ";
+    vsx_string_helper::explode(trimmed, deli, parts);
+    add(parts);
+  }
+
+  // a whole text state
+  void add_state(const vsx_string<>& state)
+  {
+    vsx_nw_vector< vsx_string<> > lines;
+    vsx_string<> deli = "\n";
+    vsx_string_helper::explode(state, deli, lines);
+    foreach (lines, i)
+      add_raw(lines[i]);
+  }
+
+  vsx_ma_vector<unsigned char> get_data()
+  {
+    vsx_ma_vector<unsigned char> data;
+    write_bytes(data, "VSXB", 4);
+    write_u32(data, VSX_COMMAND_STATE_BINARY_VERSION);
+    write_u32(data, (uint32_t)strings.size());
+    write_u32(data, record_count);
+    foreach (strings, i)
+    {
+      write_u32(data, (uint32_t)strings[i].size());
+      write_bytes(data, strings[i].get_pointer(), strings[i].size());
+    }
+    write_bytes(data, (const char*)records.get_pointer(), records.size());
+    write_bytes(data, "BXSV", 4);
+    return data;
+  }
+};
+
+/*
+  Checks and unpacks a compiled state. load() returns false for anything
+  that isn't a complete compiled state of this version, the caller should
+  then fall back to the text state.
+*/
+class vsx_command_state_binary_reader
+{
+  vsx_nw_vector< vsx_string<> > strings;
+  vsx_ma_vector<vsx_command_state_binary_record> records;
+  vsx_ma_vector<uint32_t> fields;
+
+  const unsigned char* p = 0x0;
+  const unsigned char* end = 0x0;
+
+  inline bool read_u32(uint32_t& value)
+  {
+    if ((size_t)(end - p) < 4)
+      return false;
+    value = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    p += 4;
+    return true;
+  }
+
+  inline bool read_float(float& value)
+  {
+    uint32_t bits;
+    if (!read_u32(bits))
+      return false;
+    memcpy(&value, &bits, sizeof(value));
+    return true;
+  }
+
+  inline bool read_fields(vsx_command_state_binary_record& record, uint32_t count)
+  {
+    record.field_offset = (uint32_t)fields.size();
+    record.field_count = count;
+    for (uint32_t i = 0; i < count; i++)
+    {
+      uint32_t index;
+      if (!read_u32(index))
+        return false;
+      if (index >= strings.size())
+        return false;
+      fields.push_back(index);
+    }
+    return true;
+  }
+
+  bool read_record(vsx_command_state_binary_record& record)
+  {
+    if (p >= end)
+      return false;
+    record.type = *p++;
+    record.direction = 0;
+    record.x = record.y = 0.0f;
+
+    switch (record.type)
+    {
+      case vsx_command_state_binary_record::component_create:
+        return read_fields(record, 2) && read_float(record.x) && read_float(record.y);
+
+      case vsx_command_state_binary_record::param_set:
+        return read_fields(record, 3);
+
+      case vsx_command_state_binary_record::param_connect:
+        return read_fields(record, 4);
+
+      case vsx_command_state_binary_record::param_alias:
+        if (!read_fields(record, 5) || p >= end)
+          return false;
+        record.direction = *p++;
+        return true;
+
+      case vsx_command_state_binary_record::command:
+      {
+        if ((size_t)(end - p) < 2)
+          return false;
+        uint32_t count = (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+        p += 2;
+        return count && read_fields(record, count);
+      }
+    }
+    return false;
+  }
+
+public:
+
+  static bool is_compiled(const unsigned char* data, size_t size)
+  {
+    return size >= 4 && !memcmp(data, "VSXB", 4);
+  }
+
+  bool load(const unsigned char* data, size_t size)
+  {
+    strings.clear();
+    records.reset_used(0);
+    fields.reset_used(0);
+
+    if (size < 8 || !is_compiled(data, size))
+      return false;
+
+    // lengths are checked against what's left, end - p, never by forming
+    // a pointer past the end
+    p = data + 4;
+    end = data + size - 4;
+    if (memcmp(end, "BXSV", 4))
+      return false;
+
+    uint32_t version, string_count, record_count;
+    if (!read_u32(version) || !read_u32(string_count) || !read_u32(record_count))
+      return false;
+    if (version != VSX_COMMAND_STATE_BINARY_VERSION)
+      return false;
+
+    for (uint32_t i = 0; i < string_count; i++)
+    {
+      uint32_t string_size;
+      if (!read_u32(string_size))
+        return false;
+      if (string_size > (size_t)(end - p))
+        return false;
+      strings.push_back( vsx_string<>((const char*)p, string_size) );
+      p += string_size;
+    }
+
+    for (uint32_t i = 0; i < record_count; i++)
+    {
+      vsx_command_state_binary_record record;
+      if (!read_record(record))
+        return false;
+      records.push_back(record);
+    }
+
+    return p == end;
+  }
+
+  size_t get_record_count()
+  {
+    return records.size();
+  }
+
+  vsx_command_state_binary_record& get_record(size_t index)
+  {
+    return records[index];
+  }
+
+  vsx_string<>& get_field(vsx_command_state_binary_record& record, size_t index)
+  {
+    return strings[ fields[record.field_offset + index] ];
+  }
+
+  // the record as text command parts, i.e. to hand it to the command queue
+  void get_parts(vsx_command_state_binary_record& record, vsx_nw_vector< vsx_string<> >& parts)
+  {
+    parts.reset_used(0);
+    switch (record.type)
+    {
+      case vsx_command_state_binary_record::component_create:
+        parts.push_back("component_create");
+        parts.push_back( get_field(record, 0) );
+        parts.push_back( get_field(record, 1) );
+        parts.push_back( vsx_string_helper::f2s(record.x) );
+        parts.push_back( vsx_string_helper::f2s(record.y) );
+        return;
+
+      case vsx_command_state_binary_record::param_set:
+        parts.push_back("ps64");
+        parts.push_back( get_field(record, 0) );
+        parts.push_back( get_field(record, 1) );
+        parts.push_back( vsx_string_helper::base64_encode( get_field(record, 2) ) );
+        return;
+
+      case vsx_command_state_binary_record::param_connect:
+        parts.push_back("param_connect");
+        for (size_t i = 0; i < 4; i++)
+          parts.push_back( get_field(record, i) );
+        return;
+
+      case vsx_command_state_binary_record::param_alias:
+        parts.push_back("param_alias");
+        parts.push_back( get_field(record, 0) );
+        parts.push_back( record.direction ? "1" : "-1" );
+        for (size_t i = 1; i < 5; i++)
+          parts.push_back( get_field(record, i) );
+        return;
+
+      case vsx_command_state_binary_record::command:
+        for (size_t i = 0; i < record.field_count; i++)
+          parts.push_back( get_field(record, i) );
+        return;
+    }
+  }
+};
@@ -26,6 +26,7 @@ void filesystem_archive_vsx_reader::load_all_worker(vsx_nw_vector<filesystem_arc
 void filesystem_archive_vsx_reader::load_all()
 {
   size_t pooled_size = 0;
+  vsx_thread_pool<>::task_group group;
   vsx_nw_vector<filesystem_archive_file_read*>* pool = new vsx_nw_vector<filesystem_archive_file_read*>();
   foreach (archive_files, i)
   {
@@ -36,13 +37,12 @@ void filesystem_archive_vsx_reader::load_all()
     if (pooled_size <= work_chunk_size && !is_last)
       continue;
 
-    vsx_thread_pool<>::instance()->add(
-      [=](vsx_nw_vector<filesystem_archive_file_read*>* work_pool)
+    group.run(
+      [this, pool]()
       {
-        load_all_worker(work_pool);
-        delete work_pool;
-      },
-      pool
+        load_all_worker(pool);
+        delete pool;
+      }
     );
 
     if (!is_last)
@@ -51,7 +51,7 @@ void filesystem_archive_vsx_reader::load_all()
     pooled_size = 0;
   }
   vsx_printf(L"waiting for threads...\n");
-  vsx_thread_pool<>::instance()->wait_all(100);
+  group.wait();
   vsx_printf(L"done waiting\n");
 }
 
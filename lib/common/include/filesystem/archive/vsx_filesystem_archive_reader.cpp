@@ -105,4 +105,17 @@ void filesystem_archive_reader::file_open(const char* filename, file* &handle)
   archive->file_open(filename, handle);
 }
 
+void filesystem_archive_reader::file_close(file* handle)
+{
+  req(archive);
+  archive->file_close(handle);
+}
+
+void filesystem_archive_reader::set_chunk_cache_budget(size_t bytes)
+{
+  req(archive);
+  req(archive_type == archive_vsxz);
+  ((filesystem_archive_vsxz_reader*)archive)->set_chunk_cache_budget(bytes);
+}
+
 }
@@ -39,8 +39,12 @@ namespace vsx
     bool load(const char* archive_filename, vsx_thread_pool<1>& pool, uint64_t loading_flags);
 
     void file_open(const char* filename, file* &handle);
+    void file_close(file* handle);
     void close();
 
+    // memory budget for decompressed chunks when loaded with VSX_FILESYSTEM_ARCHIVE_LOADING_FLAG_LAZY
+    void set_chunk_cache_budget(size_t bytes);
+
     bool is_archive();
     bool is_archive_populated();
     bool is_file(vsx_string<> filename);
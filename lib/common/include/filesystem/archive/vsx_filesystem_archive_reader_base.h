@@ -8,6 +8,9 @@
 
 #define VSX_FILESYSTEM_ARCHIVE_LOADING_FLAG_DO_NOT_COPY_MMAP_TO_RAM 2
 
+// don't decompress anything on load, chunks are decompressed when a file in them is opened
+#define VSX_FILESYSTEM_ARCHIVE_LOADING_FLAG_LAZY 4
+
 namespace vsx
 {
 
@@ -22,6 +25,12 @@ namespace vsx
     virtual void files_get(vsx_nw_vector<filesystem_archive_file_read>& files) = 0;
     virtual void file_open(const char* filename, file* &handle) = 0;
 
+    // called when a handle from file_open is done with, its data may be released after this
+    virtual void file_close(file* handle)
+    {
+      VSX_UNUSED(handle);
+    }
+
     virtual void close() = 0;
 
     virtual bool is_archive() = 0;
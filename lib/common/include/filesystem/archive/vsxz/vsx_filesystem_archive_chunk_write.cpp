@@ -1,4 +1,6 @@
 #include <filesystem/archive/vsxz/vsx_filesystem_archive_chunk_write.h>
+#include <filesystem/archive/vsxz/vsx_filesystem_archive_entropy.h>
+#include <time/vsx_timer.h>
 #include <vsx_compression_lzham.h>
 #include <vsx_compression_lzma.h>
 
@@ -8,32 +10,36 @@ void vsx::filesystem_archive_chunk_write::compress()
 
   threaded_task {
 
-    vsx_printf(L"compressing chunk %d\n", file_info_table[0].chunk);
-    vsx_ma_vector< unsigned char> uncompressed_data_readback;
+    vsx_printf(L"compressing chunk %d\n", chunk_id);
 
-    vsx_perf perf;
-    perf.cpu_instructions_start();
+    vsx_timer timer;
+    timer.start();
 
-    // LZHAM
-    compressed_data = vsx::compression_lzham::compress( uncompressed_data );
-    perf.cpu_instructions_begin();
-    uncompressed_data_readback = vsx::compression_lzham::uncompress(compressed_data, uncompressed_data.size() );
-    long long cpu_instructions_lzham = perf.cpu_instructions_end();
+    float entropy = filesystem_archive_entropy(uncompressed_data);
 
-    // LZMA
-    compression_type = compression_lzma;
-    compressed_data = vsx::compression_lzma::compress( uncompressed_data );
-    perf.cpu_instructions_begin();
-    uncompressed_data_readback = vsx::compression_lzma::uncompress(compressed_data, uncompressed_data.size() );
-    long long cpu_instructions_lzma = perf.cpu_instructions_end();
-
-    if (cpu_instructions_lzham < cpu_instructions_lzma)
+    // already compressed data (images, audio, video) is stored as is
+    if (entropy > 7.5f)
+      compression_type = compression_none;
+    else
+    // not much to gain, prefer the faster decompression
+    if (entropy > 6.0f)
     {
-      compressed_data = vsx::compression_lzham::compress( uncompressed_data );
       compression_type = compression_lzham;
+      compressed_data = vsx::compression_lzham::compress( uncompressed_data );
+    }
+    else
+    {
+      compression_type = compression_lzma;
+      compressed_data = vsx::compression_lzma::compress( uncompressed_data );
+    }
+
+    if (compression_type != compression_none && compressed_data.size() >= uncompressed_data.size())
+    {
+      compressed_data.clear();
+      compression_type = compression_none;
     }
 
-    perf.cpu_instructions_stop();
-    vsx_printf(L"compressing chunk %d [DONE]\n", file_info_table[0].chunk);
+    compression_time = timer.dtime();
+    vsx_printf(L"compressing chunk %d [DONE]\n", chunk_id);
   } threaded_task_end;
 }
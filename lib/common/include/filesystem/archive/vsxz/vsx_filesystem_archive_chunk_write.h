@@ -16,7 +16,7 @@ public:
 
   vsx_ma_vector<unsigned char> uncompressed_data;
   vsx_ma_vector<unsigned char> compressed_data;
-  vsx_ma_vector< vsxz_header_file_info > file_info_table;
+  vsx_ma_vector< vsxz_header_file_info_v2 > file_info_table;
   vsx_ma_vector< filesystem_archive_file_write* > archive_file_write;
 
 
@@ -28,23 +28,42 @@ public:
 
   compression_type_t compression_type = compression_none;
 
+  uint32_t chunk_id = 0;
+
+  // seconds spent compressing
+  double compression_time = 0.0;
+
   bool has_files()
   {
     return file_info_table.size() > 0;
   }
 
 
-  void add_file(filesystem_archive_file_write* file_info)
+  // returns the file's position in this chunk
+  size_t add_file(filesystem_archive_file_write* file_info)
   {
     archive_file_write.push_back( file_info );
 
-    vsxz_header_file_info info;
-    info.offset = (uint32_t)uncompressed_data.size();
-    info.size = (uint32_t)file_info->data.size();
+    vsxz_header_file_info_v2 info;
+    info.offset = uncompressed_data.size();
+    info.size = file_info->data.size();
+
+    if (info.size)
+    {
+      uncompressed_data.allocate(info.offset + info.size - 1);
+      memcpy(uncompressed_data.get_pointer() + info.offset, file_info->data.get_pointer(), info.size);
+    }
 
-    foreach(file_info->data, i)
-      uncompressed_data.push_back(file_info->data[i]);
+    size_t position = file_info_table.size();
+    file_info_table.move_back( std::move(info));
+    return position;
+  }
 
+  // file with the same content as the one at position, shares its data
+  void add_duplicate(filesystem_archive_file_write* file_info, size_t position)
+  {
+    archive_file_write.push_back( file_info );
+    vsxz_header_file_info_v2 info = file_info_table[position];
     file_info_table.move_back( std::move(info));
   }
 
@@ -53,8 +72,9 @@ public:
     return uncompressed_data.size() > 1024*1024;
   }
 
-  void set_chunk_id(uint8_t index)
+  void set_chunk_id(uint32_t index)
   {
+    chunk_id = index;
     foreach (file_info_table, i)
       file_info_table[i].chunk = index;
   }
@@ -67,12 +87,22 @@ public:
     }
   }
 
-  uint32_t get_compressed_uncompressed_size()
+  // memory needed for this chunk when the whole archive is decompressed,
+  // chunk 0 is used straight from the archive
+  uint64_t get_compressed_uncompressed_size()
   {
-    if (compression_type == compression_none)
+    if (chunk_id == 0)
       return 0;
 
-    return (uint32_t)uncompressed_data.get_sizeof();
+    return uncompressed_data.get_sizeof();
+  }
+
+  // bytes this chunk takes in the archive
+  uint64_t get_stored_size()
+  {
+    if (compressed_data.size())
+      return compressed_data.get_sizeof();
+    return uncompressed_data.get_sizeof();
   }
 
   void compress();
@@ -80,19 +110,22 @@ public:
   void write_file_info_table(FILE* file)
   {
     foreach (file_info_table, i)
-      fwrite(&file_info_table[i], sizeof(vsxz_header_file_info), 1, file);
+      fwrite(&file_info_table[i], sizeof(vsxz_header_file_info_v2), 1, file);
   }
 
-  void write_chunk_info_table(FILE* file, bool force = false)
+  // data_offset is where this chunk's data starts in the archive, advanced past it
+  void write_chunk_info_table(FILE* file, uint64_t& data_offset, bool force = false)
   {
     if (!has_files() && !force)
       return;
 
-    vsxz_header_chunk_info info;
-    info.compressed_size = (uint32_t)compressed_data.size();
-    info.uncompressed_size = (uint32_t)uncompressed_data.size();
+    vsxz_header_chunk_info_v2 info;
+    info.compressed_size = chunk_id ? get_stored_size() : 0;
+    info.uncompressed_size = uncompressed_data.size();
     info.compression_type = (uint16_t)compression_type;
-    fwrite(&info, sizeof(vsxz_header_chunk_info), 1, file);
+    info.offset = data_offset;
+    fwrite(&info, sizeof(vsxz_header_chunk_info_v2), 1, file);
+    data_offset += get_stored_size();
   }
 
 
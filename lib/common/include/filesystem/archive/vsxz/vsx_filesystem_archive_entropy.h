@@ -0,0 +1,57 @@
+#pragma once
+
+#include <math.h>
+#include <container/vsx_ma_vector.h>
+
+namespace vsx
+{
+
+/**
+ * Quick estimate of the Shannon entropy of data in bits per byte (0..8).
+ * Large buffers are sampled in blocks spread over the whole buffer, so this
+ * is cheap enough to run on every file before deciding how to compress it.
+ * Anything close to 8 is already compressed or random.
+ */
+inline float filesystem_archive_entropy(vsx_ma_vector<unsigned char>& data)
+{
+  const size_t block_size = 4096;
+  const size_t max_blocks = 64;
+
+  size_t size = data.size();
+  if (!size)
+    return 0.0f;
+
+  size_t histogram[256] = {0};
+  size_t sampled = 0;
+
+  size_t block_count = size / block_size;
+  if (block_count <= max_blocks)
+  {
+    for (size_t i = 0; i < size; i++)
+      histogram[data[i]]++;
+    sampled = size;
+  }
+  else
+  {
+    size_t stride = block_count / max_blocks;
+    for (size_t block = 0; block < max_blocks; block++)
+    {
+      unsigned char* p = data.get_pointer() + block * stride * block_size;
+      for (size_t i = 0; i < block_size; i++)
+        histogram[p[i]]++;
+    }
+    sampled = max_blocks * block_size;
+  }
+
+  float entropy = 0.0f;
+  for (size_t i = 0; i < 256; i++)
+  {
+    if (!histogram[i])
+      continue;
+    float p = (float)histogram[i] / (float)sampled;
+    entropy -= p * log2f(p);
+  }
+  return entropy;
+}
+
+}
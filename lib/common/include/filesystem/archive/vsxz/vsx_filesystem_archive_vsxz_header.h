@@ -12,6 +12,10 @@
  *    [ vsxz_header_compression_chunk][ vsxz_header_compression_chunk]
  * 5. compressed data
  *
+ * Version 2 has the same layout with the _v2 structs: 64-bit sizes,
+ * 32-bit chunk indices and the file offset of each chunk's data in the
+ * chunk table so any chunk can be found without walking the ones before it.
+ * Both versions start with identifier + version.
  */
 namespace vsx
 {
@@ -46,4 +50,36 @@ struct vsxz_header_file_info
 }
 VSX_PACK_END
 
+VSX_PACK_BEGIN
+struct vsxz_header_v2
+{
+   uint8_t identifier[4] = {'V','S', 'X', 'Z'}; // "VSXZ"
+   uint32_t version = 2; // 2
+   uint64_t tree_size = 0; // size of the file tree
+   uint64_t file_count = 0; // number of files stored in this archive
+   uint64_t chunk_count = 0; // number of compression chunks in this archive
+   uint64_t compression_uncompressed_memory_size = 0; // the chunk of memory needed for uncompressing the entire archive
+   uint32_t reserved[4] = {0xEFBEADDE, 0xEFBEADDE, 0xEFBEADDE, 0xEFBEADDE};
+}
+VSX_PACK_END
+
+VSX_PACK_BEGIN
+struct vsxz_header_chunk_info_v2
+{
+  uint16_t compression_type = 0; // 0 for none, 1 for lzma, 2 for lzham
+  uint64_t compressed_size = 0;
+  uint64_t uncompressed_size = 0;
+  uint64_t offset = 0; // offset of the chunk's data from the start of the archive
+}
+VSX_PACK_END
+
+VSX_PACK_BEGIN
+struct vsxz_header_file_info_v2
+{
+  uint32_t chunk = 0; // chunk index, starts with 0
+  uint64_t offset = 0; // offset within the chunk
+  uint64_t size = 0; // uncompressed size
+}
+VSX_PACK_END
+
 }
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <string.h>
+#include <container/vsx_ma_vector.h>
+#include <tools/vsx_req.h>
+#include "vsx_filesystem_archive_vsxz_header.h"
+
+namespace vsx
+{
+
+/**
+ * Version independent tables of a mapped VSXZ archive.
+ * Version 1 tables are widened to the v2 structs, chunk data offsets are
+ * calculated for them.
+ */
+class filesystem_archive_vsxz_index
+{
+public:
+
+  uint32_t version = 0;
+  uint64_t tree_size = 0;
+  uint64_t file_count = 0;
+  uint64_t chunk_count = 0;
+  uint64_t compression_uncompressed_memory_size = 0;
+
+  unsigned char* tree = 0x0;
+  vsx_ma_vector<vsxz_header_file_info_v2> file_info_table;
+  vsx_ma_vector<vsxz_header_chunk_info_v2> chunk_info_table;
+
+private:
+
+  bool read_v1(unsigned char* data, uint64_t size)
+  {
+    reqrv(size >= sizeof(vsxz_header), false);
+    vsxz_header* header = (vsxz_header*)data;
+    tree_size = header->tree_size;
+    file_count = header->file_count;
+    chunk_count = header->chunk_count;
+    compression_uncompressed_memory_size = header->compression_uncompressed_memory_size;
+
+    uint64_t tables_end =
+        sizeof(vsxz_header) +
+        tree_size +
+        sizeof(vsxz_header_file_info) * file_count +
+        sizeof(vsxz_header_chunk_info) * chunk_count;
+    reqrv(tables_end <= size, false);
+
+    tree = data + sizeof(vsxz_header);
+
+    vsxz_header_file_info* files = (vsxz_header_file_info*)(tree + tree_size);
+    if (file_count)
+      file_info_table.allocate(file_count - 1);
+    for (size_t i = 0; i < file_count; i++)
+    {
+      file_info_table[i].chunk = files[i].chunk;
+      file_info_table[i].offset = files[i].offset;
+      file_info_table[i].size = files[i].size;
+    }
+
+    // chunk data is stored back to back after the tables
+    vsxz_header_chunk_info* chunks = (vsxz_header_chunk_info*)(files + file_count);
+    uint64_t offset = tables_end;
+    if (chunk_count)
+      chunk_info_table.allocate(chunk_count - 1);
+    for (size_t i = 0; i < chunk_count; i++)
+    {
+      chunk_info_table[i].compression_type = chunks[i].compression_type;
+      chunk_info_table[i].compressed_size = chunks[i].compressed_size;
+      chunk_info_table[i].uncompressed_size = chunks[i].uncompressed_size;
+      chunk_info_table[i].offset = offset;
+
+      // the first chunk is stored uncompressed
+      offset += i ? chunks[i].compressed_size : chunks[i].uncompressed_size;
+    }
+    return true;
+  }
+
+  bool read_v2(unsigned char* data, uint64_t size)
+  {
+    reqrv(size >= sizeof(vsxz_header_v2), false);
+    vsxz_header_v2* header = (vsxz_header_v2*)data;
+    tree_size = header->tree_size;
+    file_count = header->file_count;
+    chunk_count = header->chunk_count;
+    compression_uncompressed_memory_size = header->compression_uncompressed_memory_size;
+
+    uint64_t tables_end =
+        sizeof(vsxz_header_v2) +
+        tree_size +
+        sizeof(vsxz_header_file_info_v2) * file_count +
+        sizeof(vsxz_header_chunk_info_v2) * chunk_count;
+    reqrv(tables_end <= size, false);
+
+    tree = data + sizeof(vsxz_header_v2);
+
+    unsigned char* files = tree + tree_size;
+    if (file_count)
+    {
+      file_info_table.allocate(file_count - 1);
+      memcpy(file_info_table.get_pointer(), files, sizeof(vsxz_header_file_info_v2) * file_count);
+    }
+
+    unsigned char* chunks = files + sizeof(vsxz_header_file_info_v2) * file_count;
+    if (chunk_count)
+    {
+      chunk_info_table.allocate(chunk_count - 1);
+      memcpy(chunk_info_table.get_pointer(), chunks, sizeof(vsxz_header_chunk_info_v2) * chunk_count);
+    }
+
+    for (size_t i = 0; i < chunk_count; i++)
+    {
+      uint64_t stored_size = i ? chunk_info_table[i].compressed_size : chunk_info_table[i].uncompressed_size;
+      reqrv(chunk_info_table[i].offset + stored_size <= size, false);
+
+      // stored chunks are copied straight to memory
+      if (i && chunk_info_table[i].compression_type == 0)
+        reqrv(chunk_info_table[i].compressed_size == chunk_info_table[i].uncompressed_size, false);
+    }
+    return true;
+  }
+
+public:
+
+  bool read(unsigned char* data, uint64_t size)
+  {
+    clear();
+    reqrv(size >= 8, false);
+    reqrv(data[0] == 'V', false);
+    reqrv(data[1] == 'S', false);
+    reqrv(data[2] == 'X', false);
+    reqrv(data[3] == 'Z', false);
+
+    version = *(uint32_t*)(data + 4);
+
+    bool read_ok = false;
+
+    if (version == 1)
+      read_ok = read_v1(data, size);
+
+    if (version == 2)
+      read_ok = read_v2(data, size);
+
+    // every file must be inside its chunk
+    for (size_t i = 0; i < file_count && read_ok; i++)
+    {
+      if (file_info_table[i].chunk >= chunk_count)
+        read_ok = false;
+      else
+      if (file_info_table[i].offset + file_info_table[i].size > chunk_info_table[file_info_table[i].chunk].uncompressed_size)
+        read_ok = false;
+    }
+
+    if (!read_ok)
+      clear();
+
+    return read_ok;
+  }
+
+  void clear()
+  {
+    version = 0;
+    tree_size = file_count = chunk_count = compression_uncompressed_memory_size = 0;
+    tree = 0x0;
+    file_info_table.clear();
+    chunk_info_table.clear();
+  }
+};
+
+}
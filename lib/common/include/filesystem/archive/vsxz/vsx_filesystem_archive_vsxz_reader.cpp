@@ -12,104 +12,224 @@ bool filesystem_archive_vsxz_reader::load_initial(const char* archive_filename,
 {
   mmap = filesystem_mmap::create(archive_filename);
   reqrv(mmap, false);
-  reqrv(mmap->size > sizeof(vsxz_header) + sizeof(vsxz_header_file_info), false);
-  header = (vsxz_header*)mmap->data;
-
-  reqrv(header->identifier[0] == 'V', false);
-  reqrv(header->identifier[1] == 'S', false);
-  reqrv(header->identifier[2] == 'X', false);
-  reqrv(header->identifier[3] == 'Z', false);
+  reqrv(index.read(mmap->data, mmap->size), false);
+  reqrv(index.chunk_count, false);
 
   this->loading_flags = loading_flags;
+  lazy = (loading_flags & VSX_FILESYSTEM_ARCHIVE_LOADING_FLAG_LAZY) != 0;
 
-  if (header->compression_uncompressed_memory_size)
-    uncompressed_data.allocate(header->compression_uncompressed_memory_size - 1);
-
-  chunk_info_table =
-      (vsxz_header_chunk_info*) (
-        mmap->data +
-        sizeof(vsxz_header) +
-        header->tree_size +
-        sizeof(vsxz_header_file_info) * header->file_count
-      );
-
-  file_info_table = (vsxz_header_file_info*) (
-        mmap->data +
-        sizeof(vsxz_header) +
-        header->tree_size
-      );
+  if (index.compression_uncompressed_memory_size && !lazy)
+    uncompressed_data.allocate(index.compression_uncompressed_memory_size - 1);
 
-  tree.initialize( mmap->data + sizeof(vsxz_header) );
+  tree.initialize( index.tree );
 
-  uncompressed_data_start = uncompressed_data.get_pointer();
+  uncompressed_data_start_pointers.allocate(index.chunk_count - 1);
+  uncompressed_data_start_pointers.memory_clear();
 
-  compressed_data_start =
-      mmap->data +
-      sizeof(vsxz_header) +
-      header->tree_size +
-      sizeof(vsxz_header_file_info) * header->file_count +
-      sizeof(vsxz_header_chunk_info) * header->chunk_count
-    ;
-
-  uncompressed_data_start_pointers[0] = compressed_data_start;
+  // first chunk is always uncompressed
+  uncompressed_data_start_pointers[0] = mmap->data + index.chunk_info_table[0].offset;
 
 #if PLATFORM == PLATFORM_WINDOWS
   if ( !(loading_flags & VSX_FILESYSTEM_ARCHIVE_LOADING_FLAG_DO_NOT_COPY_MMAP_TO_RAM) )
   {
-    uncompressed_data_start_pointers[0] = (unsigned char*)malloc(chunk_info_table[0].uncompressed_size);
-    memcpy(uncompressed_data_start_pointers[0], compressed_data_start, chunk_info_table[0].uncompressed_size);
+    uncompressed_data_start_pointers[0] = (unsigned char*)malloc(index.chunk_info_table[0].uncompressed_size);
+    memcpy(uncompressed_data_start_pointers[0], mmap->data + index.chunk_info_table[0].offset, index.chunk_info_table[0].uncompressed_size);
   }
 #endif
 
-  // first chunk is always uncompressed
-  compressed_data_start += chunk_info_table[0].uncompressed_size;
   return true;
 }
 
+template<int Td>
+void filesystem_archive_vsxz_reader::load_chunks(vsx_thread_pool<Td>& pool)
+{
+  uint64_t offset_uncompressed = 0;
+  typename vsx_thread_pool<Td>::task_group group(&pool);
+  for (size_t chunk_i = 1; chunk_i < index.chunk_count; chunk_i++)
+  {
+    uncompressed_data_start_pointers[chunk_i] = uncompressed_data.get_pointer() + offset_uncompressed;
+
+    const vsxz_header_chunk_info_v2* chunk = &index.chunk_info_table[chunk_i];
+    unsigned char* compressed_data = mmap->data + chunk->offset;
+    unsigned char* chunk_uncompressed_data = uncompressed_data_start_pointers[chunk_i];
+    group.run(
+      [chunk, compressed_data, chunk_uncompressed_data]()
+      {
+        chunk_uncompress(*chunk, compressed_data, chunk_uncompressed_data);
+      }
+    );
+
+    offset_uncompressed += chunk->uncompressed_size;
+  }
+
+  // only our chunks, not whatever else is on the pool
+  group.wait();
+}
+
+void filesystem_archive_vsxz_reader::chunk_uncompress
+(
+  const vsxz_header_chunk_info_v2& chunk,
+  unsigned char* compressed_data,
+  unsigned char* uncompressed_data
+)
+{
+  req(chunk.compressed_size);
+
+  // stored as is
+  if (chunk.compression_type == 0)
+  {
+    memcpy(uncompressed_data, compressed_data, chunk.uncompressed_size);
+    return;
+  }
+
+  vsx_ma_vector<unsigned char> compressed;
+  compressed.set_volatile();
+  compressed.set_data( compressed_data, chunk.compressed_size );
+
+  vsx_ma_vector<unsigned char> uncompressed;
+  uncompressed.set_volatile();
+  uncompressed.set_data( uncompressed_data, chunk.uncompressed_size );
+
+  if (chunk.compression_type == 1)
+    compression_lzma::uncompress(uncompressed, compressed);
+
+  if (chunk.compression_type == 2)
+    compression_lzham::uncompress(uncompressed, compressed);
+}
+
+void filesystem_archive_vsxz_reader::load_lazy()
+{
+  for (size_t chunk_i = 0; chunk_i < index.chunk_count; chunk_i++)
+  {
+    chunk_cache_entry entry;
+
+    // first chunk is stored uncompressed, it's always available
+    if (chunk_i == 0)
+    {
+      entry.state = chunk_cache_entry::state_loaded;
+      entry.data = uncompressed_data_start_pointers[0];
+      entry.references = 1;
+      chunk_cache.push_back(entry);
+      continue;
+    }
+
+    entry.compressed_data = mmap->data + index.chunk_info_table[chunk_i].offset;
+    chunk_cache.push_back(entry);
+  }
+}
+
+void filesystem_archive_vsxz_reader::chunk_load(size_t chunk_i, std::unique_lock<std::mutex>& lock)
+{
+  chunk_cache_entry& entry = chunk_cache[chunk_i];
+  const vsxz_header_chunk_info_v2& chunk = index.chunk_info_table[chunk_i];
+  entry.state = chunk_cache_entry::state_loading;
+
+  // others can use the cache while we decompress
+  lock.unlock();
+  unsigned char* data = (unsigned char*)malloc(chunk.uncompressed_size);
+  chunk_uncompress(chunk, entry.compressed_data, data);
+  lock.lock();
+
+  entry.data = data;
+  entry.state = chunk_cache_entry::state_loaded;
+  entry.last_used = ++chunk_cache_tick;
+  chunk_cache_size += chunk.uncompressed_size;
+  chunk_cache_evict(chunk_i);
+  chunk_cache_loaded.notify_all();
+}
+
+void filesystem_archive_vsxz_reader::chunk_cache_evict(size_t keep_chunk_i)
+{
+  while (chunk_cache_size > chunk_cache_budget)
+  {
+    // least recently used chunk without open files, chunk 0 is never evicted
+    size_t oldest = 0;
+    for (size_t i = 1; i < chunk_cache.size(); i++)
+    {
+      if (i == keep_chunk_i)
+        continue;
+      if (chunk_cache[i].state != chunk_cache_entry::state_loaded)
+        continue;
+      if (chunk_cache[i].references)
+        continue;
+      if (!oldest || chunk_cache[i].last_used < chunk_cache[oldest].last_used)
+        oldest = i;
+    }
+    req(oldest);
+
+    free(chunk_cache[oldest].data);
+    chunk_cache[oldest].data = 0x0;
+    chunk_cache[oldest].state = chunk_cache_entry::state_unloaded;
+    chunk_cache_size -= index.chunk_info_table[oldest].uncompressed_size;
+  }
+}
+
+void filesystem_archive_vsxz_reader::chunk_prefetch(size_t chunk_i)
+{
+  req(chunk_i < chunk_cache.size());
+  std::unique_lock<std::mutex> lock(chunk_cache_lock);
+  req(chunk_cache[chunk_i].state == chunk_cache_entry::state_unloaded);
+
+  // a guess is not worth pushing out chunks already decompressed
+  req(chunk_cache_size + index.chunk_info_table[chunk_i].uncompressed_size <= chunk_cache_budget);
+
+  chunk_prefetches_pending++;
+  vsx_thread_pool<>::instance()->add(
+    vsx_thread_pool<>::low_priority,
+    [this, chunk_i]()
+    {
+      std::unique_lock<std::mutex> lock(chunk_cache_lock);
+      if (chunk_cache[chunk_i].state == chunk_cache_entry::state_unloaded)
+        chunk_load(chunk_i, lock);
+      chunk_prefetches_pending--;
+      chunk_cache_loaded.notify_all();
+    }
+  );
+}
+
+unsigned char* filesystem_archive_vsxz_reader::chunk_acquire(size_t chunk_i)
+{
+  std::unique_lock<std::mutex> lock(chunk_cache_lock);
+  chunk_cache_entry& entry = chunk_cache[chunk_i];
+  forever
+  {
+    if (entry.state == chunk_cache_entry::state_loaded)
+      break;
+
+    if (entry.state == chunk_cache_entry::state_unloaded)
+    {
+      chunk_load(chunk_i, lock);
+      continue;
+    }
+
+    // being decompressed by someone else
+    chunk_cache_loaded.wait(lock);
+  }
+  entry.references++;
+  entry.last_used = ++chunk_cache_tick;
+  return entry.data;
+}
+
+void filesystem_archive_vsxz_reader::chunk_release(size_t chunk_i)
+{
+  std::unique_lock<std::mutex> lock(chunk_cache_lock);
+  req(chunk_cache[chunk_i].references);
+  chunk_cache[chunk_i].references--;
+  chunk_cache_evict(0);
+}
+
 bool filesystem_archive_vsxz_reader::load(const char* archive_filename, bool load_data_multithreaded, uint64_t loading_flags)
 {
   VSX_UNUSED(load_data_multithreaded);
   reqrf(load_initial(archive_filename, loading_flags));
 
-  uint32_t offset_uncompressed = 0;
-  uint32_t offset_compressed = 0;
-  for (size_t chunk_i = 1; chunk_i < header->chunk_count; chunk_i++)
+  if (lazy)
   {
-    uncompressed_data_start_pointers[chunk_i] = uncompressed_data_start + offset_uncompressed;
-    vsx_thread_pool<>::instance()->add(
-      []
-      (
-        const vsxz_header_chunk_info& chunk,
-        unsigned char* compressed_data,
-        unsigned char* uncompressed_data
-      )
-      {
-        req(chunk.compressed_size);
-        req(chunk.compression_type);
-
-        vsx_ma_vector<unsigned char> compressed;
-        compressed.set_volatile();
-        compressed.set_data( compressed_data, chunk.compressed_size );
-
-        vsx_ma_vector<unsigned char> uncompressed;
-        uncompressed.set_volatile();
-        uncompressed.set_data( uncompressed_data, chunk.uncompressed_size );
-
-        if (chunk.compression_type == 1)
-          compression_lzma::uncompress(uncompressed, compressed);
-
-        if (chunk.compression_type == 2)
-          compression_lzham::uncompress(uncompressed, compressed);
-      },
-      chunk_info_table[chunk_i],
-      compressed_data_start + offset_compressed,
-      uncompressed_data_start + offset_uncompressed
-    );
-
-    offset_compressed += chunk_info_table[chunk_i].compressed_size;
-    offset_uncompressed += chunk_info_table[chunk_i].uncompressed_size;
+    load_lazy();
+    return true;
   }
-  vsx_thread_pool<>::instance()->wait_all(100);
+
+  load_chunks(*vsx_thread_pool<>::instance());
   return true;
 }
 
@@ -117,45 +237,13 @@ bool filesystem_archive_vsxz_reader::load(const char* archive_filename, vsx_thre
 {
   reqrf(load_initial(archive_filename, loading_flags));
 
-  uint32_t offset_uncompressed = 0;
-  uint32_t offset_compressed = 0;
-  for (size_t chunk_i = 1; chunk_i < header->chunk_count; chunk_i++)
+  if (lazy)
   {
-    uncompressed_data_start_pointers[chunk_i] = uncompressed_data_start + offset_uncompressed;
-    pool.add(
-      []
-      (
-        const vsxz_header_chunk_info& chunk,
-        unsigned char* compressed_data,
-        unsigned char* uncompressed_data
-      )
-      {
-        req(chunk.compressed_size);
-        req(chunk.compression_type);
-
-        vsx_ma_vector<unsigned char> compressed;
-        compressed.set_volatile();
-        compressed.set_data( compressed_data, chunk.compressed_size );
-
-        vsx_ma_vector<unsigned char> uncompressed;
-        uncompressed.set_volatile();
-        uncompressed.set_data( uncompressed_data, chunk.uncompressed_size );
-
-        if (chunk.compression_type == 1)
-          compression_lzma::uncompress(uncompressed, compressed);
-
-        if (chunk.compression_type == 2)
-          compression_lzham::uncompress(uncompressed, compressed);
-      },
-      chunk_info_table[chunk_i],
-      compressed_data_start + offset_compressed,
-      uncompressed_data_start + offset_uncompressed
-    );
-
-    offset_compressed += chunk_info_table[chunk_i].compressed_size;
-    offset_uncompressed += chunk_info_table[chunk_i].uncompressed_size;
+    load_lazy();
+    return true;
   }
-  pool.wait_all(100);
+
+  load_chunks(pool);
   return true;
 }
 
@@ -163,45 +251,13 @@ bool filesystem_archive_vsxz_reader::load(const char* archive_filename, vsx_thre
 {
   reqrf(load_initial(archive_filename, loading_flags));
 
-  uint32_t offset_uncompressed = 0;
-  uint32_t offset_compressed = 0;
-  for (size_t chunk_i = 1; chunk_i < header->chunk_count; chunk_i++)
+  if (lazy)
   {
-    uncompressed_data_start_pointers[chunk_i] = uncompressed_data_start + offset_uncompressed;
-    pool.add(
-      []
-      (
-        const vsxz_header_chunk_info& chunk,
-        unsigned char* compressed_data,
-        unsigned char* uncompressed_data
-      )
-      {
-        req(chunk.compressed_size);
-        req(chunk.compression_type);
-
-        vsx_ma_vector<unsigned char> compressed;
-        compressed.set_volatile();
-        compressed.set_data( compressed_data, chunk.compressed_size );
-
-        vsx_ma_vector<unsigned char> uncompressed;
-        uncompressed.set_volatile();
-        uncompressed.set_data( uncompressed_data, chunk.uncompressed_size );
-
-        if (chunk.compression_type == 1)
-          compression_lzma::uncompress(uncompressed, compressed);
-
-        if (chunk.compression_type == 2)
-          compression_lzham::uncompress(uncompressed, compressed);
-      },
-      chunk_info_table[chunk_i],
-      compressed_data_start + offset_compressed,
-      uncompressed_data_start + offset_uncompressed
-    );
-
-    offset_compressed += chunk_info_table[chunk_i].compressed_size;
-    offset_uncompressed += chunk_info_table[chunk_i].uncompressed_size;
+    load_lazy();
+    return true;
   }
-  pool.wait_all(100);
+
+  load_chunks(pool);
   return true;
 }
 
@@ -209,45 +265,13 @@ bool filesystem_archive_vsxz_reader::load(const char* archive_filename, vsx_thre
 {
   reqrf(load_initial(archive_filename, loading_flags));
 
-  uint32_t offset_uncompressed = 0;
-  uint32_t offset_compressed = 0;
-  for (size_t chunk_i = 1; chunk_i < header->chunk_count; chunk_i++)
+  if (lazy)
   {
-    uncompressed_data_start_pointers[chunk_i] = uncompressed_data_start + offset_uncompressed;
-    pool.add(
-      []
-      (
-        const vsxz_header_chunk_info& chunk,
-        unsigned char* compressed_data,
-        unsigned char* uncompressed_data
-      )
-      {
-        req(chunk.compressed_size);
-        req(chunk.compression_type);
-
-        vsx_ma_vector<unsigned char> compressed;
-        compressed.set_volatile();
-        compressed.set_data( compressed_data, chunk.compressed_size );
-
-        vsx_ma_vector<unsigned char> uncompressed;
-        uncompressed.set_volatile();
-        uncompressed.set_data( uncompressed_data, chunk.uncompressed_size );
-
-        if (chunk.compression_type == 1)
-          compression_lzma::uncompress(uncompressed, compressed);
-
-        if (chunk.compression_type == 2)
-          compression_lzham::uncompress(uncompressed, compressed);
-      },
-      chunk_info_table[chunk_i],
-      compressed_data_start + offset_compressed,
-      uncompressed_data_start + offset_uncompressed
-    );
-
-    offset_compressed += chunk_info_table[chunk_i].compressed_size;
-    offset_uncompressed += chunk_info_table[chunk_i].uncompressed_size;
+    load_lazy();
+    return true;
   }
-  pool.wait_all(100);
+
+  load_chunks(pool);
   return true;
 }
 
@@ -260,41 +284,75 @@ void filesystem_archive_vsxz_reader::file_open(const char* filename, file* &hand
     return;
   }
   file_info_table_index--;
+  if (file_info_table_index >= index.file_count)
+  {
+    handle = 0x0;
+    return;
+  }
 
-  vsxz_header_file_info* file_info = &file_info_table[file_info_table_index];
+  vsxz_header_file_info_v2* file_info = &index.file_info_table[file_info_table_index];
 
   unsigned char* data_ptr = uncompressed_data_start_pointers[file_info->chunk];
 
+  if (lazy)
+  {
+    data_ptr = chunk_acquire(file_info->chunk);
+    handle->archive_chunk = file_info->chunk;
+
+    // files are usually read in order, have the next chunk ready
+    chunk_prefetch(file_info->chunk + 1);
+  }
+
   handle->data.set_volatile();
   handle->data.set_data( data_ptr + file_info->offset, file_info->size );
   handle->size = file_info->size;
 }
 
+void filesystem_archive_vsxz_reader::file_close(file* handle)
+{
+  req(handle->archive_chunk != -1);
+  chunk_release(handle->archive_chunk);
+  handle->archive_chunk = -1;
+}
+
 void filesystem_archive_vsxz_reader::close()
 {
+  if (lazy)
+  {
+    std::unique_lock<std::mutex> lock(chunk_cache_lock);
+    chunk_cache_loaded.wait(lock, [this](){ return chunk_prefetches_pending == 0; });
+    for (size_t i = 1; i < chunk_cache.size(); i++)
+      if (chunk_cache[i].data)
+        free(chunk_cache[i].data);
+    chunk_cache.clear();
+    chunk_cache_size = 0;
+    lazy = false;
+  }
+
   filesystem_mmap::destroy(mmap);
 
 #if PLATFORM == PLATFORM_WINDOWS
   if ( !(loading_flags & VSX_FILESYSTEM_ARCHIVE_LOADING_FLAG_DO_NOT_COPY_MMAP_TO_RAM) )
-    if (uncompressed_data_start_pointers[0])
+    if (uncompressed_data_start_pointers.size() && uncompressed_data_start_pointers[0])
       free(uncompressed_data_start_pointers[0]);
 #endif
 
-  header = 0x0;
+  index.clear();
+  uncompressed_data_start_pointers.clear();
   uncompressed_data.clear();
 }
 
 
 bool filesystem_archive_vsxz_reader::is_archive()
 {
-  return header != 0x0;
+  return index.version != 0;
 }
 
 
 bool filesystem_archive_vsxz_reader::is_archive_populated()
 {
-  reqrv(header, false);
-  return header->file_count > 0;
+  reqrv(index.version, false);
+  return index.file_count > 0;
 }
 
 bool filesystem_archive_vsxz_reader::is_file(vsx_string<> filename)
@@ -309,11 +367,16 @@ void filesystem_archive_vsxz_reader::files_get(vsx_nw_vector<filesystem_archive_
   tree.get_filename_payload_list(filenames, file_info_table_indices);
   foreach (filenames, i)
   {
-    vsxz_header_file_info* file_info = &file_info_table[file_info_table_indices[i]];
+    // tree payloads are file info table index + 1
+    vsxz_header_file_info_v2* file_info = &index.file_info_table[file_info_table_indices[i] - 1];
 
     filesystem_archive_file_read read;
     unsigned char* data_ptr = uncompressed_data_start_pointers[file_info->chunk];
 
+    // the chunk stays until the archive is closed
+    if (lazy)
+      data_ptr = chunk_acquire(file_info->chunk);
+
     read.filename = filenames[i];
     read.uncompressed_data.set_volatile();
     read.uncompressed_data.set_data( data_ptr + file_info->offset, file_info->size );
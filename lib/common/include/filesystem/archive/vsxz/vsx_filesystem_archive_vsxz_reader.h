@@ -1,10 +1,13 @@
 #pragma once
 
+#include <mutex>
+#include <condition_variable>
 #include <container/vsx_ma_vector.h>
 #include <filesystem/mmap/vsx_filesystem_mmap.h>
 #include <filesystem/vsx_file.h>
 #include <filesystem/archive/vsx_filesystem_archive_reader_base.h>
 #include "vsx_filesystem_archive_vsxz_header.h"
+#include "vsx_filesystem_archive_vsxz_index.h"
 #include <filesystem/tree/vsx_filesystem_tree_reader.h>
 
 namespace vsx
@@ -13,27 +16,53 @@ namespace vsx
 class filesystem_archive_vsxz_reader
     : public filesystem_archive_reader_base
 {
-  struct uncompress_info
-  {
-    unsigned char* compressed_data;
-    unsigned char* uncompressed_data;
-    vsxz_header_file_info* file_info;
-  };
-
-  vsxz_header* header = 0x0;
   file_mmap* mmap = 0x0;
+  filesystem_archive_vsxz_index index;
   vsx_ma_vector<unsigned char> uncompressed_data;
   vsx_filesystem_tree_reader tree;
-  unsigned char* uncompressed_data_start_pointers[9] = {0,0,0,0,0,0,0,0,0};
-  vsxz_header_file_info* file_info_table = 0x0;
+  vsx_ma_vector<unsigned char*> uncompressed_data_start_pointers;
   uint64_t loading_flags;
 
   // loading
-  unsigned char* uncompressed_data_start = 0x0;
-  unsigned char* compressed_data_start = 0x0;
-  vsxz_header_chunk_info* chunk_info_table = 0x0;
   bool load_initial(const char* archive_filename, uint64_t loading_flags);
 
+  template<int Td>
+  void load_chunks(vsx_thread_pool<Td>& pool);
+
+  // lazy loading
+  struct chunk_cache_entry
+  {
+    enum state_t
+    {
+      state_unloaded,
+      state_loading,
+      state_loaded
+    };
+
+    state_t state = state_unloaded;
+    unsigned char* compressed_data = 0x0;
+    unsigned char* data = 0x0;
+    size_t references = 0; // open files in this chunk
+    uint64_t last_used = 0;
+  };
+
+  bool lazy = false;
+  vsx_nw_vector<chunk_cache_entry> chunk_cache;
+  std::mutex chunk_cache_lock;
+  std::condition_variable chunk_cache_loaded;
+  size_t chunk_cache_budget = 64 * 1024 * 1024;
+  size_t chunk_cache_size = 0;
+  uint64_t chunk_cache_tick = 0;
+  size_t chunk_prefetches_pending = 0;
+
+  static void chunk_uncompress(const vsxz_header_chunk_info_v2& chunk, unsigned char* compressed_data, unsigned char* uncompressed_data);
+  void load_lazy();
+  void chunk_load(size_t chunk_i, std::unique_lock<std::mutex>& lock);
+  void chunk_cache_evict(size_t keep_chunk_i);
+  void chunk_prefetch(size_t chunk_i);
+  unsigned char* chunk_acquire(size_t chunk_i);
+  void chunk_release(size_t chunk_i);
+
 public:
 
   bool load(const char* archive_filename, bool load_data_multithreaded, uint64_t loading_flags);
@@ -43,6 +72,14 @@ public:
 
   void files_get(vsx_nw_vector<filesystem_archive_file_read>& files);
   void file_open(const char* filename, file* &handle);
+  void file_close(file* handle);
+
+  // bytes of decompressed chunks kept around when loading lazily, chunks
+  // with open files are kept regardless
+  void set_chunk_cache_budget(size_t bytes)
+  {
+    chunk_cache_budget = bytes;
+  }
 
   void close();
 
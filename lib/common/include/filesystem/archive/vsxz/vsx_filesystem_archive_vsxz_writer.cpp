@@ -1,8 +1,9 @@
 #include <filesystem/archive/vsxz/vsx_filesystem_archive_vsxz_writer.h>
 #include <filesystem/vsx_filesystem_helper.h>
-#include <vsx_compression_lzma.h>
-#include <vsx_compression_lzham.h>
+#include <filesystem/archive/vsxz/vsx_filesystem_archive_entropy.h>
 #include <tools/vsx_thread_pool.h>
+#include <string/vsx_string_helper.h>
+#include <crypto/md5.h>
 #include <filesystem/archive/vsxz/vsx_filesystem_archive_vsxz_header.h>
 #include <filesystem/vsx_filesystem_identifier.h>
 #include <filesystem/tree/vsx_filesystem_tree_serialize_binary.h>
@@ -65,67 +66,84 @@ void filesystem_archive_vsxz_writer::archive_files_saturate_all()
   vsx_printf(L"reading all files from disk [DONE]\n");
 }
 
-void filesystem_archive_vsxz_writer::calculate_ratios()
+void filesystem_archive_vsxz_writer::find_duplicates()
 {
-  compression_ratios.allocate(archive_files.size() - 1);
-  compression_ratios.memory_clear();
+  duplicate_of.allocate(archive_files.size() - 1);
+  duplicate_count = 0;
+  duplicate_bytes = 0;
 
-  vsx_ma_vector<bool> is_processed;
-  is_processed.allocate(archive_files.size() - 1);
-  is_processed.memory_clear();
+  vsx_nw_vector<std::string> hashes;
+  hashes.allocate(archive_files.size() - 1);
 
+  // only our own hashes, not whatever else is in the pool
+  vsx_thread_pool<>::task_group group;
   foreach (archive_files, i)
   {
+    duplicate_of[i] = i;
+    group.run( [&, i]()
+      {
+        MD5 md5;
+        vsx_ma_vector<unsigned char>& data = archive_files[i].data;
+        // md5 takes 32-bit lengths
+        for (size_t offset = 0; offset < data.size(); offset += 0x40000000)
+        {
+          size_t length = data.size() - offset;
+          if (length > 0x40000000)
+            length = 0x40000000;
+          md5.update(data.get_pointer() + offset, (MD5::size_type)length);
+        }
+        hashes[i] = md5.finalize().hexdigest();
+      }
+    );
+  }
+  group.wait();
 
-    // look for largest file
-    size_t id_found = 0;
-    int64_t max_size_found = -1;
-    foreach (archive_files, si)
+  // confirm hash matches byte by byte
+  foreach (archive_files, i)
+    for_n(j, 0, i)
     {
-      if (is_processed[si])
+      if (duplicate_of[j] != j)
+        continue;
+      if (hashes[i] != hashes[j])
+        continue;
+      if (archive_files[i].data.size() != archive_files[j].data.size())
+        continue;
+      if (memcmp(archive_files[i].data.get_pointer(), archive_files[j].data.get_pointer(), archive_files[i].data.size()))
         continue;
 
-      int64_t cur_size = archive_files[si].data.size();
-      if (cur_size > max_size_found)
-      {
-        id_found = si;
-        max_size_found = cur_size;
-      }
+      vsx_printf(L"file %hs is a duplicate of %hs\n", archive_files[i].filename.c_str(), archive_files[j].filename.c_str());
+      duplicate_of[i] = j;
+      duplicate_count++;
+      duplicate_bytes += archive_files[i].data.size();
+      break;
     }
-    is_processed[id_found] = true;
+}
 
-    if (archive_files[id_found].data.size() <= 1024*1024)
-      break;
+void filesystem_archive_vsxz_writer::calculate_ratios()
+{
+  compression_ratios.allocate(archive_files.size() - 1);
+  compression_ratios.memory_clear();
 
-    compression_ratios[id_found] = 1.0f;
+  foreach (archive_files, i)
+  {
+    if (archive_files[i].data.size() <= 1024*1024)
+      continue;
+
+    if (duplicate_of[i] != i)
+      continue;
 
     if (!do_calculate_ratios)
     {
-      compression_ratios[id_found] = 0.5f;
+      compression_ratios[i] = 0.5f;
       continue;
     }
 
     req_continue(do_compress);
-    vsx_thread_pool<>::instance()->add( [&](float& ratio, size_t ai)
-      {
-        vsx_printf(L"calculating ratio for %hs\n", archive_files[ai].filename.c_str());
-        vsx_ma_vector<unsigned char> lzma_compressed = vsx::compression_lzma::compress( archive_files[ai].data );
-        float lzma_ratio = (float)(lzma_compressed.size()) / (float)(archive_files[ai].data.size());
-        vsx_ma_vector<unsigned char> lzham_compressed = vsx::compression_lzham::compress( archive_files[ai].data );
-        float lzham_ratio = (float)(lzham_compressed.size()) / (float)(archive_files[ai].data.size());
-        if (lzham_ratio < lzma_ratio)
-          ratio = lzham_ratio;
-        else
-          ratio = lzma_ratio;
-        vsx_printf(L"calculating ratio for %hs [DONE]\n", archive_files[ai].filename.c_str());
-      },
-      compression_ratios[id_found],
-      id_found
-    );
-  }
 
-  // wait until thread pool done
-  vsx_thread_pool<>::instance()->wait_all(100);
+    // order 0 entropy is a good enough estimate to tell compressed media from the rest
+    compression_ratios[i] = filesystem_archive_entropy(archive_files[i].data) / 8.0f;
+    vsx_printf(L"estimated ratio for %hs: %f\n", archive_files[i].filename.c_str(), compression_ratios[i]);
+  }
 }
 
 void filesystem_archive_vsxz_writer::add_files_to_chunk_space_evenly()
@@ -134,6 +152,12 @@ void filesystem_archive_vsxz_writer::add_files_to_chunk_space_evenly()
   is_processed.allocate(archive_files.size() - 1);
   is_processed.memory_clear();
 
+  // where each file ended up, for its duplicates
+  vsx_ma_vector<size_t> file_chunk;
+  vsx_ma_vector<size_t> file_position;
+  file_chunk.allocate(archive_files.size() - 1);
+  file_position.allocate(archive_files.size() - 1);
+
   foreach (archive_files, i)
   {
     // look for largest file
@@ -154,15 +178,19 @@ void filesystem_archive_vsxz_writer::add_files_to_chunk_space_evenly()
 
     is_processed[id_found] = true;
 
+    // added after all originals are placed
+    if (duplicate_of[id_found] != id_found)
+      continue;
+
+    size_t target_chunk = 2;
+
     // handle text file
     if (filesystem_identifier::is_text_file(archive_files[id_found].data, 256))
     {
-      chunks[1].add_file( &archive_files[id_found] );
-      is_processed[id_found] = true;
+      target_chunk = 1;
       vsx_printf(L"adding file %hs to text file chunk: 1\n", archive_files[id_found].filename.c_str());
-      continue;
     }
-
+    else
     // if file is large and has bad compression ratio add to uncompressed chunk
     if (
       !do_compress
@@ -174,32 +202,40 @@ void filesystem_archive_vsxz_writer::add_files_to_chunk_space_evenly()
       )
     )
     {
+      target_chunk = 0;
       vsx_printf(L"adding file %hs to chunk 0\n", archive_files[id_found].filename.c_str());
-      chunks[0].add_file( &archive_files[id_found] );
-      continue;
     }
-
-
-    // find out which chunk has least data in it
-    size_t target_chunk = 2;
-    uint64_t min_size = 0xffffffffffffffff;
-    for_n(ichunk, 2, max_chunks)
+    else
     {
-      if (!chunks[ichunk].is_size_above_treshold())
-      {
-        target_chunk = ichunk;
-        break;
-      }
-
-      if (chunks[ichunk].uncompressed_data.size() < min_size)
+      // find out which chunk has least data in it
+      uint64_t min_size = 0xffffffffffffffff;
+      for_n(ichunk, 2, max_chunks)
       {
-        target_chunk = ichunk;
-        min_size = chunks[ichunk].uncompressed_data.size();
+        if (!chunks[ichunk].is_size_above_treshold())
+        {
+          target_chunk = ichunk;
+          break;
+        }
+
+        if (chunks[ichunk].uncompressed_data.size() < min_size)
+        {
+          target_chunk = ichunk;
+          min_size = chunks[ichunk].uncompressed_data.size();
+        }
       }
+      vsx_printf(L"adding file %hs to chunk %lld\n", archive_files[id_found].filename.c_str(), target_chunk);
     }
 
-    vsx_printf(L"adding file %hs to chunk %lld\n", archive_files[id_found].filename.c_str(), target_chunk);
-    chunks[target_chunk].add_file( &archive_files[id_found] );
+    file_chunk[id_found] = target_chunk;
+    file_position[id_found] = chunks[target_chunk].add_file( &archive_files[id_found] );
+  }
+
+  foreach (archive_files, i)
+  {
+    size_t original = duplicate_of[i];
+    if (original == i)
+      continue;
+    chunks[file_chunk[original]].add_duplicate( &archive_files[i], file_position[original] );
   }
 
   foreach (is_processed, i)
@@ -215,7 +251,10 @@ void filesystem_archive_vsxz_writer::close()
   // Read all files from disk
   archive_files_saturate_all();
 
-  // Calculate compression ratios for all large files
+  // Identical files are stored once
+  find_duplicates();
+
+  // Estimate compression ratios for all large files
   calculate_ratios();
 
   // Add files to compression chunks
@@ -223,7 +262,7 @@ void filesystem_archive_vsxz_writer::close()
 
   // Set chunk id in all file info structs
   for_n(i, 0, max_chunks)
-    chunks[i].set_chunk_id((uint8_t)i);
+    chunks[i].set_chunk_id((uint32_t)i);
 
   // Add to file tree
   vsx_filesystem_tree_writer tree;
@@ -247,15 +286,21 @@ void filesystem_archive_vsxz_writer::close()
   vsx_ma_vector<unsigned char> tree_data = vsx_filesystem_tree_serialize_binary::serialize(tree);
 
   // Calculate & fill in header
-  vsxz_header header;
-  header.file_count = (uint32_t)archive_files.size();
-  header.chunk_count = (uint32_t)valid_chunk_index;
+  vsxz_header_v2 header;
+  header.file_count = archive_files.size();
+  header.chunk_count = valid_chunk_index;
 
   for_n(i, 0, max_chunks)
     header.compression_uncompressed_memory_size += chunks[i].get_compressed_uncompressed_size();
 
-  header.file_count = (uint32_t)archive_files.size();
-  header.tree_size = (uint32_t)tree_data.size();
+  header.tree_size = tree_data.get_sizeof();
+
+  // chunk data starts after all tables
+  uint64_t data_offset =
+      sizeof(vsxz_header_v2) +
+      header.tree_size +
+      sizeof(vsxz_header_file_info_v2) * header.file_count +
+      sizeof(vsxz_header_chunk_info_v2) * header.chunk_count;
 
 
 
@@ -264,7 +309,7 @@ void filesystem_archive_vsxz_writer::close()
 
   {
     // header:
-    fwrite(&header, sizeof(vsxz_header), 1, file);
+    fwrite(&header, sizeof(vsxz_header_v2), 1, file);
 
     // tree:
     fwrite(tree_data.get_pointer(), 1, tree_data.get_sizeof(), file);
@@ -274,17 +319,46 @@ void filesystem_archive_vsxz_writer::close()
       chunks[i].write_file_info_table(file);
 
     // chunk info table:
-    chunks[0].write_chunk_info_table(file, true);
-    chunks[1].write_chunk_info_table(file, true);
-    for_n(i, 2, max_chunks)
-      chunks[i].write_chunk_info_table(file);
+    chunks[0].write_chunk_info_table(file, data_offset, true);
+    chunks[1].write_chunk_info_table(file, data_offset, true);
+    for_n(i, 2, valid_chunk_index)
+      chunks[i].write_chunk_info_table(file, data_offset);
 
     // compressed data:
-    for_n(i, 0, max_chunks)
+    for_n(i, 0, valid_chunk_index)
       chunks[i].write_data(file);
   }
   fclose(file);
 }
 
+void filesystem_archive_vsxz_writer::get_statistics(vsx_nw_vector< vsx_string<> >& result)
+{
+  const char* type_names[] = {"stored", "lzma", "lzham"};
+  for_n(i, 0, max_chunks)
+  {
+    filesystem_archive_chunk_write& chunk = chunks[i];
+    if (!chunk.has_files())
+      continue;
+
+    float uncompressed_mb = (float)chunk.uncompressed_data.get_sizeof() / (1024.0f * 1024.0f);
+    float stored_mb = (float)chunk.get_stored_size() / (1024.0f * 1024.0f);
+    float ratio = uncompressed_mb > 0.0f ? stored_mb / uncompressed_mb : 1.0f;
+    float speed = chunk.compression_time > 0.0 ? uncompressed_mb / (float)chunk.compression_time : 0.0f;
+
+    result.push_back(
+      "chunk " + vsx_string_helper::st2s(i) +
+      ": " + type_names[chunk.compression_type] +
+      ", " + vsx_string_helper::st2s(chunk.file_info_table.size()) + " files" +
+      ", " + vsx_string_helper::f2s(uncompressed_mb, 2) + " MB -> " + vsx_string_helper::f2s(stored_mb, 2) + " MB" +
+      ", ratio " + vsx_string_helper::f2s(ratio, 3) +
+      (chunk.compression_time > 0.0 ? ", " + vsx_string_helper::f2s(speed, 2) + " MB/s" : vsx_string<>(""))
+    );
+  }
+
+  result.push_back(
+    "duplicates: " + vsx_string_helper::st2s(duplicate_count) + " files"
+    ", " + vsx_string_helper::f2s((float)duplicate_bytes / (1024.0f * 1024.0f), 2) + " MB saved"
+  );
 }
 
+}
@@ -25,8 +25,14 @@ class filesystem_archive_vsxz_writer
 
   vsx_ma_vector<float> compression_ratios;
 
+  // index of the first file with identical content, or the file itself
+  vsx_ma_vector<size_t> duplicate_of;
+  size_t duplicate_count = 0;
+  uint64_t duplicate_bytes = 0;
+
 
   void archive_files_saturate_all();
+  void find_duplicates();
   void calculate_ratios();
   void add_files_to_chunk_space_evenly();
   void file_add_all_worker(vsx_nw_vector<filesystem_archive_file_write*>* work_list);
@@ -49,6 +55,9 @@ public:
   void add_string(vsx_string<> filename, vsx_string<> payload, bool deferred_multithreaded);
   void close();
 
+  // human readable per chunk statistics, valid after close()
+  void get_statistics(vsx_nw_vector< vsx_string<> >& result);
+
   ~filesystem_archive_vsxz_writer()
   {}
 
@@ -17,6 +17,9 @@ namespace vsx
 
 
     vsx_ma_vector<unsigned char> data;
+
+    // archive chunk kept in memory for this file while it's open, -1 if none
+    int32_t archive_chunk = -1;
   };
 
 }
@@ -164,6 +164,9 @@ void filesystem::f_close(file* &handle)
 
   //open_files.erase(handle->filename);
 
+  if (archive.is_archive())
+    archive.file_close(handle);
+
   if (!archive.is_archive())
   {
     if (handle->handle)
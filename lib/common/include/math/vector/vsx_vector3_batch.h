@@ -0,0 +1,655 @@
+/**
+* Project: VSXu Engine: Realtime modular visual programming engine.
+*
+* This file is part of Vovoid VSXu Engine.
+*
+* @author Jonatan Wallmander, Robert Wenzel, Vovoid Media Technologies AB Copyright (C) 2003-2013
+* @see The GNU Lesser General Public License (LGPL)
+*
+* VSXu Engine is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include <math/vector/vsx_vector3.h>
+#include <math/quaternion/vsx_quaternion.h>
+#include <math/vsx_matrix.h>
+
+/*
+  Operations on arrays of vsx_vector3<float>, as stored in meshes and particle
+  systems (packed, 12 bytes per vector).
+
+  The implementation is picked once at runtime from what the CPU supports:
+  AVX (8 vectors per iteration), SSE (4), NEON (4) or plain C++.
+  Vectors are loaded and stored unaligned and the tail is done in plain C++,
+  so any count and any pointer works. Source and destination may be the same
+  array, but must not otherwise overlap.
+
+  transform() uses the same convention as vsx_matrix::multiply_vector.
+*/
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define VSX_VECTOR3_BATCH_X86
+  #include <immintrin.h>
+  #if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    #define VSX_VECTOR3_BATCH_TARGET_SSE
+    #define VSX_VECTOR3_BATCH_TARGET_AVX
+  #else
+    #define VSX_VECTOR3_BATCH_TARGET_SSE __attribute__((target("sse2")))
+    #define VSX_VECTOR3_BATCH_TARGET_AVX __attribute__((target("avx")))
+  #endif
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+  #define VSX_VECTOR3_BATCH_NEON
+  #include <arm_neon.h>
+#endif
+
+namespace vsx_vector3_batch
+{
+
+// rows of the upper 3x4 part of a matrix
+struct affine
+{
+  float m[12];
+
+  affine(const vsx_matrix<float>& mat)
+  {
+    memcpy(m, mat.m, sizeof(m));
+  }
+};
+
+struct implementation
+{
+  const char* name;
+  void (*transform)(const affine& a, const float* source, float* destination, size_t count);
+  void (*add)(const float* value, const float* source, float* destination, size_t count);
+  void (*multiply)(const float* value, const float* source, float* destination, size_t count);
+  void (*normalize)(const float* source, float* destination, size_t count);
+  void (*cross)(const float* a, const float* b, float* destination, size_t count);
+  void (*dot)(const float* a, const float* b, float* destination, size_t count);
+};
+
+namespace scalar
+{
+  inline void transform(const affine& a, const float* s, float* d, size_t count)
+  {
+    const float* m = a.m;
+    for (size_t i = 0; i < count; i++, s += 3, d += 3)
+    {
+      float x = s[0], y = s[1], z = s[2];
+      d[0] = m[0] * x + m[1] * y + m[2]  * z + m[3];
+      d[1] = m[4] * x + m[5] * y + m[6]  * z + m[7];
+      d[2] = m[8] * x + m[9] * y + m[10] * z + m[11];
+    }
+  }
+
+  inline void add(const float* v, const float* s, float* d, size_t count)
+  {
+    for (size_t i = 0; i < count; i++, s += 3, d += 3)
+    {
+      d[0] = s[0] + v[0];
+      d[1] = s[1] + v[1];
+      d[2] = s[2] + v[2];
+    }
+  }
+
+  inline void multiply(const float* v, const float* s, float* d, size_t count)
+  {
+    for (size_t i = 0; i < count; i++, s += 3, d += 3)
+    {
+      d[0] = s[0] * v[0];
+      d[1] = s[1] * v[1];
+      d[2] = s[2] * v[2];
+    }
+  }
+
+  inline void normalize(const float* s, float* d, size_t count)
+  {
+    for (size_t i = 0; i < count; i++, s += 3, d += 3)
+    {
+      float a = 1.0f / sqrtf(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+      d[0] = s[0] * a;
+      d[1] = s[1] * a;
+      d[2] = s[2] * a;
+    }
+  }
+
+  inline void cross(const float* a, const float* b, float* d, size_t count)
+  {
+    for (size_t i = 0; i < count; i++, a += 3, b += 3, d += 3)
+    {
+      float x = a[1] * b[2] - a[2] * b[1];
+      float y = a[2] * b[0] - a[0] * b[2];
+      float z = a[0] * b[1] - a[1] * b[0];
+      d[0] = x;
+      d[1] = y;
+      d[2] = z;
+    }
+  }
+
+  inline void dot(const float* a, const float* b, float* d, size_t count)
+  {
+    for (size_t i = 0; i < count; i++, a += 3, b += 3)
+      d[i] = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+  }
+
+  inline const implementation* get()
+  {
+    static const implementation i = { "scalar", transform, add, multiply, normalize, cross, dot };
+    return &i;
+  }
+}
+
+#ifdef VSX_VECTOR3_BATCH_X86
+
+/*
+  4 packed vectors are 3 registers: x0y0z0x1 y1z1x2y2 z2x3y3z3
+  which are shuffled into x0x1x2x3 y0y1y2y3 z0z1z2z3 and back.
+  The AVX version does the same in both 128-bit lanes, 8 vectors at a time.
+*/
+namespace sse
+{
+  VSX_VECTOR3_BATCH_TARGET_SSE
+  inline void load(const float* p, __m128& x, __m128& y, __m128& z)
+  {
+    __m128 a = _mm_loadu_ps(p);
+    __m128 b = _mm_loadu_ps(p + 4);
+    __m128 c = _mm_loadu_ps(p + 8);
+    __m128 xy = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2)); // x2 y2 x3 y3
+    __m128 yz = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1)); // y0 z0 y1 z1
+    x = _mm_shuffle_ps(a, xy, _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    z = _mm_shuffle_ps(yz, c, _MM_SHUFFLE(3, 0, 3, 1));
+  }
+
+  VSX_VECTOR3_BATCH_TARGET_SSE
+  inline void store(float* p, __m128 x, __m128 y, __m128 z)
+  {
+    __m128 xy = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0)); // x0 x2 y0 y2
+    __m128 yz = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1)); // y1 y3 z1 z3
+    __m128 zx = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0)); // z0 z2 x1 x3
+    _mm_storeu_ps(p,     _mm_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(p + 4, _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0)));
+    _mm_storeu_ps(p + 8, _mm_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+
+  VSX_VECTOR3_BATCH_TARGET_SSE
+  inline void transform(const affine& a, const float* s, float* d, size_t count)
+  {
+    const float* m = a.m;
+    __m128 c0 = _mm_set1_ps(m[0]), c1 = _mm_set1_ps(m[1]), c2  = _mm_set1_ps(m[2]),  c3  = _mm_set1_ps(m[3]);
+    __m128 c4 = _mm_set1_ps(m[4]), c5 = _mm_set1_ps(m[5]), c6  = _mm_set1_ps(m[6]),  c7  = _mm_set1_ps(m[7]);
+    __m128 c8 = _mm_set1_ps(m[8]), c9 = _mm_set1_ps(m[9]), c10 = _mm_set1_ps(m[10]), c11 = _mm_set1_ps(m[11]);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, s += 12, d += 12)
+    {
+      __m128 x, y, z;
+      load(s, x, y, z);
+      __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, x), _mm_mul_ps(c1, y)), _mm_add_ps(_mm_mul_ps(c2,  z), c3));
+      __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c4, x), _mm_mul_ps(c5, y)), _mm_add_ps(_mm_mul_ps(c6,  z), c7));
+      __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c8, x), _mm_mul_ps(c9, y)), _mm_add_ps(_mm_mul_ps(c10, z), c11));
+      store(d, rx, ry, rz);
+    }
+    scalar::transform(a, s, d, count - i);
+  }
+
+  // the value repeated over 3 registers lines up with 4 packed vectors
+  VSX_VECTOR3_BATCH_TARGET_SSE
+  inline void add(const float* v, const float* s, float* d, size_t count)
+  {
+    __m128 a = _mm_setr_ps(v[0], v[1], v[2], v[0]);
+    __m128 b = _mm_setr_ps(v[1], v[2], v[0], v[1]);
+    __m128 c = _mm_setr_ps(v[2], v[0], v[1], v[2]);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, s += 12, d += 12)
+    {
+      _mm_storeu_ps(d,     _mm_add_ps(_mm_loadu_ps(s),     a));
+      _mm_storeu_ps(d + 4, _mm_add_ps(_mm_loadu_ps(s + 4), b));
+      _mm_storeu_ps(d + 8, _mm_add_ps(_mm_loadu_ps(s + 8), c));
+    }
+    scalar::add(v, s, d, count - i);
+  }
+
+  VSX_VECTOR3_BATCH_TARGET_SSE
+  inline void multiply(const float* v, const float* s, float* d, size_t count)
+  {
+    __m128 a = _mm_setr_ps(v[0], v[1], v[2], v[0]);
+    __m128 b = _mm_setr_ps(v[1], v[2], v[0], v[1]);
+    __m128 c = _mm_setr_ps(v[2], v[0], v[1], v[2]);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, s += 12, d += 12)
+    {
+      _mm_storeu_ps(d,     _mm_mul_ps(_mm_loadu_ps(s),     a));
+      _mm_storeu_ps(d + 4, _mm_mul_ps(_mm_loadu_ps(s + 4), b));
+      _mm_storeu_ps(d + 8, _mm_mul_ps(_mm_loadu_ps(s + 8), c));
+    }
+    scalar::multiply(v, s, d, count - i);
+  }
+
+  VSX_VECTOR3_BATCH_TARGET_SSE
+  inline void normalize(const float* s, float* d, size_t count)
+  {
+    __m128 one = _mm_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, s += 12, d += 12)
+    {
+      __m128 x, y, z;
+      load(s, x, y, z);
+      __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+      __m128 a = _mm_div_ps(one, len);
+      store(d, _mm_mul_ps(x, a), _mm_mul_ps(y, a), _mm_mul_ps(z, a));
+    }
+    scalar::normalize(s, d, count - i);
+  }
+
+  VSX_VECTOR3_BATCH_TARGET_SSE
+  inline void cross(const float* a, const float* b, float* d, size_t count)
+  {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, a += 12, b += 12, d += 12)
+    {
+      __m128 ax, ay, az, bx, by, bz;
+      load(a, ax, ay, az);
+      load(b, bx, by, bz);
+      store(
+        d,
+        _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by)),
+        _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz)),
+        _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx))
+      );
+    }
+    scalar::cross(a, b, d, count - i);
+  }
+
+  VSX_VECTOR3_BATCH_TARGET_SSE
+  inline void dot(const float* a, const float* b, float* d, size_t count)
+  {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, a += 12, b += 12)
+    {
+      __m128 ax, ay, az, bx, by, bz;
+      load(a, ax, ay, az);
+      load(b, bx, by, bz);
+      _mm_storeu_ps(d + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz)));
+    }
+    scalar::dot(a, b, d + i, count - i);
+  }
+
+  inline const implementation* get()
+  {
+    static const implementation i = { "sse", transform, add, multiply, normalize, cross, dot };
+    return &i;
+  }
+}
+
+namespace avx
+{
+  VSX_VECTOR3_BATCH_TARGET_AVX
+  inline void load(const float* p, __m256& x, __m256& y, __m256& z)
+  {
+    __m256 a = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)),     _mm_loadu_ps(p + 12), 1);
+    __m256 b = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 4)), _mm_loadu_ps(p + 16), 1);
+    __m256 c = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 8)), _mm_loadu_ps(p + 20), 1);
+    __m256 xy = _mm256_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+    __m256 yz = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));
+    x = _mm256_shuffle_ps(a, xy, _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    z = _mm256_shuffle_ps(yz, c, _MM_SHUFFLE(3, 0, 3, 1));
+  }
+
+  VSX_VECTOR3_BATCH_TARGET_AVX
+  inline void store(float* p, __m256 x, __m256 y, __m256 z)
+  {
+    __m256 xy = _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+    __m256 yz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+    __m256 zx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+    __m256 a = _mm256_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0));
+    __m256 b = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    __m256 c = _mm256_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1));
+    _mm_storeu_ps(p,      _mm256_castps256_ps128(a));
+    _mm_storeu_ps(p + 4,  _mm256_castps256_ps128(b));
+    _mm_storeu_ps(p + 8,  _mm256_castps256_ps128(c));
+    _mm_storeu_ps(p + 12, _mm256_extractf128_ps(a, 1));
+    _mm_storeu_ps(p + 16, _mm256_extractf128_ps(b, 1));
+    _mm_storeu_ps(p + 20, _mm256_extractf128_ps(c, 1));
+  }
+
+  VSX_VECTOR3_BATCH_TARGET_AVX
+  inline void transform(const affine& a, const float* s, float* d, size_t count)
+  {
+    const float* m = a.m;
+    __m256 c0 = _mm256_set1_ps(m[0]), c1 = _mm256_set1_ps(m[1]), c2  = _mm256_set1_ps(m[2]),  c3  = _mm256_set1_ps(m[3]);
+    __m256 c4 = _mm256_set1_ps(m[4]), c5 = _mm256_set1_ps(m[5]), c6  = _mm256_set1_ps(m[6]),  c7  = _mm256_set1_ps(m[7]);
+    __m256 c8 = _mm256_set1_ps(m[8]), c9 = _mm256_set1_ps(m[9]), c10 = _mm256_set1_ps(m[10]), c11 = _mm256_set1_ps(m[11]);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8, s += 24, d += 24)
+    {
+      __m256 x, y, z;
+      load(s, x, y, z);
+      __m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c0, x), _mm256_mul_ps(c1, y)), _mm256_add_ps(_mm256_mul_ps(c2,  z), c3));
+      __m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c4, x), _mm256_mul_ps(c5, y)), _mm256_add_ps(_mm256_mul_ps(c6,  z), c7));
+      __m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c8, x), _mm256_mul_ps(c9, y)), _mm256_add_ps(_mm256_mul_ps(c10, z), c11));
+      store(d, rx, ry, rz);
+    }
+    sse::transform(a, s, d, count - i);
+  }
+
+  // 8 packed vectors are 24 floats, the value pattern repeats every 12
+  VSX_VECTOR3_BATCH_TARGET_AVX
+  inline void add(const float* v, const float* s, float* d, size_t count)
+  {
+    __m256 a = _mm256_setr_ps(v[0], v[1], v[2], v[0], v[1], v[2], v[0], v[1]);
+    __m256 b = _mm256_setr_ps(v[2], v[0], v[1], v[2], v[0], v[1], v[2], v[0]);
+    __m256 c = _mm256_setr_ps(v[1], v[2], v[0], v[1], v[2], v[0], v[1], v[2]);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8, s += 24, d += 24)
+    {
+      _mm256_storeu_ps(d,      _mm256_add_ps(_mm256_loadu_ps(s),      a));
+      _mm256_storeu_ps(d + 8,  _mm256_add_ps(_mm256_loadu_ps(s + 8),  b));
+      _mm256_storeu_ps(d + 16, _mm256_add_ps(_mm256_loadu_ps(s + 16), c));
+    }
+    sse::add(v, s, d, count - i);
+  }
+
+  VSX_VECTOR3_BATCH_TARGET_AVX
+  inline void multiply(const float* v, const float* s, float* d, size_t count)
+  {
+    __m256 a = _mm256_setr_ps(v[0], v[1], v[2], v[0], v[1], v[2], v[0], v[1]);
+    __m256 b = _mm256_setr_ps(v[2], v[0], v[1], v[2], v[0], v[1], v[2], v[0]);
+    __m256 c = _mm256_setr_ps(v[1], v[2], v[0], v[1], v[2], v[0], v[1], v[2]);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8, s += 24, d += 24)
+    {
+      _mm256_storeu_ps(d,      _mm256_mul_ps(_mm256_loadu_ps(s),      a));
+      _mm256_storeu_ps(d + 8,  _mm256_mul_ps(_mm256_loadu_ps(s + 8),  b));
+      _mm256_storeu_ps(d + 16, _mm256_mul_ps(_mm256_loadu_ps(s + 16), c));
+    }
+    sse::multiply(v, s, d, count - i);
+  }
+
+  VSX_VECTOR3_BATCH_TARGET_AVX
+  inline void normalize(const float* s, float* d, size_t count)
+  {
+    __m256 one = _mm256_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8, s += 24, d += 24)
+    {
+      __m256 x, y, z;
+      load(s, x, y, z);
+      __m256 len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+      __m256 a = _mm256_div_ps(one, len);
+      store(d, _mm256_mul_ps(x, a), _mm256_mul_ps(y, a), _mm256_mul_ps(z, a));
+    }
+    sse::normalize(s, d, count - i);
+  }
+
+  VSX_VECTOR3_BATCH_TARGET_AVX
+  inline void cross(const float* a, const float* b, float* d, size_t count)
+  {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8, a += 24, b += 24, d += 24)
+    {
+      __m256 ax, ay, az, bx, by, bz;
+      load(a, ax, ay, az);
+      load(b, bx, by, bz);
+      store(
+        d,
+        _mm256_sub_ps(_mm256_mul_ps(ay, bz), _mm256_mul_ps(az, by)),
+        _mm256_sub_ps(_mm256_mul_ps(az, bx), _mm256_mul_ps(ax, bz)),
+        _mm256_sub_ps(_mm256_mul_ps(ax, by), _mm256_mul_ps(ay, bx))
+      );
+    }
+    sse::cross(a, b, d, count - i);
+  }
+
+  VSX_VECTOR3_BATCH_TARGET_AVX
+  inline void dot(const float* a, const float* b, float* d, size_t count)
+  {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8, a += 24, b += 24)
+    {
+      __m256 ax, ay, az, bx, by, bz;
+      load(a, ax, ay, az);
+      load(b, bx, by, bz);
+      _mm256_storeu_ps(d + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz)));
+    }
+    sse::dot(a, b, d + i, count - i);
+  }
+
+  inline const implementation* get()
+  {
+    static const implementation i = { "avx", transform, add, multiply, normalize, cross, dot };
+    return &i;
+  }
+
+  inline bool supported()
+  {
+    #if defined(_MSC_VER) && !defined(__clang__)
+      int regs[4];
+      __cpuid(regs, 1);
+      bool osxsave = (regs[2] & (1 << 27)) != 0;
+      bool avx = (regs[2] & (1 << 28)) != 0;
+      if (!osxsave || !avx)
+        return false;
+      // the OS saves the ymm registers
+      return (_xgetbv(0) & 6) == 6;
+    #else
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx");
+    #endif
+  }
+}
+
+#endif
+
+#ifdef VSX_VECTOR3_BATCH_NEON
+
+// vld3q / vst3q do the interleaving of packed vectors in hardware
+namespace neon
+{
+  inline void transform(const affine& a, const float* s, float* d, size_t count)
+  {
+    const float* m = a.m;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, s += 12, d += 12)
+    {
+      float32x4x3_t v = vld3q_f32(s);
+      float32x4x3_t r;
+      r.val[0] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m[3]),  v.val[0], m[0]), v.val[1], m[1]), v.val[2], m[2]);
+      r.val[1] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m[7]),  v.val[0], m[4]), v.val[1], m[5]), v.val[2], m[6]);
+      r.val[2] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m[11]), v.val[0], m[8]), v.val[1], m[9]), v.val[2], m[10]);
+      vst3q_f32(d, r);
+    }
+    scalar::transform(a, s, d, count - i);
+  }
+
+  inline void add(const float* v, const float* s, float* d, size_t count)
+  {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, s += 12, d += 12)
+    {
+      float32x4x3_t r = vld3q_f32(s);
+      r.val[0] = vaddq_f32(r.val[0], vdupq_n_f32(v[0]));
+      r.val[1] = vaddq_f32(r.val[1], vdupq_n_f32(v[1]));
+      r.val[2] = vaddq_f32(r.val[2], vdupq_n_f32(v[2]));
+      vst3q_f32(d, r);
+    }
+    scalar::add(v, s, d, count - i);
+  }
+
+  inline void multiply(const float* v, const float* s, float* d, size_t count)
+  {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, s += 12, d += 12)
+    {
+      float32x4x3_t r = vld3q_f32(s);
+      r.val[0] = vmulq_n_f32(r.val[0], v[0]);
+      r.val[1] = vmulq_n_f32(r.val[1], v[1]);
+      r.val[2] = vmulq_n_f32(r.val[2], v[2]);
+      vst3q_f32(d, r);
+    }
+    scalar::multiply(v, s, d, count - i);
+  }
+
+  inline void normalize(const float* s, float* d, size_t count)
+  {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, s += 12, d += 12)
+    {
+      float32x4x3_t r = vld3q_f32(s);
+      float32x4_t len = vsqrtq_f32(vmlaq_f32(vmlaq_f32(vmulq_f32(r.val[0], r.val[0]), r.val[1], r.val[1]), r.val[2], r.val[2]));
+      float32x4_t a = vdivq_f32(vdupq_n_f32(1.0f), len);
+      r.val[0] = vmulq_f32(r.val[0], a);
+      r.val[1] = vmulq_f32(r.val[1], a);
+      r.val[2] = vmulq_f32(r.val[2], a);
+      vst3q_f32(d, r);
+    }
+    scalar::normalize(s, d, count - i);
+  }
+
+  inline void cross(const float* a, const float* b, float* d, size_t count)
+  {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, a += 12, b += 12, d += 12)
+    {
+      float32x4x3_t va = vld3q_f32(a);
+      float32x4x3_t vb = vld3q_f32(b);
+      float32x4x3_t r;
+      r.val[0] = vmlsq_f32(vmulq_f32(va.val[1], vb.val[2]), va.val[2], vb.val[1]);
+      r.val[1] = vmlsq_f32(vmulq_f32(va.val[2], vb.val[0]), va.val[0], vb.val[2]);
+      r.val[2] = vmlsq_f32(vmulq_f32(va.val[0], vb.val[1]), va.val[1], vb.val[0]);
+      vst3q_f32(d, r);
+    }
+    scalar::cross(a, b, d, count - i);
+  }
+
+  inline void dot(const float* a, const float* b, float* d, size_t count)
+  {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, a += 12, b += 12)
+    {
+      float32x4x3_t va = vld3q_f32(a);
+      float32x4x3_t vb = vld3q_f32(b);
+      vst1q_f32(d + i, vmlaq_f32(vmlaq_f32(vmulq_f32(va.val[0], vb.val[0]), va.val[1], vb.val[1]), va.val[2], vb.val[2]));
+    }
+    scalar::dot(a, b, d + i, count - i);
+  }
+
+  inline const implementation* get()
+  {
+    static const implementation i = { "neon", transform, add, multiply, normalize, cross, dot };
+    return &i;
+  }
+}
+
+#endif
+
+inline const implementation* detect()
+{
+  #ifdef VSX_VECTOR3_BATCH_X86
+    if (avx::supported())
+      return avx::get();
+    return sse::get();
+  #elif defined(VSX_VECTOR3_BATCH_NEON)
+    return neon::get();
+  #else
+    return scalar::get();
+  #endif
+}
+
+inline const implementation*& current()
+{
+  static const implementation* i = detect();
+  return i;
+}
+
+// override the detected implementation, for testing and benchmarking
+inline void set_implementation(const implementation* i)
+{
+  current() = i ? i : detect();
+}
+
+inline const char* get_implementation_name()
+{
+  return current()->name;
+}
+
+// vsx_vector3 is packed, so its alignment is 1. Arrays of them come from
+// the vsx containers, which align the storage far beyond a float, so the
+// floats are read in place. The kernels load unaligned anyway. Copying
+// the pointer drops the packed type without a cast.
+inline const float* f(const vsx_vector3<float>* v)
+{
+  const float* result;
+  memcpy(&result, &v, sizeof(result));
+  return result;
+}
+
+inline float* f(vsx_vector3<float>* v)
+{
+  float* result;
+  memcpy(&result, &v, sizeof(result));
+  return result;
+}
+
+// destination[i] = matrix.multiply_vector(source[i])
+inline void transform(const vsx_matrix<float>& matrix, const vsx_vector3<float>* source, vsx_vector3<float>* destination, size_t count)
+{
+  current()->transform(affine(matrix), f(source), f(destination), count);
+}
+
+// destination[i] = rotation.matrix().multiply_vector(source[i]), rotation is normalized
+inline void rotate(vsx_quaternion<float> rotation, const vsx_vector3<float>* source, vsx_vector3<float>* destination, size_t count)
+{
+  current()->transform(affine(rotation.matrix()), f(source), f(destination), count);
+}
+
+// destination[i] = source[i] + value
+inline void translate(const vsx_vector3<float>& value, const vsx_vector3<float>* source, vsx_vector3<float>* destination, size_t count)
+{
+  float v[3] = { value.x, value.y, value.z };
+  current()->add(v, f(source), f(destination), count);
+}
+
+// destination[i] = source[i] * value, per component
+inline void scale(const vsx_vector3<float>& value, const vsx_vector3<float>* source, vsx_vector3<float>* destination, size_t count)
+{
+  float v[3] = { value.x, value.y, value.z };
+  current()->multiply(v, f(source), f(destination), count);
+}
+
+inline void normalize(const vsx_vector3<float>* source, vsx_vector3<float>* destination, size_t count)
+{
+  current()->normalize(f(source), f(destination), count);
+}
+
+// destination[i] = a[i] x b[i]
+inline void cross(const vsx_vector3<float>* a, const vsx_vector3<float>* b, vsx_vector3<float>* destination, size_t count)
+{
+  current()->cross(f(a), f(b), f(destination), count);
+}
+
+// destination[i] = a[i] . b[i]
+inline void dot(const vsx_vector3<float>* a, const vsx_vector3<float>* b, float* destination, size_t count)
+{
+  current()->dot(f(a), f(b), destination, count);
+}
+
+}
@@ -0,0 +1,265 @@
+/**
+* Project: VSXu Engine: Realtime modular visual programming engine.
+*
+* This file is part of Vovoid VSXu Engine.
+*
+* @author Jonatan Wallmander, Robert Wenzel, Vovoid Media Technologies AB Copyright (C) 2003-2013
+* @see The GNU Lesser General Public License (LGPL)
+*
+* VSXu Engine is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <container/vsx_ma_vector.h>
+#include <tools/vsx_thread_pool.h>
+
+template<typename T>
+class vsx_particle;
+
+// every per-particle field, one array each
+#define VSX_PARTICLE_SOA_FIELDS(F) \
+  F(T, pos_x) F(T, pos_y) F(T, pos_z) \
+  F(T, creation_pos_x) F(T, creation_pos_y) F(T, creation_pos_z) \
+  F(T, speed_x) F(T, speed_y) F(T, speed_z) \
+  F(T, color_r) F(T, color_g) F(T, color_b) F(T, color_a) \
+  F(T, color_end_r) F(T, color_end_g) F(T, color_end_b) F(T, color_end_a) \
+  F(T, rotation_x) F(T, rotation_y) F(T, rotation_z) F(T, rotation_w) \
+  F(T, rotation_dir_x) F(T, rotation_dir_y) F(T, rotation_dir_z) F(T, rotation_dir_w) \
+  F(float, orig_size) F(float, size) F(float, time) F(float, lifetime) F(float, one_div_lifetime) \
+  F(int, grounded)
+
+/*
+  Particles stored as one array per field (structure of arrays), so a modifier
+  only reads and writes the fields it uses, and loops over them vectorize.
+
+  Every array starts on a 64 byte boundary and capacity is kept a multiple of
+  chunk_granularity, so chunks handed to different threads never share a cache
+  line. Contents are kept when resizing, new particles are zeroed.
+
+  The AoS vsx_particle array of a particle system is kept in step through
+  from_aos() / to_aos(), see vsx_particlesystem.
+*/
+template<typename T = float>
+class vsx_particle_soa
+{
+public:
+
+  static const size_t alignment = 64;
+  static const size_t chunk_granularity = 16;
+
+  // which representation was written to last
+  enum sync_state
+  {
+    in_sync,
+    aos_changed,
+    soa_changed
+  };
+
+  sync_state state = aos_changed;
+
+  #define VSX_PARTICLE_SOA_DECLARE(type, name) type* name = 0x0;
+  VSX_PARTICLE_SOA_FIELDS(VSX_PARTICLE_SOA_DECLARE)
+  #undef VSX_PARTICLE_SOA_DECLARE
+
+private:
+
+  size_t count = 0;
+  size_t capacity = 0;
+  unsigned char* block = 0x0;
+
+  static size_t align(size_t value)
+  {
+    return (value + alignment - 1) & ~(alignment - 1);
+  }
+
+  void reallocate(size_t new_capacity)
+  {
+    size_t block_size = 0;
+    #define VSX_PARTICLE_SOA_SIZE(type, name) block_size += align(sizeof(type) * new_capacity);
+    VSX_PARTICLE_SOA_FIELDS(VSX_PARTICLE_SOA_SIZE)
+    #undef VSX_PARTICLE_SOA_SIZE
+
+    unsigned char* new_block = (unsigned char*)calloc(block_size + alignment, 1);
+    unsigned char* p = (unsigned char*)align((size_t)new_block);
+
+    #define VSX_PARTICLE_SOA_MOVE(type, name) \
+      if (count) \
+        memcpy(p, name, sizeof(type) * count); \
+      name = (type*)p; \
+      p += align(sizeof(type) * new_capacity);
+    VSX_PARTICLE_SOA_FIELDS(VSX_PARTICLE_SOA_MOVE)
+    #undef VSX_PARTICLE_SOA_MOVE
+
+    free(block);
+    block = new_block;
+    capacity = new_capacity;
+  }
+
+public:
+
+  vsx_particle_soa()
+  {
+  }
+
+  vsx_particle_soa(const vsx_particle_soa&) = delete;
+  vsx_particle_soa& operator=(const vsx_particle_soa&) = delete;
+
+  ~vsx_particle_soa()
+  {
+    free(block);
+  }
+
+  inline size_t get_count()
+  {
+    return count;
+  }
+
+  void resize(size_t new_count)
+  {
+    if (new_count > capacity)
+    {
+      size_t new_capacity = capacity + (capacity >> 1);
+      if (new_capacity < new_count)
+        new_capacity = new_count;
+      new_capacity = (new_capacity + chunk_granularity - 1) & ~(chunk_granularity - 1);
+      reallocate(new_capacity);
+    }
+
+    // particles beyond the old count start out zeroed
+    if (new_count > count)
+    {
+      #define VSX_PARTICLE_SOA_CLEAR(type, name) memset(name + count, 0, sizeof(type) * (new_count - count));
+      VSX_PARTICLE_SOA_FIELDS(VSX_PARTICLE_SOA_CLEAR)
+      #undef VSX_PARTICLE_SOA_CLEAR
+    }
+    count = new_count;
+  }
+
+  void from_aos(vsx_ma_vector< vsx_particle<T> >& particles)
+  {
+    resize(particles.size());
+    vsx_particle<T>* p = particles.get_pointer();
+    for (size_t i = 0; i < count; i++)
+    {
+      pos_x[i] = p[i].pos.x;
+      pos_y[i] = p[i].pos.y;
+      pos_z[i] = p[i].pos.z;
+      creation_pos_x[i] = p[i].creation_pos.x;
+      creation_pos_y[i] = p[i].creation_pos.y;
+      creation_pos_z[i] = p[i].creation_pos.z;
+      speed_x[i] = p[i].speed.x;
+      speed_y[i] = p[i].speed.y;
+      speed_z[i] = p[i].speed.z;
+      color_r[i] = p[i].color.r;
+      color_g[i] = p[i].color.g;
+      color_b[i] = p[i].color.b;
+      color_a[i] = p[i].color.a;
+      color_end_r[i] = p[i].color_end.r;
+      color_end_g[i] = p[i].color_end.g;
+      color_end_b[i] = p[i].color_end.b;
+      color_end_a[i] = p[i].color_end.a;
+      rotation_x[i] = p[i].rotation.x;
+      rotation_y[i] = p[i].rotation.y;
+      rotation_z[i] = p[i].rotation.z;
+      rotation_w[i] = p[i].rotation.w;
+      rotation_dir_x[i] = p[i].rotation_dir.x;
+      rotation_dir_y[i] = p[i].rotation_dir.y;
+      rotation_dir_z[i] = p[i].rotation_dir.z;
+      rotation_dir_w[i] = p[i].rotation_dir.w;
+      orig_size[i] = p[i].orig_size;
+      size[i] = p[i].size;
+      time[i] = p[i].time;
+      lifetime[i] = p[i].lifetime;
+      one_div_lifetime[i] = p[i].one_div_lifetime;
+      grounded[i] = p[i].grounded;
+    }
+  }
+
+  void to_aos(vsx_ma_vector< vsx_particle<T> >& particles)
+  {
+    if (count)
+      particles.allocate(count - 1);
+    particles.reset_used(count);
+    vsx_particle<T>* p = particles.get_pointer();
+    for (size_t i = 0; i < count; i++)
+    {
+      p[i].pos.x = pos_x[i];
+      p[i].pos.y = pos_y[i];
+      p[i].pos.z = pos_z[i];
+      p[i].creation_pos.x = creation_pos_x[i];
+      p[i].creation_pos.y = creation_pos_y[i];
+      p[i].creation_pos.z = creation_pos_z[i];
+      p[i].speed.x = speed_x[i];
+      p[i].speed.y = speed_y[i];
+      p[i].speed.z = speed_z[i];
+      p[i].color.r = color_r[i];
+      p[i].color.g = color_g[i];
+      p[i].color.b = color_b[i];
+      p[i].color.a = color_a[i];
+      p[i].color_end.r = color_end_r[i];
+      p[i].color_end.g = color_end_g[i];
+      p[i].color_end.b = color_end_b[i];
+      p[i].color_end.a = color_end_a[i];
+      p[i].rotation.x = rotation_x[i];
+      p[i].rotation.y = rotation_y[i];
+      p[i].rotation.z = rotation_z[i];
+      p[i].rotation.w = rotation_w[i];
+      p[i].rotation_dir.x = rotation_dir_x[i];
+      p[i].rotation_dir.y = rotation_dir_y[i];
+      p[i].rotation_dir.z = rotation_dir_z[i];
+      p[i].rotation_dir.w = rotation_dir_w[i];
+      p[i].orig_size = orig_size[i];
+      p[i].size = size[i];
+      p[i].time = time[i];
+      p[i].lifetime = lifetime[i];
+      p[i].one_div_lifetime = one_div_lifetime[i];
+      p[i].grounded = grounded[i];
+    }
+  }
+
+  /*
+    Calls f(begin, end) for chunks covering all particles, on the thread pool
+    when there are enough of them. The calling thread works on chunks too and
+    returns when all are done. f must only touch its own range.
+  */
+  template<typename F>
+  void for_each_chunk(F f, size_t chunk_size = 16384)
+  {
+    chunk_size = (chunk_size + chunk_granularity - 1) & ~(chunk_granularity - 1);
+    size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+    if (chunk_count < 2)
+    {
+      if (count)
+        f((size_t)0, count);
+      return;
+    }
+
+    size_t total = count;
+    vsx_thread_pool<>::instance()->parallel_for(0, chunk_count, 1,
+      [&f, chunk_size, total](size_t chunk_begin, size_t chunk_end)
+      {
+        size_t begin = chunk_begin * chunk_size;
+        size_t end = chunk_end * chunk_size;
+        if (end > total)
+          end = total;
+        f(begin, end);
+      }
+    );
+  }
+};
@@ -24,6 +24,7 @@
 #pragma once
 
 #include <container/vsx_ma_vector.h>
+#include <particlesystem/vsx_particle_soa.h>
 
 template<typename T = float>
 class vsx_particle
@@ -44,15 +45,55 @@ public:
   int grounded; // if a particle is grounded it shouldn't move or rotate anymore, lying on the floor
 };
 
+/*
+  A particle system is passed between modules by value, the particle arrays
+  are owned by the generator.
+
+  When the generator also provides particles_soa, modifiers can work on either
+  representation and the other one is converted when next asked for:
+    get_soa() / get_aos() - to modify particles
+    sync_aos()            - to only read particles->particles, as renderers do
+*/
 template<typename T = float>
 class vsx_particlesystem {
 public:
   int timestamp;
   vsx_ma_vector< vsx_particle<T> >* particles;
+  vsx_particle_soa<T>* particles_soa;
 
   vsx_particlesystem() {
     particles = 0;
+    particles_soa = 0;
     timestamp = 0;
   }
+
+  // 0x0 if the generator only provides vsx_particle arrays
+  vsx_particle_soa<T>* get_soa()
+  {
+    if (!particles_soa)
+      return 0x0;
+    if (particles_soa->state == vsx_particle_soa<T>::aos_changed)
+      particles_soa->from_aos(*particles);
+    particles_soa->state = vsx_particle_soa<T>::soa_changed;
+    return particles_soa;
+  }
+
+  vsx_ma_vector< vsx_particle<T> >* get_aos()
+  {
+    sync_aos();
+    if (particles_soa)
+      particles_soa->state = vsx_particle_soa<T>::aos_changed;
+    return particles;
+  }
+
+  vsx_ma_vector< vsx_particle<T> >* sync_aos()
+  {
+    if (particles_soa && particles_soa->state == vsx_particle_soa<T>::soa_changed)
+    {
+      particles_soa->to_aos(*particles);
+      particles_soa->state = vsx_particle_soa<T>::in_sync;
+    }
+    return particles;
+  }
 };  
 
@@ -37,6 +37,24 @@ class vsx_perf
   }
 
 
+  // value of a "Key: n kB" line in /proc/self/status
+  size_t status_kb(const char* key)
+  {
+    FILE* file = fopen("/proc/self/status", "r");
+    size_t result = 0;
+    char line[128];
+    size_t key_length = strlen(key);
+
+    while (fgets(line, 128, file) != NULL){
+        if (strncmp(line, key, key_length) == 0){
+            result = parseLine(line);
+            break;
+        }
+    }
+    fclose(file);
+    return result;
+  }
+
 public:
 
   // cache misses
@@ -138,18 +156,33 @@ public:
 
   size_t memory_currently_used_bytes()
   {
-    FILE* file = fopen("/proc/self/status", "r");
-    size_t result = 0;
-    char line[128];
+    return status_kb("VmRSS:") * 1024;
+  }
 
-    while (fgets(line, 128, file) != NULL){
-        if (strncmp(line, "VmRSS:", 6) == 0){
-            result = parseLine(line);
-            break;
-        }
-    }
-    fclose(file);
-    return result * 1024;
+  /**
+   * @brief memory_peak_used_bytes
+   * Highest resident set size of the process so far
+   * @return
+   */
+  size_t memory_peak_used_bytes()
+  {
+    return status_kb("VmHWM:") * 1024;
+  }
+
+  /**
+   * @brief memory_peak_reset
+   * Sets the peak resident set size back to the current one
+   * @return false if not supported
+   */
+  bool memory_peak_reset()
+  {
+    FILE* file = fopen("/proc/self/clear_refs", "w");
+    if (!file)
+      return false;
+    bool result = fputs("5", file) >= 0;
+    if (fclose(file))
+      result = false;
+    return result;
   }
 
 };
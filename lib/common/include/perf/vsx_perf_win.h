@@ -54,4 +54,17 @@ public:
     return (int)pmc.WorkingSetSize / (1024 * 1024);
   }
 
+  size_t memory_peak_used_bytes()
+  {
+    PROCESS_MEMORY_COUNTERS pmc;
+    GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+    return (size_t)pmc.PeakWorkingSetSize;
+  }
+
+  // the peak working set can't be reset
+  bool memory_peak_reset()
+  {
+    return false;
+  }
+
 };
@@ -40,6 +40,10 @@ typedef int pid_t;
 #include <sys/stat.h>
 #include <string.h>
 #include <inttypes.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 
 /*
@@ -105,6 +109,44 @@ typedef struct
 } vsx_profile_chunk;
 
 
+// Lets a worker thread sleep while it has nothing to do.
+//
+// The worker calls sleep() with a predicate re-checking its input after it
+// announced it is going to sleep; producers call wake(), which costs one
+// atomic load unless the worker is actually sleeping.
+class vsx_profiler_signal
+{
+  std::mutex lock;
+  std::condition_variable condition;
+  std::atomic<bool> sleeping;
+
+public:
+
+  vsx_profiler_signal()
+  {
+    sleeping = false;
+  }
+
+  template<typename F>
+  void sleep(F has_work, int timeout_milliseconds)
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    sleeping.store(true);
+    if (!has_work())
+      condition.wait_for(guard, std::chrono::milliseconds(timeout_milliseconds), [this]() { return !sleeping.load(); });
+    sleeping.store(false);
+  }
+
+  inline void wake()
+  {
+    if (!sleeping.load())
+      return;
+    std::lock_guard<std::mutex> guard(lock);
+    sleeping.store(false);
+    condition.notify_one();
+  }
+};
+
 // Profiler Data Logger Class (end-user interface)
 class vsx_profiler
 {
@@ -113,12 +155,41 @@ public:
   pid_t thread_id;
   bool enabled;
 
+  // the consumer sleeps until a queue is a quarter full (or its timeout)
+  vsx_profiler_signal* consumer_signal = 0x0;
+  static const uint64_t consumer_wake_threshold = 1024;
+
 
   vsx_profiler()
     :
       enabled(false)
   {}
 
+private:
+
+  inline void wake_consumer(bool queue_full)
+  {
+    if (!consumer_signal)
+      return;
+    if (queue_full || queue.live_count_get() >= consumer_wake_threshold)
+      consumer_signal->wake();
+  }
+
+  // spins while the queue is full, retime moves the timestamp to when the chunk got in
+  inline void produce(vsx_profile_chunk& chunk, bool retime)
+  {
+    while (!queue.produce(chunk))
+    {
+      wake_consumer(true);
+      chunk.spin_waste++;
+      if (retime)
+        chunk.cycles = vsx_rdtsc();
+    }
+    wake_consumer(false);
+  }
+
+public:
+
   inline void set_thread_id(pid_t new_id)
   {
     thread_id = new_id;
@@ -142,8 +213,8 @@ public:
     }
     chunk.tag[i-1] = 0;
     chunk.id = thread_id;
-    // get dizzy
-    while (!queue.produce(chunk)) {}
+    chunk.cycles = vsx_rdtsc();
+    produce(chunk, false);
   }
 
   /**
@@ -172,12 +243,8 @@ public:
     VSX_MEMORY_BARRIER;
 
     chunk.cycles = vsx_rdtsc();
-    while (!queue.produce(chunk))
-    {
-      chunk.spin_waste++;
-      // try to get as close to our target code as possible
-      chunk.cycles = vsx_rdtsc();
-    }
+    // try to get as close to our target code as possible
+    produce(chunk, true);
   }
 
   inline void sub_end()
@@ -192,10 +259,7 @@ public:
     chunk.id = thread_id;
     chunk.cycles = t;
     chunk.flags = VSX_PROFILE_CHUNK_FLAG_END;
-    while (!queue.produce(chunk))
-    {
-      chunk.spin_waste++;
-    }
+    produce(chunk, false);
   }
 
   /**
@@ -214,11 +278,7 @@ public:
     chunk.flags = VSX_PROFILE_CHUNK_FLAG_SECTION_START;
     VSX_MEMORY_BARRIER;
     chunk.cycles = vsx_rdtsc();
-    while (!queue.produce(chunk))
-    {
-      chunk.spin_waste++;
-      chunk.cycles = vsx_rdtsc();
-    }
+    produce(chunk, true);
   }
 
   /**
@@ -235,10 +295,7 @@ public:
     chunk.id = thread_id;
     chunk.cycles = t;
     chunk.flags = VSX_PROFILE_CHUNK_FLAG_SECTION_END;
-    while (!queue.produce(chunk))
-    {
-      chunk.spin_waste++;
-    }
+    produce(chunk, false);
   }
 
   /**
@@ -262,9 +319,8 @@ public:
     }
     chunk.tag[i-1] = 0;
     chunk.id = id;
-
-    // get dizzy
-    while (!queue.produce(chunk)) {}
+    chunk.cycles = vsx_rdtsc();
+    produce(chunk, false);
   }
 
 
@@ -278,12 +334,9 @@ public:
     memcpy(&chunk.tag[0],&a, sizeof(double));
     chunk.flags = VSX_PROFILE_CHUNK_FLAG_PLOT_1_DOUBLE;
     chunk.id = id;
+    chunk.spin_waste = 0;
     chunk.cycles = vsx_rdtsc();
-    while (!queue.produce(chunk))
-    {
-      chunk.spin_waste++;
-      chunk.cycles = vsx_rdtsc();
-    }
+    produce(chunk, true);
   }
 
   inline void plot_2(uint64_t id, double a, double b)
@@ -296,12 +349,9 @@ public:
     memcpy(&chunk.tag[8],&b, sizeof(double));
     chunk.flags = VSX_PROFILE_CHUNK_FLAG_PLOT_2_DOUBLE;
     chunk.id = id;
+    chunk.spin_waste = 0;
     chunk.cycles = vsx_rdtsc();
-    while (!queue.produce(chunk))
-    {
-      chunk.spin_waste++;
-      chunk.cycles = vsx_rdtsc();
-    }
+    produce(chunk, true);
   }
 
   inline void plot_3(uint64_t id, double a, double b, double c)
@@ -315,12 +365,9 @@ public:
     memcpy(&chunk.tag[16],&c, sizeof(double));
     chunk.flags = VSX_PROFILE_CHUNK_FLAG_PLOT_3_DOUBLE;
     chunk.id = id;
+    chunk.spin_waste = 0;
     chunk.cycles = vsx_rdtsc();
-    while (!queue.produce(chunk))
-    {
-      chunk.spin_waste++;
-      chunk.cycles = vsx_rdtsc();
-    }
+    produce(chunk, true);
   }
 
   inline void plot_4(uint64_t id, double a, double b, double c, double d)
@@ -336,12 +383,9 @@ public:
     memcpy(&chunk.tag[24],&d, sizeof(double));
     chunk.flags = VSX_PROFILE_CHUNK_FLAG_PLOT_4_DOUBLE;
     chunk.id = id;
+    chunk.spin_waste = 0;
     chunk.cycles = vsx_rdtsc();
-    while (!queue.produce(chunk))
-    {
-      chunk.spin_waste++;
-      chunk.cycles = vsx_rdtsc();
-    }
+    produce(chunk, true);
   }
 };
 
@@ -0,0 +1,191 @@
+/**
+* Project: VSXu: Realtime modular visual programming language, music/audio visualizer.
+*
+* This file is part of Vovoid VSXu.
+*
+* @author Jonatan Wallmander, Vovoid Media Technologies AB Copyright (C) 2014
+* @see The GNU Public License (GPL)
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include "vsx_profiler.h"
+#include "vsx_profiler_trace_file.h"
+
+/*
+ * Converts native profiler data (a file of vsx_profile_chunk) to the Chrome
+ * trace event JSON format, which chrome://tracing and ui.perfetto.dev open.
+ *
+ *   START / END               -> "B" / "E" duration events named by the tag
+ *   SECTION_START / _END      -> "B" / "E" events named "frame"
+ *   THREAD_NAME               -> "M" thread_name metadata
+ *   PLOT_1..4_DOUBLE          -> "C" counter events named "plot <id>"
+ *
+ * Timestamps are microseconds since the first chunk in the file.
+ * convert() reads trace files as well as raw chunk files.
+ */
+class vsx_profiler_chrome_trace
+{
+  static void write_escaped(FILE* out, const char* tag)
+  {
+    for (size_t i = 0; i < 32 && tag[i]; i++)
+    {
+      unsigned char c = (unsigned char)tag[i];
+      if (c == '"' || c == '\\')
+        fprintf(out, "\\%c", c);
+      else
+      if (c < 0x20)
+        fprintf(out, "\\u%04x", c);
+      else
+        fputc(c, out);
+    }
+  }
+
+  static void write_chunk(FILE* out, vsx_profile_chunk& chunk, uint64_t cycles_start, double microseconds_per_cycle, bool& first)
+  {
+    double ts = 0.0;
+    if (chunk.cycles > cycles_start)
+      ts = (double)(chunk.cycles - cycles_start) * microseconds_per_cycle;
+
+    const char* separator = first ? "\n" : ",\n";
+
+    switch (chunk.flags)
+    {
+      case VSX_PROFILE_CHUNK_FLAG_START:
+        fprintf(out, "%s{\"ph\":\"B\",\"pid\":1,\"tid\":%" PRIu64 ",\"ts\":%.3f,\"name\":\"", separator, (uint64_t)chunk.id, ts);
+        write_escaped(out, chunk.tag);
+        fprintf(out, "\"}");
+        break;
+
+      case VSX_PROFILE_CHUNK_FLAG_SECTION_START:
+        fprintf(out, "%s{\"ph\":\"B\",\"pid\":1,\"tid\":%" PRIu64 ",\"ts\":%.3f,\"name\":\"frame\"}", separator, (uint64_t)chunk.id, ts);
+        break;
+
+      case VSX_PROFILE_CHUNK_FLAG_END:
+      case VSX_PROFILE_CHUNK_FLAG_SECTION_END:
+        fprintf(out, "%s{\"ph\":\"E\",\"pid\":1,\"tid\":%" PRIu64 ",\"ts\":%.3f}", separator, (uint64_t)chunk.id, ts);
+        break;
+
+      case VSX_PROFILE_CHUNK_FLAG_THREAD_NAME:
+        fprintf(out, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu64 ",\"name\":\"thread_name\",\"args\":{\"name\":\"", separator, (uint64_t)chunk.id);
+        write_escaped(out, chunk.tag);
+        fprintf(out, "\"}}");
+        break;
+
+      case VSX_PROFILE_CHUNK_FLAG_PLOT_1_DOUBLE:
+      case VSX_PROFILE_CHUNK_FLAG_PLOT_2_DOUBLE:
+      case VSX_PROFILE_CHUNK_FLAG_PLOT_3_DOUBLE:
+      case VSX_PROFILE_CHUNK_FLAG_PLOT_4_DOUBLE:
+      {
+        const char* names = "xyzw";
+        fprintf(out, "%s{\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"name\":\"plot %" PRIu64 "\",\"args\":{", separator, ts, (uint64_t)chunk.id);
+        for (size_t i = 0; i < chunk.flags - 100; i++)
+        {
+          double value;
+          memcpy(&value, &chunk.tag[i * 8], sizeof(double));
+          fprintf(out, "%s\"%c\":%.17g", i ? "," : "", names[i], value);
+        }
+        fprintf(out, "}}");
+        break;
+      }
+
+      default:
+        // timestamps and unknown chunks carry no event
+        return;
+    }
+    first = false;
+  }
+
+  struct write_state
+  {
+    double microseconds_per_cycle = 0.0;
+    uint64_t cycles_start = 0;
+    bool have_start = false;
+    bool first = true;
+  };
+
+  static void write_begin(FILE* out, write_state& state, double cycles_per_second)
+  {
+    state.microseconds_per_cycle = cycles_per_second > 0.0 ? 1000000.0 / cycles_per_second : 0.0;
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  }
+
+  static void write_chunks(FILE* out, write_state& state, vsx_profile_chunk* chunks, size_t count)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      if (!state.have_start && chunks[i].flags != VSX_PROFILE_CHUNK_FLAG_THREAD_NAME)
+      {
+        state.cycles_start = chunks[i].cycles;
+        state.have_start = true;
+      }
+      write_chunk(out, chunks[i], state.cycles_start, state.microseconds_per_cycle, state.first);
+    }
+  }
+
+  static void write_end(FILE* out)
+  {
+    fprintf(out, "\n]}\n");
+  }
+
+public:
+
+  // in is an open raw chunk file, positioned at the first chunk
+  static void write(FILE* in, FILE* out, double cycles_per_second)
+  {
+    write_state state;
+    write_begin(out, state, cycles_per_second);
+
+    vsx_profile_chunk chunks[64];
+    size_t count;
+    while ( (count = fread(chunks, sizeof(vsx_profile_chunk), 64, in)) )
+      write_chunks(out, state, chunks, count);
+
+    write_end(out);
+  }
+
+  // streams the trace one block at a time
+  static void write(vsx_profiler_trace_reader& in, FILE* out, double cycles_per_second)
+  {
+    write_state state;
+    write_begin(out, state, cycles_per_second);
+
+    vsx_ma_vector<vsx_profile_chunk> chunks;
+    for (size_t i = 0; i < in.get_block_count(); i++)
+      if (in.read_block(i, chunks))
+        write_chunks(out, state, chunks.get_pointer(), chunks.size());
+
+    write_end(out);
+  }
+
+  static bool convert(const char* in_filename, const char* out_filename, double cycles_per_second)
+  {
+    vsx_profiler_trace_reader in;
+    if (!in.open(in_filename))
+      return false;
+
+    FILE* out = fopen(out_filename, "w");
+    if (!out)
+      return false;
+
+    write(in, out, cycles_per_second);
+    fclose(out);
+    return true;
+  }
+};
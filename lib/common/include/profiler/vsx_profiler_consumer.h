@@ -29,6 +29,7 @@
 #include <container/vsx_nw_vector.h>
 #include <math/vector/vsx_vector4.h>
 #include <profiler/vsx_profiler_manager.h>
+#include <profiler/vsx_profiler_trace_file.h>
 #include <filesystem/vsx_filesystem.h>
 #include <filesystem/vsx_filesystem_helper.h>
 
@@ -73,18 +74,21 @@ public:
 };
 
 
+/*
+ * Reads profiles one block at a time through vsx_profiler_trace_reader, so
+ * only the index of a profile is held in memory, whatever its size.
+ */
 class vsx_profiler_consumer
 {
   vsx_nw_vector< vsx_string<> > filenames;
 
 
-  vsx_nw_vector<vsx_profile_chunk> current_profile;
+  vsx_profiler_trace_reader current_profile;
+  vsx_ma_vector<vsx_profile_chunk> current_block;
 
   vsx_nw_vector<u_int64_t> current_threads;
   vsx_nw_vector<u_int64_t> current_plots;
 
-  vsx::filesystem filesystem;
-
   double current_max_time;
   double cycles_per_second;
   double one_div_cycles_per_second;
@@ -156,76 +160,41 @@ public:
     cpu_clock_start = 0;
     cpu_clock_end = 0;
 
-    current_profile.reset_used();
     current_threads.reset_used();
     current_plots.reset_used();
 
     vsx_string<>filename = vsx_profiler_manager::profiler_directory_get() + DIRECTORY_SEPARATOR + filenames[index];
-    vsx::file* fp = filesystem.f_open( filename.c_str());
-
-    size_t file_size = filesystem.f_get_size(fp);
-
-    // Some sanity checks
-    if ( file_size % sizeof(vsx_profile_chunk) )
-      VSX_ERROR_RETURN("Profile data file is not a multiple of chunk size.");
 
-    size_t chunks_in_file = file_size / sizeof(vsx_profile_chunk);
+    if (!current_profile.open( filename.c_str() ))
+      VSX_ERROR_RETURN("Could not read profile data file.");
 
-    current_profile.allocate( chunks_in_file );
+    vsx_printf(L"VSX PROFILER: loaded profile with %ld chunks in %ld blocks\n", (long)current_profile.get_chunk_count(), (long)current_profile.get_block_count());
 
-    filesystem.f_read( current_profile.get_pointer(), file_size, fp );
-    vsx_printf(L"VSX PROFILER: loaded profile with %ld chunks\n", (long)chunks_in_file);
-
-    if (current_profile.size() < 3)
+    if (current_profile.get_chunk_count() < 3)
       VSX_ERROR_RETURN("not enough data in profile");
 
-    vsx_profile_chunk& first_profile = current_profile[0];
-    vsx_profile_chunk& last_profile = current_profile[current_profile.size()-2];
-
-    cpu_clock_start = first_profile.cycles;
-
-    if (last_profile.flags != VSX_PROFILE_CHUNK_FLAG_TIMESTAMP)
+    // the i/o thread writes the timestamp last
+    current_profile.read_block(current_profile.get_block_count() - 1, current_block);
+    if (!current_block.size() || current_block.last().flags != VSX_PROFILE_CHUNK_FLAG_TIMESTAMP)
       VSX_ERROR_RETURN("No timestamp in data file, can't analyze it.");
 
+    vsx_profile_chunk& last_profile = current_block.last();
     current_max_time = vsx_string_helper::s2f( vsx_string<>( last_profile.tag, 32) );
     cpu_clock_end = last_profile.cycles;
 
+    cpu_clock_start = current_profile.get_block(0).cycles_min;
+    for (size_t i = 1; i < current_profile.get_block_count(); i++)
+      if (current_profile.get_block(i).cycles_min < cpu_clock_start)
+        cpu_clock_start = current_profile.get_block(i).cycles_min;
+
     cycles_per_second = ((double)cpu_clock_end - (double)cpu_clock_start) / current_max_time;
     one_div_cycles_per_second = 1.0 / cycles_per_second;
 
-    for (size_t i = 0; i < current_profile.size()-2; i++)
-    {
-      vsx_profile_chunk& chunk = current_profile[i];
-
-      if (chunk.flags < 100) // regular
-      {
-        bool found = false;
-        size_t j = 0;
-        while (!found && j < current_threads.size())
-        {
-          if (current_threads[j] == chunk.id)
-            found = true;
-          j++;
-        }
-
-        if (!found)
-          current_threads.push_back(chunk.id);
-      }
-      if (chunk.flags > 100) // plot
-      {
-        bool found = false;
-        size_t j = 0;
-        while (!found && j < current_plots.size())
-        {
-          if (current_plots[j] == chunk.id)
-            found = true;
-          j++;
-        }
+    foreach (current_profile.get_thread_ids(), i)
+      current_threads.push_back(current_profile.get_thread_ids()[i]);
 
-        if (!found)
-          current_plots.push_back(chunk.id);
-      }
-    }
+    foreach (current_profile.get_plot_ids(), i)
+      current_plots.push_back(current_profile.get_plot_ids()[i]);
 
     for (size_t i = 0; i < current_threads.size(); i++)
     {
@@ -241,82 +210,94 @@ public:
     vsx_printf(L"clock frequency: %f\n", (double)(cpu_clock_end-cpu_clock_start) / current_max_time );
   }
 
+  double get_max_time()
+  {
+    return current_max_time;
+  }
+
   double cycles_to_time(uint64_t cycles)
   {
     return (double)(cycles - cpu_clock_start) * one_div_cycles_per_second;
   }
 
   /**
-   * @brief get_chunks
+   * @brief get_thread
+   * Spans of one thread, reading only the blocks that overlap [t_start, t_end].
+   * Spans open at the start of the first of those blocks are not reported.
    * @param t_start
    * @param t_end
+   * @param thread_id
    * @param chunks_result
    */
   void get_thread(double t_start, double t_end, uint64_t thread_id, vsx_nw_vector<vsx_profiler_consumer_chunk> &chunks_result)
   {
-    VSX_UNUSED(t_start);
-    VSX_UNUSED(t_end);
-
-    if (current_profile.size() < 2)
+    if (current_profile.get_chunk_count() < 2)
       VSX_ERROR_RETURN("Not enough chunks in loaded profile data");
 
-    // now find the first major chunk
-    for (size_t i = 0; i < current_profile.size(); i++)
+    uint64_t cycles_window_start = cpu_clock_start + (uint64_t)((t_start > 0.0 ? t_start : 0.0) * cycles_per_second);
+    uint64_t cycles_window_end = cpu_clock_start + (uint64_t)((t_end > 0.0 ? t_end : 0.0) * cycles_per_second);
+
+    compute_stack_pointer = 0;
+
+    for (size_t b = 0; b < current_profile.get_block_count(); b++)
     {
-      vsx_profile_chunk& chunk = current_profile[i];
+      vsx_profiler_trace_block& block = current_profile.get_block(b);
+      if (block.cycles_max < cycles_window_start || block.cycles_min > cycles_window_end)
+        continue;
 
-      if (chunk.id != thread_id)
+      if (!current_profile.read_block(b, current_block))
         continue;
 
-      if (chunk.flags == VSX_PROFILE_CHUNK_FLAG_SECTION_START /* && chunk.cycles > cycles_begin_time*/)
+      for (size_t i = 0; i < current_block.size(); i++)
       {
-        compute_stack[compute_stack_pointer].time_start = cycles_to_time( chunk.cycles );
-        compute_stack[compute_stack_pointer].cycles_start = chunk.cycles;
-        compute_stack_pointer++;
-        if (compute_stack_pointer == compute_stack_depth)
-          compute_stack_pointer--;
-      }
+        vsx_profile_chunk& chunk = current_block[i];
 
-      if (chunk.flags == VSX_PROFILE_CHUNK_FLAG_SECTION_END /*&& chunk.cycles > cycles_begin_time*/)
-      {
-        if (compute_stack_pointer != 0)
-          compute_stack_pointer--;
+        if (chunk.id != thread_id)
+          continue;
 
-        compute_stack[compute_stack_pointer].time_end = cycles_to_time( chunk.cycles );
-        compute_stack[compute_stack_pointer].depth = compute_stack_pointer;
-        compute_stack[compute_stack_pointer].cycles_end = chunk.cycles;
-        chunks_result.push_back( compute_stack[compute_stack_pointer] );
-      }
+        if (chunk.flags == VSX_PROFILE_CHUNK_FLAG_SECTION_START || chunk.flags == VSX_PROFILE_CHUNK_FLAG_START)
+        {
+          compute_stack[compute_stack_pointer].time_start = cycles_to_time( chunk.cycles );
+          compute_stack[compute_stack_pointer].cycles_start = chunk.cycles;
+          compute_stack[compute_stack_pointer].tag = chunk.flags == VSX_PROFILE_CHUNK_FLAG_START ? chunk.tag : "";
+          compute_stack_pointer++;
+          if (compute_stack_pointer == compute_stack_depth)
+            compute_stack_pointer--;
+        }
 
-      if (chunk.flags == VSX_PROFILE_CHUNK_FLAG_START /*&& chunk.cycles > cycles_begin_time*/)
-      {
-        compute_stack[compute_stack_pointer].time_start = cycles_to_time( chunk.cycles );
-        compute_stack[compute_stack_pointer].tag = chunk.tag;
-        compute_stack[compute_stack_pointer].cycles_start = chunk.cycles;
-        compute_stack_pointer++;
-        if (compute_stack_pointer == compute_stack_depth)
-          compute_stack_pointer--;
-      }
+        if (chunk.flags == VSX_PROFILE_CHUNK_FLAG_SECTION_END || chunk.flags == VSX_PROFILE_CHUNK_FLAG_END)
+        {
+          // the matching start is in a block before the window
+          if (compute_stack_pointer == 0)
+            continue;
 
-      if (chunk.flags == VSX_PROFILE_CHUNK_FLAG_END /*&& chunk.cycles > cycles_begin_time*/)
-      {
-        if (compute_stack_pointer != 0)
           compute_stack_pointer--;
 
-        compute_stack[compute_stack_pointer].time_end = cycles_to_time( chunk.cycles );
-        compute_stack[compute_stack_pointer].depth = compute_stack_pointer;
-        compute_stack[compute_stack_pointer].cycles_end = chunk.cycles;
-        chunks_result.push_back( compute_stack[compute_stack_pointer] );
+          compute_stack[compute_stack_pointer].time_end = cycles_to_time( chunk.cycles );
+          compute_stack[compute_stack_pointer].depth = compute_stack_pointer;
+          compute_stack[compute_stack_pointer].cycles_end = chunk.cycles;
+          chunks_result.push_back( compute_stack[compute_stack_pointer] );
+        }
       }
     }
-
   }
 
   void get_plot(u_int64_t index, vsx_nw_vector<vsx_profiler_consumer_plot> &chunks_result)
   {
-    for (size_t i = 0; i < current_profile.size(); i++)
+    for (size_t b = 0; b < current_profile.get_block_count(); b++)
+    {
+      if (!current_profile.read_block(b, current_block))
+        continue;
+
+      get_plot_block(index, chunks_result);
+    }
+  }
+
+  void get_plot_block(u_int64_t index, vsx_nw_vector<vsx_profiler_consumer_plot> &chunks_result)
+  {
+    for (size_t i = 0; i < current_block.size(); i++)
     {
-      vsx_profile_chunk& chunk = current_profile[i];
+      vsx_profile_chunk& chunk = current_block[i];
 
       if (chunk.flags < 100)
         continue;
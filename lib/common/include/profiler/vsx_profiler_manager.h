@@ -44,6 +44,8 @@
 #include <thread>
 #include <errno.h>
 #include "vsx_profiler.h"
+#include "vsx_profiler_chrome_trace.h"
+#include "vsx_profiler_trace_file.h"
 #include <vsx_data_path.h>
 #include <time/vsx_timer.h>
 #include <string/vsx_string_helper.h>
@@ -67,15 +69,33 @@
 #define VSX_PROFILER_RECIEVE_BUFFER_ITEMS 64
 #define VSX_PROFILER_STACK_DEPTH_WARNING 64
 
+// how long the consumer and i/o threads sleep when idle unless woken up
+#define VSX_PROFILER_CONSUMER_SLEEP_MS 10
+#define VSX_PROFILER_IO_SLEEP_MS 100
+
+// a filled part of the consumer's receive buffer, handed to the i/o thread
+struct vsx_profiler_page
+{
+  vsx_profile_chunk* chunks;
+  size_t count;
+};
+
 class vsx_profiler_manager
 {
 public:
 
   std::atomic_uint_fast64_t thread_run_control;
   std::atomic_uint_fast64_t enable_data_collection;
+  std::atomic_uint_fast64_t consumer_done;
+
+  vsx_profiler_signal consumer_signal;
+  vsx_profiler_signal io_signal;
 
   bool started = false;
 
+  // also write the profile as Chrome trace JSON next to the .vsxp file on shutdown
+  bool chrome_trace_export = false;
+
   vsx_string<> output_path;
 
   vsx_lock thread_lock;
@@ -85,12 +105,17 @@ public:
   vsx_profiler profiler_list[VSX_PROFILER_MAX_THREADS];
   pid_t thread_list [VSX_PROFILER_MAX_THREADS];
 
-  vsx_fifo_mt<vsx_profile_chunk*,VSX_PROFILER_RECIEVE_BUFFER_PAGES> io_pool;
+  // at most half the receive buffer is in flight so the consumer never
+  // fills a page the i/o thread is still writing
+  vsx_fifo_mt<vsx_profiler_page,VSX_PROFILER_RECIEVE_BUFFER_PAGES / 2> io_pool;
 
   vsx_profiler_manager()
   {
     thread_run_control = 1;
     enable_data_collection = 0;
+    consumer_done = 0;
+    for (size_t i = 0; i < VSX_PROFILER_MAX_THREADS; i++)
+      profiler_list[i].consumer_signal = &consumer_signal;
   }
 
   ~vsx_profiler_manager()
@@ -101,19 +126,26 @@ public:
       vsx_printf(L"VSX PROFILER:  Shutting down:");
       thread_run_control.fetch_sub(1);
 
-      vsx_printf(L"[io thread] ");
-      if (io_thread.joinable())
-        io_thread.join();
-
+      // the consumer hands its last page to the i/o thread before it exits
       vsx_printf(L"[consumer thread] ");
+      consumer_signal.wake();
       if (consumer_thread.joinable())
         consumer_thread.join();
+      consumer_done = 1;
+
+      vsx_printf(L"[io thread] ");
+      io_signal.wake();
+      if (io_thread.joinable())
+        io_thread.join();
       vsx_printf(L"[destruction complete]\n");
     }
   }
 
   void start()
   {
+    req(!started);
+    started = true;
+
     vsx_printf(L"VSX PROFILER:\n  Creating: ");
 
     vsx_printf(L"[consumer thread]\n");
@@ -153,6 +185,9 @@ public:
 
 
 
+  // Moves chunks from the per thread queues to pages for the i/o thread.
+  // Sleeps while every queue is empty; producers wake it when a queue gets
+  // a quarter full, otherwise it drains them every VSX_PROFILER_CONSUMER_SLEEP_MS.
   static void* consumer_worker()
   {
     vsx_printf(L"[Profiler CONSUMER running]\n");
@@ -167,7 +202,8 @@ public:
     vsx_profiler* profilers = &pm->profiler_list[0];
     pid_t* producer_threads = &pm->thread_list[0];
 
-    vsx_profile_chunk recieve_buffer[VSX_PROFILER_RECIEVE_BUFFER_PAGES][VSX_PROFILER_RECIEVE_BUFFER_ITEMS];
+    // not on the stack, the i/o thread writes the last page after this thread exits
+    static vsx_profile_chunk recieve_buffer[VSX_PROFILER_RECIEVE_BUFFER_PAGES][VSX_PROFILER_RECIEVE_BUFFER_ITEMS];
     size_t recieve_buffer_iterator = 0;
 
     size_t current_buffer_page = 0;
@@ -177,8 +213,44 @@ public:
 
     uint64_t current_enabled = pm->enable_data_collection.load();
 
-    while ( pm->thread_run_control.load() )
+    auto send_page = [&]()
+    {
+      vsx_profiler_page page = { &recieve_buffer[current_buffer_page][0], recieve_buffer_iterator };
+      recieve_buffer_iterator = 0;
+
+      if (!pm->io_pool.produce(page))
+      {
+        vsx_printf(L"VSX PROFILER:  ***PERFORMANCE WARNING*** waiting while i/o fifo is full...\n");
+        while (!pm->io_pool.produce(page))
+        {
+          pm->io_signal.wake();
+          std::this_thread::yield();
+        }
+      }
+      pm->io_signal.wake();
+
+      current_buffer_page++;
+
+      if (current_buffer_page == VSX_PROFILER_RECIEVE_BUFFER_PAGES)
+        current_buffer_page = 0;
+    };
+
+    auto has_work = [&]()
+    {
+      if (!pm->thread_run_control.load())
+        return true;
+      for ( size_t i = 0; i < VSX_PROFILER_MAX_THREADS && producer_threads[i]; i++)
+        if (profilers[i].queue.live_count_get())
+          return true;
+      return false;
+    };
+
+    // after shutdown is requested, keep going until the queues are drained
+    bool consumed = true;
+    while ( pm->thread_run_control.load() || consumed )
     {
+      consumed = false;
+
       // collect from all threads
       for ( size_t i = 0; i < VSX_PROFILER_MAX_THREADS; i++)
       {
@@ -194,6 +266,8 @@ public:
           if (!profilers[i].queue.consume( recieve_chunk ))
             break;
 
+          consumed = true;
+
           if (
               recieve_chunk.flags == VSX_PROFILE_CHUNK_FLAG_SECTION_START
               ||
@@ -247,21 +321,9 @@ public:
 
             recieve_buffer_iterator++;
 
+            // when page filled, send a full "page" to io thread
             if (recieve_buffer_iterator == VSX_PROFILER_RECIEVE_BUFFER_ITEMS)
-            {
-              recieve_buffer_iterator = 0;
-
-              // when page filled, send a full "page" to io thread
-              while (!pm->io_pool.produce(&recieve_buffer[current_buffer_page][0]))
-              {
-                vsx_printf(L"VSX PROFILER:  ***PERFORMANCE WARNING*** spinning while i/o fifo is full...\n");
-              }
-
-              current_buffer_page++;
-
-              if (current_buffer_page == VSX_PROFILER_RECIEVE_BUFFER_PAGES)
-                current_buffer_page = 0;
-            }
+              send_page();
           }
 
           // read max 4 packets per thread
@@ -269,7 +331,14 @@ public:
             break;
         }
       }
+
+      if (!consumed && pm->thread_run_control.load())
+        pm->consumer_signal.sleep(has_work, VSX_PROFILER_CONSUMER_SLEEP_MS);
     }
+
+    if (recieve_buffer_iterator)
+      send_page();
+
     return 0x0;
   }
 
@@ -299,42 +368,65 @@ public:
 #endif
 
 #if (PLATFORM_FAMILY == PLATFORM_FAMILY_UNIX)
-    vsx_string<>filename = profiler_directory + "/" + vsx_string<>(program_invocation_short_name) +
-        "_" +vsx_string_helper::i2s((int)time(0x0)) + ".dat";
+    vsx_string<>filename_base = profiler_directory + "/" + vsx_string<>(program_invocation_short_name) +
+        "_" +vsx_string_helper::i2s((int)time(0x0));
 #else
-    vsx_string<>filename = profiler_directory + "/" + "_" +vsx_string_helper::i2s((int)time(0x0)) + ".dat";
+    vsx_string<>filename_base = profiler_directory + "/" + "_" +vsx_string_helper::i2s((int)time(0x0));
 #endif
+    vsx_string<>filename = filename_base + ".vsxp";
     vsx_timer timer;
 
-    FILE* fp = fopen( filename.c_str() , "wb");
+    vsx_profiler_trace_writer writer;
 
-    if (!fp)
+    if (!writer.open( filename.c_str() ))
       VSX_ERROR_EXIT("VSX PROFILER: ***ERROR*** I/O thread can not open file. Aborting...", 900);
 
 
     vsx_printf(L"[Profiler writing to %hs]\n", filename.c_str());
     timer.start();
+    uint64_t cycles_start = vsx_rdtsc();
+    double time_start = timer.atime();
     double accumulated_time = 0.0;
-    while ( pm->thread_run_control.load() )
+    auto has_work = [&]()
     {
-      vsx_profile_chunk* r;
-      while ( pm->io_pool.consume(r) )
-      {
-        fwrite(r,sizeof(vsx_profile_chunk) * VSX_PROFILER_RECIEVE_BUFFER_ITEMS,1,fp);
-      }
+      return pm->io_pool.live_count_get() || pm->consumer_done.load();
+    };
+
+    // runs until the consumer has sent its last page
+    forever
+    {
+      bool consumer_done = pm->consumer_done.load() != 0;
+
+      vsx_profiler_page page;
+      while ( pm->io_pool.consume(page) )
+        writer.write(page.chunks, page.count);
+
       double d1 = timer.dtime();
       if (pm->enable_data_collection)
         accumulated_time += d1;
+
+      if (consumer_done)
+        break;
+
+      pm->io_signal.sleep(has_work, VSX_PROFILER_IO_SLEEP_MS);
     }
 
     vsx_profile_chunk c;
+    memset(&c, 0, sizeof(c));
     c.cycles = vsx_rdtsc();
     c.flags = VSX_PROFILE_CHUNK_FLAG_TIMESTAMP;
-    memset(c.tag,0,32);
     sprintf(c.tag,"%f", accumulated_time );
-    fwrite(&c,sizeof(vsx_profile_chunk),1,fp);
+    writer.write(&c, 1);
 
-    fclose(fp);
+    writer.close();
+
+    if (pm->chrome_trace_export)
+    {
+      double cycles_per_second = (double)(c.cycles - cycles_start) / (timer.atime() - time_start);
+      vsx_string<> json_filename = filename_base + ".json";
+      vsx_printf(L"[Profiler writing Chrome trace to %hs]\n", json_filename.c_str());
+      vsx_profiler_chrome_trace::convert(filename.c_str(), json_filename.c_str(), cycles_per_second);
+    }
     return NULL;
   }
 
@@ -374,6 +466,13 @@ public:
         break;
     }
 
+    if (i == VSX_PROFILER_MAX_THREADS)
+    {
+      thread_lock.release();
+      vsx_printf(L"VSX PROFILER: ***WARNING*** No free profiler for thread id %d, raise VSX_PROFILER_MAX_THREADS\n", local_thread_id);
+      return;
+    }
+
     thread_list[i] = local_thread_id;
     profiler_list[i].set_thread_id( local_thread_id );
 
@@ -0,0 +1,477 @@
+#include <profiler/vsx_profiler_trace_file.h>
+#include <vsx_compression_lzma.h>
+#include <string/vsx_string.h>
+
+// speed matters more than size here, the i/o thread has to keep up with the program
+#define VSX_PROFILER_TRACE_COMPRESSION_LEVEL 3
+
+static uint64_t trace_file_tell(FILE* fp)
+{
+#if PLATFORM_FAMILY == PLATFORM_FAMILY_WINDOWS
+  return (uint64_t)_ftelli64(fp);
+#else
+  return (uint64_t)ftello(fp);
+#endif
+}
+
+static bool trace_file_seek(FILE* fp, uint64_t offset)
+{
+#if PLATFORM_FAMILY == PLATFORM_FAMILY_WINDOWS
+  return _fseeki64(fp, (int64_t)offset, SEEK_SET) == 0;
+#else
+  return fseeko(fp, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static uint64_t trace_file_size(FILE* fp)
+{
+#if PLATFORM_FAMILY == PLATFORM_FAMILY_WINDOWS
+  _fseeki64(fp, 0, SEEK_END);
+#else
+  fseeko(fp, 0, SEEK_END);
+#endif
+  uint64_t size = trace_file_tell(fp);
+  trace_file_seek(fp, 0);
+  return size;
+}
+
+static void trace_id_add(vsx_nw_vector<uint64_t>& ids, uint64_t id)
+{
+  if (!ids.has(id))
+    ids.push_back(id);
+}
+
+static void trace_ids_add(vsx_profile_chunk& chunk, vsx_nw_vector<uint64_t>& thread_ids, vsx_nw_vector<uint64_t>& plot_ids)
+{
+  if (chunk.flags == VSX_PROFILE_CHUNK_FLAG_TIMESTAMP)
+    return;
+
+  if (chunk.flags < 100)
+    trace_id_add(thread_ids, chunk.id);
+
+  if (chunk.flags > 100)
+    trace_id_add(plot_ids, chunk.id);
+}
+
+// size of the payload following the header fields, SIZE_MAX for a string
+static size_t trace_payload_size(uint64_t flags)
+{
+  switch (flags)
+  {
+    case VSX_PROFILE_CHUNK_FLAG_START:
+    case VSX_PROFILE_CHUNK_FLAG_TIMESTAMP:
+    case VSX_PROFILE_CHUNK_FLAG_THREAD_NAME:
+    case VSX_PROFILE_CHUNK_FLAG_PLOT_NAME:
+      return SIZE_MAX;
+    case VSX_PROFILE_CHUNK_FLAG_END:
+    case VSX_PROFILE_CHUNK_FLAG_SECTION_START:
+    case VSX_PROFILE_CHUNK_FLAG_SECTION_END:
+      return 0;
+    case VSX_PROFILE_CHUNK_FLAG_PLOT_1_DOUBLE:
+    case VSX_PROFILE_CHUNK_FLAG_PLOT_2_DOUBLE:
+    case VSX_PROFILE_CHUNK_FLAG_PLOT_3_DOUBLE:
+    case VSX_PROFILE_CHUNK_FLAG_PLOT_4_DOUBLE:
+      return (size_t)(flags - 100) * sizeof(double);
+  }
+  return 32;
+}
+
+static inline void trace_put_varint(unsigned char*& p, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    *p++ = (unsigned char)(value | 0x80);
+    value >>= 7;
+  }
+  *p++ = (unsigned char)value;
+}
+
+static bool trace_get_varint(unsigned char*& p, unsigned char* end, uint64_t& value)
+{
+  value = 0;
+  for (size_t shift = 0; shift < 64; shift += 7)
+  {
+    if (p == end)
+      return false;
+    unsigned char b = *p++;
+    value |= (uint64_t)(b & 0x7f) << shift;
+    if (!(b & 0x80))
+      return true;
+  }
+  return false;
+}
+
+
+
+bool vsx_profiler_trace_writer::open(const char* filename)
+{
+  close();
+  fp = fopen(filename, "wb");
+  if (!fp)
+    return false;
+
+  vsx_profiler_trace_header header;
+  fwrite(&header, sizeof(header), 1, fp);
+
+  pending.reset_used();
+  index.reset_used();
+  thread_ids.reset_used();
+  plot_ids.reset_used();
+  chunk_count = 0;
+  return true;
+}
+
+void vsx_profiler_trace_writer::write(vsx_profile_chunk* chunks, size_t count)
+{
+  req(fp);
+  for (size_t i = 0; i < count; i++)
+  {
+    trace_ids_add(chunks[i], thread_ids, plot_ids);
+    pending.push_back(chunks[i]);
+    if (pending.size() == block_chunks)
+      flush_block();
+  }
+}
+
+void vsx_profiler_trace_writer::flush_block()
+{
+  req(pending.size());
+
+  encode(pending.get_pointer(), pending.size(), encoded);
+  vsx_ma_vector<unsigned char> compressed = vsx::compression_lzma::compress(encoded, VSX_PROFILER_TRACE_COMPRESSION_LEVEL);
+
+  vsx_profiler_trace_block block;
+  block.offset = trace_file_tell(fp) + sizeof(vsx_profiler_trace_block);
+  block.compressed_size = (uint32_t)compressed.size();
+  block.uncompressed_size = (uint32_t)encoded.size();
+  block.chunk_count = (uint32_t)pending.size();
+  block.cycles_min = UINT64_MAX;
+  foreach (pending, i)
+  {
+    if (pending[i].cycles < block.cycles_min)
+      block.cycles_min = pending[i].cycles;
+    if (pending[i].cycles > block.cycles_max)
+      block.cycles_max = pending[i].cycles;
+  }
+
+  fwrite(&block, sizeof(block), 1, fp);
+  fwrite(compressed.get_pointer(), compressed.size(), 1, fp);
+
+  index.push_back(block);
+  chunk_count += pending.size();
+  pending.reset_used();
+}
+
+void vsx_profiler_trace_writer::close()
+{
+  req(fp);
+
+  if (pending.size())
+    flush_block();
+
+  vsx_profiler_trace_footer footer;
+  footer.index_offset = trace_file_tell(fp);
+  footer.block_count = index.size();
+  footer.chunk_count = chunk_count;
+  footer.thread_count = (uint32_t)thread_ids.size();
+  footer.plot_count = (uint32_t)plot_ids.size();
+
+  if (index.size())
+    fwrite(index.get_pointer(), sizeof(vsx_profiler_trace_block), index.size(), fp);
+  if (thread_ids.size())
+    fwrite(thread_ids.get_pointer(), sizeof(uint64_t), thread_ids.size(), fp);
+  if (plot_ids.size())
+    fwrite(plot_ids.get_pointer(), sizeof(uint64_t), plot_ids.size(), fp);
+  fwrite(&footer, sizeof(footer), 1, fp);
+
+  fclose(fp);
+  fp = 0x0;
+}
+
+void vsx_profiler_trace_writer::encode(vsx_profile_chunk* chunks, size_t count, vsx_ma_vector<unsigned char>& result)
+{
+  // worst case: 4 varints of 10 bytes and a 32 byte payload per chunk
+  result.reset_used();
+  req(count);
+  result.allocate(count * 72 - 1);
+  unsigned char* p = result.get_pointer();
+
+  uint64_t previous_cycles = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    vsx_profile_chunk& chunk = chunks[i];
+    trace_put_varint(p, chunk.flags);
+    trace_put_varint(p, chunk.id);
+    trace_put_varint(p, chunk.spin_waste);
+
+    int64_t delta = (int64_t)(chunk.cycles - previous_cycles);
+    trace_put_varint(p, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+    previous_cycles = chunk.cycles;
+
+    size_t payload_size = trace_payload_size(chunk.flags);
+    if (payload_size == SIZE_MAX)
+    {
+      size_t length = strnlen(chunk.tag, 32);
+      memcpy(p, chunk.tag, length);
+      p += length;
+      if (length < 32)
+        *p++ = 0;
+      continue;
+    }
+
+    memcpy(p, chunk.tag, payload_size);
+    p += payload_size;
+  }
+  result.reset_used( (size_t)(p - result.get_pointer()) );
+}
+
+
+
+bool vsx_profiler_trace_reader::open(const char* filename)
+{
+  close();
+  fp = fopen(filename, "rb");
+  if (!fp)
+    return false;
+
+  uint64_t file_size = trace_file_size(fp);
+
+  vsx_profiler_trace_header header;
+  bool is_trace =
+      file_size >= sizeof(header)
+      &&
+      fread(&header, sizeof(header), 1, fp) == 1
+      &&
+      memcmp(header.identifier, "VSXP", 4) == 0;
+
+  bool opened = false;
+  if (is_trace)
+    opened = open_index(file_size) || open_blocks(file_size);
+  else
+    opened = open_raw(file_size);
+
+  if (!opened)
+    close();
+  return opened;
+}
+
+void vsx_profiler_trace_reader::close()
+{
+  if (fp)
+    fclose(fp);
+  fp = 0x0;
+  raw = false;
+  blocks.reset_used();
+  thread_ids.reset_used();
+  plot_ids.reset_used();
+  chunk_count = 0;
+}
+
+bool vsx_profiler_trace_reader::open_index(uint64_t file_size)
+{
+  vsx_profiler_trace_footer footer;
+  if (file_size < sizeof(vsx_profiler_trace_header) + sizeof(footer))
+    return false;
+
+  trace_file_seek(fp, file_size - sizeof(footer));
+  if (fread(&footer, sizeof(footer), 1, fp) != 1)
+    return false;
+
+  if (memcmp(footer.identifier, "VSXP", 4) != 0)
+    return false;
+
+  uint64_t index_size =
+      footer.block_count * sizeof(vsx_profiler_trace_block)
+      +
+      ((uint64_t)footer.thread_count + footer.plot_count) * sizeof(uint64_t);
+  if (footer.index_offset + index_size + sizeof(footer) != file_size)
+    return false;
+
+  trace_file_seek(fp, footer.index_offset);
+  for (uint64_t i = 0; i < footer.block_count; i++)
+  {
+    vsx_profiler_trace_block block;
+    if (fread(&block, sizeof(block), 1, fp) != 1)
+      return false;
+    blocks.push_back(block);
+  }
+  for (uint32_t i = 0; i < footer.thread_count + footer.plot_count; i++)
+  {
+    uint64_t id;
+    if (fread(&id, sizeof(id), 1, fp) != 1)
+      return false;
+    if (i < footer.thread_count)
+      thread_ids.push_back(id);
+    else
+      plot_ids.push_back(id);
+  }
+
+  chunk_count = footer.chunk_count;
+  return true;
+}
+
+bool vsx_profiler_trace_reader::open_blocks(uint64_t file_size)
+{
+  blocks.reset_used();
+  thread_ids.reset_used();
+  plot_ids.reset_used();
+  chunk_count = 0;
+
+  uint64_t position = sizeof(vsx_profiler_trace_header);
+  forever
+  {
+    vsx_profiler_trace_block block;
+    trace_file_seek(fp, position);
+    if (fread(&block, sizeof(block), 1, fp) != 1)
+      break;
+
+    // stop at the first block that was not completely written
+    if (block.offset != position + sizeof(block) || block.offset + block.compressed_size > file_size)
+      break;
+
+    blocks.push_back(block);
+    chunk_count += block.chunk_count;
+    position = block.offset + block.compressed_size;
+  }
+
+  if (!blocks.size())
+    return false;
+
+  vsx_printf(L"VSX PROFILER: trace has no index, reading all blocks\n");
+  scan_blocks();
+  return true;
+}
+
+bool vsx_profiler_trace_reader::open_raw(uint64_t file_size)
+{
+  if (!file_size || file_size % sizeof(vsx_profile_chunk))
+    return false;
+
+  raw = true;
+  chunk_count = file_size / sizeof(vsx_profile_chunk);
+  for (uint64_t i = 0; i < chunk_count; i += vsx_profiler_trace_writer::block_chunks)
+  {
+    vsx_profiler_trace_block block;
+    block.offset = i * sizeof(vsx_profile_chunk);
+    block.chunk_count = (uint32_t)vsx_profiler_trace_writer::block_chunks;
+    if (chunk_count - i < block.chunk_count)
+      block.chunk_count = (uint32_t)(chunk_count - i);
+    block.uncompressed_size = block.chunk_count * (uint32_t)sizeof(vsx_profile_chunk);
+    blocks.push_back(block);
+  }
+
+  scan_blocks();
+  return true;
+}
+
+// fills in what the index would have held, one block at a time
+void vsx_profiler_trace_reader::scan_blocks()
+{
+  vsx_ma_vector<vsx_profile_chunk> chunks;
+  foreach (blocks, i)
+  {
+    if (!read_block(i, chunks))
+      continue;
+
+    blocks[i].cycles_min = UINT64_MAX;
+    blocks[i].cycles_max = 0;
+    foreach (chunks, j)
+    {
+      trace_ids_add(chunks[j], thread_ids, plot_ids);
+
+      // thread names in raw files carry no timestamp
+      if (chunks[j].flags == VSX_PROFILE_CHUNK_FLAG_THREAD_NAME)
+        continue;
+      if (chunks[j].cycles < blocks[i].cycles_min)
+        blocks[i].cycles_min = chunks[j].cycles;
+      if (chunks[j].cycles > blocks[i].cycles_max)
+        blocks[i].cycles_max = chunks[j].cycles;
+    }
+  }
+}
+
+bool vsx_profiler_trace_reader::read_block(size_t index, vsx_ma_vector<vsx_profile_chunk>& chunks)
+{
+  chunks.reset_used();
+  reqrv(fp, false);
+  reqrv(index < blocks.size(), false);
+
+  vsx_profiler_trace_block& block = blocks[index];
+  reqrv(block.chunk_count, false);
+  trace_file_seek(fp, block.offset);
+
+  if (raw)
+  {
+    chunks.allocate(block.chunk_count - 1);
+    return fread(chunks.get_pointer(), sizeof(vsx_profile_chunk), block.chunk_count, fp) == block.chunk_count;
+  }
+
+  reqrv(block.compressed_size, false);
+  reqrv(block.uncompressed_size, false);
+
+  compressed.reset_used();
+  compressed.allocate(block.compressed_size - 1);
+  if (fread(compressed.get_pointer(), block.compressed_size, 1, fp) != 1)
+    return false;
+
+  encoded.reset_used();
+  encoded.allocate(block.uncompressed_size - 1);
+  vsx::compression_lzma::uncompress(encoded, compressed);
+
+  return decode(encoded.get_pointer(), encoded.size(), block.chunk_count, chunks);
+}
+
+bool vsx_profiler_trace_reader::decode(unsigned char* data, size_t size, size_t count, vsx_ma_vector<vsx_profile_chunk>& result)
+{
+  result.reset_used();
+  reqrv(count, true);
+  result.allocate(count - 1);
+
+  unsigned char* p = data;
+  unsigned char* end = data + size;
+  uint64_t previous_cycles = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    vsx_profile_chunk& chunk = result[i];
+    memset(&chunk, 0, sizeof(chunk));
+
+    uint64_t flags, id, spin_waste, delta;
+    if (
+        !trace_get_varint(p, end, flags)
+        ||
+        !trace_get_varint(p, end, id)
+        ||
+        !trace_get_varint(p, end, spin_waste)
+        ||
+        !trace_get_varint(p, end, delta)
+        )
+      return false;
+
+    chunk.flags = flags;
+    chunk.id = id;
+    chunk.spin_waste = spin_waste;
+    chunk.cycles = previous_cycles + ((delta >> 1) ^ (~(delta & 1) + 1));
+    previous_cycles = chunk.cycles;
+
+    size_t payload_size = trace_payload_size(flags);
+    if (payload_size == SIZE_MAX)
+    {
+      for (size_t j = 0; j < 32; j++)
+      {
+        if (p == end)
+          return false;
+        char c = (char)*p++;
+        if (!c)
+          break;
+        chunk.tag[j] = c;
+      }
+      continue;
+    }
+
+    if ((size_t)(end - p) < payload_size)
+      return false;
+    memcpy(chunk.tag, p, payload_size);
+    p += payload_size;
+  }
+  return true;
+}
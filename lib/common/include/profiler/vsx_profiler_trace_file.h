@@ -0,0 +1,178 @@
+/**
+* Project: VSXu: Realtime modular visual programming language, music/audio visualizer.
+*
+* This file is part of Vovoid VSXu.
+*
+* @author Jonatan Wallmander, Vovoid Media Technologies AB Copyright (C) 2014
+* @see The GNU Public License (GPL)
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <vsx_common_dllimport.h>
+#include <container/vsx_ma_vector.h>
+#include <container/vsx_nw_vector.h>
+#include "vsx_profiler.h"
+
+/**
+ * A profiler trace file (.vsxp) consists of 4 parts:
+ * 1. header
+ * 2. blocks
+ *    [ vsx_profiler_trace_block ][ compressed data ][ vsx_profiler_trace_block ]...
+ * 3. index, written on close
+ *    [ vsx_profiler_trace_block ]... [ thread ids ][ plot ids ]
+ * 4. footer, written on close
+ *
+ * A block holds up to block_chunks chunks, delta encoded and LZMA compressed
+ * on its own so a reader only ever holds one block in memory. Per chunk:
+ * flags, id and spin_waste as varints, cycles as a zigzag varint delta from
+ * the previous chunk (chunks from different threads interleave, the delta
+ * can be negative), then the payload: the tag as a zero terminated string
+ * for named chunks, the doubles for plots, nothing for end chunks.
+ *
+ * A file without index and footer (the program did not shut down) is read by
+ * walking the block headers.
+ *
+ * The reader also opens the raw chunk files (.dat) older versions wrote.
+ */
+
+VSX_PACK_BEGIN
+struct vsx_profiler_trace_header
+{
+  uint8_t identifier[4] = {'V','S','X','P'}; // "VSXP"
+  uint32_t version = 1;
+  uint32_t reserved[2] = {0, 0};
+}
+VSX_PACK_END
+
+VSX_PACK_BEGIN
+struct vsx_profiler_trace_block
+{
+  uint64_t offset = 0; // offset of the compressed data from the start of the file
+  uint32_t compressed_size = 0; // 0 for raw chunks
+  uint32_t uncompressed_size = 0;
+  uint32_t chunk_count = 0;
+  uint32_t reserved = 0;
+  uint64_t cycles_min = 0;
+  uint64_t cycles_max = 0;
+}
+VSX_PACK_END
+
+VSX_PACK_BEGIN
+struct vsx_profiler_trace_footer
+{
+  uint64_t index_offset = 0;
+  uint64_t block_count = 0;
+  uint64_t chunk_count = 0;
+  uint32_t thread_count = 0;
+  uint32_t plot_count = 0;
+  uint8_t identifier[4] = {'V','S','X','P'}; // "VSXP"
+  uint32_t reserved = 0;
+}
+VSX_PACK_END
+
+
+class COMMON_DLLIMPORT vsx_profiler_trace_writer
+{
+  FILE* fp = 0x0;
+  vsx_ma_vector<vsx_profile_chunk> pending;
+  vsx_ma_vector<unsigned char> encoded;
+  vsx_nw_vector<vsx_profiler_trace_block> index;
+  vsx_nw_vector<uint64_t> thread_ids;
+  vsx_nw_vector<uint64_t> plot_ids;
+  uint64_t chunk_count = 0;
+
+  void flush_block();
+
+public:
+
+  // 1 MB of chunks before encoding
+  static const size_t block_chunks = 16384;
+
+  ~vsx_profiler_trace_writer()
+  {
+    close();
+  }
+
+  bool open(const char* filename);
+  void write(vsx_profile_chunk* chunks, size_t count);
+
+  // writes the last block, the index and the footer
+  void close();
+
+  static void encode(vsx_profile_chunk* chunks, size_t count, vsx_ma_vector<unsigned char>& result);
+};
+
+
+class COMMON_DLLIMPORT vsx_profiler_trace_reader
+{
+  FILE* fp = 0x0;
+  bool raw = false;
+  vsx_nw_vector<vsx_profiler_trace_block> blocks;
+  vsx_nw_vector<uint64_t> thread_ids;
+  vsx_nw_vector<uint64_t> plot_ids;
+  uint64_t chunk_count = 0;
+  vsx_ma_vector<unsigned char> compressed;
+  vsx_ma_vector<unsigned char> encoded;
+
+  bool open_index(uint64_t file_size);
+  bool open_blocks(uint64_t file_size);
+  bool open_raw(uint64_t file_size);
+  void scan_blocks();
+
+public:
+
+  ~vsx_profiler_trace_reader()
+  {
+    close();
+  }
+
+  bool open(const char* filename);
+  void close();
+
+  size_t get_block_count()
+  {
+    return blocks.size();
+  }
+
+  vsx_profiler_trace_block& get_block(size_t index)
+  {
+    return blocks[index];
+  }
+
+  uint64_t get_chunk_count()
+  {
+    return chunk_count;
+  }
+
+  vsx_nw_vector<uint64_t>& get_thread_ids()
+  {
+    return thread_ids;
+  }
+
+  vsx_nw_vector<uint64_t>& get_plot_ids()
+  {
+    return plot_ids;
+  }
+
+  // replaces the contents of chunks with the ones in block index
+  bool read_block(size_t index, vsx_ma_vector<vsx_profile_chunk>& chunks);
+
+  static bool decode(unsigned char* data, size_t size, size_t count, vsx_ma_vector<vsx_profile_chunk>& result);
+};
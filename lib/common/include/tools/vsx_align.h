@@ -1,5 +1,6 @@
 #pragma once
 
+#include <xmmintrin.h>
 #include <vsx_platform.h>
 
 namespace vsx
@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <atomic>
 #include <vsx_platform.h>
 
@@ -118,4 +119,43 @@ public:
     return true;
   }
 
+
+  // producer - writes as many of the values as there is room for
+  // returns:
+  //   number of values written
+  inline size_t produce(const T* values, size_t count)
+  {
+    size_t room = buffer_size - (size_t)live_count.load();
+    if (count > room)
+      count = room;
+
+    uint64_t pointer = write_pointer.load();
+    for (size_t i = 0; i < count; i++)
+      buffer[ (pointer + 1 + i) & (buffer_size-1) ] = values[i];
+    write_pointer.store(pointer + count);
+
+    // make all of them available at once
+    live_count.fetch_add(count);
+    return count;
+  }
+
+
+  // consumer - reads up to count values
+  // returns:
+  //   number of values read
+  inline size_t consume(T* result, size_t count)
+  {
+    size_t available = (size_t)live_count.load();
+    if (count > available)
+      count = available;
+
+    uint64_t pointer = read_pointer.load();
+    for (size_t i = 0; i < count; i++)
+      result[i] = buffer[ (pointer + 1 + i) & (buffer_size-1) ];
+    read_pointer.store(pointer + count);
+
+    live_count.fetch_sub(count);
+    return count;
+  }
+
 };
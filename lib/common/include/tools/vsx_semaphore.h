@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vsx_platform.h>
+
+#if PLATFORM_FAMILY == PLATFORM_FAMILY_WINDOWS
+  #include <windows.h>
+#else
+  #include <errno.h>
+  #include <semaphore.h>
+#endif
+
+/**
+ * Counting semaphore.
+ * post() neither blocks nor takes a lock, so a real-time thread (an audio
+ * callback) can use it to wake a worker without the lost wakeups of a
+ * condition variable notified outside its mutex.
+ */
+class vsx_semaphore
+{
+#if PLATFORM_FAMILY == PLATFORM_FAMILY_WINDOWS
+  HANDLE handle;
+#else
+  sem_t semaphore;
+#endif
+
+public:
+
+  vsx_semaphore()
+  {
+    #if PLATFORM_FAMILY == PLATFORM_FAMILY_WINDOWS
+      handle = CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+    #else
+      sem_init(&semaphore, 0, 0);
+    #endif
+  }
+
+  vsx_semaphore(const vsx_semaphore&) = delete;
+  vsx_semaphore& operator=(const vsx_semaphore&) = delete;
+
+  ~vsx_semaphore()
+  {
+    #if PLATFORM_FAMILY == PLATFORM_FAMILY_WINDOWS
+      CloseHandle(handle);
+    #else
+      sem_destroy(&semaphore);
+    #endif
+  }
+
+  inline void post()
+  {
+    #if PLATFORM_FAMILY == PLATFORM_FAMILY_WINDOWS
+      ReleaseSemaphore(handle, 1, NULL);
+    #else
+      sem_post(&semaphore);
+    #endif
+  }
+
+  // blocks until the count is above 0, then decrements it
+  inline void wait()
+  {
+    #if PLATFORM_FAMILY == PLATFORM_FAMILY_WINDOWS
+      WaitForSingleObject(handle, INFINITE);
+    #else
+      while (sem_wait(&semaphore) == -1 && errno == EINTR)
+        continue;
+    #endif
+  }
+};
@@ -1,7 +1,8 @@
 #pragma once
 
 #include <vector>
-#include <queue>
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <thread>
 #include <mutex>
@@ -14,11 +15,23 @@
 #include <tools/vsx_foreach.h>
 #include <string/vsx_printf.h>
 #include <debug/vsx_backtrace.h>
+#include <tools/vsx_thread_pool_task.h>
 
 #if PLATFORM_FAMILY == PLATFORM_FAMILY_WINDOWS
 #include <windows.h>
 #endif
 
+/*
+  Worker threads with two kinds of queues:
+
+  - one shared priority queue for add() and add_ordered(): coarse tasks that
+    need a future or an order (loaders, engine components, module jobs)
+  - a work-stealing deque per worker for task_group and parallel_for: fine
+    grained tasks, submitted without allocating. A worker pops the newest task
+    from its own deque and steals the oldest from the others when it runs dry.
+
+  Workers prefer deque work: someone is usually blocked waiting for a group.
+*/
 template<int Td = 1>
 class vsx_thread_pool
 {
@@ -30,13 +43,124 @@ public:
     high_priority
   };
 
+  /*
+    A set of tasks to wait for. wait() runs queued tasks on the calling thread
+    while there are any, then blocks until the rest are done, so it's safe to
+    use from within a pool task.
+
+    Example:
+      vsx_thread_pool<>::task_group group;
+      for_n(i, 0, count)
+        group.run( [&, i](){ work(i); } );
+      group.wait();
+  */
+  class task_group
+  {
+    vsx_thread_pool* pool;
+    size_t pending = 0;
+    size_t spawned = 0;
+    std::atomic<bool> waiting;
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    template<typename F>
+    struct group_task
+    {
+      task_group* group;
+      F f;
+
+      void operator()()
+      {
+        f();
+        group->done();
+      }
+    };
+
+    void done()
+    {
+      // under the lock, so the group can't be gone before notify returns
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--pending == 0)
+        finished.notify_all();
+    }
+
+  public:
+
+    task_group()
+      :
+      pool(instance())
+    {
+      waiting = false;
+    }
+
+    explicit task_group(vsx_thread_pool* thread_pool)
+      :
+      pool(thread_pool)
+    {
+      waiting = false;
+    }
+
+    ~task_group()
+    {
+      wait();
+    }
+
+    template<typename F>
+    void run(F&& f)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending++;
+      }
+      group_task<typename std::decay<F>::type> t = {this, std::forward<F>(f)};
+      pool->push_local( vsx_thread_pool_task(std::move(t)) );
+
+      // wake wait() to help with the new task
+      if (waiting.load())
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        spawned++;
+        finished.notify_all();
+      }
+    }
+
+    void wait()
+    {
+      forever
+      {
+        size_t seen;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          if (!pending)
+            return;
+          seen = spawned;
+          // set before looking for tasks, so run() either pushes a task
+          // pop_local finds or sees the flag and wakes us
+          waiting = true;
+        }
+
+        vsx_thread_pool_task task;
+        if (pool->pop_local(task))
+        {
+          waiting = false;
+          pool->run_task(task);
+          continue;
+        }
+
+        // the rest is running; sleep until it's done or adds tasks
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this, seen]{ return pending == 0 || spawned != seen; });
+        waiting = false;
+      }
+    }
+  };
+
   explicit vsx_thread_pool(size_t threads = std::thread::hardware_concurrency())
-    :
-    tasks(
-      [](prioritized_task l, prioritized_task r){ return std::get<0>(l) < std::get<0>(r); }
-    )
   {
     tasks_queued = 0;
+    local_count = 0;
+    sleeping = 0;
+    next_queue = 0;
 
     if (Td == 0)
     {
@@ -56,33 +180,19 @@ public:
         threads -= 1 * Td;
     }
 
+    if (!threads)
+      threads = 1;
+
     vsx_printf(L"INFO: initializing thread pool with %d threads\n", (int)threads)
 
+    for_n (i, 0, threads)
+      queues.push_back( std::unique_ptr<worker_queue>(new worker_queue) );
+
     for_n (i, 0, threads)
       workers.emplace_back(
-        [this]
+        [this, i]
         {
-          forever
-          {
-            std::function<void()> task;
-
-            {
-              std::unique_lock<std::mutex> lock(this->queue_mutex);
-
-              // waits if not stopping
-              // waits if tasks empty
-              this->condition.wait(lock, [this]{ return this->stop || !this->tasks.empty(); });
-
-              if(this->stop && this->tasks.empty())
-                return;
-
-              task = std::get<1>(std::move(this->tasks.top()));
-              this->tasks.pop();
-            }
-
-            task();
-            this->tasks_queued--;
-          }
+          worker_loop(i);
         }
       );
   }
@@ -103,25 +213,15 @@ public:
   inline auto add(priority p, F&& f, Args&&... args)
     -> std::future<typename std::result_of<F(Args...)>::type>
   {
-    tasks_queued++;
-
     using return_type = typename std::result_of<F(Args...)>::type;
 
-    auto task = std::make_shared< std::packaged_task<return_type()> >(
+    // the future's shared state is the only allocation
+    std::packaged_task<return_type()> task(
         std::bind(std::forward<F>(f), std::forward<Args>(args)...)
       );
 
-    std::future<return_type> res = task->get_future();
-    {
-      std::unique_lock<std::mutex> lock(queue_mutex);
-
-      // don't allow enqueueing after stopping the pool
-      if(stop)
-        throw std::runtime_error("enqueue on stopped thread_pool");
-
-      tasks.emplace(prioritized_task( static_cast<int>(p), [task](){ (*task)(); } ));
-    }
-    condition.notify_one();
+    std::future<return_type> res = task.get_future();
+    push_global( priority_key(p), vsx_thread_pool_task(std::move(task)) );
     return res;
   }
 
@@ -133,23 +233,71 @@ public:
     return add(normal_priority, f, args...);
   }
 
+  // Add a task ordered by a full 64 bit key, larger keys run first.
+  // The top 8 bits are the priority, see priority_key(), the rest is free
+  // for the caller to order tasks within a priority.
+  template<class F>
+  inline void add_ordered(uint64_t key, F&& f)
+  {
+    push_global( key, vsx_thread_pool_task(std::forward<F>(f)) );
+  }
+
+  static inline uint64_t priority_key(priority p)
+  {
+    return ((uint64_t)p) << 56;
+  }
+
+  // task_group work that didn't fit in a worker's deque; someone is waiting
+  // for its group, so it goes ahead of everything else in the shared queue
+  static inline uint64_t local_overflow_key()
+  {
+    return priority_key(high_priority) | 0x00FFFFFFFFFFFFFFULL;
+  }
+
+  // Calls f(range_begin, range_end) for sub ranges of [begin, end) no larger
+  // than grain, spread over the workers, and returns when all are done.
+  // The calling thread works on the range too.
+  template<class F>
+  void parallel_for(size_t begin, size_t end, size_t grain, F f)
+  {
+    if (begin >= end)
+      return;
+
+    if (!grain)
+      grain = 1;
+
+    if (end - begin <= grain)
+    {
+      f(begin, end);
+      return;
+    }
+
+    task_group group(this);
+    parallel_for_split(group, begin, end, grain, &f);
+    group.wait();
+  }
+
+  inline size_t get_thread_count()
+  {
+    return workers.size();
+  }
+
   inline bool is_jobless()
   {
-    return tasks.empty();
+    return tasks.empty() && !local_count.load();
   }
 
   inline bool wait_all(size_t milliseconds)
   {
-    foreach(workers, i)
-      if (std::this_thread::get_id() == workers[i].get_id())
-      {
-        vsx_printf(L"\n\n\n\nWARNING!!! DO NOT RUN THREAD POOL WAIT ALL INSIDE A THREAD POOL TASK!!!\n      If the pool is filled, you end up with a deadlock. \n\n");
-        return false;
-      }
-
-    while (tasks_queued.load())
-      std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    VSX_UNUSED(milliseconds);
+    if (current_worker().pool == this)
+    {
+      vsx_printf(L"\n\n\n\nWARNING!!! DO NOT RUN THREAD POOL WAIT ALL INSIDE A THREAD POOL TASK!!!\n      If the pool is filled, you end up with a deadlock. \n\n");
+      return false;
+    }
 
+    std::unique_lock<std::mutex> lock(queue_empty_mutex);
+    queue_empty_condition.wait(lock, [this]{ return tasks_queued.load() == 0; });
     return true;
   }
 
@@ -168,19 +316,245 @@ public:
   }
 
 private:
+
+  // bounded so pushing never allocates, a full deque spills to the shared queue
+  struct worker_queue
+  {
+    static const size_t capacity = 256;
+    std::mutex lock;
+    std::atomic<size_t> count;
+    size_t top = 0; // oldest, stolen from here
+    size_t bottom = 0; // newest, the owner works here
+    vsx_thread_pool_task tasks[capacity];
+
+    worker_queue()
+    {
+      count = 0;
+    }
+
+    bool push(vsx_thread_pool_task& task)
+    {
+      std::lock_guard<std::mutex> l(lock);
+      if (bottom - top == capacity)
+        return false;
+      tasks[bottom % capacity] = std::move(task);
+      bottom++;
+      count++;
+      return true;
+    }
+
+    bool pop(vsx_thread_pool_task& task)
+    {
+      if (!count.load())
+        return false;
+      std::lock_guard<std::mutex> l(lock);
+      if (bottom == top)
+        return false;
+      bottom--;
+      task = std::move(tasks[bottom % capacity]);
+      count--;
+      return true;
+    }
+
+    bool steal(vsx_thread_pool_task& task)
+    {
+      if (!count.load())
+        return false;
+      std::lock_guard<std::mutex> l(lock);
+      if (bottom == top)
+        return false;
+      task = std::move(tasks[top % capacity]);
+      top++;
+      count--;
+      return true;
+    }
+  };
+
+  struct worker_identity
+  {
+    void* pool;
+    size_t index;
+  };
+
+  static worker_identity& current_worker()
+  {
+    static thread_local worker_identity identity = {0x0, 0};
+    return identity;
+  }
+
+  template<class F>
+  static void parallel_for_split(task_group& group, size_t begin, size_t end, size_t grain, F* f)
+  {
+    // hand out the upper half until the rest is small enough to run here
+    while (end - begin > grain)
+    {
+      size_t middle = begin + (end - begin) / 2;
+      task_group* g = &group;
+      group.run(
+        [g, middle, end, grain, f]()
+        {
+          parallel_for_split(*g, middle, end, grain, f);
+        }
+      );
+      end = middle;
+    }
+    (*f)(begin, end);
+  }
+
+  void wake_worker()
+  {
+    if (!sleeping.load())
+      return;
+    // a worker between checking for work and sleeping holds the mutex
+    {
+      std::lock_guard<std::mutex> lock(queue_mutex);
+    }
+    condition.notify_one();
+  }
+
+  void push_global(uint64_t key, vsx_thread_pool_task task)
+  {
+    tasks_queued++;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex);
+
+      // don't allow enqueueing after stopping the pool
+      if(stop)
+        throw std::runtime_error("enqueue on stopped thread_pool");
+
+      tasks.push_back( prioritized_task(key, std::move(task)) );
+      std::push_heap(tasks.begin(), tasks.end(), prioritized_task_less);
+    }
+    condition.notify_one();
+  }
+
+  void push_local(vsx_thread_pool_task task)
+  {
+    worker_identity& self = current_worker();
+    size_t index =
+        self.pool == this
+          ? self.index
+          : next_queue++ % queues.size();
+
+    tasks_queued++;
+    local_count++;
+    if (!queues[index]->push(task))
+    {
+      local_count--;
+      tasks_queued--;
+      push_global( local_overflow_key(), std::move(task) );
+      return;
+    }
+    wake_worker();
+  }
+
+  // own deque first, then steal
+  bool pop_local(vsx_thread_pool_task& task)
+  {
+    worker_identity& self = current_worker();
+    size_t first = 0;
+    if (self.pool == this)
+    {
+      if (queues[self.index]->pop(task))
+      {
+        local_count--;
+        return true;
+      }
+      first = self.index + 1;
+    }
+
+    for_n (i, 0, queues.size())
+      if (queues[(first + i) % queues.size()]->steal(task))
+      {
+        local_count--;
+        return true;
+      }
+
+    return false;
+  }
+
+  bool pop_global(vsx_thread_pool_task& task)
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    if (tasks.empty())
+      return false;
+    std::pop_heap(tasks.begin(), tasks.end(), prioritized_task_less);
+    task = std::move(tasks.back().task);
+    tasks.pop_back();
+    return true;
+  }
+
+  void run_task(vsx_thread_pool_task& task)
+  {
+    task();
+    task.reset();
+
+    if (--tasks_queued == 0)
+    {
+      std::lock_guard<std::mutex> lock(queue_empty_mutex);
+      queue_empty_condition.notify_all();
+    }
+  }
+
+  void worker_loop(size_t index)
+  {
+    current_worker().pool = this;
+    current_worker().index = index;
+
+    forever
+    {
+      vsx_thread_pool_task task;
+
+      if (pop_local(task) || pop_global(task))
+      {
+        run_task(task);
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(this->queue_mutex);
+      sleeping++;
+
+      // waits if not stopping
+      // waits if tasks empty
+      this->condition.wait(lock, [this]{ return this->stop || !this->tasks.empty() || this->local_count.load(); });
+      sleeping--;
+
+      if(this->stop && this->tasks.empty() && !this->local_count.load())
+        return;
+    }
+  }
+
   // need to keep track of threads so we can join them
   std::vector< std::thread > workers;
+  std::vector< std::unique_ptr<worker_queue> > queues;
+  std::atomic<size_t> next_queue;
+
+  // the shared task queue, a heap on the key
+  struct prioritized_task
+  {
+    uint64_t key;
+    vsx_thread_pool_task task;
+
+    prioritized_task(uint64_t k, vsx_thread_pool_task&& t)
+      :
+      key(k),
+      task(std::move(t))
+    {}
+  };
+
+  static bool prioritized_task_less(const prioritized_task& l, const prioritized_task& r)
+  {
+    return l.key < r.key;
+  }
 
-  // the task queue
-  using prioritized_task = std::tuple< uint64_t, std::function<void()> >;
-  std::priority_queue< prioritized_task,
-                       std::vector<prioritized_task>,
-                       std::function<bool(prioritized_task, prioritized_task)> > tasks;
+  std::vector<prioritized_task> tasks;
 
   // synchronization
   std::mutex queue_mutex;
   std::condition_variable condition;
   bool stop = false;
+  std::atomic<size_t> local_count;
+  std::atomic<size_t> sleeping;
 
   // More synchronization for wait_all()
   std::atomic<uint64_t> tasks_queued;
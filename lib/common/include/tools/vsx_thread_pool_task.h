@@ -0,0 +1,157 @@
+#pragma once
+
+#include <stddef.h>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+/*
+  A move-only void() callable for the thread pool queues.
+
+  Callables up to storage_size bytes - a lambda capturing a handful of
+  pointers and sizes - live inside the task, so submitting one does not touch
+  the heap. Larger ones fall back to new/delete.
+*/
+class vsx_thread_pool_task
+{
+public:
+
+  static const size_t storage_size = 56;
+
+private:
+
+  enum operation
+  {
+    operation_run,
+    operation_move,
+    operation_destroy
+  };
+
+  typedef void (*manager_function)(operation o, void* self, void* other);
+
+  typename std::aligned_storage<storage_size, alignof(void*)>::type storage;
+  manager_function manager = 0x0;
+
+  template<typename F>
+  static void manage_inline(operation o, void* self, void* other)
+  {
+    F* f = (F*)self;
+    switch (o)
+    {
+      case operation_run:
+        (*f)();
+        break;
+      case operation_move:
+        new (other) F(std::move(*f));
+        f->~F();
+        break;
+      case operation_destroy:
+        f->~F();
+        break;
+    }
+  }
+
+  template<typename F>
+  static void manage_heap(operation o, void* self, void* other)
+  {
+    F** f = (F**)self;
+    switch (o)
+    {
+      case operation_run:
+        (**f)();
+        break;
+      case operation_move:
+        *(F**)other = *f;
+        break;
+      case operation_destroy:
+        delete *f;
+        break;
+    }
+  }
+
+  template<typename Fd, typename F>
+  void construct(F&& f, std::true_type)
+  {
+    new (&storage) Fd(std::forward<F>(f));
+    manager = &manage_inline<Fd>;
+  }
+
+  template<typename Fd, typename F>
+  void construct(F&& f, std::false_type)
+  {
+    *(Fd**)&storage = new Fd(std::forward<F>(f));
+    manager = &manage_heap<Fd>;
+  }
+
+  void move_from(vsx_thread_pool_task& other)
+  {
+    manager = other.manager;
+    if (manager)
+      manager(operation_move, &other.storage, &storage);
+    other.manager = 0x0;
+  }
+
+public:
+
+  vsx_thread_pool_task()
+  {}
+
+  template<
+    typename F,
+    typename Fd = typename std::decay<F>::type,
+    typename = typename std::enable_if< !std::is_same<Fd, vsx_thread_pool_task>::value >::type
+  >
+  vsx_thread_pool_task(F&& f)
+  {
+    construct<Fd>(
+      std::forward<F>(f),
+      std::integral_constant<bool,
+        sizeof(Fd) <= storage_size
+        &&
+        alignof(Fd) <= alignof(void*)
+        &&
+        std::is_nothrow_move_constructible<Fd>::value
+      >()
+    );
+  }
+
+  vsx_thread_pool_task(vsx_thread_pool_task&& other)
+  {
+    move_from(other);
+  }
+
+  vsx_thread_pool_task& operator=(vsx_thread_pool_task&& other)
+  {
+    if (this != &other)
+    {
+      reset();
+      move_from(other);
+    }
+    return *this;
+  }
+
+  vsx_thread_pool_task(const vsx_thread_pool_task&) = delete;
+  vsx_thread_pool_task& operator=(const vsx_thread_pool_task&) = delete;
+
+  ~vsx_thread_pool_task()
+  {
+    reset();
+  }
+
+  void reset()
+  {
+    if (manager)
+      manager(operation_destroy, &storage, 0x0);
+    manager = 0x0;
+  }
+
+  explicit operator bool() const
+  {
+    return manager != 0x0;
+  }
+
+  void operator()()
+  {
+    manager(operation_run, &storage, 0x0);
+  }
+};
@@ -23,11 +23,49 @@
 
 #include <command/vsx_command.h>
 #include <time.h>
+#include <mutex>
+#include <unordered_map>
 
 int vsx_command_s::id = 0;
 
 std::vector<vsx_command_s*> vsx_command_garbage_list;
 
+// FNV-1a
+struct vsx_command_name_hash
+{
+  size_t operator()(const vsx_string<>& name) const
+  {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < name.size(); i++)
+    {
+      hash ^= (unsigned char)name[i];
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+};
+
+static std::mutex vsx_command_id_lock;
+static std::unordered_map< vsx_string<>, uint32_t, vsx_command_name_hash > vsx_command_ids;
+
+uint32_t vsx_command_id_register(const vsx_string<>& name)
+{
+  std::lock_guard<std::mutex> lock(vsx_command_id_lock);
+  uint32_t& id = vsx_command_ids[name];
+  if (!id)
+    id = (uint32_t)vsx_command_ids.size();
+  return id;
+}
+
+uint32_t vsx_command_id_find(const vsx_string<>& name)
+{
+  std::lock_guard<std::mutex> lock(vsx_command_id_lock);
+  std::unordered_map< vsx_string<>, uint32_t, vsx_command_name_hash >::iterator it = vsx_command_ids.find(name);
+  if (it == vsx_command_ids.end())
+    return 0;
+  return it->second;
+}
+
 void vsx_command_process_garbage()
 {
   if (!vsx_command_garbage_list.size())
@@ -103,6 +141,7 @@ void vsx_command_s::parse() {
   vsx_string<>deli = " ";
   vsx_string_helper::explode(raw, deli, cmdps);
   cmd = cmdps[0];
+  cmd_id = vsx_command_id_find(cmd);
   if (cmdps.size() > 1)
   {
     cmd_data = cmdps[1];
@@ -31,6 +31,12 @@
 
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <fcntl.h>
+#include <poll.h>
+
+#if PLATFORM == PLATFORM_LINUX
+  #include <sys/epoll.h>
+#endif
 
 #include <container/vsx_nw_vector.h>
 #include <filesystem/vsx_filesystem.h>
@@ -59,6 +65,41 @@ void *get_in_addr(struct sockaddr *sa)
     return &(((struct sockaddr_in6*)sa)->sin6_addr);
 }
 
+// self-pipe: the adding thread writes a byte, the worker waits for it
+// alongside its sockets and drains it before taking the commands
+static bool wakeup_pipe_create(int* fds, vsx_command_list* list)
+{
+  reqrv(pipe(fds) == 0, false);
+  fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+  fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL, 0) | O_NONBLOCK);
+
+  // a full pipe already means "wake up", so a failed write is fine
+  int write_fd = fds[1];
+  list->set_add_notify(
+    [write_fd]()
+    {
+      char c = 1;
+      ssize_t written = write(write_fd, &c, 1);
+      VSX_UNUSED(written);
+    }
+  );
+  return true;
+}
+
+static void wakeup_pipe_drain(int read_fd)
+{
+  char buf[256];
+  while (read(read_fd, buf, sizeof(buf)) > 0)
+    ;
+}
+
+// dead peers are found by the kernel instead of by sending "_" now and then
+static void socket_keepalive(int sock)
+{
+  int flag = 1;
+  setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, (char *) &flag, sizeof(int));
+}
+
 vsx_command_list_server::vsx_command_list_server()
 {
   cmd_in = cmd_out = 0;
@@ -80,10 +121,193 @@ void vsx_command_list_server::set_command_lists(vsx_command_list* new_in,
 bool vsx_command_list_server::start()
 {
   if (!cmd_in || !cmd_out) return false;
+  if (!wakeup_pipe_create(wakeup_pipe, cmd_out)) return false;
   worker_thread = std::thread( [this](){ server_worker(); } );
   return true;
 }
 
+vsx_command_list_server::connection* vsx_command_list_server::connection_get(int sock)
+{
+  foreach (connections, i)
+    if (connections[i]->sock == sock)
+      return connections[i];
+  return 0x0;
+}
+
+void vsx_command_list_server::connection_accept(int listen_sock)
+{
+  struct sockaddr_storage their_addr;
+  socklen_t addr_size = sizeof their_addr;
+  char s[INET6_ADDRSTRLEN];
+
+  int sock = accept(
+    listen_sock,
+    (struct sockaddr *)&their_addr,
+    &addr_size
+  );
+  req(sock != -1);
+
+  inet_ntop(
+    their_addr.ss_family,
+    get_in_addr((struct sockaddr *)&their_addr),
+    s,
+    sizeof s
+  );
+  printf("server: got connection from %s\n", s);
+
+  fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+  int flag = 1;
+  setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char *) &flag, sizeof(int));
+  socket_keepalive(sock);
+
+  connection* c = new connection;
+  c->sock = sock;
+  connections.push_back(c);
+
+  #if PLATFORM == PLATFORM_LINUX
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = sock;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sock, &event);
+  #endif
+
+  vsx_string<>welcome = ">>VSXu Server 0.3.0\n";
+  connection_send(c, welcome.c_str(), welcome.size());
+}
+
+bool vsx_command_list_server::connection_read(connection* c)
+{
+  char recv_buf[BUFLEN];
+  bool keep = true;
+
+  forever
+  {
+    ssize_t size_recv = recv(c->sock, recv_buf, BUFLEN, 0);
+
+    if (size_recv == 0)
+      return false;
+
+    if (size_recv == -1)
+    {
+      if (EAGAIN == errno || EWOULDBLOCK == errno)
+        return keep;
+      if (EINTR == errno)
+        continue;
+      return false;
+    }
+
+    bool valid = c->reader.feed(
+      recv_buf,
+      (size_t)size_recv,
+      [&](vsx_string<>& line)
+      {
+        if (line == "dc")
+        {
+          keep = false;
+          return;
+        }
+        if (line == "_")
+          return;
+        cmd_in->add_raw(line);
+      },
+      [&](vsx_nw_vector< vsx_string<> >& parts)
+      {
+        cmd_in->add_parts(parts);
+      }
+    );
+
+    if (!valid)
+    {
+      printf("malformed frame. closing socket...\n");
+      return false;
+    }
+  }
+}
+
+bool vsx_command_list_server::connection_send(connection* c, const char* data, size_t size)
+{
+  reqrv(size, true);
+
+  // already queued data goes first
+  if (c->outgoing.size())
+  {
+    size_t offset = c->outgoing.size();
+    c->outgoing.allocate(offset + size - 1);
+    memcpy(c->outgoing.get_pointer() + offset, data, size);
+    return true;
+  }
+
+  ssize_t sent = send(c->sock, data, size, MSG_NOSIGNAL);
+  if (sent == -1)
+  {
+    if (EAGAIN != errno && EWOULDBLOCK != errno)
+      return false;
+    sent = 0;
+  }
+
+  if ((size_t)sent == size)
+    return true;
+
+  // socket buffer full, keep the rest until it's writable
+  c->outgoing.allocate(size - sent - 1);
+  memcpy(c->outgoing.get_pointer(), data + sent, size - sent);
+  c->outgoing_sent = 0;
+
+  #if PLATFORM == PLATFORM_LINUX
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.fd = c->sock;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c->sock, &event);
+  #endif
+  return true;
+}
+
+bool vsx_command_list_server::connection_flush(connection* c)
+{
+  while (c->outgoing_sent < c->outgoing.size())
+  {
+    ssize_t sent = send(
+      c->sock,
+      c->outgoing.get_pointer() + c->outgoing_sent,
+      c->outgoing.size() - c->outgoing_sent,
+      MSG_NOSIGNAL
+    );
+    if (sent == -1)
+    {
+      if (EAGAIN == errno || EWOULDBLOCK == errno)
+        return true;
+      return false;
+    }
+    c->outgoing_sent += sent;
+  }
+
+  c->outgoing.reset_used(0);
+  c->outgoing_sent = 0;
+
+  #if PLATFORM == PLATFORM_LINUX
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = c->sock;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c->sock, &event);
+  #endif
+  return true;
+}
+
+void vsx_command_list_server::connection_close(connection* c)
+{
+  printf("closing connection %d\n", c->sock);
+  #if PLATFORM == PLATFORM_LINUX
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c->sock, 0x0);
+  #endif
+  close(c->sock);
+  connections.remove_value(c);
+  delete c;
+}
+
 void vsx_command_list_server::server_worker()
 {
   printf("server starting...\n");
@@ -91,29 +315,19 @@ void vsx_command_list_server::server_worker()
   int status;
   struct addrinfo hints;
   struct addrinfo *servinfo;  // will point to the results
-  struct sockaddr_storage their_addr;
-  char recv_buf[BUFLEN];
-  socklen_t addr_size;
   int tr=1;
-  char s[INET6_ADDRSTRLEN];
-  bool run = true;
-  ssize_t size_recv;
-  int keepalive_timer = 0;
-  vsx_string<>message_stack;
 
   memset(&hints, 0, sizeof hints); // make sure the struct is empty
   hints.ai_family = AF_INET; //AF_INET6 or AF_UNSPEC
   hints.ai_socktype = SOCK_STREAM; // TCP stream sockets
   hints.ai_flags = AI_PASSIVE;     // fill in my IP for me
 
-  printf("a\n");
-
   if ((status = getaddrinfo(NULL, "11030", &hints, &servinfo)) != 0)
   {
     printf("getaddrinfo error: %s\n", gai_strerror(status));
     exit(1);
   }
-  printf("b\n");
+
   listen_sock = socket(
     servinfo->ai_family,
     servinfo->ai_socktype,
@@ -122,8 +336,6 @@ void vsx_command_list_server::server_worker()
     printf("error in socket\n\n");
     handle_error("socket");
   }
-  printf("c socket id: %d\n",listen_sock);
-
 
   // kill "Address already in use" error message
   if (setsockopt(listen_sock,SOL_SOCKET,SO_REUSEADDR,&tr,sizeof(int)) == -1)
@@ -131,172 +343,152 @@ void vsx_command_list_server::server_worker()
     printf("error in setsockopt\n");
     handle_error("setsockopt\n");
   }
-  printf("d\n");
 
   if (bind(listen_sock, servinfo->ai_addr, servinfo->ai_addrlen) == -1)
   {
     printf("error in bind\n");
     handle_error("bind");
   }
-  printf("e\n");
 
   freeaddrinfo(servinfo);
-  printf("f\n");
 
   if (listen(listen_sock,5) == -1) {
     printf("error listen\n");
     handle_error("bind");
   }
-  printf("g\n");
 
-  addr_size = sizeof their_addr;
+  #if PLATFORM == PLATFORM_LINUX
+    epoll_fd = epoll_create1(0);
+    if (epoll_fd == -1)
+    {
+      printf("error in epoll_create1\n");
+      handle_error("epoll_create1");
+    }
 
-  forever
-  {
-    printf("waiting for connection...\n");
-    run = true;
-    int recv_sock = accept(
-                            listen_sock,
-                            (struct sockaddr *)&their_addr,
-                            &addr_size
-                          );
-
-    inet_ntop(
-      their_addr.ss_family,
-      get_in_addr((struct sockaddr *)&their_addr),
-      s,
-      sizeof s
-    );
-    printf("server: got connection from %s\n", s);
-    //
+    struct epoll_event listen_event;
+    memset(&listen_event, 0, sizeof(listen_event));
+    listen_event.events = EPOLLIN;
+    listen_event.data.fd = listen_sock;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_sock, &listen_event);
 
-    vsx_string<>welcome = ">>VSXu Server 0.3.0\n";
+    struct epoll_event wakeup_event;
+    memset(&wakeup_event, 0, sizeof(wakeup_event));
+    wakeup_event.events = EPOLLIN;
+    wakeup_event.data.fd = wakeup_pipe[0];
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup_pipe[0], &wakeup_event);
 
-    send(
-      recv_sock,
-      welcome.c_str(),
-      welcome.size(),
-      0
-    );
+    const int max_events = 64;
+    struct epoll_event events[max_events];
+  #else
+    vsx_nw_vector<struct pollfd> poll_fds;
+  #endif
 
-    memset(&recv_buf,0,BUFLEN);
-    while (run)
-    {
-      size_recv = recv(recv_sock, &recv_buf, BUFLEN, MSG_DONTWAIT);
-      if (size_recv == -1)
+  vsx_nw_vector<connection*> closing;
+  vsx_string<> outgoing;
+
+  printf("waiting for connections...\n");
+
+  forever
+  {
+    // sleeps until a client or cmd_out has something
+    #if PLATFORM == PLATFORM_LINUX
+      int event_count = epoll_wait(epoll_fd, events, max_events, -1);
+      for (int i = 0; i < event_count; i++)
       {
-        if (EAGAIN != errno && EWOULDBLOCK != errno)
+        if (events[i].data.fd == listen_sock)
         {
-          printf("EAGAIN / EWOULDBLOCK. closing socket...\n");
-          close(recv_sock);
-          run = false;
+          connection_accept(listen_sock);
+          continue;
         }
-      }
-      //printf("status: %d\n",status);
 
-      vsx_command_s *out_command;
-      int count_sent = 0;
-      while (cmd_out->pop(&out_command))
-      {
-        //printf("sending command: %s\n",out_command->str().c_str() );
-        vsx_string<>res = out_command->str()+"\n";
-        if (send(
-          recv_sock,
-          res.c_str(),
-          res.size(),
-          MSG_NOSIGNAL
-        ) == -1) {
-          printf("error in sending. closing socket...\n");
-          close(recv_sock);
-          run = false;
-        } else
+        if (events[i].data.fd == wakeup_pipe[0])
         {
-          count_sent++;
+          wakeup_pipe_drain(wakeup_pipe[0]);
+          continue;
         }
-      }
-      //printf("after cmd_out loop\n");
-      if (!count_sent) {
-        if (keepalive_timer++ == 150) {
-          vsx_string<>res = "_\n";
-          if (send(
-            recv_sock,
-            res.c_str(),
-            res.size(),
-            MSG_NOSIGNAL
-          ) == -1) {
-            close(recv_sock);
-            run = false;
-          }
-          keepalive_timer = 0;
-        }
-      }
 
-      // need microsecond timing calculation
-      if (size_recv > 0 && size_recv < BUFLEN)
+        connection* c = connection_get(events[i].data.fd);
+        req_continue(c);
+
+        bool keep = true;
+        if (events[i].events & (EPOLLERR | EPOLLHUP))
+          keep = false;
+        if (keep && (events[i].events & EPOLLIN))
+          keep = connection_read(c);
+        if (keep && (events[i].events & EPOLLOUT))
+          keep = connection_flush(c);
+        if (!keep)
+          connection_close(c);
+      }
+    #else
+      poll_fds.reset_used(0);
+      struct pollfd listen_fd;
+      listen_fd.fd = listen_sock;
+      listen_fd.events = POLLIN;
+      listen_fd.revents = 0;
+      poll_fds.push_back(listen_fd);
+      struct pollfd wakeup_fd;
+      wakeup_fd.fd = wakeup_pipe[0];
+      wakeup_fd.events = POLLIN;
+      wakeup_fd.revents = 0;
+      poll_fds.push_back(wakeup_fd);
+      foreach (connections, i)
       {
-        //printf("size_recv: %d\n", size_recv);
-        for (ssize_t i = 0; i < size_recv; i++)
-        {
-          if
-            (
-              (recv_buf[i] == '\n' || recv_buf[i] == '\r')
-              &&
-              message_stack.size()
-            )
-          {
-            //printf("got2: %s___\n",message_stack.c_str());
-            if (message_stack == "dc")
-            {
-              memset(&recv_buf,0,BUFLEN);
-              close(recv_sock);
-              run = false;
-              message_stack = "";
-              //return 0;
-            }
-            else
-            {
-              if (message_stack != "_")
-              {
-                cmd_in->add_raw(message_stack);
-              }
-            }
-            message_stack = "";
-          } else
-          {
-            message_stack.push_back(recv_buf[i]);
-          }
-        }
-        memset(&recv_buf,0,BUFLEN);
+        struct pollfd fd;
+        fd.fd = connections[i]->sock;
+        fd.events = POLLIN;
+        if (connections[i]->outgoing.size())
+          fd.events |= POLLOUT;
+        fd.revents = 0;
+        poll_fds.push_back(fd);
       }
-      usleep(10);
-      /*if (recv_buf[0] != 0)
+
+      if (poll(poll_fds.get_pointer(), poll_fds.size(), -1) > 0)
       {
-        vsx_string<>recv_data(recv_buf);
+        if (poll_fds[1].revents & POLLIN)
+          wakeup_pipe_drain(wakeup_pipe[0]);
 
-        vsx_nw_vector< vsx_string<> > parts;
-        vsx_string<>deli = "\n";
-        vsx_string_helper::explode(recv_data, deli, parts);
-        for (unsigned long i = 0; i < parts.size(); i++)
+        closing.reset_used(0);
+        for (size_t i = 2; i < poll_fds.size(); i++)
         {
-          vsx_string<>* msg = &parts[i];
-          if ((*msg)[msg->size()-1] == '\r') msg->pop_back();
-          if ((*msg)[msg->size()-1] == '\n') msg->pop_back();
-          if ((*msg)[msg->size()-1] == '\r') msg->pop_back();
-          //printf("got2: %s___\n",msg->c_str());
-          if (*msg == "dc")
-          {
-            close(recv_sock);
-            run = false;
-          }
-          else
-          {
-            cmd_in->add_raw(*msg);
-          }
+          connection* c = connections[i - 2];
+          bool keep = true;
+          if (poll_fds[i].revents & (POLLERR | POLLHUP))
+            keep = false;
+          if (keep && (poll_fds[i].revents & POLLIN))
+            keep = connection_read(c);
+          if (keep && (poll_fds[i].revents & POLLOUT))
+            keep = connection_flush(c);
+          if (!keep)
+            closing.push_back(c);
         }
-        memset(&recv_buf,0,size_recv+0x1);
+        foreach (closing, i)
+          connection_close(closing[i]);
+
+        if (poll_fds[0].revents & POLLIN)
+          connection_accept(listen_sock);
       }
-      usleep(10000);*/
+    #endif
+
+    // everything queued for the clients goes out in one send per client
+    outgoing.clear();
+    vsx_command_s *out_command;
+    while (cmd_out->pop(&out_command))
+    {
+      outgoing += out_command->str();
+      outgoing.push_back('\n');
     }
+
+    if (!outgoing.size())
+      continue;
+
+    closing.reset_used(0);
+    foreach (connections, i)
+      if (!connection_send(connections[i], outgoing.c_str(), outgoing.size()))
+        closing.push_back(connections[i]);
+
+    foreach (closing, i)
+      connection_close(closing[i]);
   }
   close(listen_sock);
 }
@@ -322,8 +514,9 @@ void vsx_command_list_client::client_worker()
   char recv_buf[BUFLEN];
   int sock;
   ssize_t size_recv;
-  int keepalive_timer = 0;
   vsx_string<>message_stack;
+  vsx_string<> outgoing;
+  vsx_command_protocol_writer frame_writer;
 
   memset(&hints, 0, sizeof hints); // make sure the struct is empty
   hints.ai_family = AF_UNSPEC;     // don't care IPv4 or IPv6
@@ -353,66 +546,80 @@ void vsx_command_list_client::client_worker()
   {
     handle_error("setsockopt");
   }
+  socket_keepalive(sock);
 
   memset(&recv_buf,0,BUFLEN);
-  bool run = true;
+
+  struct pollfd poll_fds[2];
+  poll_fds[0].fd = sock;
+  poll_fds[0].events = POLLIN;
+  poll_fds[1].fd = wakeup_pipe[0];
+  poll_fds[1].events = POLLIN;
 
   connected = VSX_COMMAND_CLIENT_CONNECTED;
-  while (run)
+  forever
   {
+    // sleeps until the server or cmd_out has something
+    poll_fds[0].revents = poll_fds[1].revents = 0;
+    if (poll(poll_fds, 2, -1) == -1 && EINTR != errno)
+    {
+      close(sock);
+      connected = VSX_COMMAND_CLIENT_DISCONNECTED;
+      return;
+    }
+
+    if (poll_fds[1].revents & POLLIN)
+      wakeup_pipe_drain(wakeup_pipe[0]);
+
     size_recv = recv(sock, &recv_buf, BUFLEN-1, MSG_DONTWAIT);
-    if (size_recv == -1)
+    if (size_recv == 0 || (size_recv == -1 && EAGAIN != errno && EWOULDBLOCK != errno))
     {
-      if (EAGAIN != errno && EWOULDBLOCK != errno)
-      {
-        close(sock);
-        run = false;
-        connected = VSX_COMMAND_CLIENT_DISCONNECTED;
-        //printf("line: %d\n", __LINE__);
-        return;
-      }
+      close(sock);
+      connected = VSX_COMMAND_CLIENT_DISCONNECTED;
+      return;
     }
+    // send everything pending at once
     int count_sent = 0;
     vsx_command_s *out_command;
+    outgoing.clear();
+    frame_writer.clear();
     while (cmd_out.pop(&out_command))
     {
-      vsx_string<>res = out_command->str()+"\n";
-      //printf("sending to server: %s\n", res.c_str() );
-      if (send(
-        sock,
-        res.c_str(),
-        res.size(),
-        MSG_NOSIGNAL
-        ) == -1)
-      {
-          close(sock);
-          cmd_out.add_front(out_command);
-          connected = VSX_COMMAND_CLIENT_DISCONNECTED;
-          //printf("line: %d\n", __LINE__);
-          return;
-      }
+      vsx_string<> command = out_command->str();
+      if (binary)
+        frame_writer.add(command);
       else
       {
-        count_sent++;
+        outgoing += command;
+        outgoing.push_back('\n');
       }
+      count_sent++;
     }
 
-    if (!count_sent) {
-      if (keepalive_timer++ == 150) {
-        vsx_string<>res = "_\n";
-        if (send(
-          sock,
-          res.c_str(),
-          res.size(),
-          MSG_NOSIGNAL
-        ) == -1) {
+    if (count_sent)
+    {
+      const char* data = outgoing.get_pointer();
+      size_t size = outgoing.size();
+      if (binary)
+      {
+        vsx_ma_vector<unsigned char>& frames = frame_writer.get_frames();
+        data = (const char*)frames.get_pointer();
+        size = frames.size();
+      }
+
+      while (size)
+      {
+        ssize_t sent = send(sock, data, size, MSG_NOSIGNAL);
+        if (sent == -1)
+        {
+          if (EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno)
+            continue;
           close(sock);
           connected = VSX_COMMAND_CLIENT_DISCONNECTED;
-          run = false;
-          printf("line: %d\n", __LINE__);
           return;
         }
-        keepalive_timer = 0;
+        data += sent;
+        size -= sent;
       }
     }
 
@@ -441,7 +648,6 @@ void vsx_command_list_client::client_worker()
       }
       memset(&recv_buf,0,BUFLEN);
     }
-    usleep(10);
   }
 }
 
@@ -458,6 +664,8 @@ vsx_command_list* vsx_command_list_client::get_command_list_out()
 bool vsx_command_list_client::client_connect(vsx_string<>&server_a)
 {
   server_address = server_a;
+  if (!wakeup_pipe_create(wakeup_pipe, &cmd_out))
+    return false;
   worker_thread = std::thread( [this](){ client_worker(); });
   return true;
 }
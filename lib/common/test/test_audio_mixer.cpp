@@ -0,0 +1,221 @@
+#include <container/vsx_ma_vector.h>
+#include <string/vsx_string.h>
+#include <audio/vsx_audio_mixer.h>
+#include <audio/vsx_sample.h>
+#include <test/vsx_test.h>
+
+#ifdef main
+#undef main
+#endif
+
+// a sine per side, through the per sample interface only
+class test_channel : public vsx_audio_mixer_channel
+{
+  float gain_value = 1.0f;
+  size_t position_left = 0;
+  size_t position_right = 0;
+  float frequency;
+
+public:
+
+  test_channel(float n)
+    :
+    frequency(n)
+  {}
+
+  int is_active()
+  {
+    return 1;
+  }
+
+  float get_gain()
+  {
+    return gain_value;
+  }
+
+  void set_gain(float n)
+  {
+    gain_value = n;
+  }
+
+  int16_t consume_left()
+  {
+    return (int16_t)(sinf((float)position_left++ * frequency) * 20000.0f);
+  }
+
+  int16_t consume_right()
+  {
+    return (int16_t)(cosf((float)position_right++ * frequency) * 20000.0f);
+  }
+};
+
+class test_sample : public vsx_sample
+{
+public:
+
+  void load_filename(vsx_string<> filename)
+  {
+    VSX_UNUSED(filename);
+  }
+
+  void fill(size_t count)
+  {
+    data.reset_used();
+    for (size_t i = 0; i < count; i++)
+      data.push_back( (int16_t)(sinf((float)i * 0.01f) * 30000.0f) );
+  }
+};
+
+void test_kernels()
+{
+  float a[67], b[67], l[67], r[67];
+  int16_t out[67 * 2];
+
+  // every count up to a few iterations plus tail
+  for (size_t count = 0; count < 67; count++)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      a[i] = 0.25f;
+      b[i] = (float)i * 0.01f;
+    }
+    vsx_audio_mix::add_ramp(a, b, 0.5f, 0.1f, count);
+    for (size_t i = 0; i < count; i++)
+      test_assert( fabsf(a[i] - (0.25f + (float)i * 0.01f * (0.5f + 0.1f * (float)i))) < 1e-4f );
+
+    for (size_t i = 0; i < count; i++)
+    {
+      l[i] = (float)i / 32.0f - 1.0f;
+      r[i] = -l[i] * 1.5f;
+    }
+    vsx_audio_mix::to_int16_interleaved(l, r, out, count);
+    for (size_t i = 0; i < count; i++)
+    {
+      float cl = l[i] > 1.0f ? 1.0f : l[i];
+      float cr = r[i] > 1.0f ? 1.0f : (r[i] < -1.0f ? -1.0f : r[i]);
+      test_assert( abs(out[i * 2] - (int)(cl * 32767.0f)) <= 1 );
+      test_assert( abs(out[i * 2 + 1] - (int)(cr * 32767.0f)) <= 1 );
+    }
+  }
+}
+
+// block mix of channels without consume_block matches mixing them per sample
+void test_mix()
+{
+  test_channel c1(0.01f), c2(0.033f), reference1(0.01f), reference2(0.033f);
+  c2.set_gain(0.5f);
+  reference2.set_gain(0.5f);
+
+  vsx_audio_mixer* mixer = new vsx_audio_mixer;
+  mixer->register_channel(&c1);
+  mixer->register_channel(&c2);
+
+  // more than a mixer block, with a tail
+  const size_t frames = vsx_audio_mixer::block_frames * 3 + 13;
+  int16_t out[frames * 2];
+  mixer->consume_block(out, frames);
+
+  for (size_t i = 0; i < frames; i++)
+  {
+    float l = (float)reference1.consume_left() * one_div_32768 + (float)reference2.consume_left() * one_div_32768 * 0.5f;
+    float r = (float)reference1.consume_right() * one_div_32768 + (float)reference2.consume_right() * one_div_32768 * 0.5f;
+    test_assert( abs(out[i * 2] - (int)roundf(l * 32767.0f)) <= 1 );
+    test_assert( abs(out[i * 2 + 1] - (int)roundf(r * 32767.0f)) <= 1 );
+  }
+
+  // no channels
+  mixer->unregister_channel(&c1);
+  mixer->unregister_channel(&c2);
+  mixer->consume_block(out, frames);
+  for (size_t i = 0; i < frames * 2; i++)
+    test_assert(out[i] == 0);
+
+  delete mixer;
+}
+
+// a gain change is spread over the next block instead of a step
+void test_gain_ramp()
+{
+  class constant_channel : public test_channel
+  {
+  public:
+    constant_channel() : test_channel(0.0f) {}
+    int16_t consume_left() { return 16000; }
+    int16_t consume_right() { return -16000; }
+  } c;
+
+  vsx_audio_mixer* mixer = new vsx_audio_mixer;
+  mixer->register_channel(&c);
+
+  const size_t frames = vsx_audio_mixer::block_frames;
+  int16_t out[frames * 2];
+  mixer->consume_block(out, frames);
+  test_assert(out[0] == out[frames * 2 - 2]);
+
+  c.set_gain(0.0f);
+  mixer->consume_block(out, frames);
+  test_assert(out[0] > 15000);
+  for (size_t i = 1; i < frames; i++)
+  {
+    test_assert(out[i * 2] <= out[i * 2 - 2]);
+    test_assert(out[i * 2 - 2] - out[i * 2] < 100);
+    test_assert(out[i * 2 + 1] == -out[i * 2]);
+  }
+  test_assert(out[frames * 2 - 2] < 100);
+
+  mixer->consume_block(out, frames);
+  for (size_t i = 0; i < frames * 2; i++)
+    test_assert(out[i] == 0);
+
+  delete mixer;
+}
+
+// vsx_sample::consume_block follows the per sample path
+void test_sample_block()
+{
+  for (int stereo = VSX_SAMPLE_MONO; stereo <= VSX_SAMPLE_STEREO; stereo++)
+  {
+    test_sample a, b;
+    a.fill(20000);
+    b.fill(20000);
+    a.set_stereo_type(stereo);
+    b.set_stereo_type(stereo);
+    a.play();
+    b.play();
+    a.set_pitch_bend(0.75f);
+    b.set_pitch_bend(0.75f);
+
+    const size_t frames = 12000;
+    float l[frames], r[frames];
+    a.consume_block(l, r, frames);
+    for (size_t i = 0; i < frames; i++)
+    {
+      float bl = (float)b.consume_left() * one_div_32768;
+      float br = (float)b.consume_right() * one_div_32768;
+      test_assert( fabsf(l[i] - bl) < 1e-3f );
+      test_assert( fabsf(r[i] - br) < 1e-3f );
+    }
+    test_assert( fabsf(a.get_position() - b.get_position()) < 1e-3f );
+
+    // silence on both sides past the end of the data
+    a.consume_block(l, r, frames);
+    a.consume_block(l, r, frames);
+    for (size_t i = frames - 100; i < frames; i++)
+      test_assert(l[i] == 0.0f && r[i] == 0.0f);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  VSX_UNUSED(argc);
+  VSX_UNUSED(argv);
+
+  test_kernels();
+  test_mix();
+  test_gain_ramp();
+  test_sample_block();
+
+  test_complete
+
+  return 0;
+}
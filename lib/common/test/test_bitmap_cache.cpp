@@ -0,0 +1,83 @@
+#include <bitmap/vsx_bitmap_cache.h>
+#include <bitmap/generators/vsx_bitmap_generator_blob.h>
+#include <filesystem/vsx_filesystem.h>
+#include <test/vsx_test.h>
+
+#ifdef main
+#undef main
+#endif
+
+void generate_blob(vsx_bitmap* bitmap)
+{
+  vsx_bitmap_generator_blob::generate_thread(bitmap, 1.0f, 0.1f, 0.0f, 0.0f, vsx_color<>(1.0f, 1.0f, 1.0f, 1.0f), false, 4);
+  vsx_thread_pool<>::instance()->wait_all(1);
+}
+
+// a bitmap kept by the cache comes back generated and isn't generated again
+void test_revive_generate()
+{
+  vsx_bitmap_cache cache;
+  vsx_string<> handle = "blob";
+
+  vsx_bitmap* bitmap = cache.aquire_create(handle, 0);
+  generate_blob(bitmap);
+  test_assert(bitmap->data_ready == 1);
+  void* data = bitmap->data_get();
+  test_assert(data);
+
+  vsx_bitmap* kept = bitmap;
+  cache.destroy(bitmap);
+  test_assert(cache.get_unreferenced_bytes() > 0);
+
+  bitmap = cache.aquire_create(handle, 0);
+  test_assert(bitmap == kept);
+  test_assert(bitmap->references == 1);
+  test_assert(cache.get_unreferenced_bytes() == 0);
+
+  generate_blob(bitmap);
+  test_assert(bitmap->data_ready == 1);
+  test_assert(bitmap->data_get() == data);
+
+  cache.destroy(bitmap);
+}
+
+// nothing to keep from a failed load, but not while it is still loading
+void test_failed_load_evicted()
+{
+  vsx_bitmap_cache cache;
+  vsx::filesystem filesystem;
+  vsx_string<> filename = "/nonexistent/missing.tga";
+
+  vsx_bitmap* bitmap = cache.aquire_create(filename, 0);
+  vsx_bitmap_loader_tga::get_instance()->load(bitmap, filename, &filesystem, false);
+  test_assert(!bitmap->data_ready);
+  test_assert(!bitmap->data_loading);
+
+  cache.destroy(bitmap);
+  test_assert(cache.get_item_count() == 0);
+  test_assert(cache.get_evictions() == 1);
+
+  bitmap = cache.aquire_create(filename, 0);
+  bitmap->data_loading = true;
+  vsx_bitmap* loading = bitmap;
+  cache.destroy(bitmap);
+  test_assert(cache.get_item_count() == 1);
+
+  loading->data_loading = false;
+  cache.set_budget(cache.get_budget());
+  test_assert(cache.get_item_count() == 0);
+  test_assert(cache.get_evictions() == 2);
+}
+
+int main(int argc, char *argv[])
+{
+  VSX_UNUSED(argc);
+  VSX_UNUSED(argv);
+
+  test_revive_generate();
+  test_failed_load_evicted();
+
+  test_complete
+
+  return 0;
+}
@@ -0,0 +1,56 @@
+#include <command/vsx_command.h>
+#include <vsx_argvector.h>
+#include <test/vsx_test.h>
+
+#ifdef main
+#undef main
+#endif
+
+void test_register()
+{
+  test_assert(vsx_command_id_find("param_set") == 0);
+
+  uint32_t param_set = vsx_command_id_register("param_set");
+  uint32_t ps64 = vsx_command_id_register("ps64");
+  test_assert(param_set != 0);
+  test_assert(ps64 != 0 && ps64 != param_set);
+
+  // dense and stable
+  test_assert(param_set < 3 && ps64 < 3);
+  test_assert(vsx_command_id_register("param_set") == param_set);
+  test_assert(vsx_command_id_find("param_set") == param_set);
+  test_assert(vsx_command_id_find("param_sets") == 0);
+}
+
+void test_parse()
+{
+  uint32_t component_create = vsx_command_id_register("component_create");
+
+  vsx_string<> line = "component_create renderers;basic;textured_rectangle rect 0 0";
+  vsx_command_s* command = vsx_command_parse<vsx_command_s>(line);
+  test_assert(command->cmd_id == component_create);
+  delete command;
+
+  line = "unknown_command 1";
+  command = vsx_command_parse<vsx_command_s>(line);
+  test_assert(command->cmd_id == 0);
+  delete command;
+
+  vsx_command_s raw;
+  raw.raw = "component_create a b 0 0";
+  raw.parse();
+  test_assert(raw.cmd_id == component_create);
+}
+
+int main(int argc, char *argv[])
+{
+  VSX_UNUSED(argc);
+  VSX_UNUSED(argv);
+
+  test_register();
+  test_parse();
+
+  test_complete
+
+  return 0;
+}
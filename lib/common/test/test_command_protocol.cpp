@@ -0,0 +1,158 @@
+#include <command/vsx_command_protocol.h>
+#include <string/vsx_string_helper.h>
+#include <vsx_argvector.h>
+#include <test/vsx_test.h>
+
+#ifdef main
+#undef main
+#endif
+
+void test_text()
+{
+  vsx_command_protocol_reader reader;
+  vsx_nw_vector< vsx_string<> > lines;
+  const char* data = "param_set a b 1.0\r\nhello";
+  bool valid = reader.feed(data, strlen(data),
+    [&](vsx_string<>& line) { lines.push_back(line); },
+    [&](vsx_nw_vector< vsx_string<> >& parts) { VSX_UNUSED(parts); }
+  );
+  test_assert(valid);
+  test_assert(lines.size() == 1);
+  test_assert((lines[0] == "param_set a b 1.0"));
+
+  // rest of the line arrives later
+  reader.feed(" world\n", 7,
+    [&](vsx_string<>& line) { lines.push_back(line); },
+    [&](vsx_nw_vector< vsx_string<> >& parts) { VSX_UNUSED(parts); }
+  );
+  test_assert(lines.size() == 2);
+  test_assert((lines[1] == "hello world"));
+}
+
+void test_binary()
+{
+  vsx_command_protocol_writer writer;
+  for (int i = 0; i < 100; i++)
+  {
+    vsx_string<> command = "param_set comp param " + vsx_string_helper::i2s(i);
+    writer.add(command);
+  }
+  vsx_ma_vector<unsigned char>& frame = writer.get_frames();
+
+  vsx_command_protocol_reader reader;
+  vsx_nw_vector< vsx_string<> > lines;
+  size_t count = 0;
+  bool valid = true;
+  auto on_line = [&](vsx_string<>& line) { lines.push_back(line); };
+  auto on_parts = [&](vsx_nw_vector< vsx_string<> >& parts)
+  {
+    test_assert(parts.size() == 4);
+    test_assert((parts[0] == "param_set"));
+    test_assert((parts[3] == vsx_string_helper::i2s((int)count)));
+    count++;
+  };
+
+  // one byte at a time
+  foreach (frame, i)
+    valid &= reader.feed((char*)frame.get_pointer() + i, 1, on_line, on_parts);
+  valid &= reader.feed("text\n", 5, on_line, on_parts);
+
+  test_assert(valid);
+  test_assert(count == 100);
+  test_assert(lines.size() == 1);
+}
+
+void test_malformed()
+{
+  // part size pointing past the end of the frame
+  unsigned char frame[] = {VSX_COMMAND_PROTOCOL_FRAME_START, 8, 0, 0, 0, 1, 0, 0, 0, 9, 0, 0, 0};
+  vsx_command_protocol_reader reader;
+  bool valid = reader.feed((char*)frame, sizeof(frame),
+    [&](vsx_string<>& line) { VSX_UNUSED(line); },
+    [&](vsx_nw_vector< vsx_string<> >& parts) { VSX_UNUSED(parts); }
+  );
+  test_assert(!valid);
+}
+
+void test_large()
+{
+  // a part over 64 KiB
+  vsx_string<> big;
+  for (size_t i = 0; i < 70000; i++)
+    big.push_back( (char)('a' + i % 26) );
+
+  vsx_command_protocol_writer writer;
+  vsx_nw_vector< vsx_string<> > command;
+  command.push_back("ps64");
+  command.push_back(big);
+  writer.add(command);
+
+  // a batch over the frame limit, 260 commands of 64 KiB
+  vsx_string<> batch_command = "param_set comp param " + big.substr(0, 65536);
+  for (int i = 0; i < 260; i++)
+    writer.add(batch_command);
+
+  // too big for any frame
+  vsx_string<> huge;
+  while (huge.size() <= VSX_COMMAND_PROTOCOL_FRAME_MAX_SIZE)
+    huge += big;
+  vsx_string<> huge_command = "ps64 " + huge;
+  writer.add(huge_command);
+  writer.add(batch_command);
+
+  vsx_ma_vector<unsigned char>& frames = writer.get_frames();
+
+  // the frames ahead of the text line, each within the limit
+  size_t frame_count = 0;
+  size_t offset = 0;
+  bool in_limit = true;
+  while (offset < frames.size() && frames[offset] == VSX_COMMAND_PROTOCOL_FRAME_START)
+  {
+    unsigned char* h = frames.get_pointer() + offset;
+    size_t payload_size = (size_t)h[1] | ((size_t)h[2] << 8) | ((size_t)h[3] << 16) | ((size_t)h[4] << 24);
+    in_limit &= payload_size <= VSX_COMMAND_PROTOCOL_FRAME_MAX_SIZE;
+    offset += VSX_COMMAND_PROTOCOL_FRAME_HEADER_SIZE + payload_size;
+    frame_count++;
+  }
+  test_assert(in_limit);
+  test_assert(frame_count == 2);
+
+  vsx_command_protocol_reader reader;
+  size_t count = 0;
+  size_t lines = 0;
+  bool parts_valid = true;
+  bool valid = reader.feed((char*)frames.get_pointer(), frames.size(),
+    [&](vsx_string<>& line)
+    {
+      parts_valid &= line.size() == huge_command.size();
+      lines++;
+    },
+    [&](vsx_nw_vector< vsx_string<> >& parts)
+    {
+      if (!count)
+        parts_valid &= parts.size() == 2 && parts[1].size() == 70000 && parts[1] == big;
+      else
+        parts_valid &= parts.size() == 4 && parts[3].size() == 65536;
+      count++;
+    }
+  );
+  test_assert(valid);
+  test_assert(parts_valid);
+  test_assert(count == 262);
+  test_assert(lines == 1);
+}
+
+int main(int argc, char *argv[])
+{
+  VSX_UNUSED(argc);
+  VSX_UNUSED(argv);
+
+  test_text();
+  test_binary();
+  test_malformed();
+  test_large();
+
+  test_complete
+
+  return 0;
+}
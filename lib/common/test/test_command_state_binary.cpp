@@ -0,0 +1,150 @@
+#include <command/vsx_command_state_binary.h>
+#include <string/vsx_string_helper.h>
+#include <vsx_argvector.h>
+#include <test/vsx_test.h>
+
+#ifdef main
+#undef main
+#endif
+
+const char* state =
+  "meta_set bWV0YQ==\n"
+  "component_create renderers;basic;textured_rectangle rect 0.013 -0.204\n"
+  "param_set rect position 0.5,0.25,0\n"
+  "ps64 rect texture_id aGVsbG8gd29ybGQ=\n"
+  "macro_create macro1 0.1 0.2 0.3\n"
+  "param_connect screen0 screen rect render_out\n"
+  "param_alias alias_pos:float3 -1 macro1 alias_pos rect position\r\n"
+  "\n"
+  "param_connect screen0 screen rect render_out 1\n"
+  "break\n"
+  "param_set rect position 1,1,1\n";
+
+void test_round_trip()
+{
+  vsx_command_state_binary_writer writer;
+  writer.add_state(state);
+  vsx_ma_vector<unsigned char> data = writer.get_data();
+
+  vsx_command_state_binary_reader reader;
+  test_assert(reader.load(data.get_pointer(), data.size()));
+  test_assert(reader.get_record_count() == 10);
+
+  typedef vsx_command_state_binary_record record;
+  const uint8_t types[] =
+  {
+    record::command,
+    record::component_create,
+    record::param_set,
+    record::param_set,
+    record::command,
+    record::param_connect,
+    record::param_alias,
+    record::command,
+    record::command,
+    record::command
+  };
+  for (size_t i = 0; i < 10; i++)
+    test_assert(reader.get_record(i).type == types[i]);
+
+  record& create = reader.get_record(1);
+  test_assert((reader.get_field(create, 0) == "renderers;basic;textured_rectangle"));
+  test_assert((reader.get_field(create, 1) == "rect"));
+  test_assert(fabsf(create.x - 0.013f) < 1e-6f && fabsf(create.y + 0.204f) < 1e-6f);
+
+  // ps64 values are stored decoded
+  test_assert((reader.get_field(reader.get_record(3), 2) == "hello world"));
+
+  record& alias = reader.get_record(6);
+  test_assert(alias.direction == 0);
+  test_assert((reader.get_field(alias, 4) == "position"));
+
+  // back to text
+  vsx_nw_vector< vsx_string<> > parts;
+  reader.get_parts(alias, parts);
+  test_assert(parts.size() == 7);
+  test_assert((parts[2] == "-1"));
+  test_assert((parts[6] == "position"));
+
+  reader.get_parts(reader.get_record(3), parts);
+  test_assert((parts[0] == "ps64"));
+  test_assert((vsx_string_helper::base64_decode(parts[3]) == "hello world"));
+
+  // everything after the break stays text
+  reader.get_parts(reader.get_record(9), parts);
+  test_assert(parts.size() == 4);
+  test_assert((parts[0] == "param_set"));
+}
+
+void test_invalid()
+{
+  vsx_command_state_binary_writer writer;
+  writer.add_state(state);
+  vsx_ma_vector<unsigned char> data = writer.get_data();
+
+  vsx_command_state_binary_reader reader;
+
+  // text state
+  test_assert(!reader.load((const unsigned char*)state, strlen(state)));
+
+  // truncated anywhere
+  for (size_t i = 0; i < data.size(); i++)
+    test_assert(!reader.load(data.get_pointer(), i));
+
+  // string index out of range
+  vsx_command_state_binary_writer empty;
+  vsx_string<> line = "component_create a b 0 0";
+  empty.add_raw(line);
+  vsx_ma_vector<unsigned char> bad = empty.get_data();
+  test_assert(reader.load(bad.get_pointer(), bad.size()));
+  bad[bad.size() - 4 - 8 - 5] = 0xff;
+  test_assert(!reader.load(bad.get_pointer(), bad.size()));
+}
+
+void test_corrupt()
+{
+  vsx_command_state_binary_writer writer;
+  writer.add_state(state);
+  vsx_ma_vector<unsigned char> data = writer.get_data();
+
+  vsx_command_state_binary_reader reader;
+
+  // cut anywhere but still ending in the trailer
+  vsx_ma_vector<unsigned char> cut;
+  for (size_t i = 4; i < data.size() - 4; i++)
+  {
+    cut.reset_used(0);
+    for (size_t j = 0; j < i; j++)
+      cut.push_back(data[j]);
+    for (size_t j = data.size() - 4; j < data.size(); j++)
+      cut.push_back(data[j]);
+    test_assert(!reader.load(cut.get_pointer(), cut.size()));
+  }
+
+  // lengths and counts far past the end of the data: the first string's
+  // size, the string count and the record count
+  const size_t offsets[] = {16, 8, 12};
+  for (size_t i = 0; i < 3; i++)
+  {
+    vsx_ma_vector<unsigned char> bad = data;
+    for (size_t j = 0; j < 4; j++)
+      bad[offsets[i] + j] = j < 3 ? 0xff : 0x7f;
+    test_assert(!reader.load(bad.get_pointer(), bad.size()));
+    bad[offsets[i] + 3] = 0xff;
+    test_assert(!reader.load(bad.get_pointer(), bad.size()));
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  VSX_UNUSED(argc);
+  VSX_UNUSED(argv);
+
+  test_round_trip();
+  test_invalid();
+  test_corrupt();
+
+  test_complete
+
+  return 0;
+}
@@ -0,0 +1,173 @@
+#include <vsx_engine.h>
+#include <vsx_engine_param_handle.h>
+#include <vsx_module_list_abs.h>
+#include <string/vsx_string_helper.h>
+#include <test/vsx_test.h>
+
+#ifdef main
+#undef main
+#endif
+
+// stands in for the screen the engine creates on start
+class module_test_screen : public vsx_module
+{
+public:
+
+  void module_info(vsx_module_specification* info)
+  {
+    info->identifier = "outputs;screen";
+    info->output = 1;
+  }
+
+  void declare_params(vsx_module_param_list& in_parameters, vsx_module_param_list& out_parameters)
+  {
+    VSX_UNUSED(in_parameters);
+    VSX_UNUSED(out_parameters);
+    loading_done = true;
+  }
+};
+
+// one float input per count, redeclared whenever count is set
+class module_test_redeclare : public vsx_module
+{
+public:
+  vsx_module_param_int* count_in = 0x0;
+  int count = 1;
+  vsx_nw_vector< vsx_string<> > notified;
+
+  void module_info(vsx_module_specification* info)
+  {
+    info->identifier = "test;redeclare";
+    info->in_param_spec = "count:int";
+    for_n (i, 0, (size_t)count)
+      info->in_param_spec += ",input" + vsx_string_helper::i2s((int)i) + ":float";
+  }
+
+  void declare_params(vsx_module_param_list& in_parameters, vsx_module_param_list& out_parameters)
+  {
+    VSX_UNUSED(out_parameters);
+    loading_done = true;
+    redeclare_in_params(in_parameters);
+  }
+
+  void redeclare_in_params(vsx_module_param_list& in_parameters)
+  {
+    count_in = (vsx_module_param_int*)in_parameters.create(VSX_MODULE_PARAM_ID_INT, "count");
+    count_in->set(count);
+    for_n (i, 0, (size_t)count)
+      in_parameters.create(VSX_MODULE_PARAM_ID_FLOAT, ("input" + vsx_string_helper::i2s((int)i)).c_str());
+  }
+
+  void param_set_notify(const vsx_string<>& name)
+  {
+    notified.push_back(name);
+    req(name == "count");
+    count = count_in->get();
+    redeclare_in = true;
+  }
+};
+
+class test_module_list : public vsx_module_list_abs
+{
+  vsx_module_specification screen;
+  vsx_module_specification redeclare;
+
+public:
+
+  void init(void* extra_modules = 0x0)
+  {
+    VSX_UNUSED(extra_modules);
+    screen.identifier = "outputs;screen";
+    redeclare.identifier = "test;redeclare";
+    module_list[screen.identifier] = &screen;
+    module_list[redeclare.identifier] = &redeclare;
+  }
+
+  void destroy()
+  {
+    module_list.clear();
+  }
+
+  std::vector< vsx_module_specification* >* get_module_list( bool include_hidden = false)
+  {
+    VSX_UNUSED(include_hidden);
+    std::vector< vsx_module_specification* >* result = new std::vector< vsx_module_specification* >;
+    result->push_back(&screen);
+    result->push_back(&redeclare);
+    return result;
+  }
+
+  vsx_module* load_module_by_name(vsx_string<> name)
+  {
+    if (name == screen.identifier)
+      return new module_test_screen;
+    if (name == redeclare.identifier)
+      return new module_test_redeclare;
+    return 0x0;
+  }
+
+  void unload_module( vsx_module* module_pointer )
+  {
+    delete module_pointer;
+  }
+
+  bool find( const vsx_string<>& module_name_to_look_for)
+  {
+    return get_module_info(module_name_to_look_for) != 0x0;
+  }
+
+  void print_help()
+  {}
+};
+
+// a handle sets a value the way a param_set command does
+void test_set_notifies()
+{
+  test_module_list modules;
+  modules.init();
+
+  vsx_engine engine(&modules);
+  engine.start();
+
+  vsx_command_list cmd_in(true);
+  vsx_command_list cmd_out(true);
+  cmd_in.add_raw("component_create test;redeclare r 0 0");
+  engine.process_message_queue(&cmd_in, &cmd_out);
+
+  vsx_comp* comp = engine.get_component_by_name("r");
+  test_assert(comp);
+  module_test_redeclare* module = (module_test_redeclare*)comp->module;
+
+  vsx_engine_param_handle<vsx_module_param_int> count(&engine, "r", "count");
+  vsx_engine_param_handle<vsx_module_param_float> input2(&engine, "r", "input2");
+  test_assert(count.validate());
+  test_assert(!input2.validate());
+
+  count.set(3);
+  test_assert(module->notified.size() == 1);
+  test_assert((module->notified[0] == "count"));
+
+  // redeclared right away, the handles resolve again
+  test_assert(!module->redeclare_in);
+  test_assert(input2.validate());
+  test_assert(count.get() == 3);
+
+  input2.set(0.5f);
+  test_assert(module->notified.size() == 2);
+  test_assert((module->notified[1] == "input2"));
+  test_assert(input2.get() == 0.5f);
+
+  engine.stop();
+}
+
+int main(int argc, char *argv[])
+{
+  VSX_UNUSED(argc);
+  VSX_UNUSED(argv);
+
+  test_set_notifies();
+
+  test_complete
+
+  return 0;
+}
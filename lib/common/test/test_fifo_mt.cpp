@@ -0,0 +1,87 @@
+#include <thread>
+#include <tools/vsx_fifo_mt.h>
+#include <test/vsx_test.h>
+
+#ifdef main
+#undef main
+#endif
+
+void test_block()
+{
+  vsx_fifo_mt<int, 16> fifo;
+  int values[20], result[20];
+  for (int i = 0; i < 20; i++)
+    values[i] = i;
+
+  // single values and blocks interleave, wrapping around the buffer
+  test_assert(fifo.produce(values[0]));
+  test_assert(fifo.produce(values + 1, 10) == 10);
+  test_assert(fifo.consume(result, 4) == 4);
+  test_assert(fifo.produce(values + 11, 9) == 9);
+  test_assert(fifo.live_count_get() == 16);
+  test_assert(fifo.produce(values, 1) == 0);
+
+  int value = -1;
+  test_assert(fifo.consume(value));
+  test_assert(fifo.consume(result + 5, 20) == 15);
+  test_assert(fifo.consume(result, 1) == 0);
+
+  test_assert(result[0] == 0 && result[3] == 3 && value == 4);
+  for (int i = 5; i < 20; i++)
+    test_assert(result[i] == i);
+}
+
+// blocks of varying size through a small buffer
+void test_threads()
+{
+  vsx_fifo_mt<int, 64> fifo;
+  const int count = 1000000;
+  bool in_order = true;
+
+  std::thread consumer([&]()
+  {
+    int result[50];
+    int expected = 0;
+    while (expected < count)
+    {
+      size_t n = fifo.consume(result, (size_t)(expected % 50) + 1);
+      for (size_t i = 0; i < n; i++)
+        if (result[i] != expected++)
+          in_order = false;
+      if (!n)
+        std::this_thread::yield();
+    }
+  });
+
+  int values[37];
+  int next = 0;
+  while (next < count)
+  {
+    size_t n = (size_t)(next % 37) + 1;
+    if (n > (size_t)(count - next))
+      n = (size_t)(count - next);
+    for (size_t i = 0; i < n; i++)
+      values[i] = next + (int)i;
+    size_t written = fifo.produce(values, n);
+    next += (int)written;
+    if (!written)
+      std::this_thread::yield();
+  }
+
+  consumer.join();
+  test_assert(in_order);
+  test_assert(fifo.live_count_get() == 0);
+}
+
+int main(int argc, char *argv[])
+{
+  VSX_UNUSED(argc);
+  VSX_UNUSED(argv);
+
+  test_block();
+  test_threads();
+
+  test_complete
+
+  return 0;
+}
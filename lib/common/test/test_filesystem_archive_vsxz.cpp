@@ -89,6 +89,55 @@ void test_filesystem_archive_reader()
   my_filesystem.get_archive()->close();
 }
 
+void test_lazy()
+{
+  filesystem_archive_vsxz_reader archive_load;
+
+  archive_load.load("test_filesystem_archive.vsxz", false, VSX_FILESYSTEM_ARCHIVE_LOADING_FLAG_LAZY);
+  archive_load.set_chunk_cache_budget(0);
+
+  file* handle = new file;
+  archive_load.file_open("test_filesystem_archive_file_1", handle);
+  vsx_string<> hello((char*)handle->data.get_pointer(), handle->data.size());
+  test_assert((hello == "hello world 1"));
+  archive_load.file_close(handle);
+  test_assert(handle->archive_chunk == -1);
+
+  // decompressed again after being evicted
+  archive_load.file_open("test_filesystem_archive_file_2", handle);
+  vsx_string<> hello_2((char*)handle->data.get_pointer(), handle->data.size());
+  test_assert((hello_2 == "hello world 2"));
+  archive_load.file_close(handle);
+
+  delete handle;
+  archive_load.close();
+}
+
+void test_duplicates()
+{
+  filesystem_archive_vsxz_writer archive;
+  archive.create("test_filesystem_archive.vsxz");
+  archive.add_string("test_string_1", "hello", false);
+  archive.add_string("test_string_2", "hello", false);
+  archive.add_string("test_string_3", "world", false);
+  archive.close();
+
+  filesystem_archive_vsxz_reader archive_load;
+  archive_load.load("test_filesystem_archive.vsxz", false, 0);
+
+  file* handle = new file;
+  archive_load.file_open("test_string_2", handle);
+  vsx_string<> test_string_2((char*)handle->data.get_pointer(), handle->data.size());
+  test_assert( test_string_2 == "hello");
+
+  archive_load.file_open("test_string_3", handle);
+  vsx_string<> test_string_3((char*)handle->data.get_pointer(), handle->data.size());
+  test_assert( test_string_3 == "world");
+
+  delete handle;
+  archive_load.close();
+}
+
 int main(int argc, char *argv[])
 {
   VSX_UNUSED(argc);
@@ -98,6 +147,8 @@ int main(int argc, char *argv[])
   test_plain_files();
   test_text_files();
   test_filesystem_archive_reader();
+  test_lazy();
+  test_duplicates();
 
   teardown();
 
@@ -0,0 +1,62 @@
+#include <module/vsx_module_job.h>
+#include <test/vsx_test.h>
+
+#ifdef main
+#undef main
+#endif
+
+// the render thread waits for the engine's components, module jobs must not
+// get ahead of them even when submitted first
+void test_engine_before_jobs()
+{
+  vsx_thread_pool<> pool(4);
+  test_assert(pool.get_thread_count() > 1);
+  vsx_module_job_system job_system(&pool);
+
+  // hold every worker so the queue fills up before anything runs; one of
+  // them is let go first and runs the rest while the others still wait
+  std::atomic<size_t> held(0);
+  std::atomic<bool> go(false);
+  std::atomic<bool> release(false);
+  pool.add_ordered(
+    vsx_thread_pool<>::priority_key(vsx_thread_pool<>::high_priority) | 1,
+    [&](){ held++; while (!go) std::this_thread::yield(); }
+  );
+  for_n(i, 1, pool.get_thread_count())
+    pool.add_ordered(
+      vsx_thread_pool<>::priority_key(vsx_thread_pool<>::high_priority),
+      [&](){ held++; while (!release) std::this_thread::yield(); }
+    );
+  while (held.load() < pool.get_thread_count())
+    std::this_thread::yield();
+
+  std::vector<int> order;
+  auto record = [&](int v){ return [&, v](){ order.push_back(v); }; };
+  job_system.submit(vsx_module_job_system::priority_background, 1, record(4));
+  job_system.submit(vsx_module_job_system::priority_frame, 2, record(3));
+  job_system.submit(vsx_module_job_system::priority_frame, 1, record(2));
+
+  // what vsx_engine_scheduler submits
+  pool.add( [&](){ order.push_back(1); return true; } );
+
+  std::future<void> last = pool.add(vsx_thread_pool<>::low_priority, [](){});
+  go = true;
+  last.wait();
+  release = true;
+  pool.wait_all(1);
+
+  test_assert(order.size() == 4);
+  test_assert(order[0] == 1 && order[1] == 2 && order[2] == 3 && order[3] == 4);
+}
+
+int main(int argc, char *argv[])
+{
+  VSX_UNUSED(argc);
+  VSX_UNUSED(argv);
+
+  test_engine_before_jobs();
+
+  test_complete
+
+  return 0;
+}
@@ -0,0 +1,81 @@
+#include <math/vector/vsx_vector3.h>
+#include <math/quaternion/vsx_quaternion.h>
+#include <color/vsx_color.h>
+#include <particlesystem/vsx_particlesystem.h>
+#include <test/vsx_test.h>
+
+#ifdef main
+#undef main
+#endif
+
+void test_round_trip()
+{
+  vsx_ma_vector< vsx_particle<> > particles;
+  vsx_particle_soa<> soa;
+  vsx_particlesystem<> system;
+  system.particles = &particles;
+  system.particles_soa = &soa;
+
+  for_n(i, 0, 1000)
+  {
+    particles[i].pos = vsx_vector3<>((float)i, (float)i * 2.0f, (float)i * 3.0f);
+    particles[i].size = (float)i;
+    particles[i].grounded = (int)(i & 1);
+  }
+
+  vsx_particle_soa<>* s = system.get_soa();
+  test_assert(s == &soa);
+  test_assert(s->get_count() == 1000);
+  test_assert((size_t)s->pos_x % vsx_particle_soa<>::alignment == 0);
+  test_assert((size_t)s->grounded % vsx_particle_soa<>::alignment == 0);
+  test_assert(s->pos_y[10] == 20.0f);
+  test_assert(s->grounded[11] == 1);
+
+  s->pos_z[5] = -1.0f;
+  system.sync_aos();
+  test_assert(particles[5].pos.z == -1.0f);
+  test_assert(particles[999].size == 999.0f);
+  test_assert(soa.state == vsx_particle_soa<>::in_sync);
+
+  // growing keeps contents and zeroes new particles
+  s->resize(1500);
+  test_assert(s->pos_x[999] == 999.0f);
+  test_assert(s->size[1499] == 0.0f);
+  s->resize(3000);
+  test_assert(s->pos_y[999] == 1998.0f);
+  test_assert(s->size[2000] == 0.0f);
+}
+
+void test_for_each_chunk()
+{
+  vsx_particle_soa<> soa;
+  soa.resize(100003);
+
+  for_n(pass, 0, 2)
+  {
+    soa.for_each_chunk(
+      [&soa](size_t begin, size_t end)
+      {
+        for (size_t i = begin; i < end; i++)
+          soa.time[i] += 1.0f;
+      },
+      pass ? 1000 : 16384
+    );
+  }
+
+  for_n(i, 0, soa.get_count())
+    test_assert(soa.time[i] == 2.0f);
+}
+
+int main(int argc, char *argv[])
+{
+  VSX_UNUSED(argc);
+  VSX_UNUSED(argv);
+
+  test_round_trip();
+  test_for_each_chunk();
+
+  test_complete
+
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include <profiler/vsx_profiler_chrome_trace.h>
+#include <string/vsx_string.h>
+#include <test/vsx_test.h>
+
+#ifdef main
+#undef main
+#endif
+
+vsx_profile_chunk make_chunk(uint64_t flags, uint64_t cycles, uint64_t id, const char* tag)
+{
+  vsx_profile_chunk chunk;
+  memset(&chunk, 0, sizeof(chunk));
+  chunk.flags = flags;
+  chunk.cycles = cycles;
+  chunk.id = id;
+  if (tag)
+    strncpy(chunk.tag, tag, 31);
+  return chunk;
+}
+
+vsx_string<> convert(vsx_profile_chunk* chunks, size_t count, double cycles_per_second)
+{
+  FILE* in = tmpfile();
+  FILE* out = tmpfile();
+  fwrite(chunks, sizeof(vsx_profile_chunk), count, in);
+  rewind(in);
+
+  vsx_profiler_chrome_trace::write(in, out, cycles_per_second);
+
+  vsx_string<> result;
+  rewind(out);
+  int c;
+  while ( (c = fgetc(out)) != EOF )
+    result.push_back((char)c);
+
+  fclose(in);
+  fclose(out);
+  return result;
+}
+
+void test_events()
+{
+  vsx_profile_chunk chunks[8];
+  chunks[0] = make_chunk(VSX_PROFILE_CHUNK_FLAG_THREAD_NAME, 12345, 7, "render");
+  chunks[1] = make_chunk(VSX_PROFILE_CHUNK_FLAG_SECTION_START, 1000, 7, 0x0);
+  chunks[2] = make_chunk(VSX_PROFILE_CHUNK_FLAG_START, 1500, 7, "blob \"mesh\"");
+  chunks[3] = make_chunk(VSX_PROFILE_CHUNK_FLAG_END, 3000, 7, 0x0);
+  chunks[4] = make_chunk(VSX_PROFILE_CHUNK_FLAG_SECTION_END, 4000, 7, 0x0);
+  chunks[5] = make_chunk(VSX_PROFILE_CHUNK_FLAG_PLOT_2_DOUBLE, 5000, 3, 0x0);
+  double a = 1.5, b = -2.0;
+  memcpy(&chunks[5].tag[0], &a, sizeof(double));
+  memcpy(&chunks[5].tag[8], &b, sizeof(double));
+  chunks[6] = make_chunk(VSX_PROFILE_CHUNK_FLAG_TIMESTAMP, 6000, 0, "1.0");
+  chunks[7] = make_chunk(999, 6000, 0, 0x0);
+
+  // one cycle per microsecond
+  vsx_string<> json = convert(chunks, 8, 1000000.0);
+  const char* s = json.c_str();
+
+  test_assert(strstr(s, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n{") == s);
+  test_assert(strstr(s, "{\"ph\":\"M\",\"pid\":1,\"tid\":7,\"name\":\"thread_name\",\"args\":{\"name\":\"render\"}}"));
+  test_assert(strstr(s, "{\"ph\":\"B\",\"pid\":1,\"tid\":7,\"ts\":0.000,\"name\":\"frame\"}"));
+  test_assert(strstr(s, "{\"ph\":\"B\",\"pid\":1,\"tid\":7,\"ts\":500.000,\"name\":\"blob \\\"mesh\\\"\"}"));
+  test_assert(strstr(s, "{\"ph\":\"E\",\"pid\":1,\"tid\":7,\"ts\":2000.000}"));
+  test_assert(strstr(s, "{\"ph\":\"E\",\"pid\":1,\"tid\":7,\"ts\":3000.000}"));
+  test_assert(strstr(s, "{\"ph\":\"C\",\"pid\":1,\"ts\":4000.000,\"name\":\"plot 3\",\"args\":{\"x\":1.5,\"y\":-2}}"));
+  test_assert(strstr(s, "\n]}\n"));
+
+  // timestamp and unknown chunks carry no event
+  test_assert(!strstr(s, "6000") && !strstr(s, "5000.000"));
+  test_assert(!strstr(s, "},\n]"));
+}
+
+void test_empty()
+{
+  vsx_string<> json = convert(0x0, 0, 1000000.0);
+  test_assert(json == "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n]}\n");
+}
+
+int main(int argc, char *argv[])
+{
+  VSX_UNUSED(argc);
+  VSX_UNUSED(argv);
+
+  test_events();
+  test_empty();
+
+  test_complete
+
+  return 0;
+}
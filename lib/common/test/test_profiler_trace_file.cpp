@@ -0,0 +1,175 @@
+#include <profiler/vsx_profiler_trace_file.h>
+#include <test/vsx_test.h>
+
+#ifdef main
+#undef main
+#endif
+
+vsx_profile_chunk make_chunk(uint64_t flags, uint64_t cycles, uint64_t id, const char* tag)
+{
+  vsx_profile_chunk chunk;
+  memset(&chunk, 0, sizeof(chunk));
+  chunk.flags = flags;
+  chunk.cycles = cycles;
+  chunk.id = id;
+  if (tag)
+    strncpy(chunk.tag, tag, 31);
+  return chunk;
+}
+
+// a frame per thread, interleaved the way the consumer hands them over
+void make_chunks(vsx_ma_vector<vsx_profile_chunk>& chunks, size_t count)
+{
+  chunks.reset_used();
+  chunks.push_back( make_chunk(VSX_PROFILE_CHUNK_FLAG_THREAD_NAME, 10, 100, "main") );
+  for (size_t i = 1; chunks.size() < count; i++)
+  {
+    uint64_t id = 100 + (i & 1);
+    uint64_t cycles = 1000 + i * 50 - (i & 1) * 30;
+    chunks.push_back( make_chunk(VSX_PROFILE_CHUNK_FLAG_SECTION_START, cycles, id, 0x0) );
+    chunks.push_back( make_chunk(VSX_PROFILE_CHUNK_FLAG_START, cycles + 5, id, "module run") );
+    chunks.push_back( make_chunk(VSX_PROFILE_CHUNK_FLAG_END, cycles + 20, id, 0x0) );
+    chunks.push_back( make_chunk(VSX_PROFILE_CHUNK_FLAG_SECTION_END, cycles + 25, id, 0x0) );
+    vsx_profile_chunk plot = make_chunk(VSX_PROFILE_CHUNK_FLAG_PLOT_2_DOUBLE, cycles + 26, 7, 0x0);
+    double a = (double)i, b = -0.5;
+    memcpy(&plot.tag[0], &a, sizeof(double));
+    memcpy(&plot.tag[8], &b, sizeof(double));
+    chunks.push_back(plot);
+  }
+  chunks.reset_used(count);
+}
+
+void test_encode()
+{
+  vsx_profile_chunk chunks[6];
+  chunks[0] = make_chunk(VSX_PROFILE_CHUNK_FLAG_START, 5000, 3, "a tag");
+  chunks[1] = make_chunk(VSX_PROFILE_CHUNK_FLAG_START, 4000, 4, 0x0); // earlier cycles from another thread
+  chunks[2] = make_chunk(VSX_PROFILE_CHUNK_FLAG_END, 0xFFFFFFFFFFFFull, 3, "garbage");
+  chunks[3] = make_chunk(VSX_PROFILE_CHUNK_FLAG_PLOT_1_DOUBLE, 6000, 9, "12345678");
+  chunks[4] = make_chunk(999, 6000, 1, 0x0);
+  memset(chunks[4].tag, 'x', 32);
+  chunks[5] = make_chunk(VSX_PROFILE_CHUNK_FLAG_THREAD_NAME, 1, 2, 0x0);
+  memset(chunks[5].tag, 'y', 32);
+  chunks[2].spin_waste = 300;
+
+  vsx_ma_vector<unsigned char> encoded;
+  vsx_profiler_trace_writer::encode(chunks, 6, encoded);
+  test_assert(encoded.size() < sizeof(chunks) / 2);
+
+  vsx_ma_vector<vsx_profile_chunk> decoded;
+  test_assert(vsx_profiler_trace_reader::decode(encoded.get_pointer(), encoded.size(), 6, decoded));
+  test_assert(decoded.size() == 6);
+
+  // end chunks carry no tag
+  memset(chunks[2].tag, 0, 32);
+  for (size_t i = 0; i < 6; i++)
+    test_assert(memcmp(&decoded[i], &chunks[i], sizeof(vsx_profile_chunk)) == 0);
+
+  // truncated data
+  test_assert(!vsx_profiler_trace_reader::decode(encoded.get_pointer(), encoded.size() - 1, 6, decoded));
+}
+
+void test_write_read()
+{
+  vsx_ma_vector<vsx_profile_chunk> chunks;
+  size_t count = vsx_profiler_trace_writer::block_chunks * 2 + 1000;
+  make_chunks(chunks, count);
+
+  vsx_profiler_trace_writer writer;
+  test_assert(writer.open("test_profiler_trace_file.vsxp"));
+  writer.write(chunks.get_pointer(), 3);
+  writer.write(chunks.get_pointer() + 3, count - 3);
+  writer.close();
+
+  vsx_profiler_trace_reader reader;
+  test_assert(reader.open("test_profiler_trace_file.vsxp"));
+  test_assert(reader.get_block_count() == 3);
+  test_assert(reader.get_chunk_count() == count);
+  test_assert(reader.get_thread_ids().size() == 2);
+  test_assert(reader.get_thread_ids()[0] == 100 && reader.get_thread_ids()[1] == 101);
+  test_assert(reader.get_plot_ids().size() == 1 && reader.get_plot_ids()[0] == 7);
+  test_assert(reader.get_block(0).cycles_min == 10);
+  test_assert(reader.get_block(0).cycles_max < reader.get_block(1).cycles_max);
+
+  vsx_ma_vector<vsx_profile_chunk> block;
+  size_t offset = 0;
+  for (size_t b = 0; b < reader.get_block_count(); b++)
+  {
+    test_assert(reader.read_block(b, block));
+    test_assert(block.size() == reader.get_block(b).chunk_count);
+    test_assert(memcmp(block.get_pointer(), chunks.get_pointer() + offset, block.get_sizeof()) == 0);
+    offset += block.size();
+  }
+  test_assert(offset == count);
+  reader.close();
+
+  unlink("test_profiler_trace_file.vsxp");
+}
+
+void test_unfinished()
+{
+  vsx_ma_vector<vsx_profile_chunk> chunks;
+  size_t count = vsx_profiler_trace_writer::block_chunks * 2;
+  make_chunks(chunks, count);
+
+  vsx_profiler_trace_writer writer;
+  test_assert(writer.open("test_profiler_trace_file.vsxp"));
+  writer.write(chunks.get_pointer(), count);
+  writer.close();
+
+  // cut off the index and footer and half of the last block
+  vsx_profiler_trace_reader reader;
+  test_assert(reader.open("test_profiler_trace_file.vsxp"));
+  vsx_profiler_trace_block last = reader.get_block(1);
+  reader.close();
+  test_assert( truncate("test_profiler_trace_file.vsxp", (off_t)(last.offset + last.compressed_size / 2)) == 0 );
+
+  test_assert(reader.open("test_profiler_trace_file.vsxp"));
+  test_assert(reader.get_block_count() == 1);
+  test_assert(reader.get_chunk_count() == vsx_profiler_trace_writer::block_chunks);
+  test_assert(reader.get_thread_ids().size() == 2);
+  test_assert(reader.get_plot_ids().size() == 1);
+  reader.close();
+
+  unlink("test_profiler_trace_file.vsxp");
+}
+
+void test_raw()
+{
+  vsx_ma_vector<vsx_profile_chunk> chunks;
+  size_t count = vsx_profiler_trace_writer::block_chunks + 10;
+  make_chunks(chunks, count);
+
+  FILE* fp = fopen("test_profiler_trace_file.dat", "wb");
+  fwrite(chunks.get_pointer(), sizeof(vsx_profile_chunk), count, fp);
+  fclose(fp);
+
+  vsx_profiler_trace_reader reader;
+  test_assert(reader.open("test_profiler_trace_file.dat"));
+  test_assert(reader.get_block_count() == 2);
+  test_assert(reader.get_chunk_count() == count);
+  test_assert(reader.get_thread_ids().size() == 2);
+
+  vsx_ma_vector<vsx_profile_chunk> block;
+  test_assert(reader.read_block(1, block));
+  test_assert(block.size() == 10);
+  test_assert(memcmp(block.get_pointer(), chunks.get_pointer() + vsx_profiler_trace_writer::block_chunks, block.get_sizeof()) == 0);
+  reader.close();
+
+  unlink("test_profiler_trace_file.dat");
+}
+
+int main(int argc, char *argv[])
+{
+  VSX_UNUSED(argc);
+  VSX_UNUSED(argv);
+
+  test_encode();
+  test_write_read();
+  test_unfinished();
+  test_raw();
+
+  test_complete
+
+  return 0;
+}
@@ -0,0 +1,181 @@
+#include <thread>
+#include <chrono>
+#include <audio/vsx_sample_stream.h>
+#include <test/vsx_test.h>
+
+#ifdef main
+#undef main
+#endif
+
+// every frame holds its own index (mod 30000), negated on the right
+class test_decoder : public vsx_sample_stream_decoder
+{
+  uint64_t position = 0;
+  uint64_t length;
+
+public:
+
+  test_decoder(uint64_t n)
+    :
+    length(n)
+  {}
+
+  uint64_t get_length()
+  {
+    return length;
+  }
+
+  bool seek(uint64_t frame)
+  {
+    if (frame > length)
+      return false;
+    position = frame;
+    return true;
+  }
+
+  size_t decode(int16_t* buffer, size_t frames)
+  {
+    if (frames > length - position)
+      frames = (size_t)(length - position);
+    for (size_t i = 0; i < frames; i++)
+    {
+      int16_t value = (int16_t)((position + i) % 30000);
+      buffer[i * 2] = value;
+      buffer[i * 2 + 1] = -value;
+    }
+    position += frames;
+    return frames;
+  }
+};
+
+float left[512], right[512];
+
+void wait_for_worker()
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+}
+
+// true if the block holds the frames from first on
+bool block_from(uint64_t first, bool mono = false)
+{
+  for (size_t i = 0; i < 512; i++)
+  {
+    int value = (int)lroundf(left[i] * 32767.0f);
+    int value_right = (int)lroundf(right[i] * 32767.0f);
+    if (value != (int)((first + i) % 30000))
+      return false;
+    if (value_right != (mono ? value : -value))
+      return false;
+  }
+  return true;
+}
+
+bool block_silent()
+{
+  for (size_t i = 0; i < 512; i++)
+    if (left[i] != 0.0f || right[i] != 0.0f)
+      return false;
+  return true;
+}
+
+void test_play()
+{
+  vsx_sample_stream stream;
+  stream.load(new test_decoder(44100 * 20));
+  test_assert(stream.get_length() == 44100 * 20);
+  test_assert(stream.get_time() == 0.0f);
+  wait_for_worker();
+
+  // stopped, mixed once to take the loaded position
+  test_assert(stream.is_active());
+  stream.consume_block(left, right, 512);
+  test_assert(block_silent());
+  test_assert(!stream.is_active());
+
+  // through the preroll and on, the worker keeping ahead
+  stream.play();
+  test_assert(stream.is_active());
+  uint64_t first = (uint64_t)DRIFT;
+  for (size_t block = 0; block < 200; block++)
+  {
+    stream.consume_block(left, right, 512);
+    test_assert(block_from(first));
+    first += 512;
+    if (block % 8 == 0)
+      wait_for_worker();
+  }
+  test_assert(fabsf(stream.get_time() - 200.0f * 512.0f / 44100.0f) < 0.001f);
+
+  stream.set_stereo_type(VSX_SAMPLE_MONO);
+  stream.consume_block(left, right, 512);
+  test_assert(block_from(first, true));
+  stream.set_stereo_type(VSX_SAMPLE_STEREO);
+
+  // silence after the end
+  stream.goto_time(19.99f);
+  wait_for_worker();
+  for (size_t block = 0; block < 4; block++)
+    stream.consume_block(left, right, 512);
+  test_assert(block_silent());
+}
+
+void test_seek()
+{
+  vsx_sample_stream stream;
+  stream.load(new test_decoder(44100 * 60));
+  stream.play();
+
+  // the new position is reported at once
+  stream.goto_time(10.0f);
+  test_assert(fabsf(stream.get_time() - 10.0f) < 0.001f);
+  wait_for_worker();
+  stream.consume_block(left, right, 512);
+  test_assert(block_from(441000 + (uint64_t)DRIFT));
+
+  // back into the preroll, and stale chunks are dropped
+  stream.consume_block(left, right, 512);
+  stream.goto_time(0.01f);
+  stream.goto_time(0.02f);
+  wait_for_worker();
+  stream.consume_block(left, right, 512);
+  test_assert(block_from(882 + (uint64_t)DRIFT));
+
+  stream.rewind();
+  wait_for_worker();
+  stream.play();
+  stream.consume_block(left, right, 512);
+  test_assert(block_from((uint64_t)DRIFT));
+
+  // a preview while stopped doesn't move the position
+  stream.stop();
+  stream.goto_time(30.0f);
+  test_assert(stream.is_active());
+  wait_for_worker();
+  stream.consume_block(left, right, 512);
+  test_assert(block_from(1323000 + (uint64_t)DRIFT));
+  stream.consume_block(left, right, 512);
+  test_assert(fabsf(stream.get_time() - 30.0f) < 0.001f);
+  stream.play();
+  wait_for_worker();
+  stream.consume_block(left, right, 512);
+  test_assert(block_from(1323000 + (uint64_t)DRIFT));
+
+  // another file, from the same position
+  stream.load(new test_decoder(44100 * 40));
+  wait_for_worker();
+  stream.consume_block(left, right, 512);
+  test_assert(block_from(1323000 + 512 + (uint64_t)DRIFT));
+}
+
+int main(int argc, char *argv[])
+{
+  VSX_UNUSED(argc);
+  VSX_UNUSED(argv);
+
+  test_play();
+  test_seek();
+
+  test_complete
+
+  return 0;
+}
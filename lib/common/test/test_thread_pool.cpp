@@ -3,11 +3,186 @@
 #include <time/vsx_timer.h>
 #include <vsx_argvector.h>
 #include <test/vsx_test.h>
+#include <stdlib.h>
 
 #ifdef main
 #undef main
 #endif
 
+void test_add_ordered()
+{
+  vsx_thread_pool<> pool(4);
+  test_assert(pool.get_thread_count() > 1);
+
+  // hold every worker so the queue fills up before anything runs; one of
+  // them is let go first and runs the ordered tasks while the rest still wait
+  std::atomic<size_t> held(0);
+  std::atomic<bool> go(false);
+  std::atomic<bool> release(false);
+  pool.add_ordered(
+    vsx_thread_pool<>::priority_key(vsx_thread_pool<>::high_priority) | 1,
+    [&](){ held++; while (!go) std::this_thread::yield(); }
+  );
+  for_n(i, 1, pool.get_thread_count())
+    pool.add_ordered(
+      vsx_thread_pool<>::priority_key(vsx_thread_pool<>::high_priority),
+      [&](){ held++; while (!release) std::this_thread::yield(); }
+    );
+  while (held.load() < pool.get_thread_count())
+    std::this_thread::yield();
+
+  std::vector<int> order;
+  auto record = [&](int v){ return [&, v](){ order.push_back(v); }; };
+  pool.add_ordered(vsx_thread_pool<>::priority_key(vsx_thread_pool<>::low_priority) | 5, record(3));
+  pool.add_ordered(vsx_thread_pool<>::priority_key(vsx_thread_pool<>::normal_priority) | 1, record(2));
+  pool.add_ordered(vsx_thread_pool<>::priority_key(vsx_thread_pool<>::normal_priority) | 2, record(1));
+  std::future<void> last = pool.add(vsx_thread_pool<>::low_priority, [](){});
+  go = true;
+  last.wait();
+  release = true;
+  pool.wait_all(1);
+
+  test_assert(order.size() == 3);
+  test_assert(order[0] == 1 && order[1] == 2 && order[2] == 3);
+}
+
+// counts heap allocations so the tests can check task submission doesn't make any
+std::atomic<uint64_t> allocations(0);
+
+// not inlined, gcc warns about a mismatched new and delete when it sees the
+// malloc in one and not the other
+#if COMPILER == COMPILER_GCC
+#define TEST_NOINLINE __attribute__((noinline))
+#else
+#define TEST_NOINLINE
+#endif
+
+TEST_NOINLINE void* operator new(size_t size)
+{
+  allocations++;
+  void* p = malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+TEST_NOINLINE void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+TEST_NOINLINE void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+TEST_NOINLINE void operator delete[](void* p) noexcept
+{
+  free(p);
+}
+
+TEST_NOINLINE void operator delete(void* p, size_t) noexcept
+{
+  free(p);
+}
+
+TEST_NOINLINE void operator delete[](void* p, size_t) noexcept
+{
+  free(p);
+}
+
+void test_task()
+{
+  int value = 0;
+  uint64_t before = allocations.load();
+  vsx_thread_pool_task small( [&value](){ value++; } );
+  test_assert(allocations.load() == before);
+  vsx_thread_pool_task moved(std::move(small));
+  test_assert(!small);
+  moved();
+  test_assert(value == 1);
+
+  // too large to store inline
+  char large[128];
+  memset(large, 1, sizeof(large));
+  vsx_thread_pool_task heap( [&value, large](){ value += large[127]; } );
+  test_assert(allocations.load() == before + 1);
+  small = std::move(heap);
+  small();
+  test_assert(value == 2);
+}
+
+void test_task_group()
+{
+  vsx_thread_pool<>* pool = vsx_thread_pool<>::instance();
+  std::atomic<size_t> sum(0);
+
+  // warm up, the shared queue and the thread locals allocate on first use
+  {
+    vsx_thread_pool<>::task_group group(pool);
+    group.run( [&](){ sum++; } );
+  }
+
+  uint64_t before = allocations.load();
+  vsx_thread_pool<>::task_group group(pool);
+  for_n(i, 0, 200)
+    group.run( [&sum, i](){ sum += i; } );
+  group.wait();
+  test_assert(allocations.load() == before);
+  test_assert(sum.load() == 1 + 199 * 200 / 2);
+
+  // more tasks than the deques hold spill to the shared queue
+  sum = 0;
+  for_n(i, 0, 5000)
+    group.run( [&sum](){ sum++; } );
+  group.wait();
+  test_assert(sum.load() == 5000);
+}
+
+void test_parallel_for()
+{
+  vsx_thread_pool<>* pool = vsx_thread_pool<>::instance();
+
+  std::vector<uint8_t> hits(100003, 0);
+  pool->parallel_for(0, hits.size(), 100,
+    [&](size_t begin, size_t end)
+    {
+      test_assert(end - begin <= 100);
+      for (size_t i = begin; i < end; i++)
+        hits[i]++;
+    }
+  );
+  for_n(i, 0, hits.size())
+    test_assert(hits[i] == 1);
+
+  // nested in pool tasks, more of them than there are workers
+  std::atomic<size_t> sum(0);
+  std::vector< std::future<void> > outer;
+  for_n(j, 0, pool->get_thread_count() * 2 + 1)
+    outer.push_back(
+      pool->add(
+        [&]()
+        {
+          pool->parallel_for(0, 1000, 10,
+            [&](size_t begin, size_t end)
+            {
+              sum += end - begin;
+            }
+          );
+        }
+      )
+    );
+  foreach(outer, j)
+    outer[j].wait();
+  test_assert(sum.load() == 1000 * outer.size());
+
+  // empty and single grain ranges run in place
+  size_t calls = 0;
+  pool->parallel_for(5, 5, 10, [&](size_t, size_t){ calls++; });
+  pool->parallel_for(5, 10, 10, [&](size_t begin, size_t end){ calls++; test_assert(begin == 5 && end == 10); });
+  test_assert(calls == 1);
+}
+
 class foo
 {
 public:
@@ -38,6 +213,11 @@ int main(int argc, char *argv[])
 
   threaded_task_wait_all(100);
 
+  test_add_ordered();
+  test_task();
+  test_task_group();
+  test_parallel_for();
+
   delete f;
 
   test_complete
@@ -0,0 +1,117 @@
+#include <math/vector/vsx_vector3_batch.h>
+#include <math/vsx_rand.h>
+#include <container/vsx_ma_vector.h>
+#include <test/vsx_test.h>
+
+#ifdef main
+#undef main
+#endif
+
+vsx_rand rand_gen;
+
+bool close(float a, float b)
+{
+  return fabs(a - b) <= 1e-4f * (1.0f + fabs(a));
+}
+
+bool close(const vsx_vector3<>& a, const vsx_vector3<>& b)
+{
+  return close(a.x, b.x) && close(a.y, b.y) && close(a.z, b.z);
+}
+
+void fill(vsx_ma_vector< vsx_vector3<> >& v, size_t count)
+{
+  v.reset_used(0);
+  for (size_t i = 0; i < count; i++)
+    v[i] = vsx_vector3<>(rand_gen.frand() * 2.0f - 1.0f, rand_gen.frand() * 2.0f - 1.0f, rand_gen.frand() * 2.0f + 0.5f);
+}
+
+// every count up to a few full iterations of the widest implementation plus tail
+void test_implementation()
+{
+  vsx_matrix<float> matrix;
+  for (size_t i = 0; i < 12; i++)
+    matrix.m[i] = rand_gen.frand() * 2.0f - 1.0f;
+
+  vsx_quaternion<float> rotation(0.3f, -0.2f, 0.5f, 0.8f);
+  vsx_matrix<float> rotation_matrix = rotation.matrix();
+  vsx_vector3<> value(0.5f, -2.0f, 3.0f);
+
+  vsx_ma_vector< vsx_vector3<> > a, b, result;
+  vsx_ma_vector< float > dots;
+
+  for (size_t count = 0; count < 40; count++)
+  {
+    fill(a, count);
+    fill(b, count);
+    result.allocate(count);
+    dots.allocate(count);
+
+    vsx_vector3_batch::transform(matrix, a.get_pointer(), result.get_pointer(), count);
+    for (size_t i = 0; i < count; i++)
+      test_assert(close(result[i], matrix.multiply_vector(a[i])));
+
+    vsx_vector3_batch::rotate(rotation, a.get_pointer(), result.get_pointer(), count);
+    for (size_t i = 0; i < count; i++)
+      test_assert(close(result[i], rotation_matrix.multiply_vector(a[i])));
+
+    vsx_vector3_batch::translate(value, a.get_pointer(), result.get_pointer(), count);
+    for (size_t i = 0; i < count; i++)
+      test_assert(close(result[i], a[i] + value));
+
+    vsx_vector3_batch::scale(value, a.get_pointer(), result.get_pointer(), count);
+    for (size_t i = 0; i < count; i++)
+      test_assert(close(result[i], a[i] * value));
+
+    vsx_vector3_batch::normalize(a.get_pointer(), result.get_pointer(), count);
+    for (size_t i = 0; i < count; i++)
+    {
+      vsx_vector3<> n = a[i];
+      n.normalize();
+      test_assert(close(result[i], n));
+    }
+
+    vsx_vector3_batch::cross(a.get_pointer(), b.get_pointer(), result.get_pointer(), count);
+    for (size_t i = 0; i < count; i++)
+    {
+      vsx_vector3<> c;
+      c.cross(a[i], b[i]);
+      test_assert(close(result[i], c));
+    }
+
+    vsx_vector3_batch::dot(a.get_pointer(), b.get_pointer(), dots.get_pointer(), count);
+    for (size_t i = 0; i < count; i++)
+      test_assert(close(dots[i], a[i].dot_product(&b[i])));
+
+    // in place
+    result.reset_used(0);
+    for (size_t i = 0; i < count; i++)
+      result[i] = a[i];
+    vsx_vector3_batch::transform(matrix, result.get_pointer(), result.get_pointer(), count);
+    for (size_t i = 0; i < count; i++)
+      test_assert(close(result[i], matrix.multiply_vector(a[i])));
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  VSX_UNUSED(argc);
+  VSX_UNUSED(argv);
+
+  vsx_printf(L"detected implementation: %hs\n", vsx_vector3_batch::get_implementation_name());
+  test_implementation();
+
+  vsx_vector3_batch::set_implementation( vsx_vector3_batch::scalar::get() );
+  test_implementation();
+
+  #ifdef VSX_VECTOR3_BATCH_X86
+    vsx_vector3_batch::set_implementation( vsx_vector3_batch::sse::get() );
+    test_implementation();
+  #endif
+
+  vsx_vector3_batch::set_implementation(0x0);
+
+  test_complete
+
+  return 0;
+}
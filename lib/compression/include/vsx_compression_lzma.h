@@ -9,6 +9,8 @@ class compression_lzma
 {
 public:
   static vsx_ma_vector<unsigned char> compress( vsx_ma_vector<unsigned char> &uncompressed_data);
+  // level 0 (fastest) to 9 (smallest), dictionary size follows the level
+  static vsx_ma_vector<unsigned char> compress( vsx_ma_vector<unsigned char> &uncompressed_data, int level);
   static void uncompress( vsx_ma_vector<unsigned char> &uncompressed_data, vsx_ma_vector<unsigned char> &compressed_data);
   static vsx_ma_vector<unsigned char> uncompress( vsx_ma_vector<unsigned char> &compressed_data, size_t original_size);
 };
@@ -32,6 +32,32 @@ vsx_ma_vector<unsigned char> compression_lzma::compress(vsx_ma_vector<unsigned c
   return compressed_data;
 }
 
+vsx_ma_vector<unsigned char> compression_lzma::compress(vsx_ma_vector<unsigned char> &uncompressed_data, int level)
+{
+  vsx_ma_vector<unsigned char> compressed_data;
+  size_t propsSize = LZMA_PROPS_SIZE;
+  size_t destLen = uncompressed_data.get_sizeof() + uncompressed_data.get_sizeof() / 3 + 128;
+  compressed_data.allocate(propsSize + destLen);
+
+  LzmaCompress(
+    &compressed_data[LZMA_PROPS_SIZE],
+    &destLen,
+    uncompressed_data.get_pointer(),
+    uncompressed_data.get_sizeof(),
+    compressed_data.get_pointer(),
+    &propsSize,
+    level,
+    0,  /* dictionary size from level */
+    -1,
+    -1,
+    -1,
+    -1,
+    1
+  );
+  compressed_data.reset_used(destLen + LZMA_PROPS_SIZE);
+  return compressed_data;
+}
+
 void compression_lzma::uncompress(
     vsx_ma_vector<unsigned char> &uncompressed_data,
     vsx_ma_vector<unsigned char> &compressed_data
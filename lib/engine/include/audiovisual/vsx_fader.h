@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vsx_engine.h>
+#include <vsx_engine_param_handle.h>
 
 namespace vsx
 {
@@ -16,6 +17,11 @@ class fader
   vsx_command_list cmd_in;
   vsx_command_list cmd_out;
 
+  vsx_engine_param_handle<vsx_module_param_texture> param_t_a;
+  vsx_engine_param_handle<vsx_module_param_texture> param_t_b;
+  vsx_engine_param_handle<vsx_module_param_float> param_pos;
+  vsx_engine_param_handle<vsx_module_param_float> fade_pos_from_engine;
+
 public:
 
   fader(vsx_string<> filename)
@@ -26,29 +32,35 @@ public:
     engine = new vsx_engine( vsx_module_list_manager::get()->module_list );
     engine->start();
     engine->load_state( filename );
+
+    param_t_a.bind(engine, "visual_fader", "texture_a_in");
+    param_t_b.bind(engine, "visual_fader", "texture_b_in");
+    param_pos.bind(engine, "visual_fader", "fade_pos_in");
+    fade_pos_from_engine.bind(engine, "visual_fader", "fade_pos_from_engine");
   }
 
   void render(vsx_texture<>& tex_current, vsx_texture<>& tex_upcoming, float transition_time)
   {
-    vsx_module_param_texture* param_t_a = (vsx_module_param_texture*)engine->get_in_param_by_name("visual_fader", "texture_a_in");
-    vsx_module_param_texture* param_t_b = (vsx_module_param_texture*)engine->get_in_param_by_name("visual_fader", "texture_b_in");
-    vsx_module_param_float* param_pos = (vsx_module_param_float*)engine->get_in_param_by_name("visual_fader", "fade_pos_in");
-    vsx_module_param_float* fade_pos_from_engine = (vsx_module_param_float*)engine->get_in_param_by_name("visual_fader", "fade_pos_from_engine");
     engine->process_message_queue(&cmd_in, &cmd_out);
     cmd_out.clear_normal();
 
-    req(param_t_a);
-    req(param_t_b);
-    req(param_pos);
-    req(fade_pos_from_engine);
+    vsx_module_param_texture* t_a = param_t_a.get_module_param();
+    vsx_module_param_texture* t_b = param_t_b.get_module_param();
+    vsx_module_param_float* pos = param_pos.get_module_param();
+    vsx_module_param_float* pos_from_engine = fade_pos_from_engine.get_module_param();
+
+    req(t_a);
+    req(t_b);
+    req(pos);
+    req(pos_from_engine);
 
-    param_t_a->set(&tex_current);
-    param_t_b->set(&tex_upcoming);
+    t_a->set(&tex_current);
+    t_b->set(&tex_upcoming);
 
-    fade_pos_from_engine->set(1.0f);
+    pos_from_engine->set(1.0f);
 
     float t = CLAMP(transition_time, 0.0f, 1.0f);
-    param_pos->set(1.0f - t);
+    pos->set(1.0f - t);
 
     engine->render();
   }
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <future>
+#include <chrono>
 #include <vsx_engine.h>
 #include <string/vsx_json.h>
 #include <vsx_module_list_manager.h>
+#include <tools/vsx_thread_pool.h>
 
 namespace vsx
 {
@@ -16,6 +19,26 @@ class state {
   vsx_command_list cmd_in;
   vsx_command_list cmd_out;
 
+  // background part of the load, see preload()
+  std::future<int> preload_result;
+  bool preloading = false;
+
+  // preloads run one after the other, so modules are constructed by one
+  // thread at a time; their thread safe inits still use the shared pool
+  static vsx_thread_pool<>* loader()
+  {
+    static vsx_thread_pool<> pool(1);
+    return &pool;
+  }
+
+  void engine_create()
+  {
+    engine = new vsx_engine( vsx_module_list_manager::get()->module_list );
+    engine->set_no_send_client_time( true );
+    engine->start();
+    engine->reset_time();
+  }
+
 public:
   float fx_level = 1.0f;
   float speed = 1.0f;
@@ -64,13 +87,59 @@ public:
   {
   }
 
+  // Starts loading the state on the loader thread: reading, parsing and
+  // constructing the modules, init() for those that are thread safe.
+  // init() finishes the load on the render thread, which this is called on.
+  void preload()
+  {
+    req(!engine);
+
+    // the loader constructs modules, their plugins have to be set up here
+    vsx_module_list_manager::get()->module_list->load_plugins();
+
+    engine_create();
+
+    vsx_engine* preload_engine = engine;
+    vsx_string<> preload_filename = filename;
+    vsx::filesystem* preload_filesystem = filesystem;
+    preload_result = loader()->add(
+      vsx_thread_pool<>::low_priority,
+      [preload_engine, preload_filename, preload_filesystem]()
+      {
+        vsx_string<> error;
+        return preload_engine->preload_state( preload_filename, &error, preload_filesystem );
+      }
+    );
+    preloading = true;
+  }
+
+  // true unless the background part of a preload is still running
+  bool preload_ready()
+  {
+    reqrv(preloading, true);
+    return preload_result.wait_for( std::chrono::seconds(0) ) == std::future_status::ready;
+  }
+
+  bool is_loaded()
+  {
+    return engine && !preloading;
+  }
+
+  // Loads the state, or finishes a preload (waiting for it if needed).
+  // 0 = successfully loaded, 1 if it already was.
   int init()
   {
+    if (preloading)
+    {
+      preloading = false;
+      int result = preload_result.get();
+      if (result)
+        return result;
+      return engine->load_preloaded_state();
+    }
+
     reqrv(!engine, 1);
-    engine = new vsx_engine( vsx_module_list_manager::get()->module_list );
-    engine->set_no_send_client_time( true );
-    engine->start();
-    engine->reset_time();
+    engine_create();
     vsx_string<> error;
     if (filesystem)
       return engine->load_state_filesystem( filename, &error, filesystem );
@@ -80,6 +149,8 @@ public:
   ~state()
   {
     req(engine);
+    if (preloading)
+      preload_result.wait();
     engine->stop();
     delete engine;
   }
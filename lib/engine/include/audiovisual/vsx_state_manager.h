@@ -33,6 +33,7 @@
   #include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <GL/glew.h>
 #include "vsx_engine.h"
 #include <math/vsx_rand_singleton.h>
@@ -63,6 +64,10 @@ private:
   // currently active state
   state* state_current = 0x0;
 
+  // the state the randomizer / sequential progression changes to next,
+  // finished loading ahead of the change
+  state* state_next = 0x0;
+
   // event queue
   vsx_input_event_queue* event_queue = 0x0;
 
@@ -83,24 +88,100 @@ private:
 
   void init_states()
   {
-    // go through states and exclude broken visuals
+    // otherwise only the selected state and the one predicted to be next
+    // are loaded, see handle_render_first and update_preload
+    req(option_preload_all);
+
+    // load all of them in the background, finish them in order and
+    // exclude broken visuals
+    foreach (states, i)
+      states[i]->preload();
+
     std::vector<state*> new_statelist;
     for (states_iter = states.begin(); states_iter != states.end(); states_iter++)
     {
       // 0 = successfully loaded
-      req_continue(!(*states_iter)->init());
+      if ((*states_iter)->init())
+      {
+        delete *states_iter;
+        continue;
+      }
 
       // state is OK, add to state list
       new_statelist.push_back(*states_iter);
 
-      // preload where applicable
-      if (option_preload_all == true)
-        while ( !(*states_iter)->done_loading() )
-          (*states_iter)->render(event_queue);
+      while ( !(*states_iter)->done_loading() )
+        (*states_iter)->render(event_queue);
     }
     states = new_statelist;
   }
 
+  // removes a state that failed to load, states_iter stays on its state
+  void drop_state(state* broken)
+  {
+    state* selected = *states_iter;
+    if (selected == broken)
+      selected = state_current;
+
+    states.erase( std::find(states.begin(), states.end(), broken) );
+    delete broken;
+
+    states_iter = std::find(states.begin(), states.end(), selected);
+    if (states_iter == states.end())
+      states_iter = states.begin();
+  }
+
+  // Loads the selected state or finishes its preload. A broken one is dropped
+  // and the selection goes back to the current state.
+  bool init_selected()
+  {
+    state* selected = *states_iter;
+    reqrv(!selected->is_loaded(), true);
+    reqrv(selected->init(), true);
+    drop_state(selected);
+    return false;
+  }
+
+  // picks the next state ahead of the change, relative to the selected one
+  void predict_next_state()
+  {
+    state_next = 0x0;
+    req(states.size() > 1);
+
+    size_t selected_index = states_iter - states.begin();
+    if (randomizer)
+    {
+      // any but the selected one
+      size_t index = rand() % (states.size() - 1);
+      if (index >= selected_index)
+        index++;
+      state_next = states[index];
+      return;
+    }
+
+    req(sequential);
+    state_next = states[(selected_index + 1) % states.size()];
+  }
+
+  // finishes loading the predicted state as soon as its background part is
+  // done, so the change to it only has to wait for its GL resources
+  void update_preload()
+  {
+    req(state_next);
+    req(!state_next->is_loaded());
+
+    if (!state_next->engine)
+    {
+      state_next->preload();
+      return;
+    }
+
+    req(state_next->preload_ready());
+    req(state_next->init());
+    drop_state(state_next);
+    predict_next_state();
+  }
+
 public:
 
   // options
@@ -143,10 +224,12 @@ public:
 
   void toggle_randomizer() {
     randomizer = !randomizer;
+    predict_next_state();
   }
 
   void set_randomizer(bool status) {
     randomizer = status;
+    predict_next_state();
   }
 
   bool get_randomizer_status() {
@@ -155,6 +238,7 @@ public:
 
   void set_sequential(bool status) {
     sequential = status;
+    predict_next_state();
   }
 
   void select_state (int selection)
@@ -178,8 +262,9 @@ public:
           change = false;
       }
     }
-    (*states_iter)->init();
+    req(init_selected());
     faders.mark_change();
+    predict_next_state();
   }
 
 
@@ -188,23 +273,29 @@ public:
     req(states.size() > 1);
     req(*states_iter == state_current);
 
-    int steps = rand() % states.size();
-    while (steps) {
-      ++states_iter;
-      if (states_iter == states.end())
-        states_iter = states.begin();
-      --steps;
-    }
-
-    if ((*states_iter) == state_current)
+    if (state_next)
+      states_iter = std::find(states.begin(), states.end(), state_next);
+    else
     {
-      select_random_state();
-      return;
+      int steps = rand() % states.size();
+      while (steps) {
+        ++states_iter;
+        if (states_iter == states.end())
+          states_iter = states.begin();
+        --steps;
+      }
+
+      if ((*states_iter) == state_current)
+      {
+        select_random_state(mark_change);
+        return;
+      }
     }
 
-    (*states_iter)->init();
+    req(init_selected());
     if (mark_change)
       faders.mark_change();
+    predict_next_state();
   }
 
   void select_next_state()
@@ -216,8 +307,9 @@ public:
     if (states_iter == states.end())
       states_iter = states.begin();
 
-    (*states_iter)->init();
+    req(init_selected());
     faders.mark_change();
+    predict_next_state();
   }
 
   void select_prev_state()
@@ -227,8 +319,9 @@ public:
     if (states_iter == states.begin())
       states_iter = states.end();
     --states_iter;
-    (*states_iter)->init();
+    req(init_selected());
     faders.mark_change();
+    predict_next_state();
   }
 
   vsx_string<> state_loading()
@@ -299,16 +392,18 @@ public:
 
     init_states();
 
-    // reset state_iter
+    // reset state_iter, select random initial state
     states_iter = states.begin();
-    state_current = *states_iter;
+    if (randomizer && states.size())
+      states_iter += rand() % states.size();
 
-    // select random initial state
-    if (randomizer)
-    {
-      select_random_state(false);
-      state_current = *states_iter;
-    }
+    // waits for its preload
+    while (states.size() && !init_selected())
+      ;
+    req(states.size());
+
+    state_current = *states_iter;
+    predict_next_state();
   }
 
   bool render_change()
@@ -325,6 +420,7 @@ public:
     // automatic progression
     update_randomizer();
     update_sequential();
+    update_preload();
 
     system_message = "";
     foreach (states, i)
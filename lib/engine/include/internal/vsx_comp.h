@@ -52,9 +52,13 @@ protected:
   bool has_run;
   
   bool all_valid;
+  bool critical_unconnected;
+  bool critical_unconnected_dirty;
 	vsx_timer run_timer;
 
   vsx_nw_vector< vsx_module_operation* > module_operations;
+
+  void run_module();
 	
 public:
 
@@ -91,12 +95,39 @@ public:
 	//void load_module(vsx_string<>module_class, vsx_string<>name);
 
   void load_module(const vsx_string<>& module_name, vsx_module_engine_state* engine_info);
+
+  // load_module in two steps: constructs the module, then init_module declares
+  // its params and runs init(), which the loader may do on another thread
+  bool create_module(const vsx_string<>& module_name, vsx_module_engine_state* engine_info);
   void unload_module();
 	void init_module();
 	
   bool prepare(); // pre-parade!
 
+  // prepare() split in steps for the engine's execution plan:
+  //   prepare_begin()        - false if we're already done (or failed) this frame
+  //   prepare_channel_done() - after each successful channel execution
+  //   prepare_failed()       - a channel failed, we're done for this frame
+  //   prepare_end()          - all channels are executed
+  bool prepare_begin();
+  void prepare_channel_done(vsx_channel* channel);
+  void prepare_failed()
+  {
+    frame_status = frame_failed;
+  }
+  void prepare_end();
+
+  // connections changed, re-check critical parameters on next prepare
+  void invalidate_critical_unconnected()
+  {
+    critical_unconnected_dirty = true;
+  }
+
   bool run(vsx_module_param_abs* param);
+
+  // prepare and run the module without asking for output, used by the
+  // scheduler to run thread safe modules ahead of the render thread pull
+  bool prepare_and_run();
 	bool stop();
 	bool start();
 
@@ -123,6 +154,12 @@ public:
   void reset_frame_status()
   {
 		frame_status = initial_status;
+    #ifdef VSXU_MODULE_TIMING
+      time_run = new_time_run;
+      time_output = new_time_output;
+      new_time_run = 0.0;
+      new_time_output = 0.0;
+    #endif
 	}
 
   vsx_comp();
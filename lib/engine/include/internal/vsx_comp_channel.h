@@ -85,14 +85,23 @@ public:
 	
 	
 	vsx_string<>get_param_name();
-	virtual bool execute() = 0;
+
+  // execution is split in two so the engine's execution plan can prepare the
+  // sources in between:
+  //   activate()        - module offscreen activation, before the sources are prepared
+  //   execute_sources() - prepare (if not already done), run and read the sources
+  bool activate();
+  virtual bool execute_sources() = 0;
+
+  bool execute();
+
 	virtual ~vsx_channel();
 };
 
 
 class vsx_channel_render : public vsx_channel {
 public:
-	bool execute();
+	bool execute_sources();
 	vsx_channel_render(vsx_module* module,vsx_engine_param* param, vsx_comp* pare) : vsx_channel(module,param,100,pare) {	component = pare;}
 };
 
@@ -100,7 +109,7 @@ public:
 #define NEW_DEFAULT_CHANNEL(name, mcon) \
 class name : public vsx_channel { \
 public: \
-	bool execute(); \
+	bool execute_sources(); \
 	name(vsx_module* module,vsx_engine_param* param, vsx_comp* pare) : vsx_channel(module,param,mcon,pare) {	component = pare;} \
 };
 NEW_DEFAULT_CHANNEL(vsx_channel_texture, 1)
@@ -0,0 +1,121 @@
+/**
+* Project: VSXu Engine: Realtime modular visual programming engine.
+*
+* This file is part of Vovoid VSXu Engine.
+*
+* @author Jonatan Wallmander, Robert Wenzel, Vovoid Media Technologies AB Copyright (C) 2003-2013
+* @see The GNU Lesser General Public License (LGPL)
+*
+* VSXu Engine is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#pragma once
+
+#include <vector>
+#include <set>
+#include <container/vsx_nw_vector.h>
+
+class vsx_comp;
+class vsx_channel;
+
+/*
+  Flattened execution plan.
+
+  The recursive pull from the outputs (vsx_comp::prepare() -> vsx_channel::execute()
+  -> vsx_comp::prepare() on the sources ...) always visits the components in the
+  same order as long as the connections don't change. The plan records that order
+  once as a flat array of operations which render() then walks in a single loop:
+
+    comp_begin       - vsx_comp::prepare_begin(), skips the comp if it's already done
+    channel_activate - offscreen activation, before the channel's sources are prepared
+    channel_execute  - run the (already prepared) sources and read their values
+    comp_end         - run output modules, mark the comp as prepared
+
+  Every operation knows where its component ends in the array, so a failing or
+  already prepared component skips the rest of its operations just like the
+  recursive version returns early. Components not yet prepared when a channel
+  reads them (after a failure, or tunnels) are still prepared recursively by the
+  channel.
+
+  The plan also keeps the list of reachable components so the per-frame status
+  reset doesn't have to walk the whole forge.
+*/
+class vsx_engine_plan
+{
+public:
+
+  enum operation_type
+  {
+    comp_begin,
+    channel_activate,
+    channel_execute,
+    comp_end
+  };
+
+  struct operation
+  {
+    operation_type type;
+    vsx_comp* comp;
+    vsx_channel* channel;
+    // index of the first operation after this component's comp_end
+    size_t skip_to;
+  };
+
+private:
+
+  std::vector<operation> operations;
+  std::vector<vsx_comp*> components;
+  std::set<vsx_comp*> visited;
+  std::set<vsx_comp*> reachable;
+
+  bool dirty = true;
+
+  void compile(vsx_comp* comp);
+  void collect(vsx_comp* comp);
+
+public:
+
+  void invalidate()
+  {
+    dirty = true;
+  }
+
+  bool is_dirty()
+  {
+    return dirty;
+  }
+
+  size_t get_num_operations()
+  {
+    return operations.size();
+  }
+
+  // all components reachable from the outputs
+  std::vector<vsx_comp*>& get_components()
+  {
+    return components;
+  }
+
+  void rebuild(vsx_nw_vector<vsx_comp*>& outputs);
+
+  void run(vsx_nw_vector<vsx_comp*>& outputs);
+
+  void clear()
+  {
+    operations.clear();
+    components.clear();
+    dirty = true;
+  }
+};
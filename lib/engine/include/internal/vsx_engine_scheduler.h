@@ -0,0 +1,97 @@
+/**
+* Project: VSXu Engine: Realtime modular visual programming engine.
+*
+* This file is part of Vovoid VSXu Engine.
+*
+* @author Jonatan Wallmander, Robert Wenzel, Vovoid Media Technologies AB Copyright (C) 2003-2013
+* @see The GNU Lesser General Public License (LGPL)
+*
+* VSXu Engine is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include <container/vsx_nw_vector.h>
+
+class vsx_comp;
+
+/*
+  Parallel pre-run of the component graph.
+
+  The normal render path pulls the graph through vsx_comp::prepare() from the
+  outputs, on the render thread. When enabled, the scheduler runs before that
+  pull and executes all components that are safe to run on a worker thread
+  (module_info->thread_safe and no GL-bound component upstream) level by level
+  in topological order. Components within the same level do not depend on each
+  other and are run in parallel on the thread pool.
+
+  Once the pre-run is done, those components are in the run_finished state so
+  the regular pull only calls module->output() on them - everything else
+  (render, texture, GL-bound modules) still runs on the render thread.
+
+  The schedule is built from the channel connection lists and is only rebuilt
+  after invalidate() has been called, which the engine does whenever a
+  component, connection or script modifier changes.
+*/
+class vsx_engine_scheduler
+{
+  // components grouped by dependency depth, level 0 has no scheduled upstream
+  std::vector< std::vector<vsx_comp*> > levels;
+
+  bool dirty = true;
+
+  // 0 = not visited, 1 = being visited, 2 = schedulable, 3 = not schedulable
+  std::map<vsx_comp*, int> visit_state;
+  std::map<vsx_comp*, size_t> comp_level;
+
+  bool is_thread_safe(vsx_comp* comp);
+  bool visit(vsx_comp* comp);
+  void collect(vsx_comp* comp);
+
+public:
+
+  void invalidate()
+  {
+    dirty = true;
+  }
+
+  bool is_dirty()
+  {
+    return dirty;
+  }
+
+  // number of components run in the pre-pass, for diagnostics
+  size_t get_num_scheduled();
+
+  // number of dependency levels, for diagnostics
+  size_t get_num_levels()
+  {
+    return levels.size();
+  }
+
+  void rebuild(vsx_nw_vector<vsx_comp*>& outputs);
+
+  void run(vsx_nw_vector<vsx_comp*>& outputs);
+
+  void clear()
+  {
+    levels.clear();
+    visit_state.clear();
+    comp_level.clear();
+    dirty = true;
+  }
+};
@@ -0,0 +1,184 @@
+/**
+* Project: VSXu Engine: Realtime modular visual programming engine.
+*
+* This file is part of Vovoid VSXu Engine.
+*
+* @author Jonatan Wallmander, Robert Wenzel, Vovoid Media Technologies AB Copyright (C) 2003-2013
+* @see The GNU Lesser General Public License (LGPL)
+*
+* VSXu Engine is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <atomic>
+#include <string/vsx_string.h>
+#include <profiler/vsx_profiler_manager.h>
+
+/*
+  Engine tracing: spans for frames, module run/output, channel execution,
+  the sequencer and command batches, fed to vsx_profiler. Every thread that
+  runs components records into its own profiler queue.
+
+  When tracing is off a span costs one relaxed atomic load. A span keeps the
+  profiler it started on, so stopping in the middle of a frame still ends
+  every span that was begun.
+*/
+class vsx_engine_trace
+{
+  static std::atomic<bool>& enabled_flag()
+  {
+    static std::atomic<bool> flag(false);
+    return flag;
+  }
+
+public:
+
+  static bool is_enabled()
+  {
+    return enabled_flag().load(std::memory_order_relaxed);
+  }
+
+  // starts the profiler threads the first time, then data collection
+  static void start(bool chrome_trace_export)
+  {
+    req(!is_enabled());
+    vsx_profiler_manager* manager = vsx_profiler_manager::get_instance();
+    manager->chrome_trace_export = manager->chrome_trace_export || chrome_trace_export;
+    manager->start();
+    manager->enable();
+    enabled_flag().store(true);
+  }
+
+  static void stop()
+  {
+    req(is_enabled());
+    enabled_flag().store(false);
+    vsx_profiler_manager::get_instance()->disable();
+  }
+
+  // this thread's profiler, 0x0 if all profiler slots are taken
+  static vsx_profiler* get_profiler()
+  {
+    static thread_local vsx_profiler* profiler = 0x0;
+    static thread_local bool looked_up = false;
+    if (!looked_up)
+    {
+      profiler = vsx_profiler_manager::get_instance()->get_profiler();
+      looked_up = true;
+    }
+    return profiler;
+  }
+
+  static vsx_profiler* begin(const char* tag)
+  {
+    if (!is_enabled())
+      return 0x0;
+    vsx_profiler* profiler = get_profiler();
+    if (profiler)
+      profiler->sub_begin(tag);
+    return profiler;
+  }
+
+  // tag "<prefix> <suffix>", built only when tracing
+  static vsx_profiler* begin(const char* prefix, const char* suffix)
+  {
+    if (!is_enabled())
+      return 0x0;
+    char tag[32];
+    snprintf(tag, sizeof(tag), "%s %s", prefix, suffix);
+    return begin(tag);
+  }
+
+  // names are only read when tracing
+  static vsx_profiler* begin(const vsx_string<>& tag)
+  {
+    if (!is_enabled())
+      return 0x0;
+    return begin(tag.c_str());
+  }
+
+  static vsx_profiler* begin(const vsx_string<>& prefix, const vsx_string<>& suffix)
+  {
+    if (!is_enabled())
+      return 0x0;
+    return begin(prefix.c_str(), suffix.c_str());
+  }
+
+  static vsx_profiler* begin(const vsx_string<>& prefix, const char* suffix)
+  {
+    if (!is_enabled())
+      return 0x0;
+    return begin(prefix.c_str(), suffix);
+  }
+
+  static void end(vsx_profiler* profiler)
+  {
+    if (profiler)
+      profiler->sub_end();
+  }
+
+  static vsx_profiler* frame_begin()
+  {
+    if (!is_enabled())
+      return 0x0;
+    vsx_profiler* profiler = get_profiler();
+    if (profiler)
+      profiler->maj_begin();
+    return profiler;
+  }
+
+  static void frame_end(vsx_profiler* profiler)
+  {
+    if (profiler)
+      profiler->maj_end();
+  }
+};
+
+class vsx_engine_trace_span
+{
+  vsx_profiler* profiler;
+
+public:
+
+  vsx_engine_trace_span(const char* tag)
+    :
+      profiler( vsx_engine_trace::begin(tag) )
+  {}
+
+  vsx_engine_trace_span(const char* prefix, const char* suffix)
+    :
+      profiler( vsx_engine_trace::begin(prefix, suffix) )
+  {}
+
+  vsx_engine_trace_span(const vsx_string<>& tag)
+    :
+      profiler( vsx_engine_trace::begin(tag) )
+  {}
+
+  vsx_engine_trace_span(const vsx_string<>& prefix, const char* suffix)
+    :
+      profiler( vsx_engine_trace::begin(prefix, suffix) )
+  {}
+
+  vsx_engine_trace_span(const vsx_engine_trace_span&) = delete;
+  vsx_engine_trace_span& operator=(const vsx_engine_trace_span&) = delete;
+
+  ~vsx_engine_trace_span()
+  {
+    vsx_engine_trace::end(profiler);
+  }
+};
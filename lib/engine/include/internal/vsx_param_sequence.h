@@ -25,16 +25,22 @@
 #pragma once
 
 #include <internal/vsx_param_sequence_item.h>
+#include <internal/vsx_param_sequence_track.h>
 
 class vsx_param_sequence
 {
   float last_time; // last time we were called, to see if we should trace back
   float line_time; // current line time (accumulated)
   int line_cur; // current line
-  vsx_string<>cur_val, to_val;
+  int cur_key, to_key; // keys we're interpolating between, -1 until started
   float cur_delay;
   int cur_interpolation;
   float total_time;
+
+  // keyframes parsed for execute(), rebuilt after each edit
+  vsx_param_sequence_track track;
+  void build_track();
+
 public:
   void* engine;
   vsx_comp_abs* comp;
@@ -57,6 +63,7 @@ public:
       items[i].accum_time = accum_time;
       accum_time += items[i].total_length;
     }
+    track.invalidate();
   }
 
   void set_time(float stime);
@@ -0,0 +1,92 @@
+/**
+* Project: VSXu Engine: Realtime modular visual programming engine.
+*
+* This file is part of Vovoid VSXu Engine.
+*
+* @author Jonatan Wallmander, Robert Wenzel, Vovoid Media Technologies AB Copyright (C) 2003-2013
+* @see The GNU Lesser General Public License (LGPL)
+*
+* VSXu Engine is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <math/vsx_bezier_calc.h>
+#include <math/quaternion/vsx_quaternion.h>
+
+/*
+  Typed copy of the keyframes in a vsx_param_sequence.
+
+  The items keep their values as strings since that's what the sequencer
+  protocol talks. The track holds the same keyframes parsed once per edit so
+  execute() never has to touch a string:
+
+    float, float3, float4 - values[key * arity + component]
+    quaternion            - normalized quaternions
+    bezier (interpolation 4) - coefficients for the segment key -> key+1
+
+  times[] is the ascending start time of every key, used to binary search
+  the current key when the time jumps.
+*/
+class vsx_param_sequence_track
+{
+public:
+  // start time of each key
+  std::vector<float> times;
+
+  // non-empty value, empty values aren't interpolated
+  std::vector<char> has_value;
+
+  size_t arity = 0;
+  std::vector<float> values;
+  std::vector< vsx_quaternion<> > quaternions;
+  std::vector< vsx_bezier_calc<float> > beziers;
+
+  bool dirty = true;
+
+  void invalidate()
+  {
+    dirty = true;
+  }
+
+  void clear()
+  {
+    times.clear();
+    has_value.clear();
+    values.clear();
+    quaternions.clear();
+    beziers.clear();
+    arity = 0;
+  }
+
+  inline float get_float(size_t key, size_t component = 0)
+  {
+    return values[key * arity + component];
+  }
+
+  // last key starting before time (or at it, if inclusive), -1 if none
+  inline int find(float time, bool inclusive)
+  {
+    std::vector<float>::iterator it =
+        inclusive
+        ?
+          std::upper_bound(times.begin(), times.end(), time)
+        :
+          std::lower_bound(times.begin(), times.end(), time);
+    return (int)(it - times.begin()) - 1;
+  }
+};
@@ -14,6 +14,8 @@
 #define VSX_ENGINE_PLAYING 1
 #define VSX_ENGINE_REWIND 2
 
+class vsx_module_job_system;
+
 class vsx_module_engine_state
 {
 public:
@@ -30,6 +32,9 @@ public:
   // module list - so that modules can construct their own vsx_engine's
   void* module_list;
 
+  // background work for modules, see vsx_module_job.h
+  vsx_module_job_system* job_system = 0x0;
+
   int state = VSX_ENGINE_STOPPED; // stopped or playing
 
   // engine effect amplification - can be used freely by the modules
@@ -50,6 +55,9 @@ public:
   float real_dtime = 0.0f;
   float real_vtime = 0.0f;
 
+  // frames rendered, counts up at the start of every frame
+  uint64_t frame = 0;
+
   // time control from module
   int request_play = 0;
   int request_stop = 0;
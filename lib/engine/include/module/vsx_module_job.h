@@ -0,0 +1,260 @@
+/*
+  Background work for modules.
+
+  Modules must not start their own threads: a state with a few dozen threaded
+  modules would create as many OS threads. Instead they hand work to the
+  engine's job system (engine_state->job_system) which runs it on the shared
+  thread pool, so the number of threads stays bounded by the core count.
+
+  Typical use, producing a result one frame behind:
+
+    vsx_module_job job;
+    vsx_module_job_double_buffer<vsx_mesh<>*> meshes;
+
+    void run()
+    {
+      if (job.collect())
+      {
+        meshes.swap();
+        result->set(meshes.front());
+      }
+
+      if (!job.is_busy())
+        job.submit(engine_state, vsx_module_job_system::priority_frame,
+          [this]() { build(meshes.back()); }
+        );
+    }
+
+    void on_delete()
+    {
+      job.cancel();
+    }
+*/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <tools/vsx_thread_pool.h>
+#include "vsx_module_engine_state.h"
+
+class vsx_module_job_system
+{
+  vsx_thread_pool<>* pool;
+
+public:
+
+  enum priority
+  {
+    // loading, generating - nobody is waiting for the result this frame
+    priority_background,
+    // results picked up by the module on a following frame
+    priority_frame
+  };
+
+  explicit vsx_module_job_system(vsx_thread_pool<>* thread_pool)
+    :
+    pool(thread_pool)
+  {}
+
+  // Within a priority, jobs due on an earlier frame run first.
+  void submit(priority p, uint64_t deadline_frame, std::function<void()> f)
+  {
+    // the engine scheduler runs components on the same pool with normal
+    // priority and the render thread waits for those, so all module jobs
+    // stay in the low priority band; frame jobs get its upper half
+    const uint64_t frame_bit = 1ULL << 55;
+    const uint64_t order_mask = frame_bit - 1;
+    if (deadline_frame > order_mask)
+      deadline_frame = order_mask;
+
+    uint64_t key =
+      vsx_thread_pool<>::priority_key(vsx_thread_pool<>::low_priority) | (order_mask - deadline_frame);
+    if (p == priority_frame)
+      key |= frame_bit;
+
+    pool->add_ordered(key, std::move(f));
+  }
+
+  size_t get_thread_count()
+  {
+    return pool->get_thread_count();
+  }
+
+  static vsx_module_job_system* get_instance()
+  {
+    static vsx_module_job_system s(vsx_thread_pool<>::instance());
+    return &s;
+  }
+};
+
+
+// One unit of work a module keeps in flight at most once at a time.
+class vsx_module_job
+{
+  enum
+  {
+    state_idle,
+    state_queued,
+    state_running,
+    state_done
+  };
+
+  // shared with the pool task, which can outlive the module if cancelled
+  // while still queued
+  struct job_state
+  {
+    std::atomic<int> state;
+    std::atomic<bool> cancelled;
+    std::function<void()> work;
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    job_state()
+      :
+      state(state_idle),
+      cancelled(false)
+    {}
+  };
+
+  std::shared_ptr<job_state> job = std::make_shared<job_state>();
+
+  static void execute(job_state* j)
+  {
+    j->work();
+    {
+      std::lock_guard<std::mutex> lock(j->mutex);
+      j->state = state_done;
+    }
+    j->finished.notify_all();
+  }
+
+  static bool claim(job_state* j)
+  {
+    int expected = state_queued;
+    return j->state.compare_exchange_strong(expected, state_running);
+  }
+
+  void wait_running()
+  {
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [this]{ return job->state != state_running; });
+  }
+
+public:
+
+  ~vsx_module_job()
+  {
+    cancel();
+  }
+
+  // Queues work unless the previous job is still in flight or uncollected.
+  // deadline_frames: how many frames from now the result is needed.
+  bool submit(
+      vsx_module_engine_state* engine_state,
+      vsx_module_job_system::priority p,
+      std::function<void()> work,
+      uint64_t deadline_frames = 1
+  )
+  {
+    if (job->state != state_idle)
+      return false;
+
+    job->cancelled = false;
+    job->work = std::move(work);
+    job->state = state_queued;
+
+    std::shared_ptr<job_state> j = job;
+    engine_state->job_system->submit(
+      p,
+      engine_state->frame + deadline_frames,
+      [j]()
+      {
+        // cancelled, or already run by wait()
+        if (!claim(j.get()))
+          return;
+        execute(j.get());
+      }
+    );
+    return true;
+  }
+
+  // queued or running
+  bool is_busy()
+  {
+    int s = job->state;
+    return s == state_queued || s == state_running;
+  }
+
+  // for long running work to poll and bail out early
+  bool is_cancelled()
+  {
+    return job->cancelled;
+  }
+
+  // True once per finished job; the results written by the job are visible
+  // to the caller from here on and a new job can be submitted.
+  bool collect()
+  {
+    int expected = state_done;
+    return job->state.compare_exchange_strong(expected, state_idle);
+  }
+
+  // Blocks until the job is done. A job still in the queue is run on the
+  // calling thread rather than waited for, the caller may itself be one of
+  // the pool threads.
+  void wait()
+  {
+    if (claim(job.get()))
+    {
+      execute(job.get());
+      return;
+    }
+    wait_running();
+  }
+
+  // Drops a queued job, waits for a running one. Results are discarded.
+  void cancel()
+  {
+    job->cancelled = true;
+    if (!claim(job.get()))
+      wait_running();
+    job->state = state_idle;
+    job->work = nullptr;
+  }
+};
+
+
+// Results are written to back() by the job and handed over with swap()
+// after a successful collect(), front() is what the module outputs.
+template<typename T>
+class vsx_module_job_double_buffer
+{
+  T buffers[2];
+  size_t current = 0;
+
+public:
+
+  vsx_module_job_double_buffer()
+    :
+    buffers()
+  {}
+
+  T& front()
+  {
+    return buffers[current];
+  }
+
+  T& back()
+  {
+    return buffers[current ^ 1];
+  }
+
+  void swap()
+  {
+    current ^= 1;
+  }
+};
@@ -87,6 +87,22 @@ public:
 
   bool tunnel = false; // very special case for render component that have to be reset after each run.
 
+  /* [thread_safe]
+    If the engine is set to run in parallel (render_hint_parallel_execution) this module's run() may be called on a
+    worker thread, at the same time as other modules' run(). Only set this if run() and output() don't touch OpenGL,
+    the engine's filesystem or any other shared state - pure math on the in-parameters writing to the out-parameters.
+    Mesh generators, particle modifiers and the like are good candidates.
+  */
+  bool thread_safe = false;
+
+  /* [init_thread_safe]
+    declare_params() and init() may be called on a worker thread while a state is loading, at the same time as
+    other modules' declare_params() and init(). thread_safe doesn't imply this. Only set this if neither touches
+    OpenGL, the engine's filesystem or any other shared state - declaring parameters and allocating memory the
+    module owns.
+  */
+  bool init_thread_safe = false;
+
 
   /*
   Param specifications - used for the GUI (artiste)
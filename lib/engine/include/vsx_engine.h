@@ -31,9 +31,11 @@
 #include <filesystem/vsx_filesystem.h>
 #include <command/vsx_command.h>
 #include <command/vsx_command_list.h>
+#include <command/vsx_command_state_binary.h>
 #include "vsx_param.h"
 #include <module/vsx_module.h>
 #include <time/vsx_timer.h>
+#include <mutex>
 
 #include <internal/vsx_comp_abs.h>
 #include <internal/vsx_comp_channel.h>
@@ -42,6 +44,8 @@
 #include <internal/vsx_param_sequence.h>
 #include <internal/vsx_param_sequence_list.h>
 #include <internal/vsx_sequence_pool.h>
+#include <internal/vsx_engine_scheduler.h>
+#include <internal/vsx_engine_plan.h>
 #include "vsx_module_list_abs.h"
 #include "vsx_module_list_factory.h"
 #include <internal/vsx_note.h>
@@ -54,6 +58,63 @@ class vsxl_engine;
 #include "vsx_engine_abs.h"
 
 
+// run() and output() time of one component's module, in seconds
+class vsx_engine_component_timing
+{
+public:
+  vsx_string<> name;
+  vsx_string<> identifier;
+  double time_run = 0.0;
+  double time_output = 0.0;
+};
+
+class vsx_engine;
+class vsx_engine_param_batch;
+
+#define VSX_ENGINE_COMMAND_HISTOGRAM_SIZE 16
+
+// handler of one command id, with the statistics of the commands it handled
+class vsx_engine_command_handler
+{
+public:
+  vsx_string<> name;
+  void (vsx_engine::*function)(vsx_command_s* c, vsx_command_list* cmd_out) = 0x0;
+
+  uint64_t count = 0;
+  double time_total = 0.0;
+  double time_max = 0.0;
+
+  // commands by time taken: < 1 us, < 2 us, < 4 us... the last is everything
+  // from 16 ms up
+  uint32_t histogram[VSX_ENGINE_COMMAND_HISTOGRAM_SIZE];
+
+  vsx_engine_command_handler()
+  {
+    reset();
+  }
+
+  void add_time(double time)
+  {
+    count++;
+    time_total += time;
+    if (time > time_max)
+      time_max = time;
+
+    size_t bucket = 0;
+    for (double limit = 0.000001; time >= limit && bucket < VSX_ENGINE_COMMAND_HISTOGRAM_SIZE - 1; limit *= 2.0)
+      bucket++;
+    histogram[bucket]++;
+  }
+
+  void reset()
+  {
+    count = 0;
+    time_total = 0.0;
+    time_max = 0.0;
+    memset(histogram, 0, sizeof(histogram));
+  }
+};
+
 //////////////////////////////////////////////////////////////////////
 class ENGINE_DLLIMPORT vsx_engine : public vsx_engine_abs
 {
@@ -112,6 +173,31 @@ public:
   bool get_render_hint_post_render_reset_component_status();
   void set_render_hint_post_render_reset_component_status( bool new_value );
 
+  // run modules flagged as thread_safe in parallel on the thread pool ahead
+  // of the regular render pass. GL-bound modules stay on the render thread.
+  bool get_render_hint_parallel_execution();
+  void set_render_hint_parallel_execution( bool new_value );
+
+  // walk a precompiled, flattened execution plan instead of recursing
+  // from the outputs every frame. Not used while loading.
+  bool get_render_hint_execution_plan();
+  void set_render_hint_execution_plan( bool new_value );
+
+  // called whenever components or connections change so the parallel
+  // schedule and the execution plan are rebuilt before the next frame
+  void invalidate_schedule();
+
+  // changes whenever components or their parameters do, parameter handles
+  // resolve their names again when it has
+  uint64_t get_structure_generation();
+
+  // record frames, module run/output, channel execution, the sequencer and
+  // command batches as vsx_profiler spans. With chrome_trace_export a Chrome
+  // trace JSON is also written next to the profiler data on shutdown.
+  void trace_start(bool chrome_trace_export = true);
+  void trace_stop();
+  bool get_trace_enabled();
+
 
 
 //-- time manipulation and status
@@ -144,9 +230,22 @@ public:
   vsx_module* get_module_by_name(vsx_string<>module_name);
   vsx_string<>get_modules_not_loaded();
 
+  // Queue parameter values (see vsx_engine_param_handle.h) to be applied
+  // together at the start of the next render(). Can be called from any
+  // thread; batch is emptied.
+  void param_batch_submit(vsx_engine_param_batch& batch);
+
+  // what a param_set command does once the value is in: tells the module,
+  // and redeclares its in-parameters if it asks for that
+  void param_set_notify(vsx_comp* component, vsx_engine_param* param);
+
   // get a list of all external-exposed parameters (parameters that we want to export from a sub-engine)
   void get_external_exposed_parameters( vsx_nw_vector< vsx_module_param_abs* >* result );
 
+  // module timing of every component for the last frame. Empty unless the
+  // engine is built with VSXU_MODULE_TIMING.
+  void get_component_timing( std::vector<vsx_engine_component_timing>& result );
+
 
 //-- engine function / lifecycle presented in the order they should happen
   // constructors
@@ -163,6 +262,18 @@ public:
   // for instance 3 state files into one .vsx file with vsxz, and want to load them into 3 different engines
   int load_state_filesystem(vsx_string<>filename, vsx_string<>*error_string, vsx::filesystem* filesystem);
 
+  // Load a state in two steps, so most of the work is off the render thread:
+  // preload_state can run on any thread while the (started) engine isn't
+  // rendered. It reads and compiles the state, constructs its components and
+  // initializes the modules flagged init_thread_safe. load_preloaded_state, on the
+  // render thread, initializes the rest and replaces the current state; GL
+  // resources are then created over the following frames as usual.
+  // Call module_list->load_plugins() on the render thread first, preload_state
+  // creates modules and would otherwise load their plugins on its thread.
+  // filesystem is optional, as for load_state_filesystem.
+  int preload_state(vsx_string<>filename, vsx_string<>*error_string = 0, vsx::filesystem* filesystem = 0x0);
+  int load_preloaded_state();
+
   // process messages - this should be run once per physical frame
   void process_message_queue(vsx_command_list *cmd_in, vsx_command_list *cmd_out_res, bool exclusive = false, bool ignore_timing = false, float max_time = 0.01f);
 
@@ -184,6 +295,123 @@ public:
 
   // destructor
   virtual ~vsx_engine();
+
+private:
+
+  std::mutex param_batch_lock;
+  vsx_engine_param_batch* param_batch_pending = 0x0;
+  vsx_engine_param_batch* param_batch_applying = 0x0;
+  void param_batch_apply();
+
+  // the "_st" (sound time) out parameters of the outputs, see render()
+  std::vector<vsx_module_param_float*> output_sync_params;
+  uint64_t output_sync_generation = 0;
+
+  // Commands are dispatched by their id (vsx_command_s::cmd_id) through this
+  // table, filled in by the constructor. Handlers are in vsx_engine_messages/.
+  std::vector<vsx_engine_command_handler> command_handlers;
+  void command_register(const char* name, void (vsx_engine::*function)(vsx_command_s* c, vsx_command_list* cmd_out));
+  void command_register_all();
+  vsx_engine_command_handler* command_get_handler(vsx_command_s* c);
+
+  #define VSX_ENGINE_COMMAND(name) void command_##name(vsx_command_s* c, vsx_command_list* cmd_out)
+
+  VSX_ENGINE_COMMAND(help);
+
+  // vsx_saveload.h
+  VSX_ENGINE_COMMAND(state_load);
+  VSX_ENGINE_COMMAND(state_load_done);
+  VSX_ENGINE_COMMAND(clear);
+  VSX_ENGINE_COMMAND(meta_set);
+  VSX_ENGINE_COMMAND(meta_get);
+  VSX_ENGINE_COMMAND(set_silent);
+  VSX_ENGINE_COMMAND(package_export);
+  VSX_ENGINE_COMMAND(state_save);
+
+  // vsx_em_comp.h
+  VSX_ENGINE_COMMAND(component_create);
+  VSX_ENGINE_COMMAND(component_delete);
+  VSX_ENGINE_COMMAND(component_assign);
+  VSX_ENGINE_COMMAND(component_rename);
+  VSX_ENGINE_COMMAND(component_pos);
+  VSX_ENGINE_COMMAND(component_size);
+  VSX_ENGINE_COMMAND(get_module_status);
+  VSX_ENGINE_COMMAND(component_timing);
+
+  // vsx_connections.h
+  VSX_ENGINE_COMMAND(param_connect);
+  VSX_ENGINE_COMMAND(param_disconnect);
+  VSX_ENGINE_COMMAND(param_alias);
+  VSX_ENGINE_COMMAND(param_unalias);
+  VSX_ENGINE_COMMAND(connections_order);
+
+  // vsx_parameters.h
+  VSX_ENGINE_COMMAND(help_param_set);
+  VSX_ENGINE_COMMAND(param_set);
+  VSX_ENGINE_COMMAND(pa_ren);
+  VSX_ENGINE_COMMAND(param_get);
+  VSX_ENGINE_COMMAND(pg64);
+  VSX_ENGINE_COMMAND(ps64);
+  VSX_ENGINE_COMMAND(ps);
+  VSX_ENGINE_COMMAND(help_param_clone_value);
+  VSX_ENGINE_COMMAND(param_clone_value);
+  VSX_ENGINE_COMMAND(param_set_interpolate);
+  VSX_ENGINE_COMMAND(param_set_default);
+  VSX_ENGINE_COMMAND(pflag);
+
+  // vsx_em_sequencer.h
+  VSX_ENGINE_COMMAND(seq_list);
+  VSX_ENGINE_COMMAND(pseq_l_dump);
+  VSX_ENGINE_COMMAND(pseq_l_rescale_time);
+  VSX_ENGINE_COMMAND(pseq_inject_get_keyframe_at_time);
+  VSX_ENGINE_COMMAND(pseq_p);
+  VSX_ENGINE_COMMAND(pseq_r);
+  VSX_ENGINE_COMMAND(mseq_channel);
+
+  // vsx_em_macro.h
+  VSX_ENGINE_COMMAND(macro_dump);
+  VSX_ENGINE_COMMAND(macro_prerun);
+  VSX_ENGINE_COMMAND(macro_create);
+
+  // vsx_em_seq_pool.h
+  VSX_ENGINE_COMMAND(seq_pool);
+
+  // vsx_engine_time.h
+  VSX_ENGINE_COMMAND(time_set_loop_point);
+  VSX_ENGINE_COMMAND(time_set_speed);
+  VSX_ENGINE_COMMAND(play);
+  VSX_ENGINE_COMMAND(stop);
+  VSX_ENGINE_COMMAND(rewind);
+  VSX_ENGINE_COMMAND(fps);
+  VSX_ENGINE_COMMAND(time_set);
+
+  // vsx_em_script.h
+  VSX_ENGINE_COMMAND(vsxl_cfl);
+  VSX_ENGINE_COMMAND(vsxl_cfi);
+  VSX_ENGINE_COMMAND(vsxl_cfr);
+  VSX_ENGINE_COMMAND(vsxl_pfl);
+  VSX_ENGINE_COMMAND(vsxl_pfi);
+  VSX_ENGINE_COMMAND(vsxl_pfr);
+
+  // vsx_note.h
+  VSX_ENGINE_COMMAND(note_create);
+  VSX_ENGINE_COMMAND(note_update);
+  VSX_ENGINE_COMMAND(note_delete);
+
+  // vsx_em_system.h
+  VSX_ENGINE_COMMAND(get_module_list);
+  VSX_ENGINE_COMMAND(get_list);
+  VSX_ENGINE_COMMAND(get_state);
+  VSX_ENGINE_COMMAND(undo_s);
+  VSX_ENGINE_COMMAND(undo);
+  VSX_ENGINE_COMMAND(engine_trace);
+  VSX_ENGINE_COMMAND(command_stats);
+  VSX_ENGINE_COMMAND(system_shutdown);
+
+  // vsx_em_module_operation.h
+  VSX_ENGINE_COMMAND(module_operation_perform);
+
+  #undef VSX_ENGINE_COMMAND
 };
 
 
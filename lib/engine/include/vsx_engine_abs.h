@@ -24,6 +24,22 @@
 #ifndef VSX_ENGINE_ABS_H
 #define VSX_ENGINE_ABS_H
 
+// A compiled state with its components constructed but not yet added to the
+// engine, see i_prepare_state / i_load_state_prepared.
+class vsx_engine_prepared_state
+{
+public:
+  vsx_command_state_binary_reader state;
+
+  // per record, the component constructed for a component_create
+  std::vector<vsx_comp*> components;
+
+  // components init_module hasn't been called for yet
+  std::vector<vsx_comp*> init_pending;
+
+  vsx_string<> info_filename = "[undefined]";
+};
+
 
 class vsx_engine_abs
 {
@@ -89,6 +105,9 @@ protected:
   int modules_left_to_load;
   int modules_loaded;
 
+  // state made by vsx_engine::preload_state, waiting for load_preloaded_state
+  vsx_engine_prepared_state* state_preloaded;
+
 //-- engine rendering / behaviour hints
 
 
@@ -101,6 +120,22 @@ protected:
   // Reset Component Status   -  default: true
   bool render_hint_post_render_reset_component_status;
 
+  // Parallel Execution  -  default: false
+  bool render_hint_parallel_execution;
+
+  // Execution Plan  -  default: true
+  bool render_hint_execution_plan;
+
+//-- parallel scheduler for thread safe modules
+  vsx_engine_scheduler scheduler;
+
+//-- flattened execution order of the component graph
+  vsx_engine_plan plan;
+
+//-- incremented whenever components or their parameters change, so names
+// resolved to parameters (see vsx_engine_param_handle.h) are looked up again
+  uint64_t structure_generation;
+
 
 //-- module list
   vsx_module_list_abs* module_list;
@@ -167,6 +202,22 @@ protected:
 
   int i_load_state(vsx_command_list& load1, vsx_string<>*error_string, vsx_string<>info_filename = "[undefined]");
 
+  // same as i_load_state for a compiled state (see vsxz -cs), the components
+  // are constructed up front and the init_thread_safe ones initialized in parallel
+  int i_load_state_compiled(vsx_engine_prepared_state& prepared, vsx_string<>*error_string);
+
+  // i_load_state_compiled in two steps:
+  //  i_prepare_state checks the modules and constructs the components; it
+  //  doesn't touch the engine's components, so it can run on any thread while
+  //  the engine is not rendering. Modules not flagged init_thread_safe are only
+  //  initialized when called on the render thread.
+  //  i_load_state_prepared, on the render thread, replaces the current state.
+  int i_prepare_state(vsx_engine_prepared_state& prepared, vsx_string<>*error_string, bool render_thread);
+  int i_load_state_prepared(vsx_engine_prepared_state& prepared);
+
+  // unloads components of a prepared state that wasn't loaded
+  void i_discard_prepared_state(vsx_engine_prepared_state& prepared);
+
   /**
    * @brief i_clear
    * @param cmd_out
@@ -184,6 +235,9 @@ protected:
   void message_fail(vsx_string<>header, vsx_string<>message);
   // add component to the forge
   vsx_comp* add(vsx_string<>label);
+
+  // add an already constructed component, 0x0 if the name is taken
+  vsx_comp* add(vsx_comp* comp);
 public:
 
   vsx_engine_abs()
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <type_traits>
+#include <vector>
+#include "vsx_engine.h"
+
+/*
+  Typed handles to module parameters, for embedders feeding values into
+  (or reading them out of) an engine every frame.
+
+  A handle holds the component and parameter names and is resolved to the
+  parameter once; after that get() and set() do no string work. The engine
+  increments its structure generation whenever components or parameters
+  change (a state is loaded or cleared, a component is created, deleted or
+  renamed, a module redeclares its parameters), the handle then resolves
+  again on next use. Handles to aliases write to the aliased parameter.
+
+  get() / set() act immediately and belong on the thread rendering the
+  engine. To feed values from another thread, collect them in a
+  vsx_engine_param_batch and submit it; the engine applies all of a batch
+  at the start of the next render(), never in the middle of a frame.
+
+    vsx_engine_param_handle<vsx_module_param_float> speed(engine, "oscillator", "freq");
+    vsx_engine_param_batch batch;
+    batch.set(speed, 2.0f);
+    engine->param_batch_submit(batch);
+*/
+
+// parameter type id for a module parameter class
+template<class T> struct vsx_engine_param_type;
+
+#define VSX_ENGINE_PARAM_TYPE(param_class, param_type_id) \
+  template<> struct vsx_engine_param_type<param_class> { static const int id = param_type_id; };
+
+VSX_ENGINE_PARAM_TYPE(vsx_module_param_int, VSX_MODULE_PARAM_ID_INT)
+VSX_ENGINE_PARAM_TYPE(vsx_module_param_float, VSX_MODULE_PARAM_ID_FLOAT)
+VSX_ENGINE_PARAM_TYPE(vsx_module_param_float3, VSX_MODULE_PARAM_ID_FLOAT3)
+VSX_ENGINE_PARAM_TYPE(vsx_module_param_float4, VSX_MODULE_PARAM_ID_FLOAT4)
+VSX_ENGINE_PARAM_TYPE(vsx_module_param_double, VSX_MODULE_PARAM_ID_DOUBLE)
+VSX_ENGINE_PARAM_TYPE(vsx_module_param_quaternion, VSX_MODULE_PARAM_ID_QUATERNION)
+VSX_ENGINE_PARAM_TYPE(vsx_module_param_string, VSX_MODULE_PARAM_ID_STRING)
+VSX_ENGINE_PARAM_TYPE(vsx_module_param_resource, VSX_MODULE_PARAM_ID_RESOURCE)
+VSX_ENGINE_PARAM_TYPE(vsx_module_param_texture, VSX_MODULE_PARAM_ID_TEXTURE)
+
+#undef VSX_ENGINE_PARAM_TYPE
+
+
+class vsx_engine_param_handle_base
+{
+protected:
+  vsx_engine* engine = 0x0;
+  vsx_string<> component_name;
+  vsx_string<> param_name;
+  bool out = false;
+  int type;
+
+  // engine structure generation the parameter was resolved in, 0 = never
+  uint64_t generation = 0;
+  vsx_engine_param* param = 0x0;
+
+  void resolve()
+  {
+    generation = engine->get_structure_generation();
+    param = 0x0;
+
+    vsx_comp* component = engine->get_component_by_name(component_name);
+    req(component);
+
+    vsx_engine_param* p = out ?
+      component->get_params_out()->get_by_name(param_name)
+      :
+      component->get_params_in()->get_by_name(param_name);
+    req(p);
+
+    while (p->alias && p->alias_owner)
+      p = p->alias_owner;
+
+    req(p->module_param->type == type);
+    param = p;
+  }
+
+  explicit vsx_engine_param_handle_base(int param_type)
+    :
+    type(param_type)
+  {}
+
+public:
+
+  void bind(vsx_engine* new_engine, const vsx_string<>& component, const vsx_string<>& name, bool out_param = false)
+  {
+    engine = new_engine;
+    component_name = component;
+    param_name = name;
+    out = out_param;
+    generation = 0;
+    param = 0x0;
+  }
+
+  // resolves the parameter again if the engine has changed since last time,
+  // false if it doesn't exist (or isn't of the handle's type)
+  bool validate()
+  {
+    reqrv(engine, false);
+    if (generation != engine->get_structure_generation())
+      resolve();
+    return param != 0x0;
+  }
+
+  // used by vsx_engine_param_batch
+  virtual void set_value(double value, int index) = 0;
+
+  virtual ~vsx_engine_param_handle_base()
+  {}
+};
+
+
+template<class T>
+class vsx_engine_param_handle : public vsx_engine_param_handle_base
+{
+  void set_value(double value, int index, std::true_type)
+  {
+    set( (value_type)value, index );
+  }
+
+  void set_value(double value, int index, std::false_type)
+  {
+    VSX_UNUSED(value);
+    VSX_UNUSED(index);
+  }
+
+public:
+  typedef typename T::value_type value_type;
+
+  vsx_engine_param_handle()
+    :
+    vsx_engine_param_handle_base(vsx_engine_param_type<T>::id)
+  {}
+
+  vsx_engine_param_handle(vsx_engine* engine, const vsx_string<>& component, const vsx_string<>& name, bool out_param = false)
+    :
+    vsx_engine_param_handle_base(vsx_engine_param_type<T>::id)
+  {
+    bind(engine, component, name, out_param);
+  }
+
+  T* get_module_param()
+  {
+    reqrv(validate(), 0x0);
+    return (T*)param->module_param;
+  }
+
+  value_type get(int index = 0)
+  {
+    T* p = get_module_param();
+    reqrv(p, value_type());
+    reqrv(p->param_data, value_type());
+    return p->get(index);
+  }
+
+  // as a param_set command does, without the parsing; the module may
+  // redeclare its parameters, the handle then resolves again on next use
+  void set(value_type value, int index = 0)
+  {
+    req(index < T::value_arity);
+    T* p = get_module_param();
+    req(p);
+    ++param->module->param_updates;
+    ++p->updates;
+    p->set_internal(value, index);
+    engine->param_set_notify((vsx_comp*)param->owner->component, param);
+  }
+
+  void set_value(double value, int index)
+  {
+    set_value(value, index, std::is_arithmetic<value_type>());
+  }
+};
+
+
+// parameter values to be applied together, see vsx_engine::param_batch_submit
+class vsx_engine_param_batch
+{
+  struct entry
+  {
+    vsx_engine_param_handle_base* handle;
+    int index;
+    double value;
+  };
+
+  std::vector<entry> entries;
+
+public:
+
+  // the handle must outlive the batch being applied
+  template<class T>
+  void set(vsx_engine_param_handle<T>& handle, typename T::value_type value, int index = 0)
+  {
+    static_assert(std::is_arithmetic<typename T::value_type>::value, "only numeric parameters can be batched");
+    entry e;
+    e.handle = &handle;
+    e.index = index;
+    e.value = (double)value;
+    entries.push_back(e);
+  }
+
+  size_t size()
+  {
+    return entries.size();
+  }
+
+  void clear()
+  {
+    entries.clear();
+  }
+
+  void append(vsx_engine_param_batch& other)
+  {
+    entries.insert(entries.end(), other.entries.begin(), other.entries.end());
+  }
+
+  void swap(vsx_engine_param_batch& other)
+  {
+    entries.swap(other.entries);
+  }
+
+  void apply()
+  {
+    foreach (entries, i)
+      entries[i].handle->set_value(entries[i].value, entries[i].index);
+  }
+};
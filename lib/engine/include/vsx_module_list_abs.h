@@ -73,6 +73,22 @@ public:
   // Check presence of module
   virtual bool find( const vsx_string<>&module_name_to_look_for) = 0;
 
+  // Load Plugins
+  //   Plugins are otherwise loaded when their first module is created.
+  //   Loading one runs its setup (glewInit per DLL on windows), so call this
+  //   on the render thread before modules are created on another thread.
+  virtual void load_plugins()
+  {}
+
+  // Specification of a module, 0x0 if it isn't known
+  vsx_module_specification* get_module_info(const vsx_string<>& module_name)
+  {
+    std::map< vsx_string<>, vsx_module_specification* >::iterator it = module_list.find(module_name);
+    if (it == module_list.end())
+      return 0x0;
+    return it->second;
+  }
+
   // Print help text for all loaded modules
   virtual void print_help() = 0;
 
@@ -119,6 +119,9 @@ template<int id, typename T, int arity = 1, int clear_ram = 0>
 
 class vsx_module_param : public vsx_module_param_abs {
 public:
+  typedef T value_type;
+  static const int value_arity = arity;
+
   // the data on module level
   T* param_data;
   // the value the GUI/other components assign this 
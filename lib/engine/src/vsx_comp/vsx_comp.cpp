@@ -34,6 +34,7 @@
 #include <internal/vsx_master_sequence_channel.h>
 #include <internal/vsx_param_sequence_list.h>
 #include <internal/vsx_sequence_pool.h>
+#include <internal/vsx_engine_trace.h>
 #include <filesystem/vsx_filesystem.h>
 #include <internal/vsx_param_abstraction.h>
 #include "tools/vsx_foreach.h"
@@ -65,6 +66,14 @@ vsx_comp::vsx_comp() {
   in_module_parameters = new vsx_module_param_list;
   out_module_parameters = new vsx_module_param_list;
   has_run = false;
+  critical_unconnected = false;
+  critical_unconnected_dirty = true;
+  #ifdef VSXU_MODULE_TIMING
+    time_run = 0.0;
+    time_output = 0.0;
+    new_time_run = 0.0;
+    new_time_output = 0.0;
+  #endif
 }
 
 vsx_comp::~vsx_comp()
@@ -83,18 +92,23 @@ vsx_comp::~vsx_comp()
 }
 
 void vsx_comp::load_module(const vsx_string<>& module_name, vsx_module_engine_state* engine_info)
+{
+  if (create_module(module_name, engine_info))
+    init_module();
+}
+
+bool vsx_comp::create_module(const vsx_string<>& module_name, vsx_module_engine_state* engine_info)
 {
   vsx_module_list_abs* module_list = ((vsx_engine*)engine_owner)->get_module_list();
   module = module_list->load_module_by_name( module_name );
   r_engine_info = engine_info;
 
-  if (module)
-  {
-    init_module();
-  } else
+  if (!module)
   {
     printf("vsx_comp::load_module failed\n");
+    return false;
   }
+  return true;
 }
 
 void vsx_comp::unload_module()
@@ -155,6 +169,7 @@ void vsx_comp::re_init_in_params() {
     delete *it;
   }
   channels.clear();
+  ((vsx_engine*)engine_owner)->invalidate_schedule();
   in_module_parameters = new vsx_module_param_list;
   module->redeclare_in_params(*in_module_parameters);
   module->module_info(module_info);
@@ -191,6 +206,7 @@ void vsx_comp::re_init_out_params() {
   // delete all channels
   delete out_parameters;
   delete out_module_parameters;
+  ((vsx_engine*)engine_owner)->invalidate_schedule();
 
   out_module_parameters = new vsx_module_param_list;
   module->redeclare_out_params(*out_module_parameters);
@@ -203,6 +219,7 @@ void vsx_comp::re_init_out_params() {
 }
 
 void vsx_comp::init_channels() {
+  critical_unconnected_dirty = true;
   // we need to set up channels
   for (std::vector<vsx_engine_param*>::iterator it = in_parameters->param_id_list.begin(); it != in_parameters->param_id_list.end(); ++it) {
     vsx_engine_param* param = *it;
@@ -312,36 +329,31 @@ void vsx_comp::init_module()
 }
 
 
-bool vsx_comp::prepare()
+bool vsx_comp::prepare_begin()
 {
-  if (parent)
-  {
-    LOG("comp prepare name: "+name+" of "+((vsx_comp_abs*)parent)->name)
-  }
-  else
-  {
-    LOG("comp prepare name: "+name)
-  }
-  if (frame_status == frame_failed)
-  {
-    return false;
-  }
   if (frame_status != initial_status)
   {
-    return true;
+    return false;
   }
   frame_status = prepare_called;
-  // it needs to prepare all parameters for the run function
-  // this means it has to execute all channels to get texture id's etc
-  unsigned long i = 0;
-  for (std::vector <vsx_channel*>::iterator it = channels.begin(); it != channels.end(); ++it)
+
+  // a critical channel that isn't connected means we can't run, it only
+  // changes with the connections so it's cached until then
+  if (critical_unconnected_dirty)
   {
-    if ((*it)->my_param->critical && !(*it)->connections.size()) {
-      // this channel is critical but not connected! can't run!
-      i = 1; break;
+    critical_unconnected = false;
+    for (std::vector <vsx_channel*>::iterator it = channels.begin(); it != channels.end(); ++it)
+    {
+      if ((*it)->my_param->critical && !(*it)->connections.size()) {
+        // this channel is critical but not connected! can't run!
+        critical_unconnected = true; break;
+      }
     }
+    critical_unconnected_dirty = false;
   }
-  if (i)
+
+  unsigned long i;
+  if (critical_unconnected)
   {
     for (i = 0; i < out_module_parameters->id_vec.size(); ++i)
     {
@@ -358,17 +370,70 @@ bool vsx_comp::prepare()
       all_valid = true;
     }
   }
+  return true;
+}
+
+void vsx_comp::prepare_channel_done(vsx_channel* channel)
+{
+  // run vsxl after other component has set our value
+  #ifndef VSXE_NO_GM
+    if (channel->my_param->module_param->vsxl_modifier)
+    {
+      void* a = channel->my_param->module_param->vsxl_modifier;
+      ((vsx_param_vsxl_abs*)a)  -> execute();
+    }
+  #else
+    VSX_UNUSED(channel);
+  #endif
+}
+
+void vsx_comp::prepare_end()
+{
+  if (module_info->output)
+  {
+    LOG("module->run");
+    #ifdef VSXU_MODULE_TIMING
+      run_timer.start();
+    #endif
+      // don't run run() if engine is in output mode
+      if ( false == ((vsx_engine*)engine_owner)->get_render_hint_module_output_only() )
+      {
+        vsx_engine_trace_span span(name);
+        module->run();
+      }
+    #ifdef VSXU_MODULE_TIMING
+      new_time_run += run_timer.dtime();
+    #endif
+  }
+  frame_status = prepare_finished;
+}
+
+bool vsx_comp::prepare()
+{
+  if (parent)
+  {
+    LOG("comp prepare name: "+name+" of "+((vsx_comp_abs*)parent)->name)
+  }
+  else
+  {
+    LOG("comp prepare name: "+name)
+  }
+  if (frame_status == frame_failed)
+  {
+    return false;
+  }
+  // it needs to prepare all parameters for the run function
+  // this means it has to execute all channels to get texture id's etc
+  if (!prepare_begin())
+  {
+    return true;
+  }
 
   for (std::vector <vsx_channel*>::iterator it = channels.begin(); it != channels.end(); ++it)
   {
     // check time to speed up loading bar
     if (r_engine_info->state == VSX_ENGINE_LOADING)
     {
-      //LOG("engine is loading, time to test")
-      //double atime = ((vsx_engine*)engine_owner)->g_timer.atime();
-      //LOG("atime: "+vsx_string_helper::f2s(atime));
-      //LOG("fstarttime: "+vsx_string_helper::f2s(((vsx_engine*)engine_owner)->frame_start_time));
-      //printf("frame_start_time: %f\n",vsx_string_helper::f2s(((vsx_engine*)engine_owner)->frame_start_time));
       if
       (
         ((vsx_engine*)engine_owner)->get_frame_elapsed_time() > 0.4
@@ -378,48 +443,15 @@ bool vsx_comp::prepare()
         return false;
       }
     }
-    //---
-    //if i is 0 (on the first run) prepare the module
     if (!(*it)->execute())
     {
       frame_status = frame_failed;
       //printf("failed channel execute : %s\n",name.c_str());
       return false;
     }
-    #ifdef VSXU_MODULE_TIMING
-      new_time_run += (*it)->channel_execution_time;
-    #endif
-    // run vsxl after other component has set our value
-    #ifndef VSXE_NO_GM
-      if ((*it)->my_param->module_param->vsxl_modifier)
-      {
-        void* a = (*it)->my_param->module_param->vsxl_modifier;
-        ((vsx_param_vsxl_abs*)a)  -> execute();
-      }
-    #endif
-    ++i;
+    prepare_channel_done(*it);
   }
-  if (module_info->output)
-  {
-    LOG("module->run");
-    #ifdef VSXU_MODULE_TIMING
-      run_timer.start();
-    #endif
-      // don't run run() if engine is in output mode
-      if ( false == ((vsx_engine*)engine_owner)->get_render_hint_module_output_only() )
-      {
-        module->run();
-      }
-    #ifdef VSXU_MODULE_TIMING
-      new_time_run += run_timer.dtime();
-    #endif
-  }
-  // special case for output components (screen etc.)
-  if (module_info->output)
-  {
-    frame_status = run_finished;
-  }
-  frame_status = prepare_finished;
+  prepare_end();
   return true;
 }
 
@@ -438,46 +470,64 @@ bool vsx_comp::run(vsx_module_param_abs* param)
 
   if(frame_status == frame_failed) return false;
 
-  if(frame_status == prepare_finished) {
-    //printf("c:%s:module_pre_run\n",name.c_str());
-    #ifndef VSXE_NO_GM
-      if (vsxl_modifier) {
-        ((vsx_comp_vsxl*)vsxl_modifier)->execute();
-      }
-    #endif
-    #ifdef VSXU_MODULE_TIMING
-      run_timer.start();
-    #endif
-    if (
-      false == ((vsx_engine*)engine_owner)->get_render_hint_module_output_only()
-      ||
-      false == has_run
-    )
-    {
-      module->run();
-      has_run = true;
-    }
-    #ifdef VSXU_MODULE_TIMING
-      new_time_run += run_timer.dtime();
-    #endif
-    //printf("%s new_time_run = %f\n",name.c_str(),new_time_run);
-    //printf("c:%s:module_post_run\n",name.c_str());
+  if(frame_status == prepare_finished)
+    run_module();
 
-    if (module_info->tunnel)
-    frame_status = initial_status; else
-    frame_status = run_finished;
-  }
   //printf("c:%s:module_pre_output\n",name.c_str());
   #ifdef VSXU_MODULE_TIMING
     run_timer.start();
   #endif
+  {
+    vsx_engine_trace_span span(name, "output");
     module->output(param);
+  }
   #ifdef VSXU_MODULE_TIMING
     new_time_output += run_timer.dtime();
   #endif
   return true;
 }
 
+void vsx_comp::run_module()
+{
+  #ifndef VSXE_NO_GM
+    if (vsxl_modifier) {
+      ((vsx_comp_vsxl*)vsxl_modifier)->execute();
+    }
+  #endif
+  #ifdef VSXU_MODULE_TIMING
+    run_timer.start();
+  #endif
+  if (
+    false == ((vsx_engine*)engine_owner)->get_render_hint_module_output_only()
+    ||
+    false == has_run
+  )
+  {
+    vsx_engine_trace_span span(name);
+    module->run();
+    has_run = true;
+  }
+  #ifdef VSXU_MODULE_TIMING
+    new_time_run += run_timer.dtime();
+  #endif
+
+  if (module_info->tunnel)
+    frame_status = initial_status;
+  else
+    frame_status = run_finished;
+}
+
+bool vsx_comp::prepare_and_run()
+{
+  if (!prepare())
+    return false;
+
+  if (frame_status == prepare_finished)
+    run_module();
+
+  return true;
+}
+
 bool vsx_comp::stop() {
   //printf("stopping %s\n",name.c_str());
   if (module)
@@ -31,11 +31,26 @@
 #include <internal/vsx_comp_abs.h>
 #include <internal/vsx_param_abstraction.h>
 #include <internal/vsx_comp.h>
+#include "vsx_engine.h"
+#include <internal/vsx_engine_trace.h>
 
 #include <stdio.h>
 
 using namespace	std;
 
+// connection lists feed the engine's parallel schedule, any change to them
+// needs to be seen before the next frame
+inline void channel_invalidate_schedule(vsx_comp* component)
+{
+  if (!component)
+    return;
+
+  component->invalidate_critical_unconnected();
+
+  if (component->engine_owner)
+    ((vsx_engine*)component->engine_owner)->invalidate_schedule();
+}
+
 vsx_channel::vsx_channel(vsx_module* module,vsx_engine_param* param, int mcon, vsx_comp* pare)
 {
 	my_module = module;
@@ -76,6 +91,7 @@ vsx_channel_connection_info* vsx_channel::connect(vsx_engine_param* src)
     // set both ends module params as connected
     src->module_param->connected = true;
     my_param->module_param->connected = true;
+    channel_invalidate_schedule(component);
     return ci;
   } else return 0; 
   return 0;
@@ -96,6 +112,7 @@ bool vsx_channel::disconnect(vsx_engine_param* src)
       delete *it;
       *it = 0;
       connections.erase(it);
+      channel_invalidate_schedule(component);
       return true;
     }
   }  
@@ -127,6 +144,7 @@ bool vsx_channel::disconnect(vsx_comp* comp, vsx_string<>name)
       {
         connections.erase(it);
         delete *it;
+        channel_invalidate_schedule(component);
         return true;
       }
 		}
@@ -144,6 +162,7 @@ void vsx_channel::disconnect()
       //(*it)->comp->out_map_channels[(*it)->param].remove(this);
     //}
   	connections.clear();
+    channel_invalidate_schedule(component);
 	}
 }
 
@@ -160,29 +179,46 @@ bool vsx_channel::connections_order(std::vector<int> *order_list)
     ++n;
   }
   connections = new_connections;
+  channel_invalidate_schedule(component);
   return true;
 }
 
+bool vsx_channel::activate()
+{
+  if (connections.size() == 0)
+    return true;
+
+  if (!my_param->module_param->run_activate_offscreen)
+    return true;
+
+  return my_module->activate_offscreen();
+}
+
+bool vsx_channel::execute()
+{
+  if (!activate())
+    return false;
+  vsx_profiler* trace = vsx_engine_trace::begin(component->name, my_param->name);
+  bool result = execute_sources();
+  vsx_engine_trace::end(trace);
+  return result;
+}
+
 //----------------------------------------------------------------------------------------
 
-bool vsx_channel_render::execute()
+bool vsx_channel_render::execute_sources()
 {
   #ifdef VSXU_MODULE_TIMING
     channel_execution_time = 0.0f;
-    int_timer.start();
   #endif
   if(connections.size() == 0)
   {
     if (my_param->critical) return false; else return true;
   }
-  if ( my_param->module_param->run_activate_offscreen && !my_module->activate_offscreen()) return false;
 
 	vector<vsx_channel_connection_info*>::iterator it;
   // printf("channel:render:this-name: %s\n",component->name.c_str());
 	// call all components' prepare in our connections list
-  #ifdef VSXU_MODULE_TIMING
-    channel_execution_time += (float)int_timer.dtime();
-  #endif
 	for (it = connections.begin(); it < connections.end(); ++it) 
   {
     //printf("channel:render:calling-prepare %s\n",(*it)->comp->name.c_str());
@@ -214,7 +250,7 @@ bool vsx_channel_render::execute()
 	return true;
 }
 
-bool vsx_channel_texture::execute() { 
+bool vsx_channel_texture::execute_sources() {
 	if(connections.size() == 0) {
     return !my_param->critical;// return false; else return true; 
   }
@@ -247,12 +283,11 @@ bool vsx_channel_texture::execute() {
 
 //----------------------------------------------------------------------------------------
 #define NEW_DEFAULT_CHANNEL_EXECUTE(name, type) \
-bool name::execute() { \
+bool name::execute_sources() { \
   \
 	if(connections.size() == 0) { \
     if (my_param->critical) return false; else return true; \
   } \
-  if (my_param->module_param->run_activate_offscreen && !my_module->activate_offscreen()) return false;\
 	vector<vsx_channel_connection_info*>::iterator it; \
 	for (it = connections.begin(); it != connections.end(); ++it) \
   { \
@@ -270,12 +305,11 @@ bool name::execute() { \
 }
 
 #define NEW_DEFAULT_CHANNEL_EXECUTE_INC_PARAM_UPDATES(name, type) \
-bool name::execute() { \
+bool name::execute_sources() { \
   \
 	if(connections.size() == 0) { \
     if (my_param->critical) return false; else return true; \
   } \
-  if (my_param->module_param->run_activate_offscreen && !my_module->activate_offscreen()) return false;\
 	vector<vsx_channel_connection_info*>::iterator it = connections.begin(); \
   if(!(*it)->src_comp->prepare() && my_param->all_required) return false; \
   if(!(*it)->src_comp->run((*it)->module_param) && my_param->all_required) return false; \
@@ -287,12 +321,11 @@ bool name::execute() { \
 }
 
 #define NEW_DEFAULT_CHANNEL_EXECUTE_INC_PARAM_UPDATES_WITH_VALUE_CHECK(name, type) \
-bool name::execute() { \
+bool name::execute_sources() { \
   \
   if(connections.size() == 0) { \
     if (my_param->critical) return false; else return true; \
   } \
-  if (my_param->module_param->run_activate_offscreen && !my_module->activate_offscreen()) return false;\
   vector<vsx_channel_connection_info*>::iterator it = connections.begin(); \
   if(!(*it)->src_comp->prepare() && my_param->all_required) return false; \
   if(!(*it)->src_comp->run((*it)->module_param) && my_param->all_required) return false; \
@@ -321,13 +354,12 @@ NEW_DEFAULT_CHANNEL_EXECUTE(vsx_channel_string, vsx_module_param_string)
 NEW_DEFAULT_CHANNEL_EXECUTE(vsx_channel_resource, vsx_module_param_resource)
 NEW_DEFAULT_CHANNEL_EXECUTE(vsx_channel_sequence, vsx_module_param_float_sequence)
 
-bool vsx_channel_segment_mesh::execute()
+bool vsx_channel_segment_mesh::execute_sources()
 {
   if(connections.size() == 0)
   {
     if (my_param->critical) return false; else return true; 
   } 
-  if (my_param->module_param->run_activate_offscreen && !my_module->activate_offscreen()) return false;
 	vector<vsx_channel_connection_info*>::iterator it; 
   for (it = connections.begin(); it != connections.end(); ++it)
   { 
@@ -36,7 +36,9 @@
 #include <string/vsx_string.h>
 #include <log/vsx_log.h>
 #include "vsx_engine.h"
+#include "vsx_engine_param_handle.h"
 #include <internal/vsx_master_sequence_channel.h>
+#include <internal/vsx_engine_trace.h>
 
 #include "vsx_module_list_factory.h"
 #include "vsx_data_path.h"
@@ -81,11 +83,18 @@ vsx_engine::vsx_engine(vsx_module_list_abs* initial_module_list)
   engine_info.module_list = (void*) module_list;
   constructor_set_default_values();
   loop_point_end = -1.0f;
+  command_register_all();
 }
 
 
 vsx_engine::~vsx_engine()
 {
+  if (state_preloaded)
+  {
+    i_discard_prepared_state(*state_preloaded);
+    delete state_preloaded;
+  }
+
   stop();
   commands_internal.clear_normal();
   commands_res_internal.clear_normal();
@@ -100,6 +109,9 @@ vsx_engine::~vsx_engine()
     undo_buffer[i]->clear_delete();
     delete undo_buffer[i];
   }
+
+  delete param_batch_pending;
+  delete param_batch_applying;
 }
 
 
@@ -182,6 +194,85 @@ void vsx_engine::set_render_hint_post_render_reset_component_status( bool new_va
   render_hint_post_render_reset_component_status = new_value;
 }
 
+bool vsx_engine::get_render_hint_parallel_execution()
+{
+  return render_hint_parallel_execution;
+}
+
+void vsx_engine::set_render_hint_parallel_execution( bool new_value )
+{
+  render_hint_parallel_execution = new_value;
+  scheduler.invalidate();
+}
+
+bool vsx_engine::get_render_hint_execution_plan()
+{
+  return render_hint_execution_plan;
+}
+
+void vsx_engine::set_render_hint_execution_plan( bool new_value )
+{
+  render_hint_execution_plan = new_value;
+  plan.invalidate();
+}
+
+void vsx_engine::invalidate_schedule()
+{
+  scheduler.invalidate();
+  plan.invalidate();
+  structure_generation++;
+}
+
+uint64_t vsx_engine::get_structure_generation()
+{
+  return structure_generation;
+}
+
+void vsx_engine::param_batch_submit(vsx_engine_param_batch& batch)
+{
+  std::lock_guard<std::mutex> lock(param_batch_lock);
+  if (!param_batch_pending)
+    param_batch_pending = new vsx_engine_param_batch;
+  param_batch_pending->append(batch);
+  batch.clear();
+}
+
+void vsx_engine::param_set_notify(vsx_comp* component, vsx_engine_param* param)
+{
+  param->module->param_set_notify(param->name);
+  if (param->module->redeclare_in)
+    redeclare_in_params(component, &commands_out_cache);
+}
+
+void vsx_engine::param_batch_apply()
+{
+  {
+    std::lock_guard<std::mutex> lock(param_batch_lock);
+    req(param_batch_pending);
+    req(param_batch_pending->size());
+    if (!param_batch_applying)
+      param_batch_applying = new vsx_engine_param_batch;
+    param_batch_applying->swap(*param_batch_pending);
+  }
+  param_batch_applying->apply();
+  param_batch_applying->clear();
+}
+
+void vsx_engine::trace_start(bool chrome_trace_export)
+{
+  vsx_engine_trace::start(chrome_trace_export);
+}
+
+void vsx_engine::trace_stop()
+{
+  vsx_engine_trace::stop();
+}
+
+bool vsx_engine::get_trace_enabled()
+{
+  return vsx_engine_trace::is_enabled();
+}
+
 bool vsx_engine::get_render_hint_module_output_only()
 {
   return render_hint_module_output_only;
@@ -249,6 +340,26 @@ void vsx_engine::get_external_exposed_parameters( vsx_nw_vector< vsx_module_para
   }
 }
 
+void vsx_engine::get_component_timing( std::vector<vsx_engine_component_timing>& result )
+{
+  result.clear();
+  #ifdef VSXU_MODULE_TIMING
+    for (forge_map_iter = forge_map.begin(); forge_map_iter != forge_map.end(); ++forge_map_iter)
+    {
+      vsx_comp* comp = (*forge_map_iter).second;
+      if (!comp->module)
+        continue;
+
+      vsx_engine_component_timing timing;
+      timing.name = comp->name;
+      timing.identifier = comp->identifier;
+      timing.time_run = comp->time_run;
+      timing.time_output = comp->time_output;
+      result.push_back(timing);
+    }
+  #endif
+}
+
 unsigned long vsx_engine::get_num_modules()
 {
   return (unsigned long)forge.size();
@@ -296,37 +407,93 @@ void vsx_engine::set_input_event_queue(vsx_input_event_queue* queue)
   engine_info.event_queue = queue;
 }
 
-int vsx_engine::load_state(vsx_string<>filename, vsx_string<>* error_string)
+// a compiled state is stored next to the text state in archives, see vsxz -cs
+static bool load_state_compiled(vsx::filesystem* fs, const vsx_string<>& filename, vsx_command_state_binary_reader& state)
 {
-  if (!valid)
-    return 2;
+  vsx::filesystem_archive_reader* archive = fs->get_archive();
+  reqrv(archive, false);
+  reqrv(archive->is_archive(), false);
+
+  vsx_string<> compiled_filename = filename + ".vsxb";
+  reqrv(fs->is_file(compiled_filename), false);
 
+  vsx::file* fp = fs->f_open(compiled_filename.c_str());
+  reqrv(fp, false);
+  bool result = state.load(fs->f_data_get(fp), fs->f_get_size(fp));
+  fs->f_close(fp);
+
+  if (!result)
+    vsx_printf(L"vsx_engine: invalid compiled state %hs, loading the text state\n", compiled_filename.c_str());
+  return result;
+}
+
+// compiles a text state in memory, so it can be preloaded like a compiled one
+static void load_state_text_compiled(vsx::filesystem* fs, const vsx_string<>& filename, vsx_command_state_binary_reader& state)
+{
+  vsx_command_state_binary_writer writer;
+  vsx::file* fp = fs->f_open(filename.c_str());
+  if (fp)
+  {
+    char* text = fs->f_gets_entire(fp);
+    if (text)
+    {
+      writer.add_state( vsx_string<>(text) );
+      free(text);
+    }
+    fs->f_close(fp);
+  }
+  vsx_ma_vector<unsigned char> data = writer.get_data();
+  state.load(data.get_pointer(), data.size());
+}
+
+// Opens filename in the engine's filesystem if it's a .vsx archive, then
+// filename is the state inside it. False if the archive can't be read.
+static bool load_state_open_archive(vsx::filesystem& filesystem, vsx_string<>& filename, bool& is_archive)
+{
   filesystem.set_base_path("");
 
   if (filesystem.get_archive()->is_archive())
     filesystem.get_archive()->close();
 
-  vsx_command_list load1(true);
-  load1.set_filesystem(&filesystem);
+  is_archive = false;
+  if (filename.size() < 4)
+    return true;
+
+  if (filename.substr((int)filename.size()-4,4) != ".vsx")
+    return true;
+
+  filesystem.get_archive()->load(filename.c_str(), false, 0);
+  if (!filesystem.get_archive()->is_archive_populated())
+  {
+    filesystem.get_archive()->close();
+    return false;
+  }
+
+  is_archive = true;
+  filename = "_states/_default";
+  return true;
+}
+
+int vsx_engine::load_state(vsx_string<>filename, vsx_string<>* error_string)
+{
+  if (!valid)
+    return 2;
+
   vsx_string<> i_filename = filename;
+  bool is_archive;
+  if (!load_state_open_archive(filesystem, i_filename, is_archive))
+    return 0;
 
-  bool is_archive = false;
-  if (filename.size() >= 4)
+  if (is_archive)
   {
-    if (filename.substr((int)filename.size()-4,4) == ".vsx")
-    {
-      filesystem.get_archive()->load(filename.c_str(), false, 0);
-      if (filesystem.get_archive()->is_archive_populated())
-      {
-        is_archive = true;
-        i_filename = "_states/_default";
-      } else
-      {
-        filesystem.get_archive()->close();
-        return 0;
-      }
-    }
+    vsx_engine_prepared_state prepared;
+    prepared.info_filename = filename;
+    if (load_state_compiled(&filesystem, i_filename, prepared.state))
+      return i_load_state_compiled(prepared, error_string);
   }
+
+  vsx_command_list load1(true);
+  load1.set_filesystem(&filesystem);
   load1.load_from_file(i_filename,true);
   load1.garbage_collect();
 
@@ -347,6 +514,11 @@ int vsx_engine::load_state_filesystem(vsx_string<>filename, vsx_string<>*error_s
 
   engine_info.filesystem = fs;
 
+  vsx_engine_prepared_state prepared;
+  prepared.info_filename = filename;
+  if (load_state_compiled(fs, filename, prepared.state))
+    return i_load_state_compiled(prepared, error_string);
+
   vsx_command_list load1(true);
   load1.set_filesystem( fs );
 
@@ -358,6 +530,69 @@ int vsx_engine::load_state_filesystem(vsx_string<>filename, vsx_string<>*error_s
 }
 
 
+int vsx_engine::preload_state(vsx_string<>filename, vsx_string<>*error_string, vsx::filesystem* fs)
+{
+  if (!valid)
+    return 2;
+
+  if (state_preloaded)
+  {
+    i_discard_prepared_state(*state_preloaded);
+    delete state_preloaded;
+    state_preloaded = 0x0;
+  }
+
+  vsx_engine_prepared_state* prepared = new vsx_engine_prepared_state;
+  prepared->info_filename = filename;
+  vsx_string<> i_filename = filename;
+  bool is_archive = false;
+
+  if (fs)
+    engine_info.filesystem = fs;
+  else
+  {
+    fs = &filesystem;
+    if (!load_state_open_archive(filesystem, i_filename, is_archive))
+    {
+      delete prepared;
+      return 0;
+    }
+  }
+
+  // text states are compiled here, off the render thread
+  if (!load_state_compiled(fs, i_filename, prepared->state))
+    load_state_text_compiled(fs, i_filename, prepared->state);
+
+  if (fs == &filesystem && !is_archive)
+    filesystem.set_base_path( vsx_data_path::get_instance()->data_path_get());
+
+  int result = i_prepare_state(*prepared, error_string, false);
+  if (result)
+  {
+    delete prepared;
+    return result;
+  }
+
+  state_preloaded = prepared;
+  return 0;
+}
+
+int vsx_engine::load_preloaded_state()
+{
+  if (!valid)
+    return 2;
+
+  if (!state_preloaded)
+    return 0;
+
+  vsx_engine_prepared_state* prepared = state_preloaded;
+  state_preloaded = 0x0;
+  int result = i_load_state_prepared(*prepared);
+  delete prepared;
+  return result;
+}
+
+
 
 
 // set engine speed
@@ -488,6 +723,8 @@ bool vsx_engine::render()
   if (!valid)
     return false;
 
+  param_batch_apply();
+
   // check for time control requests from the modules
   if
   (
@@ -529,7 +766,9 @@ bool vsx_engine::render()
 
   if (!disabled)
   {
+    vsx_profiler* frame_trace = vsx_engine_trace::frame_begin();
     frame_timer.start();
+    engine_info.frame++;
 
     float gtime = (float)g_timer.dtime();
 
@@ -552,36 +791,44 @@ bool vsx_engine::render()
     // this is the fmod time synchronizer
     if (frame_cfp_time == 0.0f)
     {
-      for (unsigned long i = 0; i < outputs.size(); i++)
+      if (output_sync_generation != structure_generation)
       {
-        vsx_engine_param* param;
-        param = outputs[i]->get_params_out()->get_by_name("_st");
-        if (param) {
-          vsx_module_param_float* fp = (vsx_module_param_float*)param->module_param;
-          dt = fp->get();
-          if (dt != -1.0f)
+        output_sync_generation = structure_generation;
+        output_sync_params.clear();
+        for (unsigned long i = 0; i < outputs.size(); i++)
+        {
+          vsx_engine_param* param = outputs[i]->get_params_out()->get_by_name("_st");
+          if (param)
+            output_sync_params.push_back( (vsx_module_param_float*)param->module_param );
+        }
+      }
+
+      for (unsigned long i = 0; i < output_sync_params.size(); i++)
+      {
+        vsx_module_param_float* fp = output_sync_params[i];
+        dt = fp->get();
+        if (dt != -1.0f)
+        {
+          // we're getting some time from the module
+          if (current_state == VSX_ENGINE_PLAYING)
           {
-            // we're getting some time from the module
-            if (current_state == VSX_ENGINE_PLAYING)
+            if (last_m_time_synch == 0)
             {
-              if (last_m_time_synch == 0)
-              {
-                g_timer.start();
-                if (engine_info.vtime == 0)
-                d_time_i = dt;//dt-0.06;//dt - frame_prev_time;
-                last_m_time_synch = 1;
-              } else
-              {
-                d_time_i = d_time;
-              }
+              g_timer.start();
+              if (engine_info.vtime == 0)
+              d_time_i = dt;//dt-0.06;//dt - frame_prev_time;
+              last_m_time_synch = 1;
             } else
             {
-              d_time_i = 0;
+              d_time_i = d_time;
             }
           } else
           {
             d_time_i = 0;
           }
+        } else
+        {
+          d_time_i = 0;
         }
       }
     }
@@ -640,33 +887,64 @@ bool vsx_engine::render()
     frame_dprev = engine_info.vtime;
 
     // advance the sequencer
+    vsx_profiler* trace = vsx_engine_trace::begin("sequencer");
     sequence_list.run(engine_info.dtime);
 
     // advance the sequence pool
     sequence_pool.run(engine_info.dtime);
+    vsx_engine_trace::end(trace);
 
     if (engine_time_from_sequence_pool)
       engine_info.vtime = sequence_pool.get_vtime();
 
     // run the parameter interpolators
+    trace = vsx_engine_trace::begin("interpolation");
     interpolation_list.run( (float)m_timer.dtime() );
+    vsx_engine_trace::end(trace);
+
+
+    // run the thread safe part of the graph in parallel, the pull below
+    // will then only ask those components for output
+    if
+    (
+      render_hint_parallel_execution
+      &&
+      current_state != VSX_ENGINE_LOADING
+      &&
+      !render_hint_module_output_only
+    )
+    {
+      trace = vsx_engine_trace::begin("parallel execution");
+      scheduler.run(outputs);
+      vsx_engine_trace::end(trace);
+    }
 
+    // while loading, components come and go between frames so stay with the
+    // recursive pull and reset the whole forge
+    bool use_plan = render_hint_execution_plan && current_state != VSX_ENGINE_LOADING;
 
     // render the state by iterating over the outputs
+    trace = vsx_engine_trace::begin("outputs");
+    if (use_plan)
+      plan.run(outputs);
+    else
     for (unsigned long i = 0; i < outputs.size(); i++) {
       outputs[i]->prepare();
     }
+    vsx_engine_trace::end(trace);
+
+    std::vector<vsx_comp*>& frame_components = use_plan ? plan.get_components() : forge;
 
     // post-rendering reset frame status of the components
     if (render_hint_post_render_reset_component_status)
     {
-      for(std::vector<vsx_comp*>::iterator it = forge.begin(); it < forge.end(); ++it)
+      for(std::vector<vsx_comp*>::iterator it = frame_components.begin(); it < frame_components.end(); ++it)
       {
         (*it)->reset_has_run_status();
       }
     }
 
-    for(std::vector<vsx_comp*>::iterator it = forge.begin(); it < forge.end(); ++it)
+    for(std::vector<vsx_comp*>::iterator it = frame_components.begin(); it < frame_components.end(); ++it)
     {
       (*it)->reset_frame_status();
     }
@@ -710,6 +988,7 @@ bool vsx_engine::render()
     {
       engine_info.dtime = 0.0f;
     }
+    vsx_engine_trace::frame_end(frame_trace);
     return true;
   }
   return false;
@@ -753,14 +1032,14 @@ void vsx_engine::process_message_queue(vsx_command_list *cmd_in, vsx_command_lis
   //---------------------------------------
   double total_time = 0.0;
 
-  #define FAIL(header, message) 	cmd_out->add_raw(vsx_string<>("alert_fail ") + vsx_string_helper::base64_encode(#header)+" Error " + vsx_string_helper::base64_encode(#message))
-
   vsx_command_timer.start();
 
   vsx_command_list* cmd_out = cmd_out_res;
 
   max_time = 120.0f;
 
+  vsx_profiler* batch_trace = vsx_engine_trace::begin("command batch");
+
   while (total_time < (double)max_time || ignore_timing)
   {
     c = commands_internal.pop();
@@ -774,55 +1053,188 @@ void vsx_engine::process_message_queue(vsx_command_list *cmd_in, vsx_command_lis
     {
       if (!c->garbage_collected)
         delete c;
+      vsx_engine_trace::end(batch_trace);
       return;
     }
 
+    vsx_profiler* command_trace = vsx_engine_trace::begin(c->cmd);
+
     // internal command
     if (c->type == 1)
       cmd_out = &commands_res_internal;
 
-    // process main message
-    #define cmd c->cmd
-    #define cmd_data c->cmd_data
-
-    #include "vsx_engine_messages/vsx_saveload.h"
-    #include "vsx_engine_messages/vsx_em_comp.h"
-    #include "vsx_engine_messages/vsx_connections.h"
-    #include "vsx_engine_messages/vsx_parameters.h"
-    #include "vsx_engine_messages/vsx_em_sequencer.h"
-    #include "vsx_engine_messages/vsx_em_macro.h"
-    #include "vsx_engine_messages/vsx_em_seq_pool.h"
-    #include "vsx_engine_messages/vsx_engine_time.h"
-    #include "vsx_engine_messages/vsx_em_script.h"
-    #include "vsx_engine_messages/vsx_note.h"
-    #include "vsx_engine_messages/vsx_em_system.h"
-    #include "vsx_engine_messages/vsx_em_module_operation.h"
-
-    if (cmd == "help")
-      goto process_message_queue_end;
-
-    // this shouldn't be reached unless no command is performed and thus jumped
-    // to process_message_queue_end
-    cmd_out->add_raw("invalid_command unknown_command");
-
-
-    #undef cmd
-    #undef cmd_data
+    vsx_engine_command_handler* handler = command_get_handler(c);
+    if (handler)
+      (this->*handler->function)(c, cmd_out);
+    else
+      cmd_out->add_raw("invalid_command unknown_command");
 
-    process_message_queue_end:
+    double command_time = vsx_command_timer.dtime();
+    if (handler)
+      handler->add_time(command_time);
 
     if (current_state != VSX_ENGINE_LOADING)
       process_message_queue_redeclare(cmd_out_res);
 
+    vsx_engine_trace::end(command_trace);
+
     if (!c->garbage_collected)
       delete c;
 
-    total_time += vsx_command_timer.dtime();
+    total_time += command_time + vsx_command_timer.dtime();
   }
+  vsx_engine_trace::end(batch_trace);
 
 } // process_comand_queue
 
 
+// command handlers
+#define VSX_ENGINE_COMMAND_HANDLER(name) void vsx_engine::command_##name(vsx_command_s* c, vsx_command_list* cmd_out)
+#define cmd c->cmd
+#define cmd_data c->cmd_data
+#define FAIL(header, message) 	cmd_out->add_raw(vsx_string<>("alert_fail ") + vsx_string_helper::base64_encode(#header)+" Error " + vsx_string_helper::base64_encode(#message))
+
+#include "vsx_engine_messages/vsx_saveload.h"
+#include "vsx_engine_messages/vsx_em_comp.h"
+#include "vsx_engine_messages/vsx_connections.h"
+#include "vsx_engine_messages/vsx_parameters.h"
+#include "vsx_engine_messages/vsx_em_sequencer.h"
+#include "vsx_engine_messages/vsx_em_macro.h"
+#include "vsx_engine_messages/vsx_em_seq_pool.h"
+#include "vsx_engine_messages/vsx_engine_time.h"
+#include "vsx_engine_messages/vsx_em_script.h"
+#include "vsx_engine_messages/vsx_note.h"
+#include "vsx_engine_messages/vsx_em_system.h"
+#include "vsx_engine_messages/vsx_em_module_operation.h"
+
+VSX_ENGINE_COMMAND_HANDLER(help)
+{
+  command_help_param_set(c, cmd_out);
+  command_help_param_clone_value(c, cmd_out);
+}
+
+#undef FAIL
+#undef cmd_data
+#undef cmd
+#undef VSX_ENGINE_COMMAND_HANDLER
+
+
+void vsx_engine::command_register(const char* name, void (vsx_engine::*function)(vsx_command_s* c, vsx_command_list* cmd_out))
+{
+  uint32_t id = vsx_command_id_register(name);
+  if (id >= command_handlers.size())
+    command_handlers.resize(id + 1);
+  command_handlers[id].name = name;
+  command_handlers[id].function = function;
+}
+
+void vsx_engine::command_register_all()
+{
+  command_register("help", &vsx_engine::command_help);
+
+  command_register("state_load", &vsx_engine::command_state_load);
+  command_register("state_load_done", &vsx_engine::command_state_load_done);
+  command_register("clear", &vsx_engine::command_clear);
+  command_register("meta_set", &vsx_engine::command_meta_set);
+  command_register("meta_get", &vsx_engine::command_meta_get);
+  command_register("set_silent", &vsx_engine::command_set_silent);
+  command_register("package_export", &vsx_engine::command_package_export);
+  command_register("state_save", &vsx_engine::command_state_save);
+
+  command_register("component_create", &vsx_engine::command_component_create);
+  command_register("component_delete", &vsx_engine::command_component_delete);
+  command_register("component_assign", &vsx_engine::command_component_assign);
+  command_register("component_rename", &vsx_engine::command_component_rename);
+  command_register("cpp", &vsx_engine::command_component_pos);
+  command_register("component_pos", &vsx_engine::command_component_pos);
+  command_register("component_size", &vsx_engine::command_component_size);
+  command_register("get_module_status", &vsx_engine::command_get_module_status);
+  command_register("component_timing", &vsx_engine::command_component_timing);
+
+  command_register("param_connect", &vsx_engine::command_param_connect);
+  command_register("param_disconnect", &vsx_engine::command_param_disconnect);
+  command_register("param_alias", &vsx_engine::command_param_alias);
+  command_register("param_unalias", &vsx_engine::command_param_unalias);
+  command_register("connections_order", &vsx_engine::command_connections_order);
+
+  command_register("param_set", &vsx_engine::command_param_set);
+  command_register("pa_ren", &vsx_engine::command_pa_ren);
+  command_register("param_get", &vsx_engine::command_param_get);
+  command_register("pgo", &vsx_engine::command_param_get);
+  command_register("pg64", &vsx_engine::command_pg64);
+  command_register("ps64", &vsx_engine::command_ps64);
+  command_register("ps", &vsx_engine::command_ps);
+  command_register("param_clone_value", &vsx_engine::command_param_clone_value);
+  command_register("param_set_interpolate", &vsx_engine::command_param_set_interpolate);
+  command_register("param_set_default", &vsx_engine::command_param_set_default);
+  command_register("pflag", &vsx_engine::command_pflag);
+
+  command_register("seq_list", &vsx_engine::command_seq_list);
+  command_register("pseq_l_dump", &vsx_engine::command_pseq_l_dump);
+  command_register("pseq_l_rescale_time", &vsx_engine::command_pseq_l_rescale_time);
+  command_register("pseq_inject_get_keyframe_at_time", &vsx_engine::command_pseq_inject_get_keyframe_at_time);
+  command_register("pseq_p", &vsx_engine::command_pseq_p);
+  command_register("pseq_r", &vsx_engine::command_pseq_r);
+  command_register("mseq_channel", &vsx_engine::command_mseq_channel);
+
+  command_register("macro_dump", &vsx_engine::command_macro_dump);
+  command_register("component_clone", &vsx_engine::command_macro_dump);
+  command_register("macro_prerun", &vsx_engine::command_macro_prerun);
+  command_register("macro_create", &vsx_engine::command_macro_create);
+
+  command_register("seq_pool", &vsx_engine::command_seq_pool);
+
+  command_register("time_set_loop_point", &vsx_engine::command_time_set_loop_point);
+  command_register("time_set_speed", &vsx_engine::command_time_set_speed);
+  command_register("play", &vsx_engine::command_play);
+  command_register("stop", &vsx_engine::command_stop);
+  command_register("rewind", &vsx_engine::command_rewind);
+  command_register("fps_d", &vsx_engine::command_fps);
+  command_register("fps", &vsx_engine::command_fps);
+  command_register("time_set", &vsx_engine::command_time_set);
+
+  #ifndef VSXE_NO_GM
+  command_register("vsxl_cfl", &vsx_engine::command_vsxl_cfl);
+  command_register("vsxl_cfi", &vsx_engine::command_vsxl_cfi);
+  command_register("vsxl_cfr", &vsx_engine::command_vsxl_cfr);
+  command_register("vsxl_pfl", &vsx_engine::command_vsxl_pfl);
+  command_register("vsxl_pfi", &vsx_engine::command_vsxl_pfi);
+  command_register("vsxl_pfr", &vsx_engine::command_vsxl_pfr);
+  #endif
+
+  command_register("note_create", &vsx_engine::command_note_create);
+  command_register("note_update", &vsx_engine::command_note_update);
+  command_register("note_delete", &vsx_engine::command_note_delete);
+
+  command_register("get_module_list", &vsx_engine::command_get_module_list);
+  command_register("get_list", &vsx_engine::command_get_list);
+  command_register("get_state", &vsx_engine::command_get_state);
+  command_register("undo_s", &vsx_engine::command_undo_s);
+  command_register("undo", &vsx_engine::command_undo);
+  command_register("engine_trace", &vsx_engine::command_engine_trace);
+  command_register("command_stats", &vsx_engine::command_command_stats);
+  command_register("system.shutdown", &vsx_engine::command_system_shutdown);
+
+  command_register("module_operation_perform", &vsx_engine::command_module_operation_perform);
+}
+
+// Commands made before their name was registered (i.e. parsed before the
+// first engine was created) get their id here.
+vsx_engine_command_handler* vsx_engine::command_get_handler(vsx_command_s* c)
+{
+  if (!c->cmd_id)
+    c->cmd_id = vsx_command_id_find(c->cmd);
+
+  if (c->cmd_id >= command_handlers.size())
+    return 0x0;
+
+  vsx_engine_command_handler* handler = &command_handlers[c->cmd_id];
+  if (!handler->function)
+    return 0x0;
+  return handler;
+}
+
+
 float vsx_engine::get_last_frame_time()
 {
   return last_frame_time;
@@ -39,6 +39,8 @@
 #include <internal/vsx_master_sequence_channel.h>
 #include <internal/vsx_note.h>
 #include <vsx_data_path.h>
+#include <module/vsx_module_job.h>
+#include <tools/vsx_thread_pool.h>
 
 #if PLATFORM_FAMILY == PLATFORM_FAMILY_UNIX
 #include <dirent.h>
@@ -60,13 +62,16 @@
 #endif
 
 #include <vector>
+#include <algorithm>
 
 void vsx_engine_abs::constructor_set_default_values()
 {
   valid = false;
+  structure_generation = 1;
   no_send_client_time = false;
   g_timer_amp = 1.0f;
   engine_info.filesystem = &filesystem;
+  engine_info.job_system = vsx_module_job_system::get_instance();
   vsxl = 0;
   lastsent = 0;
   sequence_pool.set_engine((void*)this);
@@ -81,12 +86,34 @@ void vsx_engine_abs::constructor_set_default_values()
   render_hint_module_output_only = false;
   render_hint_module_run_only = false;
   render_hint_post_render_reset_component_status = true;
+  render_hint_parallel_execution = false;
+  render_hint_execution_plan = true;
   frame_dcount = 0;
   frame_dtime = 0;
   frame_dprev = -1;
   frame_delta_fps = 0;
   frame_delta_fps_frame_count_interval = 50;
   component_name_autoinc = 0;
+  state_preloaded = 0x0;
+}
+
+static int i_load_state_module_missing(const vsx_string<>& module_name, vsx_string<>*error_string, const vsx_string<>& info_filename)
+{
+  if (error_string) *error_string = "VSX Engine could not find or load module: "+module_name;
+  vsx_printf( L"%hs\n",vsx_string<>(
+            "**************************************************\n"
+            "Notice: \n\tVSX Engine could not load module: "
+            "'"+module_name+"'"
+            "\n\tThis prevented the project: \n\t\t'"+
+            info_filename+"'\n"+
+            "\tfrom loading.\n"
+            "\tThis is most likely from your GPU/drivers do not support some feature needed.\n"
+            "\tPlease consider upgrading your hardware or drivers.\n"
+            "\tIf you are a developer, this might mean some modules didn't compile properly.\n"
+            "**************************************************\n\n").c_str() );
+
+  LOG3("Module missing in engine: "+module_name);
+  return 1;
 }
 
 int vsx_engine_abs::i_load_state(vsx_command_list& load1,vsx_string<>*error_string, vsx_string<>info_filename)
@@ -96,7 +123,6 @@ int vsx_engine_abs::i_load_state(vsx_command_list& load1,vsx_string<>*error_stri
   load1.reset();
   vsx_command_s* mc = 0;
   // check the macro list to verify the existence of the componente we need for this macro
-  vsx_string<>failed_component = "";
   while ( (mc = load1.get()) )
   {
     if (mc->cmd == "component_create")
@@ -106,25 +132,7 @@ int vsx_engine_abs::i_load_state(vsx_command_list& load1,vsx_string<>*error_stri
       (
           !module_list->find( mc->parts[1] )
       )
-      {
-        failed_component = mc->parts[2];
-        //components_existing = false;
-        if (error_string) *error_string = "VSX Engine could not find or load module: "+mc->parts[1];
-        vsx_printf( L"%hs\n",vsx_string<>(
-                  "**************************************************\n"
-                  "Notice: \n\tVSX Engine could not load module: "
-                  "'"+mc->parts[1]+"'"
-                  "\n\tThis prevented the project: \n\t\t'"+
-                  info_filename+"'\n"+
-                  "\tfrom loading.\n"
-                  "\tThis is most likely from your GPU/drivers do not support some feature needed.\n"
-                  "\tPlease consider upgrading your hardware or drivers.\n"
-                  "\tIf you are a developer, this might mean some modules didn't compile properly.\n"
-                  "**************************************************\n\n").c_str() );
-
-        LOG3("Module missing in engine: "+mc->parts[1]);
-        return 1;
-      }
+        return i_load_state_module_missing(mc->parts[1], error_string, info_filename);
     }
   }
   static vsx_string<>sld("state_load_done");
@@ -153,6 +161,220 @@ int vsx_engine_abs::i_load_state(vsx_command_list& load1,vsx_string<>*error_stri
   return 0;
 }
 
+int vsx_engine_abs::i_load_state_compiled(vsx_engine_prepared_state& prepared, vsx_string<>*error_string)
+{
+  int result = i_prepare_state(prepared, error_string, true);
+  if (result)
+    return result;
+  return i_load_state_prepared(prepared);
+}
+
+int vsx_engine_abs::i_prepare_state(vsx_engine_prepared_state& prepared, vsx_string<>*error_string, bool render_thread)
+{
+  if (!valid) return 2;
+  typedef vsx_command_state_binary_record record;
+  vsx_command_state_binary_reader& state = prepared.state;
+
+  // verify that the modules are present, also in components created by commands
+  for (size_t i = 0; i < state.get_record_count(); i++)
+  {
+    record& r = state.get_record(i);
+    if (r.type == record::component_create && !module_list->find( state.get_field(r, 0) ))
+      return i_load_state_module_missing(state.get_field(r, 0), error_string, prepared.info_filename);
+
+    if (r.type == record::command && r.field_count >= 2 && state.get_field(r, 0) == "component_create")
+      if (!module_list->find( state.get_field(r, 1) ))
+        return i_load_state_module_missing(state.get_field(r, 1), error_string, prepared.info_filename);
+  }
+
+  LOG("i_prepare_state: all modules are available, constructing components")
+
+  // Construct every component before replaying the state. Plugins are loaded
+  // and modules created here, init_module for modules flagged init_thread_safe
+  // runs on the thread pool while this thread initializes the rest, which
+  // may need the GL context.
+  prepared.components.assign(state.get_record_count(), 0x0);
+  prepared.init_pending.clear();
+  vsx_thread_pool<>::task_group group;
+  for (size_t i = 0; i < state.get_record_count(); i++)
+  {
+    record& r = state.get_record(i);
+    if (r.type != record::component_create)
+      continue;
+
+    vsx_comp* comp = new vsx_comp;
+    comp->engine_owner = (void*)this;
+    comp->name = state.get_field(r, 1);
+    if (!comp->create_module(state.get_field(r, 0), &engine_info))
+    {
+      delete comp;
+      continue;
+    }
+    prepared.components[i] = comp;
+
+    vsx_module_specification* spec = module_list->get_module_info( state.get_field(r, 0) );
+    if (spec && spec->init_thread_safe)
+      group.run( [comp]() { comp->init_module(); } );
+    else
+      prepared.init_pending.push_back(comp);
+  }
+
+  if (render_thread)
+  {
+    foreach (prepared.init_pending, i)
+      prepared.init_pending[i]->init_module();
+    prepared.init_pending.clear();
+  }
+
+  group.wait();
+  return 0;
+}
+
+void vsx_engine_abs::i_discard_prepared_state(vsx_engine_prepared_state& prepared)
+{
+  foreach (prepared.components, i)
+  {
+    vsx_comp* comp = prepared.components[i];
+    if (!comp)
+      continue;
+
+    // a module that wasn't initialized only needs to be destroyed
+    if (std::find(prepared.init_pending.begin(), prepared.init_pending.end(), comp) != prepared.init_pending.end())
+      module_list->unload_module(comp->module);
+    else
+      comp->unload_module();
+    delete comp;
+  }
+  prepared.components.clear();
+  prepared.init_pending.clear();
+}
+
+int vsx_engine_abs::i_load_state_prepared(vsx_engine_prepared_state& prepared)
+{
+  if (!valid) return 2;
+  typedef vsx_command_state_binary_record record;
+  vsx_command_state_binary_reader& state = prepared.state;
+  std::vector<vsx_comp*>& components = prepared.components;
+
+  stop();
+  i_clear();
+  start();
+
+  // the modules that need the render thread
+  foreach (prepared.init_pending, i)
+    prepared.init_pending[i]->init_module();
+  prepared.init_pending.clear();
+
+  // Replay the state in order. The replies of the commands are discarded as
+  // for a text state, so only what changes the engine is done here.
+  vsx_command_list loadr2(true);
+  vsx_command_list commands(true);
+  bool commands_pending = false;
+  vsx_nw_vector< vsx_string<> > parts;
+  for (size_t i = 0; i < state.get_record_count(); i++)
+  {
+    record& r = state.get_record(i);
+
+    if (r.type == record::command)
+    {
+      state.get_parts(r, parts);
+      commands.add_parts(parts);
+      commands_pending = true;
+      continue;
+    }
+
+    if (commands_pending)
+    {
+      process_message_queue(&commands,&loadr2,true,true);
+      commands_pending = false;
+    }
+
+    switch (r.type)
+    {
+      case record::component_create:
+      {
+        vsx_comp* comp = components[i];
+        components[i] = 0x0;
+        if (!comp)
+          break;
+
+        // a component with this name exists already
+        if (!add(comp))
+        {
+          comp->unload_module();
+          delete comp;
+          break;
+        }
+
+        comp->identifier = state.get_field(r, 0);
+        if ( comp->module_info->identifier_save != "")
+          comp->identifier = comp->module_info->identifier_save;
+
+        if (comp->module_info->output)
+          outputs.push_back(comp);
+
+        comp->position.x = r.x;
+        comp->position.y = r.y;
+        break;
+      }
+
+      case record::param_set:
+      {
+        vsx_comp* dest = get_component_by_name(state.get_field(r, 0));
+        if (!dest)
+          break;
+        vsx_engine_param* ep = dest->get_params_in()->get_by_name(state.get_field(r, 1));
+        if (!ep)
+          break;
+        ep->set_string(state.get_field(r, 2));
+        ep->module->param_set_notify(state.get_field(r, 1));
+        if (ep->module->redeclare_in)
+          redeclare_in_params(dest, &loadr2);
+        break;
+      }
+
+      case record::param_connect:
+      {
+        vsx_comp* dest = get_component_by_name(state.get_field(r, 0));
+        vsx_comp* src = get_component_by_name(state.get_field(r, 2));
+        if (!dest || !src)
+          break;
+        vsx_engine_param* dest_param = dest->get_params_in()->get_by_name(state.get_field(r, 1));
+        vsx_engine_param* src_param = src->get_params_out()->get_by_name(state.get_field(r, 3));
+        if (dest_param && src_param && !dest_param->sequence)
+          dest_param->connect(src_param);
+        break;
+      }
+
+      case record::param_alias:
+      {
+        vsx_comp* dest = get_component_by_name(state.get_field(r, 1));
+        vsx_comp* src = get_component_by_name(state.get_field(r, 3));
+        if (!dest || !src)
+          break;
+        vsx_engine_param_list* src_l = r.direction ? src->get_params_out() : src->get_params_in();
+        vsx_engine_param_list* dest_l = r.direction ? dest->get_params_out() : dest->get_params_in();
+        vsx_engine_param* src_param = src_l->get_by_name(state.get_field(r, 4));
+        if (src_param)
+          dest_l->alias(src_param, dest_l->alias_get_unique_name(state.get_field(r, 2)));
+        break;
+      }
+    }
+  }
+
+  // anything after a break is left in the queue for the coming frames
+  static vsx_string<>sld("state_load_done");
+  commands.add_raw(sld);
+  process_message_queue(&commands,&loadr2,true,true);
+  loadr2.clear_normal();
+
+  current_state = VSX_ENGINE_LOADING;
+  g_timer.start();
+  modules_loaded = 0;
+  modules_left_to_load = 0;
+  return 0;
+}
+
 vsx_comp* vsx_engine_abs::add(vsx_string<>label)
 {
   if (!valid) return 0x0;
@@ -161,12 +383,25 @@ vsx_comp* vsx_engine_abs::add(vsx_string<>label)
     vsx_comp* comp = new vsx_comp;
     comp->engine_owner = (void*)this;
     comp->name = label;
+    return add(comp);
+  }
+  return 0x0;
+}
+
+vsx_comp* vsx_engine_abs::add(vsx_comp* comp)
+{
+  if (!valid) return 0x0;
+  if (!forge_map[comp->name])
+  {
     forge.push_back(comp);
+    scheduler.invalidate();
+    plan.invalidate();
+    structure_generation++;
 
     // is this a child of a macro?
     vsx_nw_vector< vsx_string<> > c_parts;
     vsx_string<> deli = ".";
-    vsx_string_helper::explode(label, deli, c_parts);
+    vsx_string_helper::explode(comp->name, deli, c_parts);
     if (c_parts.size() > 1) {
       // ok, we have a macro
       vsx_string<>macro_name = vsx_string_helper::implode(c_parts, deli, 0, 1);
@@ -175,7 +410,7 @@ vsx_comp* vsx_engine_abs::add(vsx_string<>label)
         macro_comp->children.push_back(comp);
       }
     }
-    forge_map[label] = comp;
+    forge_map[comp->name] = comp;
     return comp;
   }
   return 0x0;
@@ -259,6 +494,9 @@ void vsx_engine_abs::redeclare_in_params(vsx_comp* comp, vsx_command_list *cmd_o
       cmd_out->add_raw("param_connect_volatile "+comp->name+" "+dparam->name+" "+(*it2)->src->owner->component->name+" "+(*it2)->src->name+" "+vsx_string_helper::i2s(order), VSX_COMMAND_GARBAGE_COLLECT);
     }
   }
+
+  // the parameters are new, handles to them resolve again
+  structure_generation++;
 }
 
 void vsx_engine_abs::redeclare_out_params(vsx_comp* comp, vsx_command_list *cmd_out)
@@ -289,6 +527,8 @@ void vsx_engine_abs::redeclare_out_params(vsx_comp* comp, vsx_command_list *cmd_
     vsx_string<>os = vsx_string_helper::i2s(order);
     cmd_out->add_raw("param_connect_volatile "+dest_comp_name+" "+srcn+" "+cn+" "+dpn+" "+os, VSX_COMMAND_GARBAGE_COLLECT);
   }
+
+  structure_generation++;
 }
 
 vsx_string<> vsx_engine_abs::system_message_get()
@@ -448,6 +688,9 @@ void vsx_engine_abs::i_clear(vsx_command_list *cmd_out, bool clear_critical, boo
   note_map.clear();
   forge = forge_save;
   forge_map = forge_map_save;
+  scheduler.clear();
+  plan.clear();
+  structure_generation++;
 
   sequence_pool.clear();
   sequence_list.clear_master_sequences();
@@ -719,5 +962,6 @@ int vsx_engine_abs::rename_component(vsx_string<>old_identifier, vsx_string<>new
     else
     old_identifier_component->parent = 0;
   }
+  structure_generation++;
   return 1;
 }
@@ -23,7 +23,7 @@
 
 #include <internal/vsx_comp.h>
 
-if (cmd == "param_connect")
+VSX_ENGINE_COMMAND_HANDLER(param_connect)
 {
   // syntax:
   //       0            1          2          3          4
@@ -69,13 +69,12 @@ if (cmd == "param_connect")
     }
   }
   else cmd_out->add_raw("alert_fail "+vsx_string_helper::base64_encode(c->raw)+" Error "+vsx_string_helper::base64_encode("Can not connect:| Neither source or dest component exists."), VSX_COMMAND_GARBAGE_COLLECT);
-  goto process_message_queue_end;
 }
 
 
 
 
-if (cmd == "param_disconnect")
+VSX_ENGINE_COMMAND_HANDLER(param_disconnect)
 {
   // syntax:
   //  param_disconnect [in-comp] [in-param] [out-comp] [out-param]
@@ -95,7 +94,6 @@ if (cmd == "param_disconnect")
       cmd_out->add_raw("alert_fail "+vsx_string_helper::base64_encode(c->raw)+" Error "+vsx_string_helper::base64_encode("Can not disconnect, failed. You shouldn't see this, did you type the command manually?"), VSX_COMMAND_GARBAGE_COLLECT);
     }
   }
-  goto process_message_queue_end;
 }
 
 
@@ -103,7 +101,7 @@ if (cmd == "param_disconnect")
 
 
 
-if (cmd == "param_alias")
+VSX_ENGINE_COMMAND_HANDLER(param_alias)
 {
   // syntax:
   //        0          1           2            3           4              5                 6
@@ -144,14 +142,13 @@ if (cmd == "param_alias")
       }
     }
   }
-  goto process_message_queue_end;
 }
 
 
 
 
 
-if (cmd == "param_unalias")
+VSX_ENGINE_COMMAND_HANDLER(param_unalias)
 {
   // syntax:
   //   param_unalias [-1/1] [component] [param_name]
@@ -170,14 +167,13 @@ if (cmd == "param_unalias")
     else
     cmd_out->add_raw("alert_fail "+vsx_string_helper::base64_encode(c->raw)+" Error " + vsx_string_helper::base64_encode("Could not unalias, this is a possible bug."), VSX_COMMAND_GARBAGE_COLLECT);
   }
-  goto process_message_queue_end;
 }
 
 
 
 
 
-if (cmd == "connections_order")
+VSX_ENGINE_COMMAND_HANDLER(connections_order)
 {
   //syntax:
   //  connections_order_ok [component] [param] [specification]
@@ -188,6 +184,5 @@ if (cmd == "connections_order")
     else
     cmd_out->add_raw("alert_fail "+vsx_string_helper::base64_encode(c->raw)+" Error " + vsx_string_helper::base64_encode("Could not order connections."), VSX_COMMAND_GARBAGE_COLLECT);
   }
-  goto process_message_queue_end;
 }
 
@@ -21,7 +21,7 @@
 * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 */
 
-if (cmd == "component_create")
+VSX_ENGINE_COMMAND_HANDLER(component_create)
 {
   if (c->parts.size() == 5)
   {
@@ -57,12 +57,11 @@ if (cmd == "component_create")
       cmd_out->add_raw("alert_fail [component_create] Error "+vsx_string_helper::base64_encode("There is already a component '"+c->parts[2]+"'"), VSX_COMMAND_GARBAGE_COLLECT);
     }
   }
-  goto process_message_queue_end;
 }
 
 
 
-if (cmd == "component_delete")
+VSX_ENGINE_COMMAND_HANDLER(component_delete)
 {
   if (c->parts.size() == 2)
   {
@@ -144,10 +143,10 @@ if (cmd == "component_delete")
       for (std::list<vsx_comp*>::iterator it_td = to_delete.begin(); it_td != to_delete.end(); ++it_td) {
         delete (*it_td);
       }
+      invalidate_schedule();
       cmd_out->add_raw("component_delete_ok "+c->parts[1], VSX_COMMAND_GARBAGE_COLLECT);
     } else cmd_out->add_raw("alert_fail "+vsx_string_helper::base64_encode(c->raw)+" Error "+vsx_string_helper::base64_encode("Error, component '"+c->parts[1]+"' does not exist!"), VSX_COMMAND_GARBAGE_COLLECT);
   }
-  goto process_message_queue_end;
 }
 
 
@@ -156,7 +155,7 @@ if (cmd == "component_delete")
 
 
 
-if (cmd == "component_assign")
+VSX_ENGINE_COMMAND_HANDLER(component_assign)
 {
   // syntax:
   //  0=component_assign [1=macro name] [2=master_component],[component],[component],... [3=pos_x] [4=pos_y]
@@ -171,7 +170,7 @@ if (cmd == "component_assign")
   if (c->parts.size() != 5)
   {
     cmd_out->add_raw("invalid_command wrong_number_of_arguments "+vsx_string_helper::base64_encode(c->raw), VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -218,7 +217,7 @@ if (cmd == "component_assign")
   if (!namecheck)
   {
     cmd_out->add_raw("alert_fail "+vsx_string_helper::base64_encode(c->raw)+" Error "+vsx_string_helper::base64_encode("Error, there is already a component named "+first_part+comp_name), VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
 
   std::list<vsx_engine_param_connection_info*> abs_connections_in;
@@ -271,7 +270,6 @@ if (cmd == "component_assign")
   }
 
   cmd_out->add_raw(c->parts[0]+"_ok "+c->parts[1]+" "+c->parts[2]+" "+c->parts[3]+" "+c->parts[4], VSX_COMMAND_GARBAGE_COLLECT);
-  goto process_message_queue_end;
 }
 
 
@@ -279,7 +277,7 @@ if (cmd == "component_assign")
 
 
 
-if (cmd == "component_rename")
+VSX_ENGINE_COMMAND_HANDLER(component_rename)
 {
   if (c->parts.size() == 3) {
     // component_rename macro1.macro2.component new_name
@@ -290,7 +288,6 @@ if (cmd == "component_rename")
     else
       cmd_out->add_raw(vsx_string<>("alert_fail ")+vsx_string_helper::base64_encode(c->raw)+" Error "+vsx_string_helper::base64_encode("Rename failed."), VSX_COMMAND_GARBAGE_COLLECT);
   }
-  goto process_message_queue_end;
 }
 
 
@@ -300,7 +297,7 @@ if (cmd == "component_rename")
 
 
 
-if (cmd == "cpp" || cmd == "component_pos")
+VSX_ENGINE_COMMAND_HANDLER(component_pos)
 {
   if (c->parts.size() == 4) {
     vsx_comp* dest = get_component_by_name(c->parts[1]);
@@ -309,7 +306,6 @@ if (cmd == "cpp" || cmd == "component_pos")
       dest->position.y = vsx_string_helper::s2f(c->parts[3]);
     }
   }
-  goto process_message_queue_end;
 }
 
 
@@ -317,7 +313,7 @@ if (cmd == "cpp" || cmd == "component_pos")
 
 
 
-if (cmd == "component_size")
+VSX_ENGINE_COMMAND_HANDLER(component_size)
 {
   if (c->parts.size() == 3) {
     vsx_comp* dest = get_component_by_name(c->parts[1]);
@@ -325,14 +321,13 @@ if (cmd == "component_size")
       dest->size = vsx_string_helper::s2f(c->parts[2]);
     }
   }
-  goto process_message_queue_end;
 }
 
 
 
 
 
-if (cmd == "get_module_status")
+VSX_ENGINE_COMMAND_HANDLER(get_module_status)
 {
   for (std::vector<vsx_comp*>::iterator it = forge.begin(); it < forge.end(); ++it) {
     if ((*it)->module) {
@@ -343,7 +338,6 @@ if (cmd == "get_module_status")
       cmd_out->add_raw("c_msg "+(*it)->name+" "+vsx_string_helper::base64_encode("module||ok"), VSX_COMMAND_GARBAGE_COLLECT);
     }
   }
-  goto process_message_queue_end;
 }
 
 
@@ -352,7 +346,7 @@ if (cmd == "get_module_status")
 
 
 #ifdef VSXU_MODULE_TIMING
-if (cmd == "component_timing")
+VSX_ENGINE_COMMAND_HANDLER(component_timing)
 {
   if (c->parts.size() == 3) {
     vsx_comp* src = get_component_by_name(c->parts[1]);
@@ -360,7 +354,6 @@ if (cmd == "component_timing")
       cmd_out->add_raw(vsx_string<>("component_timing_ok ")+c->parts[2]+" "+vsx_string_helper::f2s(src->time_run,12)+" "+vsx_string_helper::f2s(src->time_output,12)+" "+vsx_string_helper::f2s(last_frame_time,12), VSX_COMMAND_GARBAGE_COLLECT);
     }
   }
-  goto process_message_queue_end;
 }
 
 #endif
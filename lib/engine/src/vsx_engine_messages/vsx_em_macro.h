@@ -23,7 +23,7 @@
 
 
 
-if (cmd == "macro_dump" || cmd == "component_clone")
+VSX_ENGINE_COMMAND_HANDLER(macro_dump)
 {
   // syntax:
   //   macro_dump [name] [save_name]
@@ -32,14 +32,14 @@ if (cmd == "macro_dump" || cmd == "component_clone")
 
   // sanity
   if (!(c->parts.size() >= 3))
-    goto process_message_queue_end;
+    return;
 
   vsx_string<>my_name = c->parts[1];
   forge_map_iter = forge_map.find(c->parts[1]);
 
   // sanity
   if (forge_map_iter == forge_map.end())
-    goto process_message_queue_end;
+    return;
 
   // puchiko has been found, nyo!
   vsx_command_list tmp_comp(true);
@@ -104,34 +104,31 @@ if (cmd == "macro_dump" || cmd == "component_clone")
   }
 
   cmd_out->add_raw(vsx_string<>(c->parts[0]+"_complete ")+c->get_parts(1), VSX_COMMAND_GARBAGE_COLLECT);
-
-  goto process_message_queue_end;
 }
 
 
 
 
 
-if (cmd == "macro_prerun")
+VSX_ENGINE_COMMAND_HANDLER(macro_prerun)
 {
   if (get_component_by_name(c->parts[3])) {
     cmd_out->add_raw(vsx_string<>("alert_fail ") + vsx_string_helper::base64_encode(c->raw) + " Error " + vsx_string_helper::base64_encode("There is already a macro '"+c->parts[3]+"'"), VSX_COMMAND_GARBAGE_COLLECT);
   } else {
     cmd_out->addc(c, VSX_COMMAND_GARBAGE_COLLECT);
   }
-  goto process_message_queue_end;
 }
 
 
 
-if (cmd == "macro_create")
+VSX_ENGINE_COMMAND_HANDLER(macro_create)
 {
   // macro_create [macro_name] [pos_x] [pos_y] [size]
 
   if (c->parts.size() != 5)
   {
     cmd_out->add_raw("invalid_command wrong_number_of_arguments " + vsx_string_helper::base64_encode(c->raw), VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
 
   if (!get_component_by_name(c->parts[1]))
@@ -144,10 +141,8 @@ if (cmd == "macro_create")
     comp->size = vsx_string_helper::s2f(c->parts[4]);
     // the code creating the macro seems pretty similar to that of the component eh?
     cmd_out->add_raw(vsx_string<>("component_create_ok ")+c->parts[1]+" "+get_component_by_name(c->parts[1])->component_class+" "+c->parts[2]+" "+c->parts[3]+" "+c->parts[4], VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
   cmd_out->add_raw("alert_fail " + vsx_string_helper::base64_encode(c->raw)+" Error " + vsx_string_helper::base64_encode("There is already a macro '"+c->parts[1]), VSX_COMMAND_GARBAGE_COLLECT);
-
-  goto process_message_queue_end;
 }
 
@@ -1,4 +1,4 @@
-if (cmd == "module_operation_perform")
+VSX_ENGINE_COMMAND_HANDLER(module_operation_perform)
 {
   if (c->parts.size() == 3)
   {
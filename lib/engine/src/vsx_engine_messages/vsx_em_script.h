@@ -26,7 +26,7 @@
 
 // COMPONENT VSXL
 // gui asks for the contents of a vsxl filter (and or creating a new one)
-if (cmd == "vsxl_cfl")
+VSX_ENGINE_COMMAND_HANDLER(vsxl_cfl)
 {
   vsx_comp* dest = get_by_name(c->parts[1]);
   if (dest)
@@ -35,6 +35,7 @@ if (cmd == "vsxl_cfl")
     if (!dest->vsxl_modifier)
     {
       dest->vsxl_modifier = (vsx_comp_vsxl*)(new vsx_comp_vsxl());
+      invalidate_schedule();
       // load with default script
       driver = (vsx_comp_vsxl_driver_abs*)((vsx_comp_vsxl*)dest->vsxl_modifier)->load(dest->in_module_parameters,"");
       driver->comp = (void*)dest;
@@ -50,7 +51,6 @@ if (cmd == "vsxl_cfl")
     cmd_out->add_raw("vsxl_cfl_s "+c->parts[1]+" "+base64_encode(driver->script), VSX_COMMAND_GARBAGE_COLLECT);
 
   }
-  goto process_message_queue_end;
 }
 
 
@@ -60,16 +60,17 @@ if (cmd == "vsxl_cfl")
 
 // COMPONENT VSXL
 // init component vsxl filter, run from macros
-if (cmd == "vsxl_cfi")
+VSX_ENGINE_COMMAND_HANDLER(vsxl_cfi)
 {
   vsx_comp* dest = get_by_name(c->parts[1]);
   if (!dest)
-    goto process_message_queue_end;
+    return;
 
   vsx_comp_vsxl_driver_abs* driver;
   if (!dest->vsxl_modifier)
   {
     dest->vsxl_modifier = (vsx_comp_vsxl*)(new vsx_comp_vsxl());
+    invalidate_schedule();
     // load with default script
     driver = (vsx_comp_vsxl_driver_abs*)((vsx_comp_vsxl*)dest->vsxl_modifier)->load(dest->in_module_parameters,base64_decode(c->parts[2]));
     driver->comp = (void*)dest;
@@ -79,13 +80,12 @@ if (cmd == "vsxl_cfi")
   }
   else
     driver = (vsx_comp_vsxl_driver_abs*)((vsx_comp_vsxl*)dest->vsxl_modifier)->load((dest->in_module_parameters),base64_decode(c->parts[2]));
-  goto process_message_queue_end;
 }
 
 
 
 // remove vsxl filter from the engine
-if (cmd == "vsxl_cfr")
+VSX_ENGINE_COMMAND_HANDLER(vsxl_cfr)
 {
   vsx_comp* dest = get_by_name(c->parts[1]);
   if (dest)
@@ -96,11 +96,11 @@ if (cmd == "vsxl_cfr")
       ((vsx_comp_vsxl*)dest->vsxl_modifier)->unload();
       delete (vsx_comp_vsxl*)(dest->vsxl_modifier);
       dest->vsxl_modifier = 0;
+      invalidate_schedule();
       // send status to client
       cmd_out->add_raw("vsxl_cfr_ok "+c->parts[1], VSX_COMMAND_GARBAGE_COLLECT);
     }
   }
-  goto process_message_queue_end;
 }
 
 
@@ -110,7 +110,7 @@ if (cmd == "vsxl_cfr")
 
 // PARAMETER VSXL
 // gui asks for the contents of a vsxl filter (and or creating a new one)
-if (cmd == "vsxl_pfl")
+VSX_ENGINE_COMMAND_HANDLER(vsxl_pfl)
 {
   printf("pfl\n");
   vsx_comp* dest = get_by_name(c->parts[1]);
@@ -122,6 +122,7 @@ if (cmd == "vsxl_pfl")
     {
       param->module_param->vsxl_modifier = (vsx_param_vsxl_abs*)(new vsx_param_vsxl());
       ((vsx_param_vsxl*)(param->module_param->vsxl_modifier))->engine = this;
+      invalidate_schedule();
 
       // load with default script
       driver = (vsx_param_vsxl_driver_abs*)((vsx_param_vsxl*)param->module_param->vsxl_modifier)->load(param->module_param,"");
@@ -139,7 +140,6 @@ if (cmd == "vsxl_pfl")
     if (driver)
     cmd_out->add_raw("vsxl_pfl_s "+c->parts[1]+" "+c->parts[2]+" "+base64_encode(driver->script), VSX_COMMAND_GARBAGE_COLLECT);
   }
-  goto process_message_queue_end;
 }
 
 
@@ -148,7 +148,7 @@ if (cmd == "vsxl_pfl")
 
 
 // init vsxl filter, run from macros
-if (cmd == "vsxl_pfi")
+VSX_ENGINE_COMMAND_HANDLER(vsxl_pfi)
 {
   vsx_comp* dest = get_by_name(c->parts[1]);
   if (dest)
@@ -158,6 +158,7 @@ if (cmd == "vsxl_pfi")
     if (!param->module_param->vsxl_modifier) {
       param->module_param->vsxl_modifier = (vsx_param_vsxl_abs*)(new vsx_param_vsxl());
       ((vsx_param_vsxl*)(param->module_param->vsxl_modifier))->engine = this;
+      invalidate_schedule();
       driver = (vsx_param_vsxl_driver_abs*)((vsx_param_vsxl*)param->module_param->vsxl_modifier)->load(param->module_param,base64_decode(c->parts[4]),s2i(c->parts[3]));
 
       driver->interpolation_list = &interpolation_list;
@@ -170,7 +171,6 @@ if (cmd == "vsxl_pfi")
       driver = (vsx_param_vsxl_driver_abs*)((vsx_param_vsxl*)param->module_param->vsxl_modifier)->load(param->module_param,base64_decode(c->parts[4]));
     driver->run();
   }
-  goto process_message_queue_end;
 }
 
 
@@ -179,28 +179,27 @@ if (cmd == "vsxl_pfi")
 
 
 // remove vsxl filter from the engine
-if (cmd == "vsxl_pfr")
+VSX_ENGINE_COMMAND_HANDLER(vsxl_pfr)
 {
   vsx_comp* dest = get_by_name(c->parts[1]);
 
   if (!dest)
-    goto process_message_queue_end;
+    return;
 
   vsx_engine_param* param = dest->get_params_in()->get_by_name(c->parts[2]);
 
   if (!param->module_param->vsxl_modifier)
-    goto process_message_queue_end;
+    return;
 
 
   // actual deletion
   ((vsx_param_vsxl*)param->module_param->vsxl_modifier)->unload();
   delete (vsx_param_vsxl_abs*)(param->module_param->vsxl_modifier);
   param->module_param->vsxl_modifier = 0;
+  invalidate_schedule();
 
   // send status to client
   cmd_out->add_raw("vsxl_pfr_ok "+c->parts[1]+" "+c->parts[2], VSX_COMMAND_GARBAGE_COLLECT);
-
-  goto process_message_queue_end;
 }
 
 #endif // NO GM
@@ -25,25 +25,25 @@
 // * fix saving / loading
 // *
 
-if (cmd == "seq_pool")
+VSX_ENGINE_COMMAND_HANDLER(seq_pool)
 {
   if (c->parts[1] == "seq_list")
   {
     cmd_out->add_raw(c->parts[0]+" "+c->parts[1]+"_ok "+sequence_pool.get_selected()->get_channel_names(), VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
 
   if (c->parts[1] == "group_list")
   {
     cmd_out->add_raw(c->parts[0]+" "+c->parts[1]+"_ok "+sequence_pool.get_selected()->group_dump_all(), VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
 
   if (c->parts[1] == "group_del")
   {
     sequence_pool.get_selected()->group_del(c->parts[2]);
     cmd_out->add_raw(c->parts[0]+" group_list_ok "+sequence_pool.get_selected()->group_dump_all(), VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -55,7 +55,7 @@ if (cmd == "seq_pool")
   if (c->parts[1] == "dump_names")
   {
     cmd_out->add_raw("seq_pool dump_names "+sequence_pool.dump_names(), VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -67,7 +67,7 @@ if (cmd == "seq_pool")
   if (c->parts[1] == "time_set_loop_point")
   {
     sequence_pool.set_loop_point(vsx_string_helper::s2f(c->parts[2]));
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -79,7 +79,7 @@ if (cmd == "seq_pool")
   {
     //printf("time_set: %f\n", vsx_string_helper::s2f(c->parts[2]));
     sequence_pool.set_time(vsx_string_helper::s2f(c->parts[2]));
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -91,7 +91,7 @@ if (cmd == "seq_pool")
   {
     sequence_pool.play();
     time_play();
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -103,7 +103,7 @@ if (cmd == "seq_pool")
     sequence_pool.stop();
     if (engine_time_from_sequence_pool)
       current_state = VSX_ENGINE_STOPPED;
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -116,7 +116,7 @@ if (cmd == "seq_pool")
     sequence_pool.rewind();
     if (engine_time_from_sequence_pool)
       current_state = VSX_ENGINE_REWIND;
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -127,7 +127,7 @@ if (cmd == "seq_pool")
   if (c->parts[1] == "propagate_time")
   {
     engine_time_from_sequence_pool = true;
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -142,7 +142,7 @@ if (cmd == "seq_pool")
     {
       cmd_out->add_raw("seq_pool dump_names "+sequence_pool.dump_names(), VSX_COMMAND_GARBAGE_COLLECT);
     }
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -161,7 +161,7 @@ if (cmd == "seq_pool")
       cmd_out->add_raw("seq_pool del "+c->parts[2], VSX_COMMAND_GARBAGE_COLLECT);
       cmd_out->add_raw("seq_pool dump_names "+sequence_pool.dump_names(), VSX_COMMAND_GARBAGE_COLLECT);
     }
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -179,7 +179,7 @@ if (cmd == "seq_pool")
     }
     else
       FAIL("Sequence Pool", "No sequence found or duplicate name!");
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -194,7 +194,7 @@ if (cmd == "seq_pool")
     {
       FAIL("Sequence Pool", "Export failed...");
     }
-    goto process_message_queue_end;
+    return;
   }
 
   // ***************************************
@@ -208,7 +208,7 @@ if (cmd == "seq_pool")
     {
       FAIL("Sequence Pool", "Import failed...");
     }
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -229,7 +229,7 @@ if (cmd == "seq_pool")
       } else
         FAIL("Sequence Pool", "No sequence pool selected!");
     }
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -242,7 +242,7 @@ if (cmd == "seq_pool")
   {
     bool value = sequence_pool.toggle_edit();
     cmd_out->add_raw("seq_pool toggle_edit "+vsx_string_helper::i2s((int)value), VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -254,7 +254,7 @@ if (cmd == "seq_pool")
   {
     bool value = vsx_string_helper::s2i(c->parts[2]) != 0;
     sequence_pool.set_play_override( value );
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -271,7 +271,7 @@ if (cmd == "seq_pool")
       cmd_out->add_raw("seq_pool clear_sequencer ", VSX_COMMAND_GARBAGE_COLLECT);
       cmd_out->add_raw("seq_pool dump_names "+sequence_pool.dump_names(), VSX_COMMAND_GARBAGE_COLLECT);
     }
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -285,7 +285,7 @@ if (cmd == "seq_pool")
       vsx_string<>a = sequence_pool.get_selected()->get_sequence_list_dump();
       cmd_out->add_raw("seq_pool "+c->parts[1]+"_ok "+a, VSX_COMMAND_GARBAGE_COLLECT);
     }
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -308,7 +308,7 @@ if (cmd == "seq_pool")
         }
       }
     }
-    goto process_message_queue_end;
+    return;
   }
 
   if (c->parts[1] == "pseq_inject_get_keyframe_at_time")
@@ -344,12 +344,12 @@ if (cmd == "seq_pool")
   if (c->parts[1] == "group_inject")
   {
     if (!sequence_pool.get_sequence_list_by_name(c->parts[2]))
-      goto process_message_queue_end;
+      return;
 
     sequence_pool.get_sequence_list_by_name(c->parts[2])->
         group_inject(c->parts[3]);
 
-    goto process_message_queue_end;
+    return;
 
   }
 
@@ -397,7 +397,7 @@ if (cmd == "seq_pool")
           if (c->parts[2] == "save")
           {
             if (c->parts.size() != 6)
-              goto process_message_queue_end;
+              return;
 
             vsx_string_helper::write_to_file(
               vsx_data_path::get_instance()->data_path_get() +  "sequences" + DIRECTORY_SEPARATOR + c->parts[5],
@@ -410,7 +410,7 @@ if (cmd == "seq_pool")
           if (c->parts[2] == "save_data")
           {
             if (c->parts.size() != 6)
-              goto process_message_queue_end;
+              return;
 
             vsx_string<> filename = vsx_data_path::get_instance()->data_path_get() +  "sequences" + DIRECTORY_SEPARATOR + c->parts[5];
 
@@ -425,7 +425,7 @@ if (cmd == "seq_pool")
           if (c->parts[2] == "group_add")
           {
             if (c->parts.size() != 6)
-              goto process_message_queue_end;
+              return;
 
             sequence_pool.get_selected()->group_add_param(c->parts[5], c->parts[3]+":"+c->parts[4]);
             cmd_out->add_raw("seq_pool pseq_p_ok group_add "+c->parts[5]+" "+c->parts[3]+" "+c->parts[4]+" "+
@@ -435,7 +435,7 @@ if (cmd == "seq_pool")
           if (c->parts[2] == "group_del_param")
           {
             if (c->parts.size() != 6)
-              goto process_message_queue_end;
+              return;
 
             sequence_pool.get_selected()->group_del_param(c->parts[5], c->parts[3]+":"+c->parts[4]);
           }
@@ -443,7 +443,7 @@ if (cmd == "seq_pool")
         }
       }
     }
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -489,8 +489,7 @@ if (cmd == "seq_pool")
         }
       }
     }
-    goto process_message_queue_end;
+    return;
   }
-  goto process_message_queue_end;
 }
 
@@ -27,37 +27,35 @@
 //++
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // PATTERN/SEQUENCE MANAGEMENT
-if (cmd == "seq_list")
+VSX_ENGINE_COMMAND_HANDLER(seq_list)
 {
   cmd_out->add_raw(c->parts[0]+"_ok "+sequence_list.get_channel_names(), VSX_COMMAND_GARBAGE_COLLECT);
-  goto process_message_queue_end;
-} else
+}
 
 
 
 
 
-if (cmd == "pseq_l_dump")
+VSX_ENGINE_COMMAND_HANDLER(pseq_l_dump)
 {
   // dump all the sequences present in the engine
   cmd_out->add_raw(c->parts[0]+"_ok "+sequence_list.get_sequence_list_dump(), VSX_COMMAND_GARBAGE_COLLECT);
-  goto process_message_queue_end;
 }
 
 
 
 
 
-if (cmd == "pseq_l_rescale_time")
+VSX_ENGINE_COMMAND_HANDLER(pseq_l_rescale_time)
 {
   // dump all the sequences present in the engine
   sequence_list.rescale_time(vsx_string_helper::s2f(c->parts[1]),vsx_string_helper::s2f(c->parts[2]));
-  goto process_message_queue_end;
 }
 
 
 
-if (cmd == "pseq_inject_get_keyframe_at_time") {
+VSX_ENGINE_COMMAND_HANDLER(pseq_inject_get_keyframe_at_time)
+{
   float time = vsx_string_helper::s2f( c->parts[1] );
   float tolerance = vsx_string_helper::s2f( c->parts[2] );
   vsx_nw_vector<vsx_engine_param* > result_params;
@@ -80,22 +78,22 @@ if (cmd == "pseq_inject_get_keyframe_at_time") {
 
 
 
-if (cmd == "pseq_p")
+VSX_ENGINE_COMMAND_HANDLER(pseq_p)
 {
   // list the params linked to sequencers
   if (c->parts[1] == "list")
   {
     sequence_list.get_sequences(cmd_out);
-    goto process_message_queue_end;
+    return;
   }
 
   vsx_comp* dest = get_component_by_name(c->parts[2]);
   if (!dest)
-    goto process_message_queue_end;
+    return;
 
   vsx_engine_param* param = dest->get_params_in()->get_by_name(c->parts[3]);
   if (!param)
-    goto process_message_queue_end;
+    return;
 
   if (c->parts[1] == "inject")
     sequence_list.inject_param(param, dest, c->parts[4]);
@@ -142,14 +140,14 @@ if (cmd == "pseq_p")
   {
     vsx_comp* dest = get_component_by_name(c->parts[2]);
     if (!dest)
-      goto process_message_queue_end;
+      return;
 
     vsx_engine_param* param = dest->get_params_in()->get_by_name(c->parts[3]);
     if (!param)
-      goto process_message_queue_end;
+      return;
 
     if (c->parts.size() != 5)
-      goto process_message_queue_end;
+      return;
 
     vsx_string_helper::write_to_file(
       vsx_data_path::get_instance()->data_path_get() +  "sequences" + DIRECTORY_SEPARATOR + c->parts[4],
@@ -157,7 +155,6 @@ if (cmd == "pseq_p")
       sequence_list.dump_param(param)
     );
   }
-  goto process_message_queue_end;
 }
 
 
@@ -165,7 +162,7 @@ if (cmd == "pseq_p")
 
 
 // PATTERN/SEQUENCE ROW MANAGEMENT
-if (cmd == "pseq_r")
+VSX_ENGINE_COMMAND_HANDLER(pseq_r)
 {
   vsx_comp* dest = get_component_by_name(c->parts[2]);
   if (dest) {
@@ -190,7 +187,6 @@ if (cmd == "pseq_r")
       }
     }
   }
-  goto process_message_queue_end;
 }
 
 
@@ -199,7 +195,7 @@ if (cmd == "pseq_r")
 // ***************************** MASTER CHANNELS *******************************
 // ***************************** MASTER CHANNELS *******************************
 // ***************************** MASTER CHANNELS *******************************
-if (cmd == "mseq_channel")
+VSX_ENGINE_COMMAND_HANDLER(mseq_channel)
 {
   if (c->parts[1] == "add")
   {
@@ -210,7 +206,7 @@ if (cmd == "mseq_channel")
     {
       FAIL("Master Sequence Channel", "There seems to already be a channel with this name!");
     }
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -227,7 +223,7 @@ if (cmd == "mseq_channel")
     {
       FAIL("Master Sequence Channel", "There is no channel by that name!");
     }
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -255,7 +251,7 @@ if (cmd == "mseq_channel")
     {
       sequence_list.time_sequence_master_channel_line(c->parts[3], cmd_out, c);
     }
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -263,7 +259,7 @@ if (cmd == "mseq_channel")
   if (c->parts[1] == "inject")
   {
     sequence_list.inject_master_channel(c->parts[2], c->parts[3]);
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -277,10 +273,8 @@ if (cmd == "mseq_channel")
     {
       cmd_out->add_raw("mseq_channel_ok inject_get "+c->parts[2]+" "+a, VSX_COMMAND_GARBAGE_COLLECT);
     }
-    goto process_message_queue_end;
+    return;
   }
-
-  goto process_message_queue_end;
 }
 
 
@@ -22,7 +22,7 @@
 */
 
 
-if (cmd == "get_module_list")
+VSX_ENGINE_COMMAND_HANDLER(get_module_list)
 {
   std::vector< vsx_module_specification* >* my_module_list = module_list->get_module_list();
 
@@ -60,14 +60,13 @@ if (cmd == "get_module_list")
   }
   cmd_out->add_raw("module_list_end", VSX_COMMAND_GARBAGE_COLLECT);
   delete my_module_list;
-  goto process_message_queue_end;
 }
 
 
 
 
 
-if (cmd == "get_list")
+VSX_ENGINE_COMMAND_HANDLER(get_list)
 {
   std::list< vsx_string<> > file_list;
   vsx_string<>path;
@@ -108,34 +107,31 @@ if (cmd == "get_list")
   }
 
   cmd_out->add_raw(c->parts[1]+"_list_end", VSX_COMMAND_GARBAGE_COLLECT);
-  goto process_message_queue_end;
 }
 
 
 
 
-if (cmd == "get_state")
+VSX_ENGINE_COMMAND_HANDLER(get_state)
 {
   send_state_to_client(cmd_out);
-  goto process_message_queue_end;
 }
 
 
 
 
 
-if (cmd == "undo_s")
+VSX_ENGINE_COMMAND_HANDLER(undo_s)
 {
   vsx_command_list* savelist = new vsx_command_list(true);
   get_state_as_commandlist(*savelist);
   undo_buffer.push_back(savelist);
-  goto process_message_queue_end;
 }
 
 
 
 
-if (cmd == "undo")
+VSX_ENGINE_COMMAND_HANDLER(undo)
 {
   vsx_string<>error_string;
   if (undo_buffer.size())
@@ -146,7 +142,61 @@ if (cmd == "undo")
     delete source;
     undo_buffer.reset_used(undo_buffer.size()-1);
   }
-  goto process_message_queue_end;
+}
+
+
+
+
+// engine_trace [1|0] - start or stop recording engine spans with the profiler
+VSX_ENGINE_COMMAND_HANDLER(engine_trace)
+{
+  if (c->parts.size() == 2)
+  {
+    if (c->parts[1] == "1" && !get_trace_enabled())
+      trace_start();
+
+    if (c->parts[1] == "0" && get_trace_enabled())
+      trace_stop();
+  }
+  cmd_out->add_raw(vsx_string<>("engine_trace_ok ") + (get_trace_enabled() ? "1" : "0"), VSX_COMMAND_GARBAGE_COLLECT);
+}
+
+
+
+// command_stats [reset] - count, total and max time (ms) and the time histogram
+// (see vsx_engine_command_handler) of every command handled so far
+VSX_ENGINE_COMMAND_HANDLER(command_stats)
+{
+  if (c->parts.size() == 2 && c->parts[1] == "reset")
+  {
+    foreach (command_handlers, i)
+      command_handlers[i].reset();
+    return;
+  }
+
+  foreach (command_handlers, i)
+  {
+    vsx_engine_command_handler& handler = command_handlers[i];
+    req_continue(handler.count);
+
+    vsx_string<> histogram;
+    for (size_t j = 0; j < VSX_ENGINE_COMMAND_HISTOGRAM_SIZE; j++)
+    {
+      if (j)
+        histogram.push_back(',');
+      histogram += vsx_string_helper::i2s((int)handler.histogram[j]);
+    }
+
+    cmd_out->add_raw(
+      "command_stats_ok " +
+      handler.name + " " +
+      vsx_string_helper::i2s((int)handler.count) + " " +
+      vsx_string_helper::f2s((float)(handler.time_total * 1000.0), 6) + " " +
+      vsx_string_helper::f2s((float)(handler.time_max * 1000.0), 6) + " " +
+      histogram,
+      VSX_COMMAND_GARBAGE_COLLECT
+    );
+  }
 }
 
 
@@ -155,7 +205,7 @@ if (cmd == "undo")
 // This command is primarily used by server.
 // All other implementations should catch this command before it reaches the server
 // and do proper cleanup.
-if (cmd == "system.shutdown")
+VSX_ENGINE_COMMAND_HANDLER(system_shutdown)
 {
   stop();
   exit(0);
@@ -25,10 +25,9 @@
 // Set time loop point
 // ***************************************
 // 0=time_set_loop_point 1=[time:float]
-if (cmd == "time_set_loop_point")
+VSX_ENGINE_COMMAND_HANDLER(time_set_loop_point)
 {
   loop_point_end = vsx_string_helper::s2f(c->parts[1]);
-  goto process_message_queue_end;
 }
 
 
@@ -37,61 +36,54 @@ if (cmd == "time_set_loop_point")
 // Set Time Progression Factor (Speed)
 // ***************************************
 // 0=seq_pool 1=time_set_loop_point 2=[time:float]
-if (cmd == "time_set_speed")
+VSX_ENGINE_COMMAND_HANDLER(time_set_speed)
 {
   // sanity
   if ( c->parts.size() <= 1 )
-    goto process_message_queue_end;
+    return;
 
   set_speed( vsx_string_helper::s2f(c->parts[1]) );
-
-  goto process_message_queue_end;
 }
 
 
 
 
-if (cmd == "play")
+VSX_ENGINE_COMMAND_HANDLER(play)
 {
   time_play();
-  goto process_message_queue_end;
 }
 
 
 
-if (cmd == "stop")
+VSX_ENGINE_COMMAND_HANDLER(stop)
 {
   current_state = VSX_ENGINE_STOPPED;
-  goto process_message_queue_end;
 }
 
 
 
-if (cmd == "rewind")
+VSX_ENGINE_COMMAND_HANDLER(rewind)
 {
   current_state = VSX_ENGINE_REWIND;
-  goto process_message_queue_end;
 }
 
 
 
-if (cmd == "fps_d" || cmd == "fps")
+VSX_ENGINE_COMMAND_HANDLER(fps)
 {
   cmd_out->add_raw("fps_d " + vsx_string_helper::f2s((float)frame_delta_fps), VSX_COMMAND_GARBAGE_COLLECT);
-  goto process_message_queue_end;
 }
 
 
 
 
-if (cmd == "time_set")
+VSX_ENGINE_COMMAND_HANDLER(time_set)
 {
   float dd = engine_info.vtime - vsx_string_helper::s2f(c->parts[1]);
   if (dd > 0.0f)
   {
     engine_info.dtime = -dd;
-    goto process_message_queue_end;
+    return;
   }
   engine_info.dtime = fabs(dd);
-  goto process_message_queue_end;
 }
@@ -22,7 +22,7 @@
 */
 
 
-if (cmd == "note_create")
+VSX_ENGINE_COMMAND_HANDLER(note_create)
 {
   static unsigned long note_counter = 0;
   c->parts[1] = "n"+vsx_string_helper::i2s(note_counter);
@@ -33,31 +33,28 @@ if (cmd == "note_create")
     note_map[c->parts[1]] = new_note;
     cmd_out->add_raw(new_note.serialize(), VSX_COMMAND_GARBAGE_COLLECT);
   }
-  goto process_message_queue_end;
 }
 
 
 
 
-if (cmd == "note_update")
+VSX_ENGINE_COMMAND_HANDLER(note_update)
 {
   vsx_note new_note;
   if (new_note.set(c))
   {
     note_map[c->parts[1]] = new_note;
   }
-  goto process_message_queue_end;
 }
 
 
 
 
-if (cmd == "note_delete")
+VSX_ENGINE_COMMAND_HANDLER(note_delete)
 {
   note_iter = note_map.find(c->parts[1]);
   if (note_iter != note_map.end()) {
     note_map.erase(c->parts[1]);
     cmd_out->add_raw("note_delete_ok "+c->parts[1], VSX_COMMAND_GARBAGE_COLLECT);
   }
-  goto process_message_queue_end;
 }
@@ -24,7 +24,7 @@
 
 
 
-if ( cmd == "help" )
+VSX_ENGINE_COMMAND_HANDLER(help_param_set)
 {
   forever
   {
@@ -52,7 +52,7 @@ if ( cmd == "help" )
 }
 
 
-if (cmd == "param_set")
+VSX_ENGINE_COMMAND_HANDLER(param_set)
 {
   // this is for float3 and such where multiple arity values have to be set in one command.
   // as the last argument is a comma-separated list of values the character "," is banned
@@ -63,7 +63,7 @@ if (cmd == "param_set")
   if (c->parts.size() != 4)
   {
     cmd_out->add_raw("alert_fail " + vsx_string_helper::base64_encode(c->raw) + " Error " + vsx_string_helper::base64_encode("Wrong number of arguments for param_set"), VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
 
   vsx_comp* dest = get_component_by_name(c->parts[1]);
@@ -77,7 +77,6 @@ if (cmd == "param_set")
       }
     }
   }
-  goto process_message_queue_end;
 }
 
 
@@ -89,11 +88,11 @@ if (cmd == "param_set")
 
 
 
-if (cmd == "pa_ren")
+VSX_ENGINE_COMMAND_HANDLER(pa_ren)
 {
   vsx_comp* dest = get_component_by_name(c->parts[1]);
   if (!dest)
-    goto process_message_queue_end;
+    return;
 
   bool ok;
   if (c->parts[4] == "-1") {
@@ -105,7 +104,6 @@ if (cmd == "pa_ren")
     cmd_out->add_raw("pa_ren_ok "+c->parts[1]+" "+c->parts[2]+" "+c->parts[3]+" "+c->parts[4], VSX_COMMAND_GARBAGE_COLLECT);
   else
     cmd_out->add_raw("alert_fail "+vsx_string_helper::base64_encode(c->raw)+" Error "+vsx_string_helper::base64_encode("Either param is not alias, was changed by someone else on this server or other error."), VSX_COMMAND_GARBAGE_COLLECT);
-  goto process_message_queue_end;
 }
 
 
@@ -113,16 +111,16 @@ if (cmd == "pa_ren")
 
 
 
-if (cmd == "param_get" || cmd == "pgo")
+VSX_ENGINE_COMMAND_HANDLER(param_get)
 {
   // syntax:
   //  param_get [component] [param] [extra_info]
   if (!(c->parts.size() >= 3))
-    goto process_message_queue_end;
+    return;
 
   vsx_comp* dest = get_component_by_name(c->parts[1]);
   if (!dest)
-    goto process_message_queue_end;
+    return;
 
   vsx_engine_param* param;
 
@@ -132,13 +130,13 @@ if (cmd == "param_get" || cmd == "pgo")
     param = dest->get_params_in()->get_by_name(c->parts[2]);
 
   if (!param)
-    goto process_message_queue_end;
+    return;
 
   vsx_string<>_value = param->get_string();
 
 
   if (!_value.size())
-    goto process_message_queue_end;
+    return;
 
   if (_value.size() > 1000)
     _value = _value.substr(0,1000)+"...";
@@ -152,8 +150,6 @@ if (cmd == "param_get" || cmd == "pgo")
   // syntax:
   //  param_get_ok [component] [param] [value] [extra_info]
   cmd_out->add_raw("param_get_ok "+c->parts[1]+" "+c->parts[2]+" "+value+extra, VSX_COMMAND_GARBAGE_COLLECT);
-
-  goto process_message_queue_end;
 }
 
 
@@ -162,7 +158,7 @@ if (cmd == "param_get" || cmd == "pgo")
 
 
 
-if (cmd == "pg64")
+VSX_ENGINE_COMMAND_HANDLER(pg64)
 {
   // syntax:
   //  param_get [component] [param] [extra_info]
@@ -182,7 +178,6 @@ if (cmd == "pg64")
       }
     }
   }
-  goto process_message_queue_end;
 }
 
 
@@ -192,7 +187,7 @@ if (cmd == "pg64")
 
 
 
-if (cmd == "ps64")
+VSX_ENGINE_COMMAND_HANDLER(ps64)
 {
   // syntax:
   //  param_set [component] [param] [value]
@@ -212,7 +207,6 @@ if (cmd == "ps64")
     }
     else cmd_out->add_raw("alert_fail " + vsx_string_helper::base64_encode(c->raw)+" Error " + vsx_string_helper::base64_encode("Component "+c->parts[1]+" does not exist!"), VSX_COMMAND_GARBAGE_COLLECT);
   }
-  goto process_message_queue_end;
 }
 
 
@@ -221,7 +215,7 @@ if (cmd == "ps64")
 
 
 
-if (cmd == "ps")
+VSX_ENGINE_COMMAND_HANDLER(ps)
 {
   // syntax:
   //  ps [component] [param] [value]
@@ -241,12 +235,11 @@ if (cmd == "ps")
     }
     else cmd_out->add_raw("alert_fail " + vsx_string_helper::base64_encode(c->raw)+" Error " + vsx_string_helper::base64_encode("Component "+c->parts[1]+" does not exist!"), VSX_COMMAND_GARBAGE_COLLECT);
   }
-  goto process_message_queue_end;
 }
 
 
 
-if ( cmd == "help" )
+VSX_ENGINE_COMMAND_HANDLER(help_param_clone_value)
 {
   forever
   {
@@ -269,7 +262,7 @@ if ( cmd == "help" )
 }
 
 
-if ( cmd == "param_clone_value" )
+VSX_ENGINE_COMMAND_HANDLER(param_clone_value)
 {
   // To copy a value internally in the engine between 2 modules' parameters.
   // Will only work if they are the same type...
@@ -281,7 +274,7 @@ if ( cmd == "param_clone_value" )
   if (c->parts.size() != 5)
   {
     cmd_out->add_raw("alert_fail " + vsx_string_helper::base64_encode(c->raw) + " Error " + vsx_string_helper::base64_encode("Wrong number of arguments for param_clone_value") , VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -290,7 +283,7 @@ if ( cmd == "param_clone_value" )
   if (!source_component)
   {
     cmd_out->add_raw("alert_fail " + vsx_string_helper::base64_encode(c->raw) + " Error " + vsx_string_helper::base64_encode("Source module does not exist") , VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -299,7 +292,7 @@ if ( cmd == "param_clone_value" )
   if (!source_parameter)
   {
     cmd_out->add_raw("alert_fail " + vsx_string_helper::base64_encode(c->raw) + " Error " + vsx_string_helper::base64_encode("Source parameter does not exist") , VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -308,7 +301,7 @@ if ( cmd == "param_clone_value" )
   if (!destination_component)
   {
     cmd_out->add_raw("alert_fail " + vsx_string_helper::base64_encode(c->raw) + " Error " + vsx_string_helper::base64_encode("Destination module does not exist") , VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
 
 
@@ -317,14 +310,14 @@ if ( cmd == "param_clone_value" )
   if (!destination_parameter)
   {
     cmd_out->add_raw("alert_fail " + vsx_string_helper::base64_encode(c->raw) + " Error " + vsx_string_helper::base64_encode("Destination parameter does not exist") , VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
 
   // 6. make sure both are of same type
   if (source_parameter->module_param->type != destination_parameter->module_param->type)
   {
     cmd_out->add_raw("alert_fail " + vsx_string_helper::base64_encode(c->raw) + " Error " + vsx_string_helper::base64_encode("Parameter type mismatch") , VSX_COMMAND_GARBAGE_COLLECT);
-    goto process_message_queue_end;
+    return;
   }
 
   // 7. everything should be OK and ready for copying
@@ -340,9 +333,6 @@ if ( cmd == "param_clone_value" )
   {
     redeclare_in_params(destination_component, cmd_out);
   }
-
-
-  goto process_message_queue_end;
 }
 
 
@@ -355,7 +345,7 @@ if ( cmd == "param_clone_value" )
 
 
 
-if (cmd == "param_set_interpolate")
+VSX_ENGINE_COMMAND_HANDLER(param_set_interpolate)
 {
   // this is for float3 and such where multiple arity values have to be set in one command.
   // as the last argument is a comma-separated list of values the character "," is banned
@@ -389,7 +379,6 @@ if (cmd == "param_set_interpolate")
       } else cmd_out->add_raw("alert_fail " + vsx_string_helper::base64_encode(c->raw) + " Error " + vsx_string_helper::base64_encode("Param does not exist!"), VSX_COMMAND_GARBAGE_COLLECT);
     }
   }
-  goto process_message_queue_end;
 }
 
 
@@ -399,23 +388,21 @@ if (cmd == "param_set_interpolate")
 
 
 
-if (cmd == "param_set_default")
+VSX_ENGINE_COMMAND_HANDLER(param_set_default)
 {
   vsx_comp* dest = get_component_by_name(c->parts[1]);
 
   // sanity
   if (!dest)
-    goto process_message_queue_end;
+    return;
 
   vsx_module_param_abs* param = dest->get_params_in()->get_by_name(c->parts[2])->module_param;
 
   // sanity
   if (!param)
-    goto process_message_queue_end;
+    return;
 
   param->set_default();
-
-  goto process_message_queue_end;
 }
 
 
@@ -431,7 +418,7 @@ if (cmd == "param_set_default")
 //  pflag [component] [parameter] [key] [value]
 // example:
 //  pflag simple angle external_expose 1
-if (cmd == "pflag")
+VSX_ENGINE_COMMAND_HANDLER(pflag)
 {
   vsx_comp* dest = get_component_by_name(c->parts[1]);
   if (dest)
@@ -445,7 +432,6 @@ if (cmd == "pflag")
       }
     }
   }
-  goto process_message_queue_end;
 }
 
 
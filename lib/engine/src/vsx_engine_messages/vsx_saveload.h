@@ -23,7 +23,7 @@
 
 
 
-if (cmd == "state_load")
+VSX_ENGINE_COMMAND_HANDLER(state_load)
 {
   vsx_string<>base_path = vsx_data_path::get_instance()->data_path_get();
 
@@ -36,57 +36,54 @@ if (cmd == "state_load")
   {
     cmd_out->add_raw("clear_ok", VSX_COMMAND_GARBAGE_COLLECT);
   }
-  goto process_message_queue_end;
 }
 
 
 
-if (cmd == "state_load_done")
+VSX_ENGINE_COMMAND_HANDLER(state_load_done)
 {
   commands_out_cache.add_raw("state_load_ok "+state_name, true);
   send_state_to_client(&commands_out_cache);
-  goto process_message_queue_end;
 }
 
 
 // deletes every single component in the whole engine
-if (cmd == "clear")
+VSX_ENGINE_COMMAND_HANDLER(clear)
 {
   i_clear(&commands_out_cache, false, true);
   cmd_out->add_raw(cmd+"_ok "+cmd_data, VSX_COMMAND_GARBAGE_COLLECT);
-  goto process_message_queue_end;
 }
 
 
 
-if (cmd == "meta_set") {
+VSX_ENGINE_COMMAND_HANDLER(meta_set)
+{
   meta_information = vsx_string_helper::base64_decode(c->parts[1]);
   vsx_string<>deli("|");
   vsx_string_helper::explode(meta_information, deli, meta_fields);
-  goto process_message_queue_end;
 }
 
 
 
-if (cmd == "meta_get") {
+VSX_ENGINE_COMMAND_HANDLER(meta_get)
+{
   cmd_out->add_raw("meta_get_ok "+vsx_string_helper::base64_encode(meta_information), VSX_COMMAND_GARBAGE_COLLECT);
-  goto process_message_queue_end;
 }
 
 
 
-if (cmd == "set_silent") {
+VSX_ENGINE_COMMAND_HANDLER(set_silent)
+{
   if (c->parts[1] == "1")
   cmd_out->set_accept_commands(0);
   else
   if (c->parts[1] == "0")
   cmd_out->set_accept_commands(1);
-  goto process_message_queue_end;
 }
 
 
 
-if (cmd == "package_export")
+VSX_ENGINE_COMMAND_HANDLER(package_export)
 {
   if (filesystem.get_archive()->is_archive())
   {
@@ -134,12 +131,11 @@ if (cmd == "package_export")
     cmd_out->add_raw(vsx_string<>(cmd+"_ok ")+c->parts[1], VSX_COMMAND_GARBAGE_COLLECT);
     archive.close();
   }
-  goto process_message_queue_end;
 }
 
 
 
-if (cmd == "state_save")
+VSX_ENGINE_COMMAND_HANDLER(state_save)
 {
   if (filesystem.get_archive()->is_archive())
   {
@@ -163,5 +159,4 @@ if (cmd == "state_save")
     cmd_out->add_raw("states_list "+s2, VSX_COMMAND_GARBAGE_COLLECT);
     cmd_out->add_raw("states_list_end", VSX_COMMAND_GARBAGE_COLLECT);
   }
-  goto process_message_queue_end;
 }
@@ -0,0 +1,152 @@
+/**
+* Project: VSXu Engine: Realtime modular visual programming engine.
+*
+* This file is part of Vovoid VSXu Engine.
+*
+* @author Jonatan Wallmander, Robert Wenzel, Vovoid Media Technologies AB Copyright (C) 2003-2013
+* @see The GNU Lesser General Public License (LGPL)
+*
+* VSXu Engine is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include <tools/vsx_foreach.h>
+#include "vsx_engine.h"
+#include <internal/vsx_comp_channel.h>
+#include <internal/vsx_param_abstraction.h>
+#include <internal/vsx_engine_plan.h>
+#include <internal/vsx_engine_trace.h>
+
+void vsx_engine_plan::compile(vsx_comp* comp)
+{
+  if (visited.find(comp) != visited.end())
+    return;
+  visited.insert(comp);
+
+  // operations belonging to this component, nested sources have their own
+  std::vector<size_t> own;
+
+  own.push_back(operations.size());
+  operations.push_back( operation{ comp_begin, comp, 0x0, 0 } );
+
+  foreach (comp->channels, i)
+  {
+    vsx_channel* channel = comp->channels[i];
+
+    if (channel->connections.size() && channel->my_param->module_param->run_activate_offscreen)
+    {
+      own.push_back(operations.size());
+      operations.push_back( operation{ channel_activate, comp, channel, 0 } );
+    }
+
+    // render channels leave tunnels to be prepared when they're run
+    bool render = channel->type == VSX_MODULE_PARAM_ID_RENDER;
+    foreach (channel->connections, j)
+    {
+      vsx_comp* source = channel->connections[j]->src_comp;
+      if (render && source->module_info->tunnel)
+        continue;
+      compile(source);
+    }
+
+    own.push_back(operations.size());
+    operations.push_back( operation{ channel_execute, comp, channel, 0 } );
+  }
+
+  own.push_back(operations.size());
+  operations.push_back( operation{ comp_end, comp, 0x0, 0 } );
+
+  foreach (own, i)
+    operations[own[i]].skip_to = operations.size();
+}
+
+void vsx_engine_plan::collect(vsx_comp* comp)
+{
+  if (reachable.find(comp) != reachable.end())
+    return;
+  reachable.insert(comp);
+  components.push_back(comp);
+
+  foreach (comp->channels, i)
+    foreach (comp->channels[i]->connections, j)
+      collect(comp->channels[i]->connections[j]->src_comp);
+}
+
+void vsx_engine_plan::rebuild(vsx_nw_vector<vsx_comp*>& outputs)
+{
+  operations.clear();
+  components.clear();
+
+  foreach (outputs, i)
+  {
+    compile(outputs[i]);
+    collect(outputs[i]);
+  }
+
+  visited.clear();
+  reachable.clear();
+  dirty = false;
+}
+
+void vsx_engine_plan::run(vsx_nw_vector<vsx_comp*>& outputs)
+{
+  if (dirty)
+    rebuild(outputs);
+
+  size_t count = operations.size();
+  size_t i = 0;
+  while (i < count)
+  {
+    operation& op = operations[i];
+    switch (op.type)
+    {
+      case comp_begin:
+        if (!op.comp->prepare_begin())
+        {
+          i = op.skip_to;
+          continue;
+        }
+        break;
+
+      case channel_activate:
+        if (!op.channel->activate())
+        {
+          op.comp->prepare_failed();
+          i = op.skip_to;
+          continue;
+        }
+        break;
+
+      case channel_execute:
+      {
+        vsx_profiler* trace = vsx_engine_trace::begin(op.comp->name, op.channel->my_param->name);
+        bool executed = op.channel->execute_sources();
+        vsx_engine_trace::end(trace);
+        if (!executed)
+        {
+          op.comp->prepare_failed();
+          i = op.skip_to;
+          continue;
+        }
+        op.comp->prepare_channel_done(op.channel);
+        break;
+      }
+
+      case comp_end:
+        op.comp->prepare_end();
+        break;
+    }
+    ++i;
+  }
+}
@@ -0,0 +1,155 @@
+/**
+* Project: VSXu Engine: Realtime modular visual programming engine.
+*
+* This file is part of Vovoid VSXu Engine.
+*
+* @author Jonatan Wallmander, Robert Wenzel, Vovoid Media Technologies AB Copyright (C) 2003-2013
+* @see The GNU Lesser General Public License (LGPL)
+*
+* VSXu Engine is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include <future>
+#include <tools/vsx_thread_pool.h>
+#include <tools/vsx_foreach.h>
+#include "vsx_engine.h"
+#include <internal/vsx_comp_channel.h>
+#include <internal/vsx_param_abstraction.h>
+#include <internal/vsx_engine_scheduler.h>
+
+bool vsx_engine_scheduler::is_thread_safe(vsx_comp* comp)
+{
+  if (!comp->module)
+    return false;
+
+  if (!comp->module_info->thread_safe)
+    return false;
+
+  // tunnels are re-run once per consumer, outputs drive the render thread
+  if (comp->module_info->tunnel || comp->module_info->output)
+    return false;
+
+  // the script machine is shared by the whole engine
+  if (comp->vsxl_modifier)
+    return false;
+
+  foreach (comp->channels, i)
+    if (comp->channels[i]->my_param->module_param->vsxl_modifier)
+      return false;
+
+  return true;
+}
+
+bool vsx_engine_scheduler::visit(vsx_comp* comp)
+{
+  int state = visit_state[comp];
+  if (state == 2)
+    return true;
+
+  // state 1 means we've hit a cycle, don't try to schedule any part of it
+  if (state == 1 || state == 3)
+    return false;
+
+  visit_state[comp] = 1;
+
+  bool schedulable = is_thread_safe(comp);
+  size_t level = 0;
+
+  // always walk all the way up, there might be schedulable sub-graphs behind
+  // a GL-bound component
+  foreach (comp->channels, i)
+  {
+    vsx_channel* channel = comp->channels[i];
+    foreach (channel->connections, j)
+    {
+      vsx_comp* source = channel->connections[j]->src_comp;
+      if (!visit(source))
+      {
+        schedulable = false;
+        continue;
+      }
+      if (comp_level[source] + 1 > level)
+        level = comp_level[source] + 1;
+    }
+  }
+
+  visit_state[comp] = schedulable ? 2 : 3;
+
+  if (!schedulable)
+    return false;
+
+  comp_level[comp] = level;
+  if (levels.size() <= level)
+    levels.resize(level + 1);
+  levels[level].push_back(comp);
+  return true;
+}
+
+size_t vsx_engine_scheduler::get_num_scheduled()
+{
+  size_t count = 0;
+  foreach (levels, i)
+    count += levels[i].size();
+  return count;
+}
+
+void vsx_engine_scheduler::rebuild(vsx_nw_vector<vsx_comp*>& outputs)
+{
+  levels.clear();
+  visit_state.clear();
+  comp_level.clear();
+
+  // only components reachable from the outputs are ever pulled by render()
+  foreach (outputs, i)
+    visit(outputs[i]);
+
+  visit_state.clear();
+  comp_level.clear();
+  dirty = false;
+}
+
+void vsx_engine_scheduler::run(vsx_nw_vector<vsx_comp*>& outputs)
+{
+  if (dirty)
+    rebuild(outputs);
+
+  std::vector< std::future<bool> > results;
+
+  foreach (levels, i)
+  {
+    std::vector<vsx_comp*>& level = levels[i];
+
+    // everything in a level depends only on earlier levels; hand out all but
+    // the first component to the pool and let the render thread do its share
+    results.clear();
+    for_n (j, 1, level.size())
+    {
+      vsx_comp* comp = level[j];
+      results.push_back(
+        vsx_thread_pool<>::instance()->add(
+          [comp]()
+          {
+            return comp->prepare_and_run();
+          }
+        )
+      );
+    }
+
+    level[0]->prepare_and_run();
+
+    foreach (results, j)
+      results[j].wait();
+  }
+}
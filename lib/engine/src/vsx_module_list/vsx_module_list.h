@@ -26,14 +26,17 @@
 
 #include <map>
 #include <vector>
+#include <mutex>
 #include <string/vsx_string.h>
 #include <vsx_param.h>
 #include <module/vsx_module.h>
 #include <filesystem/vsx_filesystem_helper.h>
+#include <vsx_data_path.h>
 
 #include "vsx_dlopen.h"
 #include "vsx_module_list_abs.h"
 #include "vsx_module_plugin_info.h"
+#include "vsx_module_plugin_manifest.h"
 
 
 #include "vsx_dlopen.h"
@@ -44,7 +47,222 @@
 class vsx_module_list : public vsx_module_list_abs
 {
 private:
-  std::vector< vsx_dynamic_object_handle > plugin_handles;
+
+  class plugin
+  {
+  public:
+    vsx_string<> filename;
+    vsx_dynamic_object_handle handle = 0x0;
+    bool load_attempted = false;
+
+    vsx_module*(*create_new_module)(unsigned long, void*) = 0x0;
+    void(*destroy_module)(vsx_module*,unsigned long) = 0x0;
+    unsigned long(*get_num_modules)(vsx_module_engine_environment*) = 0x0;
+
+    // from get_num_modules, which is called once per load
+    unsigned long module_count = 0;
+  };
+
+  std::vector< plugin* > plugins;
+
+  // plugins are loaded on demand from whichever thread creates a module;
+  // loading, constructing and destroying modules are all done under this
+  std::mutex plugins_lock;
+
+  // set up engine environment for later use (directories in which modules can look for config)
+  vsx_module_engine_environment engine_environment;
+
+  vsx_string<> get_manifest_filename()
+  {
+    if (vsx_argvector::get_instance()->has_param("no_plugin_cache"))
+      return "";
+    if (!vsx_data_path::get_instance()->data_path_get().size())
+      return "";
+    return vsx_data_path::get_instance()->data_path_get() + "plugin_manifest.cache";
+  }
+
+  // dlopen the plugin and look up its factory methods, only tried once
+  bool plugin_load(plugin* p)
+  {
+    if (p->load_attempted)
+      return p->create_new_module != 0x0;
+    p->load_attempted = true;
+
+    // load the plugin
+    p->handle = vsx_dlopen::open( p->filename.c_str() );
+
+    // if loading fails, print debug output
+    if (!p->handle) {
+      vsx_printf(
+            L"vsx_module_list init: Error: trying to load the plugin \"%s\"\n"
+            "                      Cause: dlopen returned error: %s\n",
+            p->filename.c_str(),
+            vsx_dlopen::error()
+      );
+      return false;
+    }
+
+    //-------------------------------------------------------------------------
+    // look for the REQUIRED constructor (factory) method
+    if (vsx_dlopen::sym(p->handle, "create_new_module") == 0)
+    {
+      vsx_printf(
+            L"vsx_module_list init: Error: trying to load the plugin \"%s\"\n"
+            "                      Cause: sym could not find \"create_module\"\n",
+            p->filename.c_str()
+            );
+      return false;
+    }
+
+    //-------------------------------------------------------------------------
+    // look for the REQUIRED destructor method
+    if (vsx_dlopen::sym(p->handle, "destroy_module") == 0)
+    {
+      vsx_printf(
+            L"vsx_module_list init: Error: trying to load the plugin \"%s\"\n"
+            "                      Cause: sym could not find \"destroy_module\"\n",
+            p->filename.c_str()
+            );
+      return false;
+    }
+
+    //-------------------------------------------------------------------------
+    // look for the REQUIRED get_num_modules method
+    if (vsx_dlopen::sym(p->handle, "get_num_modules") == 0)
+    {
+      vsx_printf(
+            L"vsx_module_list init: Error: trying to load the plugin \"%s\"\n"
+            "                      Cause: sym could not find \"get_num_modules\"\n",
+            p->filename.c_str()
+            );
+      return false;
+    }
+
+    p->destroy_module =
+        (void(*)(vsx_module*,unsigned long))
+        vsx_dlopen::sym( p->handle, "destroy_module" );
+
+    p->get_num_modules =
+        (unsigned long(*)(vsx_module_engine_environment*))
+        vsx_dlopen::sym( p->handle, "get_num_modules" );
+
+    // plugins set themselves up here (render.glsl lists its shaders, glewInit
+    // per DLL on windows), also when registered from the manifest
+    p->module_count = p->get_num_modules(&engine_environment);
+
+    // set last, marks the plugin as usable
+    p->create_new_module =
+        (vsx_module*(*)(unsigned long, void*))
+        vsx_dlopen::sym( p->handle, "create_new_module" );
+
+    return true;
+  }
+
+  // instantiate every module in the plugin to ask for its specification
+  void plugin_probe(plugin* p, vsx_module_plugin_manifest::plugin_entry& entry)
+  {
+    // get the number of modules in this plugin
+    unsigned long num_modules_in_this_plugin = p->module_count;
+
+    // iterate through modules in this plugin
+    for (
+         size_t module_index_iterator = 0;
+         module_index_iterator < num_modules_in_this_plugin;
+         module_index_iterator++
+    )
+    {
+      // ask the constructor / factory to create a module instance for us
+      vsx_module* module_object =
+          p->create_new_module(module_index_iterator, (void*)vsx_argvector::get_instance() );
+      // check for error
+      if (0x0 == module_object)
+      {
+        vsx_printf(
+              L"vsx_module_list init: Error: trying to load the plugin \"%s\"\n"
+              "                      Cause: create_new_module returned 0x0 for module_index_iterator %lx\n"
+              "                      Hint: If you are developing, check to see that get_num_modules returns\n"
+              "                            the correct module count!\n"
+              ,
+              p->filename.c_str(),
+              module_index_iterator
+              );
+        continue; // try to load the next module
+      }
+
+      // ask the module to provide its module info
+      vsx_module_plugin_manifest::module_entry module_entry;
+      module_entry.module_index = (uint32_t)module_index_iterator;
+      module_object->module_info( &module_entry.specification );
+
+      // check to see if this module can run on this system
+      bool can_run = module_object->can_run();
+
+      p->destroy_module( module_object, module_index_iterator );
+
+      if (!can_run) continue; // try to load the next module
+
+      entry.modules.push_back(module_entry);
+    }
+  }
+
+  void register_module(size_t plugin_index, unsigned long module_index, vsx_module_specification& specification)
+  {
+    vsx_module_specification* module_info = new vsx_module_specification;
+    *module_info = specification;
+    module_info->location = "external";
+
+    // create module_plugin_info template
+    vsx_module_plugin_info module_plugin_info_template;
+
+    module_plugin_info_template.plugin_index = plugin_index;
+    module_plugin_info_template.module_id = module_index;
+
+    // split the module identifier string into its individual names
+    // a module can have multiple names (and locations in the gui tree)
+    // some of these are hidden, thus the name begins with an exclamation mark - !
+    // example module identifier string:
+    //   examples;my_modules;my_module||!old_path;old_category;old_name
+    // Only the first will show up in the gui. The second identifier is still usable in
+    // old state files.
+    vsx_string<>deli = "||";
+    vsx_nw_vector< vsx_string<> > parts;
+    vsx_string_helper::explode(module_info->identifier, deli, parts);
+    vsx_module_plugin_info* applied_plugin_info = 0;
+
+    // iterate through the individual names for this module
+    for (unsigned long i = 0; i < parts.size(); ++i)
+    {
+      // create a copy of the template
+      applied_plugin_info = new vsx_module_plugin_info;
+      *applied_plugin_info = module_plugin_info_template;
+      vsx_module_specification* applied_module_info = new vsx_module_specification;
+      *applied_module_info = *module_info;
+      applied_plugin_info->module_info = applied_module_info;
+
+
+      vsx_string<>module_identifier;
+      if (parts[i][0] == '!')
+      {
+        // hidden from gui
+        applied_plugin_info->hidden_from_gui = true;
+        module_identifier = parts[i].substr(1);
+      } else
+      {
+        // normal
+        applied_plugin_info->hidden_from_gui = false;
+        module_identifier = parts[i];
+      }
+      // set module info identifier
+      applied_module_info->identifier = module_identifier;
+      // add the applied_plugin_info to module_plugin_list
+      module_plugin_list[module_identifier] = applied_plugin_info;
+
+      // add the module info to the module list
+      module_list[module_identifier] = module_info;
+    } // iterate through the individual names for this module
+    module_infos.push_back(module_info);
+  }
+
 public:
   void init(void* extra_modules = 0x0)
   {
@@ -55,12 +273,6 @@ public:
     if (module_list.size())
       return;
 
-    // statistics counter - how many modules are loaded in total?
-    //unsigned long total_num_modules = 0;
-
-
-    // set up engine environment for later use (directories in which modules can look for config)
-    vsx_module_engine_environment engine_environment;
     engine_environment.engine_parameter[0] = PLATFORM_SHARED_FILES+"plugin-config/";
 
     // recursively find the plugin so's from the plugins directory
@@ -78,206 +290,77 @@ public:
     );
     //-------------------------------------------------------------------------
 
-    //-------------------------------------------------------------------------
-    // Iterate through all the filenames, treat them as plugins with dlopen
-    // and probe them to see if they are vsxu modules.
-    for (std::list< vsx_string<> >::iterator it = mfiles.begin(); it != mfiles.end(); ++it)
-    {
-      vsx_string<>dynamic_object_file_name = (*it);
-      //vsx_nw_vector< vsx_string<> > parts;
-      vsx_dynamic_object_handle plugin_handle;
-
-      // load the plugin
-      plugin_handle = vsx_dlopen::open(
-            dynamic_object_file_name.c_str()
-      );
-
-      // if loading fails, print debug output
-      if (!plugin_handle) {
-        vsx_printf(
-              L"vsx_module_list init: Error: trying to load the plugin \"%s\"\n"
-              "                      Cause: dlopen returned error: %s\n",
-              dynamic_object_file_name.c_str(),
-              vsx_dlopen::error()
-        );
-        continue; // try to load the next plugin
-      }
-
-      // add this module handle to our list of module handles
-      plugin_handles.push_back(plugin_handle);
+    // specifications from the last run
+    vsx_string<> manifest_filename = get_manifest_filename();
+    vsx_module_plugin_manifest manifest;
+    if (manifest_filename.size())
+      manifest.load(manifest_filename);
 
+    vsx_module_plugin_manifest updated_manifest;
+    bool manifest_changed = false;
 
-      //-------------------------------------------------------------------------
-      // look for the REQUIRED constructor (factory) method
-      if (vsx_dlopen::sym(plugin_handle, "create_new_module") == 0)
-      {
-        vsx_printf(
-              L"vsx_module_list init: Error: trying to load the plugin \"%s\"\n"
-              "                      Cause: sym could not find \"create_module\"\n",
-              dynamic_object_file_name.c_str()
-              );
-        continue; // try to load the next plugin
-      }
-      // initialize constructor (factory) method
-      vsx_module*(*create_new_module)(unsigned long, void*) =
-          (vsx_module*(*)(unsigned long, void*))
-          vsx_dlopen::sym(
-            plugin_handle,
-            "create_new_module"
-          );
-      //-------------------------------------------------------------------------
+    // plugin-config changed, probe everything again
+    updated_manifest.config_stamp = vsx_module_plugin_manifest::stamp_directory(engine_environment.engine_parameter[0]);
+    if (updated_manifest.config_stamp != manifest.config_stamp)
+    {
+      manifest.plugins.clear();
+      manifest_changed = true;
+    }
 
+    //-------------------------------------------------------------------------
+    // Iterate through all the filenames. Plugins unchanged since they were last
+    // probed are registered from the manifest and only loaded when used,
+    // the rest are loaded with dlopen and probed to see if they are vsxu modules.
+    for (std::list< vsx_string<> >::iterator it = mfiles.begin(); it != mfiles.end(); ++it)
+    {
+      plugin* p = new plugin;
+      p->filename = (*it);
+      size_t plugin_index = plugins.size();
+      plugins.push_back(p);
 
+      vsx_module_plugin_manifest::plugin_entry entry;
+      entry.filename = p->filename;
+      entry.stat_file();
 
-      //-------------------------------------------------------------------------
-      // look for the REQUIRED destructor method
-      if (vsx_dlopen::sym(plugin_handle, "destroy_module") == 0)
+      vsx_module_plugin_manifest::plugin_entry* cached = manifest.get_valid(entry);
+      if (cached)
       {
-        vsx_printf(
-              L"vsx_module_list init: Error: trying to load the plugin \"%s\"\n"
-              "                      Cause: sym could not find \"destroy_module\"\n",
-              dynamic_object_file_name.c_str()
-              );
-        continue; // try to load the next plugin
+        foreach (cached->modules, i)
+          register_module(plugin_index, cached->modules[i].module_index, cached->modules[i].specification);
+        updated_manifest.plugins[entry.filename] = *cached;
+        continue;
       }
-      // init destructor method
-      void(*destroy_module)(vsx_module*,unsigned long) =
-          (void(*)(vsx_module*,unsigned long))
-          vsx_dlopen::sym(
-            plugin_handle,
-            "destroy_module"
-          );
-      //-------------------------------------------------------------------------
 
+      manifest_changed = true;
 
-
-      //-------------------------------------------------------------------------
-      // look for the REQUIRED get_num_modules method
-      if (vsx_dlopen::sym(plugin_handle, "get_num_modules") == 0)
-      {
-        vsx_printf(
-              L"vsx_module_list init: Error: trying to load the plugin \"%s\"\n"
-              "                      Cause: sym could not find \"get_num_modules\"\n",
-              dynamic_object_file_name.c_str()
-              );
+      if (!plugin_load(p))
         continue; // try to load the next plugin
-      }
-      // init get_num_modules method
-      unsigned long(*get_num_modules)(vsx_module_engine_environment*) =
-          (unsigned long(*)(vsx_module_engine_environment*))
-          vsx_dlopen::sym(
-            plugin_handle,
-            "get_num_modules"
-          );
-      //-------------------------------------------------------------------------
 
+      plugin_probe(p, entry);
 
+      foreach (entry.modules, i)
+        register_module(plugin_index, entry.modules[i].module_index, entry.modules[i].specification);
 
-      //-------------------------------------------------------------------------
+      updated_manifest.plugins[entry.filename] = entry;
+    } // Iterate through all the filenames, treat them as plugins
 
-      // get the number of modules in this plugin
-      unsigned long num_modules_in_this_plugin = get_num_modules(&engine_environment);
+    // plugins removed since last time
+    if (updated_manifest.plugins.size() != manifest.plugins.size())
+      manifest_changed = true;
 
-      // iterate through modules in this plugin
-      for (
-           size_t module_index_iterator = 0;
-           module_index_iterator < num_modules_in_this_plugin;
-           module_index_iterator++
-      )
-      {
-        // ask the constructor / factory to create a module instance for us
-        vsx_module* module_object =
-            create_new_module(module_index_iterator, (void*)vsx_argvector::get_instance() );
-        // check for error
-        if (0x0 == module_object)
-        {
-          vsx_printf(
-                L"vsx_module_list init: Error: trying to load the plugin \"%s\"\n"
-                "                      Cause: create_new_module returned 0x0 for module_index_iterator %lx\n"
-                "                      Hint: If you are developing, check to see that get_num_modules returns\n"
-                "                            the correct module count!\n"
-                ,
-                dynamic_object_file_name.c_str(),
-                module_index_iterator
-                );
-          continue; // try to load the next module
-        }
-
-        // ask the module to provide its module info
-        vsx_module_specification* module_info = new vsx_module_specification;
-        module_object->module_info( module_info );
-
-        // check to see if this module can run on this system
-        bool can_run = module_object->can_run();
-
-        destroy_module( module_object, module_index_iterator );
-
-        if (!can_run) continue; // try to load the next module
-
-        module_info->location = "external";
-
-        // create module_plugin_info template
-        vsx_module_plugin_info module_plugin_info_template;
-
-        module_plugin_info_template.create_new_module = create_new_module;
-        module_plugin_info_template.destroy_module = destroy_module;
-
-        module_plugin_info_template.module_id = module_index_iterator;
-
-        // split the module identifier string into its individual names
-        // a module can have multiple names (and locations in the gui tree)
-        // some of these are hidden, thus the name begins with an exclamation mark - !
-        // example module identifier string:
-        //   examples;my_modules;my_module||!old_path;old_category;old_name
-        // Only the first will show up in the gui. The second identifier is still usable in
-        // old state files.
-        vsx_string<>deli = "||";
-        vsx_nw_vector< vsx_string<> > parts;
-        vsx_string_helper::explode(module_info->identifier, deli, parts);
-        vsx_module_plugin_info* applied_plugin_info = 0;
-
-        // iterate through the individual names for this module
-        for (unsigned long i = 0; i < parts.size(); ++i)
-        {
-          // create a copy of the template
-          applied_plugin_info = new vsx_module_plugin_info;
-          *applied_plugin_info = module_plugin_info_template;
-          vsx_module_specification* applied_module_info = new vsx_module_specification;
-          *applied_module_info = *module_info;
-          applied_plugin_info->module_info = applied_module_info;
-
-
-          vsx_string<>module_identifier;
-          if (parts[i][0] == '!')
-          {
-            // hidden from gui
-            applied_plugin_info->hidden_from_gui = true;
-            module_identifier = parts[i].substr(1);
-          } else
-          {
-            // normal
-            applied_plugin_info->hidden_from_gui = false;
-            module_identifier = parts[i];
-          }
-          // set module info identifier
-          applied_module_info->identifier = module_identifier;
-          // add the applied_plugin_info to module_plugin_list
-          module_plugin_list[module_identifier] = applied_plugin_info;
-
-          // add the module info to the module list
-          module_list[module_identifier] = module_info;
-        } // iterate through the individual names for this module
-        module_infos.push_back(module_info);
-      } // iterate through modules in this plugin
-    } // Iterate through all the filenames, treat them as plugins
+    if (manifest_filename.size() && manifest_changed)
+      updated_manifest.save(manifest_filename);
   }
 
   void destroy()
   {
-    for (size_t i = 0; i < plugin_handles.size(); i++)
+    for (size_t i = 0; i < plugins.size(); i++)
     {
-      vsx_dlopen::close( plugin_handles[i] );
+      if (plugins[i]->handle)
+        vsx_dlopen::close( plugins[i]->handle );
+      delete plugins[i];
     }
+    plugins.clear();
     for (std::vector< vsx_module_specification* >::iterator it = module_infos.begin(); it != module_infos.end(); it++)
     {
       delete *it;
@@ -314,28 +397,45 @@ public:
 
   vsx_module* load_module_by_name(vsx_string<>name)
   {
-    if ( module_plugin_list.find(name) == module_plugin_list.end() )
+    std::map< vsx_string<>, void* >::iterator it = module_plugin_list.find(name);
+    if ( it == module_plugin_list.end() )
     {
       return 0x0;
     }
+    vsx_module_plugin_info* plugin_info = (vsx_module_plugin_info*)it->second;
+
+    // plugins aren't re-entrant, neither loading nor constructing modules
+    std::lock_guard<std::mutex> lock(plugins_lock);
+
+    // first module used from this plugin
+    if (!plugin_info->create_new_module)
+    {
+      plugin* p = plugins[plugin_info->plugin_index];
+      if (!plugin_load(p))
+        return 0x0;
+      plugin_info->destroy_module = p->destroy_module;
+      plugin_info->create_new_module = p->create_new_module;
+    }
 
     // call constrcuction factory
     vsx_module* module =
-      ((vsx_module_plugin_info*)module_plugin_list[ name ])
+      plugin_info
       ->
       create_new_module
       (
-        ((vsx_module_plugin_info*)module_plugin_list[ name ])->module_id,
+        plugin_info->module_id,
         (void*)vsx_argvector::get_instance()
       )
     ;
-    module->module_id = ((vsx_module_plugin_info*)module_plugin_list[ name ])->module_id;
-    module->module_identifier = ((vsx_module_plugin_info*)module_plugin_list[ name ])->module_info->identifier;
+    module->module_id = plugin_info->module_id;
+    module->module_identifier = plugin_info->module_info->identifier;
     return module;
   }
 
   void unload_module( vsx_module* module_pointer )
   {
+    std::lock_guard<std::mutex> lock(plugins_lock);
+
     // call destrcuction factory
     ((vsx_module_plugin_info*)module_plugin_list[ module_pointer->module_identifier ])
     ->
@@ -346,6 +446,13 @@ public:
     );
   }
 
+  void load_plugins()
+  {
+    std::lock_guard<std::mutex> lock(plugins_lock);
+    foreach (plugins, i)
+      plugin_load(plugins[i]);
+  }
+
   bool find( const vsx_string<>&module_name_to_look_for)
   {
     if (!(module_list.find(module_name_to_look_for) != module_list.end()))
@@ -361,14 +468,20 @@ public:
     if (!module_list.size())
       return;
 
-    for (size_t i = 0; i < plugin_handles.size(); i++)
+    for (size_t i = 0; i < plugins.size(); i++)
     {
-      if ( vsx_dlopen::sym(plugin_handles[i], "print_help") )
+      plugins_lock.lock();
+      bool loaded = plugin_load(plugins[i]);
+      plugins_lock.unlock();
+      if (!loaded)
+        continue;
+
+      if ( vsx_dlopen::sym(plugins[i]->handle, "print_help") )
       {
         void(*print_help)() =
             (void(*)())
             vsx_dlopen::sym(
-              plugin_handles[i],
+              plugins[i]->handle,
               "print_help"
             );
         print_help();
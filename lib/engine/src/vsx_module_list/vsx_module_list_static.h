@@ -25,6 +25,7 @@
 #define VSX_MODULE_LIST_STATIC_H
 
 #include <map>
+#include <mutex>
 #include <vector>
 #include <string/vsx_string.h>
 #include <vsx_param.h>
@@ -48,6 +49,10 @@ class vsx_module_list : public vsx_module_list_abs
 {
 private:
   vsx_nw_vector<vsx_module_list_factory_module_info*> modules;
+
+  // modules are created by the render thread and the state loader,
+  // constructing and destroying them is done under this
+  std::mutex modules_lock;
 public:
   void init(void* extra_modules = 0x0)
   {
@@ -259,6 +264,8 @@ public:
       return 0x0;
     }
 
+    std::lock_guard<std::mutex> lock(modules_lock);
+
     // call constrcuction factory
     vsx_module* module =
       ((vsx_module_plugin_info*)module_plugin_list[ name ])
@@ -276,6 +283,8 @@ public:
 
   void unload_module( vsx_module* module_pointer )
   {
+    std::lock_guard<std::mutex> lock(modules_lock);
+
     // call destrcuction factory
     ((vsx_module_plugin_info*)module_plugin_list[ module_pointer->module_identifier ])
     ->
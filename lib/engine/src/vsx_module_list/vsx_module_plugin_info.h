@@ -35,7 +35,10 @@ public:
   :
     module_id(0),
     hidden_from_gui(false),
-    module_info(0x0)
+    module_info(0x0),
+    plugin_index(0),
+    create_new_module(0x0),
+    destroy_module(0x0)
   {}
 
   ~vsx_module_plugin_info()
@@ -49,7 +52,10 @@ public:
   bool hidden_from_gui;
   vsx_module_specification* module_info;
 
-  // cached function to module's constructor/destructor
+  // which plugin in the module list this module lives in
+  size_t plugin_index;
+
+  // cached function to module's constructor/destructor, 0x0 until the plugin is loaded
   vsx_module*(*create_new_module)( unsigned long, void* );
   void(*destroy_module)( vsx_module*, unsigned long );
 };
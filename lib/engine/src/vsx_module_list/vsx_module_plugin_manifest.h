@@ -0,0 +1,289 @@
+/**
+* Project: VSXu Engine: Realtime modular visual programming engine.
+*
+* This file is part of Vovoid VSXu Engine.
+*
+* @author Jonatan Wallmander, Robert Wenzel, Vovoid Media Technologies AB Copyright (C) 2003-2013
+* @see The GNU Lesser General Public License (LGPL)
+*
+* VSXu Engine is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#pragma once
+
+#include <map>
+#include <list>
+#include <vector>
+#include <sys/stat.h>
+#include <string/vsx_string.h>
+#include <container/vsx_ma_vector.h>
+#include <filesystem/vsx_filesystem_helper.h>
+#include <module/vsx_module_specification.h>
+
+/*
+  Module specifications of every plugin, saved to disk so the module list can
+  be built without loading the plugins and instantiating each module.
+
+  A plugin's entry is used as long as its file size and modification time match,
+  otherwise the plugin is probed again. Only modules that could run when probed
+  are stored.
+
+  Some plugins declare modules from files in plugin-config (render.glsl has one
+  per .glsl file), so the whole manifest is only valid as long as the names,
+  sizes and modification times there are the same (config_stamp).
+
+  Binary layout, little endian:
+    "VSXM", u32 version
+    u64 config stamp
+    u32 plugin count
+    plugin: string filename, u64 mtime, u64 size, u32 module count, module...
+    module: u32 module index, string identifier, identifier_save, description,
+            in_param_spec, out_param_spec, component_class, u32 output, u8 tunnel,
+            u8 thread_safe
+    string: u32 size, bytes
+*/
+class vsx_module_plugin_manifest
+{
+public:
+
+  class module_entry
+  {
+  public:
+    uint32_t module_index = 0;
+    vsx_module_specification specification;
+  };
+
+  class plugin_entry
+  {
+  public:
+    vsx_string<> filename;
+    uint64_t mtime = 0;
+    uint64_t size = 0;
+    std::vector<module_entry> modules;
+
+    // stat the file on disk into mtime and size
+    bool stat_file()
+    {
+      struct stat s;
+      if (stat(filename.c_str(), &s))
+        return false;
+      mtime = (uint64_t)s.st_mtime;
+      size = (uint64_t)s.st_size;
+      return true;
+    }
+  };
+
+  std::map< vsx_string<>, plugin_entry > plugins;
+
+  // the plugin-config directory when the plugins were probed, see stamp_directory
+  uint64_t config_stamp = 0;
+
+private:
+
+  static const uint32_t version = 2;
+
+  static inline void stamp_bytes(uint64_t& stamp, const void* data, size_t size)
+  {
+    const unsigned char* p = (const unsigned char*)data;
+    for_n(i, 0, size)
+    {
+      stamp ^= p[i];
+      stamp *= 1099511628211ULL;
+    }
+  }
+
+  vsx_ma_vector<unsigned char> buffer;
+  size_t read_position = 0;
+
+  void write_u32(uint32_t value)
+  {
+    for_n(i, 0, 4)
+      buffer.push_back( (unsigned char)((value >> (i * 8)) & 0xff) );
+  }
+
+  void write_u64(uint64_t value)
+  {
+    for_n(i, 0, 8)
+      buffer.push_back( (unsigned char)((value >> (i * 8)) & 0xff) );
+  }
+
+  void write_string(vsx_string<>& value)
+  {
+    write_u32( (uint32_t)value.size() );
+    for_n(i, 0, value.size())
+      buffer.push_back( (unsigned char)value[i] );
+  }
+
+  bool read_u32(uint32_t& value)
+  {
+    reqrv(read_position + 4 <= buffer.size(), false);
+    value = 0;
+    for_n(i, 0, 4)
+      value |= (uint32_t)buffer[read_position + i] << (i * 8);
+    read_position += 4;
+    return true;
+  }
+
+  bool read_u64(uint64_t& value)
+  {
+    reqrv(read_position + 8 <= buffer.size(), false);
+    value = 0;
+    for_n(i, 0, 8)
+      value |= (uint64_t)buffer[read_position + i] << (i * 8);
+    read_position += 8;
+    return true;
+  }
+
+  bool read_string(vsx_string<>& value)
+  {
+    uint32_t size;
+    reqrv(read_u32(size), false);
+    reqrv(read_position + size <= buffer.size(), false);
+    value = vsx_string<>((char*)buffer.get_pointer() + read_position, size);
+    read_position += size;
+    return true;
+  }
+
+  bool read_all()
+  {
+    reqrv(buffer.size() >= 8, false);
+    reqrv(buffer[0] == 'V' && buffer[1] == 'S' && buffer[2] == 'X' && buffer[3] == 'M', false);
+    read_position = 4;
+
+    uint32_t file_version;
+    reqrv(read_u32(file_version), false);
+    reqrv(file_version == version, false);
+    reqrv(read_u64(config_stamp), false);
+
+    uint32_t plugin_count;
+    reqrv(read_u32(plugin_count), false);
+    for_n(p, 0, plugin_count)
+    {
+      plugin_entry plugin;
+      reqrv(read_string(plugin.filename), false);
+      reqrv(read_u64(plugin.mtime), false);
+      reqrv(read_u64(plugin.size), false);
+
+      uint32_t module_count;
+      reqrv(read_u32(module_count), false);
+      for_n(m, 0, module_count)
+      {
+        module_entry module;
+        vsx_module_specification& spec = module.specification;
+        uint32_t output;
+        uint32_t flags;
+        reqrv(read_u32(module.module_index), false);
+        reqrv(read_string(spec.identifier), false);
+        reqrv(read_string(spec.identifier_save), false);
+        reqrv(read_string(spec.description), false);
+        reqrv(read_string(spec.in_param_spec), false);
+        reqrv(read_string(spec.out_param_spec), false);
+        reqrv(read_string(spec.component_class), false);
+        reqrv(read_u32(output), false);
+        reqrv(read_u32(flags), false);
+        spec.output = (int)output;
+        spec.tunnel = (flags & 1) != 0;
+        spec.thread_safe = (flags & 2) != 0;
+        plugin.modules.push_back(module);
+      }
+      plugins[plugin.filename] = plugin;
+    }
+    return true;
+  }
+
+public:
+
+  // FNV-1a over the name, size and modification time of every file below path
+  static uint64_t stamp_directory(const vsx_string<>& path)
+  {
+    std::list< vsx_string<> > files;
+    vsx::filesystem_helper::get_files_recursive(path, &files, "", "");
+
+    uint64_t stamp = 14695981039346656037ULL;
+    for (std::list< vsx_string<> >::iterator it = files.begin(); it != files.end(); ++it)
+    {
+      struct stat s;
+      uint64_t values[2] = {0, 0};
+      if (!stat((*it).c_str(), &s))
+      {
+        values[0] = (uint64_t)s.st_mtime;
+        values[1] = (uint64_t)s.st_size;
+      }
+      stamp_bytes(stamp, (*it).c_str(), (*it).size() + 1);
+      stamp_bytes(stamp, values, sizeof(values));
+    }
+    return stamp;
+  }
+
+  bool load(vsx_string<> filename)
+  {
+    plugins.clear();
+    config_stamp = 0;
+    reqrv(vsx::filesystem_helper::is_file(filename), false);
+    buffer = vsx::filesystem_helper::read(filename);
+    read_position = 0;
+    bool result = read_all();
+    buffer.clear();
+    if (!result)
+      plugins.clear();
+    return result;
+  }
+
+  void save(vsx_string<> filename)
+  {
+    buffer.clear();
+    buffer.push_back('V');
+    buffer.push_back('S');
+    buffer.push_back('X');
+    buffer.push_back('M');
+    write_u32(version);
+    write_u64(config_stamp);
+    write_u32( (uint32_t)plugins.size() );
+    for (auto it = plugins.begin(); it != plugins.end(); ++it)
+    {
+      plugin_entry& plugin = it->second;
+      write_string(plugin.filename);
+      write_u64(plugin.mtime);
+      write_u64(plugin.size);
+      write_u32( (uint32_t)plugin.modules.size() );
+      foreach (plugin.modules, i)
+      {
+        vsx_module_specification& spec = plugin.modules[i].specification;
+        write_u32(plugin.modules[i].module_index);
+        write_string(spec.identifier);
+        write_string(spec.identifier_save);
+        write_string(spec.description);
+        write_string(spec.in_param_spec);
+        write_string(spec.out_param_spec);
+        write_string(spec.component_class);
+        write_u32( (uint32_t)spec.output );
+        write_u32( (spec.tunnel ? 1 : 0) | (spec.thread_safe ? 2 : 0) );
+      }
+    }
+    vsx::filesystem_helper::write(filename, buffer);
+    buffer.clear();
+  }
+
+  // the cached entry if the plugin on disk hasn't changed since it was probed
+  plugin_entry* get_valid(plugin_entry& on_disk)
+  {
+    auto it = plugins.find(on_disk.filename);
+    if (it == plugins.end())
+      return 0x0;
+    if (it->second.mtime != on_disk.mtime || it->second.size != on_disk.size)
+      return 0x0;
+    return &it->second;
+  }
+};
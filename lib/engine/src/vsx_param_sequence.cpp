@@ -27,7 +27,63 @@
 #include <math/quaternion/vsx_quaternion_helper.h>
 #include <string/vsx_string_helper.h>
 
-vsx_bezier_calc<float> bez_calc;
+void vsx_param_sequence::build_track()
+{
+  track.clear();
+  track.dirty = false;
+
+  int type = param->module_param->type;
+  if (type == VSX_MODULE_PARAM_ID_FLOAT)
+    track.arity = 1;
+  if (type == VSX_MODULE_PARAM_ID_FLOAT3)
+    track.arity = 3;
+  if (type == VSX_MODULE_PARAM_ID_FLOAT4)
+    track.arity = 4;
+
+  vsx_string<> deli = ",";
+  foreach(items, i)
+  {
+    track.times.push_back(items[i].accum_time);
+    track.has_value.push_back(items[i].value.size() != 0);
+
+    if (track.arity == 1)
+      track.values.push_back( vsx_string_helper::s2f(items[i].value) );
+
+    if (track.arity > 1)
+    {
+      vsx_nw_vector< vsx_string<> > parts;
+      vsx_string_helper::explode(items[i].value, deli, parts);
+      for (size_t j = 0; j < track.arity; j++)
+        track.values.push_back( j < parts.size() ? vsx_string_helper::s2f(parts[j]) : 0.0f );
+    }
+
+    if (type == VSX_MODULE_PARAM_ID_QUATERNION)
+    {
+      vsx_quaternion<> q = vsx_quaternion_helper::from_string<float>(items[i].value);
+      q.normalize();
+      track.quaternions.push_back(q);
+    }
+  }
+
+  // bezier curves for float segments, the last key curves onto itself
+  if (track.arity == 1)
+    foreach(items, i)
+    {
+      float cv = track.get_float(i);
+      float ev = track.get_float( i + 1 < items.size() ? i + 1 : i );
+      vsx_bezier_calc<float> bez_calc;
+      bez_calc.x0 = 0.0f;
+      bez_calc.y0 = cv;
+      bez_calc.x1 = items[i].handle1.x;
+      bez_calc.y1 = cv+items[i].handle1.y;
+      bez_calc.x2 = items[i].handle2.x;
+      bez_calc.y2 = ev+items[i].handle2.y;
+      bez_calc.x3 = 1.0f;
+      bez_calc.y3 = ev;
+      bez_calc.init();
+      track.beziers.push_back(bez_calc);
+    }
+}
 
 
 //----------------------------------------------------------------------
@@ -38,12 +94,17 @@ vsx_bezier_calc<float> bez_calc;
 
 void vsx_param_sequence::execute(float ptime, float blend)
 {
+  if (!items.size())
+    return;
+
+  if (track.dirty)
+    build_track();
+
+  int last_key = (int)items.size() - 1;
+
   if (items.size() < 2)
   {
-    if (items.size())
-    {
-      param->set_string_index(items[0].value);
-    }
+    param->set_string_index(items[0].value);
   }
   if
   (
@@ -52,199 +113,194 @@ void vsx_param_sequence::execute(float ptime, float blend)
     line_cur == 0
   )
   {
-    if (cur_val == "")
+    if (cur_key == -1)
     {
-      cur_val = items[0].value;
+      cur_key = 0;
       cur_delay = items[0].total_length;
       cur_interpolation = items[0].interpolation;
       if (items.size() > 1)
       {
-        to_val = items[1].value;
+        to_key = 1;
       }
     }
   }
 
-  int c = 0;
-
   line_time += ptime;
   //printf("ptime: %f  line_time: %f line_cur: %d\n",ptime,line_time,line_cur);
 
+  // find the key we're in now, searching from the absolute position
+  // rather than stepping one key at a time
+  int key = -2;
+  float position = items[line_cur].accum_time + line_time;
   if (ptime < 0)
   {
-    if ((line_time) < 0 && line_cur != 0)
-    {
-      while (line_time < 0)
-      {
-        ++c;
-        --line_cur;
-        if (line_cur < 0)
-        {
-          line_cur = 0;
-          line_time = 0;
-        } else
-        {
-          line_time +=  items[line_cur].total_length;
-          cur_val = items[line_cur].value;
-          cur_delay = items[line_cur].total_length;
-          cur_interpolation = items[line_cur].interpolation;
-          to_val = items[line_cur+1].value;
-        }
-      }
-    }
+    if (line_time < 0 && line_cur != 0)
+      key = track.find(position, true);
   }
   else
   {
-    if (cur_delay != -1)
+    if (cur_delay != -1 && line_time > cur_delay)
+      key = track.find(position, false);
+  }
+
+  if (key != -2)
+  {
+    if (key < 0)
     {
-      while (line_time > cur_delay && cur_delay != -1)
-      {
-        ++c;
-        line_time -= items[line_cur].total_length;
-        ++line_cur;
-        cur_interpolation = items[line_cur].interpolation;
-        cur_delay = items[line_cur].total_length;
-        cur_val = to_val;
-        if (line_cur >= (int)items.size()-1)
-        {
-          cur_delay = -1;
-        }
-        else
-        {
-          if (line_cur >= (int)items.size()-1)
-          {
-            to_val = items[line_cur].value;
-          }
-          else
-          {
-            to_val = items[line_cur+1].value;
-          }
-        }
-      }
+      key = 0;
+      position = 0.0f;
     }
+    if (key > last_key)
+      key = last_key;
+
+    line_cur = key;
+    line_time = position - items[key].accum_time;
+    cur_interpolation = items[key].interpolation;
+    cur_delay = items[key].total_length;
+    if (ptime >= 0 && key == last_key)
+      cur_delay = -1;
+    cur_key = key;
+    to_key = key < last_key ? key + 1 : key;
   }
-  //printf("line_cur: %d  cur_val: %s to_val: %s line_time: %f curdel: \n",line_cur, cur_val.c_str(),to_val.c_str(),line_time,cur_delay);
-  if (to_val.size() && cur_val.size())
+
+  //printf("line_cur: %d  cur_key: %d to_key: %d line_time: %f curdel: \n",line_cur, cur_key, to_key, line_time, cur_delay);
+  if
+  (
+    cur_key < 0
+    ||
+    to_key < 0
+    ||
+    !track.has_value[cur_key]
+    ||
+    !track.has_value[to_key]
+  )
+    return;
+
+  float t = (line_time/cur_delay);
+  if (param->module_param->type == VSX_MODULE_PARAM_ID_STRING)
+  {
+    ((vsx_module_param_string*)param->module_param)->set(items[cur_key].value);
+    ((vsx_module_param_string*)param->module_param)->updates++;
+    return;
+  }
+  if (param->module_param->type == VSX_MODULE_PARAM_ID_FLOAT)
   {
-    float t = (line_time/cur_delay);
-    if (param->module_param->type == VSX_MODULE_PARAM_ID_STRING)
+    ++param->module->param_updates;
+    ++((vsx_module_param_float*)param->module_param)->updates;
+    float cv = track.get_float(cur_key);
+    float ev = track.get_float(to_key);
+    float dv = ev-cv;
+    float result_value = cv;
+
+    // 0 = no interpolation
+    // 1 = linear interpolation
+    // 2 = cosine interpolation
+    // 3 = no interpolation + param_interpolator
+    // 4 = bezier
+
+    if (cur_interpolation == 1)
     {
-      ((vsx_module_param_string*)param->module_param)->set(cur_val);
-      ((vsx_module_param_string*)param->module_param)->updates++;
-      return;
+      result_value = cv + dv * t;
+      goto execute_float_value_set;
     }
-    if (param->module_param->type == VSX_MODULE_PARAM_ID_FLOAT)
+    if (cur_interpolation == 2)
     {
-      ++param->module->param_updates;
-      ++((vsx_module_param_float*)param->module_param)->updates;
-      float cv = vsx_string_helper::s2f(cur_val);
-      float ev = vsx_string_helper::s2f(to_val);
-      float dv = ev-cv;
-      float result_value = cv;
-
-      //printf("sequence execute: %s %f\n", cur_val.c_str(), cv);
-      // 0 = no interpolation
-      // 1 = linear interpolation
-      // 2 = cosine interpolation
-      // 3 = no interpolation + param_interpolator
-
-      if (cur_interpolation == 1)
-      {
-        result_value = cv + dv * t;
-        goto execute_float_value_set;
-      }
-      if (cur_interpolation == 2)
-      {
-        float f =
-          (
-            1
-            -
-            cos(
-              t * PI_FLOAT
-            )
+      float f =
+        (
+          1
+          -
+          cos(
+            t * PI_FLOAT
           )
-          * 0.5f
-        ;
-        result_value = cv * (1.0f-f) + ev * f;
-        goto execute_float_value_set;
-      }
-      //if (cur_interpolation == 3)
-      //{
-      //  ((vsx_engine*)engine)->interpolation_list.set_target_value(param, vsx_string_helper::f2s(cv), 0, interp_time);
-      //}
+        )
+        * 0.5f
+      ;
+      result_value = cv * (1.0f-f) + ev * f;
+      goto execute_float_value_set;
+    }
 
-      if (cur_interpolation == 4)
-      {
-        bez_calc.x0 = 0.0f;
-        bez_calc.y0 = cv;
-        bez_calc.x1 = items[line_cur].handle1.x;
-        bez_calc.y1 = cv+items[line_cur].handle1.y;
-        bez_calc.x2 = items[line_cur].handle2.x;
-        bez_calc.y2 = ev+items[line_cur].handle2.y;
-        bez_calc.x3 = 1.0f;
-        bez_calc.y3 = ev;
-        bez_calc.init();
-
-        float tt = bez_calc.t_from_x(t);
-        result_value = bez_calc.y_from_t(tt);
-        goto execute_float_value_set;
-      }
+    if (cur_interpolation == 4)
+    {
+      vsx_bezier_calc<float>& bez_calc = track.beziers[cur_key];
+      float tt = bez_calc.t_from_x(t);
+      result_value = bez_calc.y_from_t(tt);
+      goto execute_float_value_set;
+    }
 
-      execute_float_value_set:
+    execute_float_value_set:
+    {
+      if (blend < 1.0f)
       {
-        if (blend < 1.0f)
-        {
-          float current_value = ((vsx_module_param_float*)param->module_param)->get_internal();
-          result_value = (1.0f - blend) * current_value + blend * result_value;
-        }
-        ((vsx_module_param_float*)param->module_param)->set_internal(result_value);
+        float current_value = ((vsx_module_param_float*)param->module_param)->get_internal();
+        result_value = (1.0f - blend) * current_value + blend * result_value;
       }
-    } else
-    if (param->module_param->type == VSX_MODULE_PARAM_ID_QUATERNION)
+      ((vsx_module_param_float*)param->module_param)->set_internal(result_value);
+    }
+  } else
+  if (param->module_param->type == VSX_MODULE_PARAM_ID_QUATERNION)
+  {
+    // keys are normalized when the track is built
+    vsx_quaternion<>& cv = track.quaternions[cur_key];
+    vsx_quaternion<>& ev = track.quaternions[to_key];
+
+    // 0 = no interpolation
+    // 1 = linear interpolation
+    // 2 = cosine interpolation
+    // 3 = no interpolation + param_interpolator
+    vsx_quaternion<> iq = cv;
+    if (cur_interpolation == 1)
+      iq.slerp(cv, ev, t);
+    else
+    if (cur_interpolation == 2)
+      iq.cos_slerp(cv, ev, t);
+
+    if (cur_interpolation <= 2)
     {
-      vsx_quaternion<> cv, ev;
-      cv = vsx_quaternion_helper::from_string<float>(cur_val);
-      ev = vsx_quaternion_helper::from_string<float>(to_val);
-
-      // 0 = no interpolation
-      // 1 = linear interpolation
-      // 2 = cosine interpolation
-      // 3 = no interpolation + param_interpolator
-      if (cur_interpolation == 0)
-      {
-        cv.normalize();
-        ((vsx_module_param_quaternion*)param->module_param)->set_internal(cv.x,0);
-        ((vsx_module_param_quaternion*)param->module_param)->set_internal(cv.y,1);
-        ((vsx_module_param_quaternion*)param->module_param)->set_internal(cv.z,2);
-        ((vsx_module_param_quaternion*)param->module_param)->set_internal(cv.w,3);
-      } else
-      if (cur_interpolation == 1)
+      ((vsx_module_param_quaternion*)param->module_param)->set_internal(iq.x,0);
+      ((vsx_module_param_quaternion*)param->module_param)->set_internal(iq.y,1);
+      ((vsx_module_param_quaternion*)param->module_param)->set_internal(iq.z,2);
+      ((vsx_module_param_quaternion*)param->module_param)->set_internal(iq.w,3);
+    }
+  }
+  else
+  if
+  (
+    param->module_param->type == VSX_MODULE_PARAM_ID_FLOAT3
+    ||
+    param->module_param->type == VSX_MODULE_PARAM_ID_FLOAT4
+  )
+  {
+    // component-wise, bezier handles only apply to floats so it's linear here
+    float f = t;
+    if (cur_interpolation == 0 || cur_interpolation == 3)
+      f = 0.0f;
+    if (cur_interpolation == 2)
+      f = (1.0f - cos(t * PI_FLOAT)) * 0.5f;
+
+    vsx_module_param_float3* float3_param = (vsx_module_param_float3*)param->module_param;
+    vsx_module_param_float4* float4_param = (vsx_module_param_float4*)param->module_param;
+
+    ++param->module->param_updates;
+    for (int i = 0; i < (int)track.arity; i++)
+    {
+      float result_value = track.get_float(cur_key, i) * (1.0f - f) + track.get_float(to_key, i) * f;
+      if (track.arity == 3)
       {
-        cv.normalize();
-        ev.normalize();
-        vsx_quaternion<> iq;
-        iq.slerp(cv, ev, t);
-        ((vsx_module_param_quaternion*)param->module_param)->set_internal(iq.x,0);
-        ((vsx_module_param_quaternion*)param->module_param)->set_internal(iq.y,1);
-        ((vsx_module_param_quaternion*)param->module_param)->set_internal(iq.z,2);
-        ((vsx_module_param_quaternion*)param->module_param)->set_internal(iq.w,3);
+        if (blend < 1.0f)
+          result_value = (1.0f - blend) * float3_param->get_internal(i) + blend * result_value;
+        float3_param->set_internal(result_value, i);
       }
       else
-      if (cur_interpolation == 2)
       {
-        cv.normalize();
-        ev.normalize();
-        vsx_quaternion<> iq;
-        iq.cos_slerp(cv, ev, t);
-        ((vsx_module_param_quaternion*)param->module_param)->set_internal(iq.x,0);
-        ((vsx_module_param_quaternion*)param->module_param)->set_internal(iq.y,1);
-        ((vsx_module_param_quaternion*)param->module_param)->set_internal(iq.z,2);
-        ((vsx_module_param_quaternion*)param->module_param)->set_internal(iq.w,3);
+        if (blend < 1.0f)
+          result_value = (1.0f - blend) * float4_param->get_internal(i) + blend * result_value;
+        float4_param->set_internal(result_value, i);
       }
     }
+    if (track.arity == 3)
+      ++float3_param->updates;
     else
-    if (param->module_param->type == VSX_MODULE_PARAM_ID_FLOAT3)
-    {
-    }
+      ++float4_param->updates;
   }
 }
 
@@ -394,19 +450,20 @@ bool vsx_param_sequence::has_keyframe_at_time(float time, float tolerance)
 vsx_param_sequence::vsx_param_sequence()
 {
   interp_time = 10;
-  cur_val = to_val = "";
+  cur_key = to_key = -1;
   last_time = 0.0f;
   line_time = 0.0f;
   line_cur = 0;
   p_time = 0;
 	total_time = 0.0f;
   cur_delay = 0.0f;
+  cur_interpolation = 1;
 }
 
 vsx_param_sequence::vsx_param_sequence(int p_type,vsx_engine_param* param)
 {
   interp_time = 10;
-  cur_val = to_val = "";
+  cur_key = to_key = -1;
   last_time = 0.0f;
   line_time = 0.0f;
   line_cur = 0;
@@ -474,7 +531,7 @@ void vsx_param_sequence::update_line(vsx_command_list* dest, vsx_command_s* cmd_
   }
 
   items[ vsx_string_helper::s2i(cmd_in->parts[7]) ] = std::move(pa);
-  cur_val = to_val = "";
+  cur_key = to_key = -1;
   last_time = 0.0;
   line_time = 0.0;
   line_cur = 0;
@@ -524,7 +581,7 @@ void vsx_param_sequence::insert_line(vsx_command_list* dest, vsx_command_s* cmd_
     ++it;
     items.insert(it, pa);
   }
-  cur_val = to_val = "";
+  cur_key = to_key = -1;
   last_time = 0.0;
   line_time = 0.0;
   line_cur = 0;
@@ -581,7 +638,7 @@ void vsx_param_sequence::insert_line_absolute(vsx_command_list* dest, vsx_comman
     items.push_back(pa);
   }
 
-  cur_val = to_val = "";
+  cur_key = to_key = -1;
   last_time = 0.0;
   line_time = 0.0;
   line_cur = 0;
@@ -600,7 +657,7 @@ void vsx_param_sequence::remove_line(vsx_command_list* dest, vsx_command_s* cmd_
   float last_time; // last time we were called, to see if we should trace back
   float line_time; // current line time (accumulated)
   int line_cur; // current line
-  vsx_string<>cur_val, to_val;
+  int cur_key, to_key;
   float cur_delay;
   int cur_interpolation;
   float total_time;
@@ -612,8 +669,8 @@ void vsx_param_sequence::remove_line(vsx_command_list* dest, vsx_command_s* cmd_
   last_time = 0.0f;
   line_time = 0.0f;
   line_cur = 0;
-  cur_val = "";
-  to_val = "";
+  cur_key = -1;
+  to_key = -1;
   cur_delay = 0.0f;
   cur_interpolation = 1;
   total_time = 0.0f; // reset total time for re-calculation
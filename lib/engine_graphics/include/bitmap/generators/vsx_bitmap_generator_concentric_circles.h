@@ -54,37 +54,44 @@ public:
     int i_size = 8 << size;
     frequency *= 0.5f;
     bitmap->data_set( malloc( sizeof(uint32_t) * i_size * i_size ) );
-    uint32_t *p = (uint32_t*)bitmap->data_get();
+    uint32_t* data = (uint32_t*)bitmap->data_get();
     int hsize = i_size >> 1;
     float one_div_hsize = 1.0f / ((float)hsize+1);
 
-    for (int y = -hsize; y < hsize; ++y)
-      for (int x = -hsize; x < hsize; ++x,p++)
+    // rows are independent, 16 of them per task
+    vsx_thread_pool<>::instance()->parallel_for(0, i_size, 16,
+      [&](size_t row_begin, size_t row_end)
       {
-        float xx = (size/(size-2.0f))*((float)x)+0.5f;
-        float yy = (size/(size-2.0f))*((float)y)+0.5f;
-        float dd = sqrt(xx*xx + yy*yy);
+        uint32_t* p = data + row_begin * i_size;
+        for (int y = (int)row_begin - hsize; y < (int)row_end - hsize; ++y)
+          for (int x = -hsize; x < hsize; ++x, p++)
+          {
+            float xx = (size/(size-2.0f))*((float)x)+0.5f;
+            float yy = (size/(size-2.0f))*((float)y)+0.5f;
+            float dd = sqrt(xx*xx + yy*yy);
 
-        float dstf = dd * one_div_hsize;
+            float dstf = dd * one_div_hsize;
 
-        float dist = (float)(pow(fabs(cos(dstf * PI * frequency)), (float)attenuation) * cos(dstf * PI * 0.5));
+            float dist = (float)(pow(fabs(cos(dstf * PI * frequency)), (float)attenuation) * cos(dstf * PI * 0.5));
 
-        if (alpha)
-        {
-          long pr = CLAMP( (long)(255.0f * color.r), 0, 255);
-          long pg = CLAMP( (long)(255.0f * color.g), 0, 255);
-          long pb = CLAMP( (long)(255.0f * color.b), 0, 255);
-          long pa = CLAMP( (long)(255.0f * dist * color.a), 0, 255);
-          *p = 0x01000000 * pa | pb * 0x00010000 | pg * 0x00000100 | pr;
-        } else
-        {
-          long pr = CLAMP( (long)(255.0f * dist * color.r), 0, 255);
-          long pg = CLAMP( (long)(255.0f * dist * color.g), 0, 255);
-          long pb = CLAMP( (long)(255.0f * dist * color.b), 0, 255);
-          long pa = (long)(255.0f * color.a);
-          *p = 0x01000000 * pa | pb * 0x00010000 | pg * 0x00000100 | pr;
-        }
+            if (alpha)
+            {
+              long pr = CLAMP( (long)(255.0f * color.r), 0, 255);
+              long pg = CLAMP( (long)(255.0f * color.g), 0, 255);
+              long pb = CLAMP( (long)(255.0f * color.b), 0, 255);
+              long pa = CLAMP( (long)(255.0f * dist * color.a), 0, 255);
+              *p = 0x01000000 * pa | pb * 0x00010000 | pg * 0x00000100 | pr;
+            } else
+            {
+              long pr = CLAMP( (long)(255.0f * dist * color.r), 0, 255);
+              long pg = CLAMP( (long)(255.0f * dist * color.g), 0, 255);
+              long pb = CLAMP( (long)(255.0f * dist * color.b), 0, 255);
+              long pa = (long)(255.0f * color.a);
+              *p = 0x01000000 * pa | pb * 0x00010000 | pg * 0x00000100 | pr;
+            }
+          }
       }
+    );
 
     bitmap->width = i_size;
     bitmap->height = i_size;
@@ -100,10 +107,12 @@ public:
       uint16_t size
   )
   {
-    if (bitmap->references > 1)
+    // shared, or kept generated by the cache
+    if (bitmap->references > 1 || bitmap->data_ready)
       ret(bitmap->timestamp = vsx_singleton_counter::get());
 
     bitmap->data_ready = 0;
+    bitmap->data_loading = true;
     bitmap->lock.aquire();
     vsx_thread_pool<>::instance()->add(
       [=]
@@ -111,6 +120,7 @@ public:
       {
         generate(bitmap, frequency, attenuation, color, alpha, size);
         bitmap->data_ready.fetch_add(1);
+        bitmap->data_loading = false;
         bitmap->lock.release();
       },
       bitmap,
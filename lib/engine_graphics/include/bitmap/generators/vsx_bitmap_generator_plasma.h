@@ -101,94 +101,101 @@ public:
 
     bitmap->data_set( malloc( sizeof(uint32_t) * i_size * i_size ) );
 
-    uint32_t* p = (uint32_t*)bitmap->data_get();
+    uint32_t* data = (uint32_t*)bitmap->data_get();
     int hsize = i_size >> 1;
     float size_f = (float)(2.0f*PI)/(float)i_size;
 
-    for(int y = -hsize; y < hsize; ++y)
-      for(int x = -hsize; x < hsize; ++x, p++)
+    // rows are independent, 16 of them per task
+    vsx_thread_pool<>::instance()->parallel_for(0, i_size, 16,
+      [&](size_t row_begin, size_t row_end)
       {
-        long r =
-          (long)round(
-            fmod(
-              fabs(
-                (
-                  (
-                    sin( ( x * size_f + offset_red.x)   * period_red.x)
-                    *
-                    sin((y * size_f + offset_red.y)   * period_red.y)
+        uint32_t* p = data + row_begin * i_size;
+        for (int y = (int)row_begin - hsize; y < (int)row_end - hsize; ++y)
+          for (int x = -hsize; x < hsize; ++x, p++)
+          {
+            long r =
+              (long)round(
+                fmod(
+                  fabs(
+                    (
+                      (
+                        sin( ( x * size_f + offset_red.x)   * period_red.x)
+                        *
+                        sin((y * size_f + offset_red.y)   * period_red.y)
+                      )
+                      + 1.0f
+                    )
+                      * amp_r
+                    + ofs_r
                   )
-                  + 1.0f
+                  ,
+                  255.0
                 )
-                  * amp_r
-                + ofs_r
-              )
-              ,
-              255.0
-            )
-          );
-
-        long g =
-          (long)round(
-            fmod(
-              fabs(
-                (
-                  (
-                    sin( ( x * size_f + offset_green.x)   * period_green.x)
-                    *
-                    sin((y * size_f + offset_green.y)   * period_green.y)
+              );
+
+            long g =
+              (long)round(
+                fmod(
+                  fabs(
+                    (
+                      (
+                        sin( ( x * size_f + offset_green.x)   * period_green.x)
+                        *
+                        sin((y * size_f + offset_green.y)   * period_green.y)
+                      )
+                      + 1.0f
+                    )
+                      * amp_g
+                    + ofs_g
                   )
-                  + 1.0f
+                  ,
+                  255.0
                 )
-                  * amp_g
-                + ofs_g
-              )
-              ,
-              255.0
-            )
-          );
-
-        long b =
-          (long)round(
-            fmod(
-              fabs(
-                (
-                  (
-                    sin( ( x * size_f + offset_blue.x)   * period_blue.x)
-                    *
-                    sin((y * size_f + offset_blue.y)   * period_blue.y)
+              );
+
+            long b =
+              (long)round(
+                fmod(
+                  fabs(
+                    (
+                      (
+                        sin( ( x * size_f + offset_blue.x)   * period_blue.x)
+                        *
+                        sin((y * size_f + offset_blue.y)   * period_blue.y)
+                      )
+                      + 1.0f
+                    )
+                      * amp_b
+                    + ofs_b
                   )
-                  + 1.0f
+                  ,
+                  255.0
                 )
-                  * amp_b
-                + ofs_b
-              )
-              ,
-              255.0
-            )
-          );
-
-        long a =
-          (long)round(
-            fmod(
-              fabs(
-                (
-                  (
-                    sin( ( x * size_f + offset_alpha.x)   * period_alpha.x)
-                    *
-                    sin((y * size_f + offset_alpha.y)   * period_alpha.y)
+              );
+
+            long a =
+              (long)round(
+                fmod(
+                  fabs(
+                    (
+                      (
+                        sin( ( x * size_f + offset_alpha.x)   * period_alpha.x)
+                        *
+                        sin((y * size_f + offset_alpha.y)   * period_alpha.y)
+                      )
+                      + 1.0f
+                    )
+                      * amp_a
+                    + ofs_a
                   )
-                  + 1.0f
+                  ,
+                  255.0
                 )
-                  * amp_a
-                + ofs_a
-              )
-              ,
-              255.0
-            )
-          );
-        *p = 0x01000000 * a | b * 0x00010000 | g * 0x00000100 | r;
+              );
+            *p = 0x01000000 * a | b * 0x00010000 | g * 0x00000100 | r;
+          }
       }
+    );
     bitmap->width = i_size;
     bitmap->height = i_size;
     bitmap->timestamp = vsx_singleton_counter::get();
@@ -210,10 +217,12 @@ public:
       uint16_t size
   )
   {
-    if (bitmap->references > 1)
+    // shared, or kept generated by the cache
+    if (bitmap->references > 1 || bitmap->data_ready)
       ret(bitmap->timestamp = vsx_singleton_counter::get());
 
     bitmap->data_ready = 0;
+    bitmap->data_loading = true;
     bitmap->lock.aquire();
     vsx_thread_pool<>::instance()->add(
       [=]
@@ -234,6 +243,7 @@ public:
       {
         generate(bitmap, period_red, period_green, period_blue, period_alpha, offset_red, offset_green, offset_blue, offset_alpha, amp, ofs, size);
         bitmap->data_ready.fetch_add(1);
+        bitmap->data_loading = false;
         bitmap->lock.release();
       },
       bitmap,
@@ -120,10 +120,12 @@ public:
     uint16_t size
   )
   {
-    if (bitmap->references > 1)
+    // shared, or kept generated by the cache
+    if (bitmap->references > 1 || bitmap->data_ready)
       ret(bitmap->timestamp = vsx_singleton_counter::get());
 
     bitmap->data_ready = 0;
+    bitmap->data_loading = true;
     bitmap->lock.aquire();
     vsx_thread_pool<>::instance()->add(
       [=]
@@ -131,6 +133,7 @@ public:
       {
         generate(bitmap, rand_seed, amplitude, size);
         bitmap->data_ready.fetch_add(1);
+        bitmap->data_loading = false;
         bitmap->lock.release();
       },
       bitmap,
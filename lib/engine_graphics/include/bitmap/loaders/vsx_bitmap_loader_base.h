@@ -29,6 +29,7 @@ public:
   void load(vsx_bitmap* bitmap, vsx_string<>filename, vsx::filesystem* filesystem, bool thread)
   {
     bitmap->data_ready = 0;
+    bitmap->data_loading = true;
     load_internal(filename, filesystem, bitmap, thread);
   }
 };
@@ -14,13 +14,18 @@ class vsx_bitmap_loader_png
   void load_internal(vsx_string<> filename, vsx::filesystem* filesystem, vsx_bitmap* bitmap, bool thread)
   {
     if (!thread)
-      return (void)worker(bitmap, filesystem, filename);
+    {
+      worker(bitmap, filesystem, filename);
+      bitmap->data_loading = false;
+      return;
+    }
 
     vsx_thread_pool<>::instance()->add(
       [=]
       (vsx_bitmap* bitmap, vsx::filesystem* filesystem, vsx_string<> filename)
       {
         worker(bitmap, filesystem, filename);
+        bitmap->data_loading = false;
       },
       bitmap,
       filesystem,
@@ -136,6 +136,9 @@ public:
   // has thread finished producing data when loading?
   std::atomic_uint_fast64_t data_ready;
 
+  // is a loader or generator thread still working on it? cleared whether or not it succeeded
+  std::atomic_bool data_loading;
+
   enum compression_type {
     compression_none = 0,
     compression_dxt1 = 1,
@@ -174,7 +177,7 @@ public:
 
   inline uint64_t data_size_get_all()
   {
-    uint64_t total_bytes;
+    uint64_t total_bytes = 0;
     for (size_t mipmap_level = 0; mipmap_level < 15; mipmap_level++)
       for (size_t cubemap_side = 0; cubemap_side < 6; cubemap_side++)
         total_bytes += data_size[mipmap_level][cubemap_side];
@@ -197,13 +200,13 @@ public:
     if (format == channel_storage_format::byte_storage)
     {
       size_t size_bytes = width * height * channels;
-      data_set( malloc(size_bytes), mip_map_level, cube_map_side );
+      data_set( malloc(size_bytes), mip_map_level, cube_map_side, size_bytes );
     }
 
     if (format == channel_storage_format::float_storage)
     {
       size_t size_bytes = sizeof(float) * width * height * channels;
-      data_set( malloc(size_bytes), mip_map_level, cube_map_side );
+      data_set( malloc(size_bytes), mip_map_level, cube_map_side, size_bytes );
     }
   }
 
@@ -237,6 +240,7 @@ public:
   vsx_bitmap()
   {
     data_ready = 0;
+    data_loading = false;
   }
 
   ~vsx_bitmap()
@@ -272,4 +276,25 @@ public:
     return sizeof(float) * channels;
   }
 
+  // bytes held, not all loaders record the size of what they set
+  uint64_t get_memory_size()
+  {
+    uint64_t total_bytes = 0;
+    for (size_t mip_map_level = 0; mip_map_level < mip_map_level_max; mip_map_level++)
+      for (size_t cube_map_side = 0; cube_map_side < 6; cube_map_side++)
+      {
+        if (!data[mip_map_level][cube_map_side])
+          continue;
+
+        if (data_size[mip_map_level][cube_map_side])
+        {
+          total_bytes += data_size[mip_map_level][cube_map_side];
+          continue;
+        }
+
+        total_bytes += (uint64_t)(width >> mip_map_level) * (uint64_t)(height >> mip_map_level) * get_channel_size();
+      }
+    return total_bytes;
+  }
+
 };
@@ -1,21 +1,37 @@
 #pragma once
 
 #include <map>
+#include <list>
+#include <unordered_map>
 #include <tools/vsx_thread_pool.h>
 #include <tools/vsx_lock.h>
 #include "vsx_bitmap_loader.h"
 
+/*
+  Bitmaps shared by filename and loader hint.
+
+  Items are indexed by a hash of (filename, hint) and by bitmap pointer.
+  When the last reference is destroyed the bitmap is kept around, unreferenced,
+  in least recently used order so that switching back to a state using it
+  doesn't load it again. Unreferenced bitmaps are deleted, oldest first, as soon
+  as they add up to more than the byte budget.
+*/
 class vsx_bitmap_cache
 {
 
   class vsx_bitmap_cache_item
   {
   public:
-    bool used = true;
     vsx_string<> filename;
     uint64_t hint;
+    uint64_t key;
     vsx_bitmap* bitmap;
 
+    // bytes counted against the budget while unreferenced
+    uint64_t bytes = 0;
+    bool unreferenced = false;
+    std::list<vsx_bitmap_cache_item*>::iterator lru_position;
+
     inline bool equals(const vsx_string<>& other_filename, uint64_t& other_hint)
     {
       if (vsx_string<>::s_equals(other_filename, filename) && hint == other_hint)
@@ -24,116 +40,179 @@ class vsx_bitmap_cache
     }
   };
 
-  vsx_nw_vector<vsx_bitmap_cache_item*> items;
-  vsx_lock lock;
+  std::unordered_multimap<uint64_t, vsx_bitmap_cache_item*> items;
+  std::unordered_map<vsx_bitmap*, vsx_bitmap_cache_item*> items_by_bitmap;
 
-  vsx_bitmap_cache_item* create_item()
-  {
-  lock.aquire();
-    foreach (items, i)
-      if (!items[i]->used)
-      {
-        items[i]->used = true;
-        lock.release();
-        return items[i];
-      }
-    vsx_bitmap_cache_item* item = new vsx_bitmap_cache_item();
-    items.push_back(item);
-    lock.release();
-    return item;
-  }
+  // unreferenced items, most recently used first
+  std::list<vsx_bitmap_cache_item*> lru;
+  uint64_t lru_bytes = 0;
+  uint64_t budget = 256 * 1024 * 1024;
+
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+
+  vsx_lock lock;
 
-  void recycle_item(vsx_bitmap_cache_item* item)
+  static uint64_t hash(const vsx_string<>& filename, uint64_t hint)
   {
-    lock.aquire();
-    foreach (items, i)
-      if (items[i] == item)
-        item->used = false;
-    lock.release();
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < filename.size(); i++)
+    {
+      h ^= (unsigned char)filename[i];
+      h *= 1099511628211ULL;
+    }
+    return h ^ (hint * 0x9E3779B97F4A7C15ULL);
   }
 
   vsx_bitmap_cache_item* get_item(vsx_string<>& filename, uint64_t& hint)
   {
-  lock.aquire();
-    foreach (items, i)
-      if (items[i]->equals(filename, hint))
-      {
-        vsx_bitmap_cache_item* item = items[i];
-        lock.release();
-        return item;
-      }
-    lock.release();
+    auto range = items.equal_range( hash(filename, hint) );
+    for (auto it = range.first; it != range.second; ++it)
+      if (it->second->equals(filename, hint))
+        return it->second;
     return 0;
   }
 
   vsx_bitmap_cache_item* get_item(vsx_bitmap* bitmap)
   {
-    lock.aquire();
-    foreach (items, i)
-      if (items[i]->bitmap == bitmap)
+    auto it = items_by_bitmap.find(bitmap);
+    if (it == items_by_bitmap.end())
+      return 0;
+    return it->second;
+  }
+
+  void remove_item(vsx_bitmap_cache_item* item)
+  {
+    auto range = items.equal_range(item->key);
+    for (auto it = range.first; it != range.second; ++it)
+      if (it->second == item)
       {
-        vsx_bitmap_cache_item* item = items[i];
-        lock.release();
-        return item;
+        items.erase(it);
+        break;
       }
-    lock.release();
-    return 0;
+    items_by_bitmap.erase(item->bitmap);
   }
 
-public:
+  // item is in use again
+  void revive_item(vsx_bitmap_cache_item* item)
+  {
+    lru.erase(item->lru_position);
+    lru_bytes -= item->bytes;
+    item->bytes = 0;
+    item->unreferenced = false;
+  }
 
-  vsx_bitmap* create(vsx_string<>& filename, uint64_t hint)
+  // called with the lock held, deletes unreferenced bitmaps until within budget
+  // and any that hold nothing, like a failed load
+  void evict()
+  {
+    auto it = lru.end();
+    while (it != lru.begin())
+    {
+      --it;
+      vsx_bitmap_cache_item* item = *it;
+
+      // a loader thread might still be writing to it
+      if (item->bitmap->data_loading)
+        continue;
+
+      if (lru_bytes <= budget && item->bytes)
+        continue;
+
+      it = lru.erase(it);
+      lru_bytes -= item->bytes;
+      remove_item(item);
+      delete item->bitmap;
+      delete item;
+      evictions++;
+    }
+  }
+
+  // called with the lock held
+  vsx_bitmap* create_item(vsx_string<>& filename, uint64_t hint)
   {
     vsx_bitmap* bitmap = new vsx_bitmap();
     bitmap->attached_to_cache = true;
     bitmap->references = 1;
     bitmap->hint = hint;
 
-    vsx_bitmap_cache_item* item = create_item();
+    vsx_bitmap_cache_item* item = new vsx_bitmap_cache_item();
     item->hint = hint;
     item->filename = filename;
+    item->key = hash(filename, hint);
     item->bitmap = bitmap;
 
+    items.insert( std::make_pair(item->key, item) );
+    items_by_bitmap[bitmap] = item;
+    misses++;
+    return bitmap;
+  }
+
+  // called with the lock held
+  vsx_bitmap* aquire_item(vsx_bitmap_cache_item* item)
+  {
+    if (item->unreferenced)
+      revive_item(item);
+
+    item->bitmap->references++;
+    hits++;
+    return item->bitmap;
+  }
+
+public:
+
+  vsx_bitmap* create(vsx_string<>& filename, uint64_t hint)
+  {
+    lock.aquire();
+    vsx_bitmap* bitmap = create_item(filename, hint);
+    lock.release();
     return bitmap;
   }
 
   bool has(vsx_string<>& filename, uint64_t hint)
   {
     lock.aquire();
-    foreach (items, i)
-      if (items[i]->equals(filename, hint))
-        if (items[i]->used)
-        {
-          lock.release();
-          return true;
-        }
+    bool found = get_item(filename, hint) != 0;
     lock.release();
-    return false;
+    return found;
   }
 
   vsx_bitmap* aquire(vsx_string<>& filename, uint64_t hint)
   {
+    lock.aquire();
     vsx_bitmap_cache_item* item = get_item(filename, hint);
     if (!item)
+    {
+      lock.release();
       VSX_ERROR_RETURN_V("Invalid texture data item", 0x0);
+    }
 
-    item->bitmap->references++;
-    return item->bitmap;
+    vsx_bitmap* bitmap = aquire_item(item);
+    lock.release();
+    return bitmap;
   }
 
   vsx_bitmap* aquire_reload( vsx_string<>& filename, vsx::filesystem* filesystem, bool thread, uint64_t hint)
   {
+    lock.aquire();
     vsx_bitmap_cache_item* item = get_item(filename, hint);
+    lock.release();
+    req_error_v(item, "Invalid bitmap cache item", 0x0);
     vsx_bitmap* bitmap = item->bitmap;
     vsx_bitmap_loader::reload(bitmap, bitmap->filename, filesystem, thread, hint );
     return bitmap;
   }
 
+  // one lock for the lookup and the create, so eviction can't slip in between
   vsx_bitmap* aquire_create(vsx_string<>& filename, uint64_t hint)
   {
-    if (has(filename, hint))
-      return aquire(filename, hint);
-    return create(filename, hint);
+    lock.aquire();
+    vsx_bitmap_cache_item* item = get_item(filename, hint);
+    vsx_bitmap* bitmap = item ? aquire_item(item) : create_item(filename, hint);
+    lock.release();
+    return bitmap;
   }
 
   void destroy(vsx_bitmap*& bitmap)
@@ -141,27 +220,79 @@ public:
     if (!bitmap->attached_to_cache)
       VSX_ERROR_RETURN("Trying to destroy a non-cached bitmap...");
 
+    lock.aquire();
     vsx_bitmap_cache_item* item = get_item(bitmap);
 
     if (!item)
+    {
+      lock.release();
       VSX_ERROR_RETURN("Bitmap not found in cache");
+    }
 
     // decrease references
     item->bitmap->references--;
 
     // still more references
     if (item->bitmap->references)
+    {
+      lock.release();
       return;
+    }
 
-    delete item->bitmap;
-    recycle_item(item);
+    // keep it until the budget runs out
+    item->unreferenced = true;
+    item->bytes = item->bitmap->get_memory_size();
+    lru.push_front(item);
+    item->lru_position = lru.begin();
+    lru_bytes += item->bytes;
+    evict();
+    lock.release();
     bitmap = 0;
   }
 
+  // bytes of unreferenced bitmaps to keep, 0 frees them right away
+  void set_budget(uint64_t bytes)
+  {
+    lock.aquire();
+    budget = bytes;
+    evict();
+    lock.release();
+  }
+
+  uint64_t get_budget()
+  {
+    return budget;
+  }
+
+  uint64_t get_hits()
+  {
+    return hits;
+  }
+
+  uint64_t get_misses()
+  {
+    return misses;
+  }
+
+  uint64_t get_evictions()
+  {
+    return evictions;
+  }
+
+  uint64_t get_unreferenced_bytes()
+  {
+    return lru_bytes;
+  }
+
+  size_t get_item_count()
+  {
+    return items.size();
+  }
+
   ~vsx_bitmap_cache()
   {
-    foreach (items, i)
-      delete items[i];
+    for (auto it = items.begin(); it != items.end(); ++it)
+      delete it->second;
   }
 
   static vsx_bitmap_cache* get_instance()
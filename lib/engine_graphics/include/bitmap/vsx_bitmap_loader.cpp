@@ -32,7 +32,8 @@ void vsx_bitmap_loader::reload(vsx_bitmap *bitmap, vsx_string<> filename, vsx::f
 
 void vsx_bitmap_loader::load(vsx_bitmap *bitmap, vsx_string<> filename, vsx::filesystem *filesystem, bool thread, uint64_t hint)
 {
-  if (bitmap->references > 1)
+  // shared, or kept loaded by the cache
+  if (bitmap->references > 1 || bitmap->data_ready)
     ret(bitmap->timestamp = vsx_singleton_counter::get());
   bitmap->hint = hint;
 
@@ -1,21 +1,36 @@
 #pragma once
 
+#include <list>
+#include <unordered_map>
 #include <texture/vsx_texture.h>
 #include <bitmap/vsx_bitmap_cache.h>
 #include <tools/vsx_thread_pool.h>
 
+/*
+  GL textures shared by filename, bitmap loader hint and gl hint.
+
+  Works like vsx_bitmap_cache: hashed lookup, and textures whose last reference
+  is destroyed stay uploaded (holding on to their bitmap) until the unreferenced
+  ones exceed the byte budget. Eviction deletes GL objects, so this must only be
+  used from the GL thread.
+*/
 class vsx_texture_gl_cache
 {
 
   class vsx_texture_gl_cache_item
   {
   public:
-    bool used = true;
     vsx_string<> filename;
     uint64_t bitmap_loader_hint;
     uint64_t hint;
+    uint64_t key;
     vsx_texture_gl* texture_gl;
 
+    // bytes counted against the budget while unreferenced
+    uint64_t bytes = 0;
+    bool unreferenced = false;
+    std::list<vsx_texture_gl_cache_item*>::iterator lru_position;
+
     inline bool equals(const vsx_string<>& other_filename, uint64_t other_bitmap_loader_hint, uint64_t& other_hint)
     {
       if (vsx_string<>::s_equals(other_filename, filename)
@@ -29,55 +44,98 @@ class vsx_texture_gl_cache
     }
   };
 
-  vsx_nw_vector<vsx_texture_gl_cache_item*> items;
+  std::unordered_multimap<uint64_t, vsx_texture_gl_cache_item*> items;
+  std::unordered_map<vsx_texture_gl*, vsx_texture_gl_cache_item*> items_by_texture;
   vsx_lock items_lock;
 
-  void create_item(vsx_string<>& filename, uint64_t bitmap_loader_hint, uint64_t hint, vsx_texture_gl* texture_gl)
-  {
-    vsx_texture_gl_cache_item* item = 0x0;
-    items_lock.aquire();
-    foreach (items, i)
-      if (!items[i]->used)
-      {
-        items[i]->used = true;
-        item = items[i];
-        break;
-      }
+  // unreferenced items, most recently used first
+  std::list<vsx_texture_gl_cache_item*> lru;
+  uint64_t lru_bytes = 0;
+  uint64_t budget = 256 * 1024 * 1024;
 
-    if (!item)
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+
+  static uint64_t hash(const vsx_string<>& filename, uint64_t bitmap_loader_hint, uint64_t hint)
+  {
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < filename.size(); i++)
     {
-      item = new vsx_texture_gl_cache_item();
-      items.push_back(item);
+      h ^= (unsigned char)filename[i];
+      h *= 1099511628211ULL;
     }
+    h ^= bitmap_loader_hint * 0x9E3779B97F4A7C15ULL;
+    h *= 1099511628211ULL;
+    return h ^ (hint * 0xC2B2AE3D27D4EB4FULL);
+  }
 
+  void create_item(vsx_string<>& filename, uint64_t bitmap_loader_hint, uint64_t hint, vsx_texture_gl* texture_gl)
+  {
+    vsx_texture_gl_cache_item* item = new vsx_texture_gl_cache_item();
     item->filename = filename;
     item->bitmap_loader_hint = bitmap_loader_hint;
     item->hint = hint;
+    item->key = hash(filename, bitmap_loader_hint, hint);
     item->texture_gl = texture_gl;
+
+    items_lock.aquire();
+    items.insert( std::make_pair(item->key, item) );
+    items_by_texture[texture_gl] = item;
+    misses++;
     items_lock.release();
   }
 
-  void recycle_item(vsx_texture_gl_cache_item* item)
+  void remove_item(vsx_texture_gl_cache_item* item)
   {
-    foreach (items, i)
-      if (items[i] == item)
-        item->used = false;
+    auto range = items.equal_range(item->key);
+    for (auto it = range.first; it != range.second; ++it)
+      if (it->second == item)
+      {
+        items.erase(it);
+        break;
+      }
+    items_by_texture.erase(item->texture_gl);
   }
 
   vsx_texture_gl_cache_item* get_item(vsx_string<>& filename, uint64_t bitmap_loader_hint, uint64_t& hint)
   {
-    foreach (items, i)
-      if (items[i]->equals(filename, bitmap_loader_hint, hint))
-        return items[i];
+    auto range = items.equal_range( hash(filename, bitmap_loader_hint, hint) );
+    for (auto it = range.first; it != range.second; ++it)
+      if (it->second->equals(filename, bitmap_loader_hint, hint))
+        return it->second;
     return 0;
   }
 
   vsx_texture_gl_cache_item* get_item(vsx_texture_gl* texture_gl)
   {
-    foreach (items, i)
-      if (items[i]->texture_gl == texture_gl)
-        return items[i];
-    return 0;
+    auto it = items_by_texture.find(texture_gl);
+    if (it == items_by_texture.end())
+      return 0;
+    return it->second;
+  }
+
+  // deletes unreferenced textures until within budget
+  void evict()
+  {
+    while (lru_bytes > budget && lru.size())
+    {
+      vsx_texture_gl_cache_item* item = lru.back();
+      lru.pop_back();
+      lru_bytes -= item->bytes;
+
+      items_lock.aquire();
+      remove_item(item);
+      items_lock.release();
+
+      // the reference kept while unreferenced
+      vsx_bitmap_cache::get_instance()->destroy( item->texture_gl->bitmap );
+      item->texture_gl->unload();
+      delete item->texture_gl;
+      delete item;
+      evictions++;
+    }
   }
 
 public:
@@ -97,27 +155,40 @@ public:
 
   void dump_to_stdout()
   {
-    foreach (items, i)
-      vsx_printf(L"item filename: %hs %d\n", items[i]->filename.c_str(), items[i]->used);
+    for (auto it = items.begin(); it != items.end(); ++it)
+      vsx_printf(L"item filename: %hs %d\n", it->second->filename.c_str(), !it->second->unreferenced);
   }
 
   bool has(vsx_string<>& filename, uint64_t bitmap_loader_hint, uint64_t hint)
   {
-    foreach (items, i)
-      if (items[i]->equals(filename, bitmap_loader_hint, hint))
-        if (items[i]->used)
-          return true;
-    return false;
+    items_lock.aquire();
+    bool found = get_item(filename, bitmap_loader_hint, hint) != 0;
+    items_lock.release();
+    return found;
   }
 
   vsx_texture_gl* aquire(vsx_string<>& filename, vsx::filesystem* filesystem, bool reload_with_thread, uint64_t bitmap_loader_hint, uint64_t hint, bool reload = false)
   {
+    items_lock.aquire();
     vsx_texture_gl_cache_item* item = get_item(filename, bitmap_loader_hint, hint);
+    items_lock.release();
     req_error_v(item, "Invalid cache item", 0x0);
 
-    if (!reload)
+    // kept since its last reference was destroyed, still holds its bitmap
+    bool revived = item->unreferenced;
+    if (revived)
+    {
+      lru.erase(item->lru_position);
+      lru_bytes -= item->bytes;
+      item->bytes = 0;
+      item->unreferenced = false;
+    }
+
+    if (!reload || revived)
       item->texture_gl->references++;
 
+    hits++;
+
     // reload data
     if (reload)
     {
@@ -127,6 +198,9 @@ public:
       return item->texture_gl;
     }
 
+    if (revived)
+      return item->texture_gl;
+
     item->texture_gl->bitmap = vsx_bitmap_cache::get_instance()->aquire( filename, bitmap_loader_hint );
     return item->texture_gl;
   }
@@ -135,38 +209,81 @@ public:
   {
     if (has(filename, bitmap_loader_hint, hint))
       return aquire(filename, filesystem, false, bitmap_loader_hint, hint);
+    return create(filename, bitmap_loader_hint, hint);
   }
 
   void destroy(vsx_texture_gl*& texture_gl)
   {
     req(texture_gl);
 
+    items_lock.aquire();
     vsx_texture_gl_cache_item* item = get_item(texture_gl);
+    items_lock.release();
     if (!item)
       VSX_ERROR_RETURN("Invalid cache item");
 
-    vsx_bitmap_cache::get_instance()->destroy( item->texture_gl->bitmap );
-
     // decrease references
     item->texture_gl->references--;
 
     // still more references
     if (item->texture_gl->references)
     {
+      vsx_bitmap_cache::get_instance()->destroy( item->texture_gl->bitmap );
       texture_gl = 0x0;
       return;
     }
 
-    item->texture_gl->unload();
-    delete item->texture_gl;
-    recycle_item(item);
+    // keep it, and its bitmap reference, until the budget runs out
+    item->unreferenced = true;
+    item->bytes = item->texture_gl->bitmap ? item->texture_gl->bitmap->get_memory_size() : 0;
+    lru.push_front(item);
+    item->lru_position = lru.begin();
+    lru_bytes += item->bytes;
+    evict();
     texture_gl = 0x0;
   }
 
+  // bytes of unreferenced textures to keep, 0 frees them right away
+  void set_budget(uint64_t bytes)
+  {
+    budget = bytes;
+    evict();
+  }
+
+  uint64_t get_budget()
+  {
+    return budget;
+  }
+
+  uint64_t get_hits()
+  {
+    return hits;
+  }
+
+  uint64_t get_misses()
+  {
+    return misses;
+  }
+
+  uint64_t get_evictions()
+  {
+    return evictions;
+  }
+
+  uint64_t get_unreferenced_bytes()
+  {
+    return lru_bytes;
+  }
+
+  size_t get_item_count()
+  {
+    return items.size();
+  }
+
   ~vsx_texture_gl_cache()
   {
-    foreach (items, i)
-      delete items[i];
+    for (auto it = items.begin(); it != items.end(); ++it)
+      delete it->second;
   }
 
   static vsx_texture_gl_cache* get_instance()
@@ -24,6 +24,7 @@
 
 #include <bitmap/vsx_bitmap.h>
 #include <texture/vsx_texture.h>
+#include <module/vsx_module_job.h>
 
 class module_bitmap_add_noise : public vsx_module
 {
@@ -34,57 +35,21 @@ class module_bitmap_add_noise : public vsx_module
   vsx_module_param_bitmap* bitmap_out;
 
   // internal
-  float time;
   vsx_bitmap* source_bitmap;
   vsx_bitmap bitmap;
 
-  int buf = 0;
-  int frame = 0;
-  void* data_a = 0x0;
-  void* data_b = 0x0;
-  int bitm_timestamp;
-  std::atomic_uint_fast8_t worker_run;
-  std::thread         worker_thread;
+  // the job fills buffers.back() from the source, bitmap points at buffers.front()
+  vsx_module_job job;
+  vsx_module_job_double_buffer< vsx_ma_vector<uint32_t> > buffers;
+  unsigned int job_width = 0;
+  unsigned int job_height = 0;
 
 public:
 
-  module_bitmap_add_noise()
+  void noise_worker(uint32_t* p, uint32_t* source, size_t count)
   {
-    worker_run = 0;
-  }
-
-  void noise_worker()
-  {
-    int i_frame = -1;
-    bool buf = false;
-    uint32_t *p;
-    while (worker_run.load())
-    {
-      if (i_frame == frame)
-      {
-        Sleep(100);
-        continue;
-      }
-
-      if (buf)
-        p = (uint32_t*)data_a;
-      else
-        p = (uint32_t*)data_b;
-
-      unsigned long b_c = bitmap.width * bitmap.height;
-
-      if (bitmap.storage_format == vsx_bitmap::byte_storage && bitmap.channels == 4)
-      {
-        for (size_t x = 0; x < b_c; ++x)
-        {
-            p[x] = ((uint32_t*)bitmap.data_get() )[x] | rand() << 8  | (unsigned char)rand(); //bitm->data[x + y*result_bitm.size_x]
-        }
-      }
-      bitmap.data_set( p );
-      bitmap.timestamp++;
-      buf = !buf;
-      i_frame = frame;
-    }
+    for (size_t x = 0; x < count; ++x)
+      p[x] = source[x] | rand() << 8  | (unsigned char)rand();
   }
 
   void module_info(vsx_module_specification* info)
@@ -100,63 +65,70 @@ public:
   {
     bitmap_in = (vsx_module_param_bitmap*)in_parameters.create(VSX_MODULE_PARAM_ID_BITMAP,"bitmap_in");
     bitmap_out = (vsx_module_param_bitmap*)out_parameters.create(VSX_MODULE_PARAM_ID_BITMAP,"bitmap");
+
+    // the buffers are ours
+    bitmap.data_mark_volatile();
   }
 
   void run()
   {
     source_bitmap = bitmap_in->get();
-    if (!source_bitmap)
+    if (
+      !source_bitmap
+      ||
+      !source_bitmap->data_ready
+      ||
+      !source_bitmap->data_get()
+      ||
+      source_bitmap->storage_format != vsx_bitmap::byte_storage
+      ||
+      source_bitmap->channels != 4
+    )
     {
-      if (worker_run.load())
-        worker_run.fetch_sub(1);
-      worker_thread.join();
+      job.cancel();
       bitmap_out->valid = false;
       return;
     }
 
-    bitmap.copy_information_from( *source_bitmap );
-    ++frame;
+    if (job.collect())
+    {
+      buffers.swap();
+      bitmap.copy_information_from( *source_bitmap );
+      bitmap.width = job_width;
+      bitmap.height = job_height;
+      bitmap.data_set( buffers.front().get_pointer() );
+      bitmap.timestamp++;
+      bitmap.data_ready = 1;
+      bitmap_out->set(&bitmap);
+    }
+
+    req(!job.is_busy());
+
+    job_width = source_bitmap->width;
+    job_height = source_bitmap->height;
+    size_t count = job_width * job_height;
+    req(count);
 
-    if (bitmap.width != source_bitmap->width && bitmap.height != source_bitmap->height)
+    // the front buffer is still out, only the back one can be resized
+    if (buffers.back().size() != count)
     {
-      if (worker_run.load())
-      {
-        worker_run.fetch_sub(1);
-        worker_thread.join();
-      }
-
-      if (data_a)
-      {
-        free( data_a );
-        free( data_b );
-      }
-
-      data_a = malloc( sizeof(uint32_t) * source_bitmap->width * source_bitmap->height);
-      data_b = malloc( sizeof(uint32_t) * source_bitmap->width * source_bitmap->height);
-
-      bitmap.data_set( data_a );
-      bitmap.width = source_bitmap->width;
-      bitmap.height = source_bitmap->height;
-
-      worker_run.fetch_add(1);
-      worker_thread = std::thread( [this](){noise_worker();} );
+      buffers.back().reset_used();
+      buffers.back().allocate(count - 1);
     }
 
-    bitmap_out->set(&bitmap);
+    uint32_t* p = buffers.back().get_pointer();
+    uint32_t* source = (uint32_t*)source_bitmap->data_get();
+    job.submit(
+      engine_state,
+      vsx_module_job_system::priority_frame,
+      [this, p, source, count]() { noise_worker(p, source, count); }
+    );
   }
 
   void on_delete()
   {
-    if (worker_run)
-    {
-      worker_run = false;
-      bitmap_out->valid = false;
-
-    }
-    free(data_a);
-    free(data_b);
+    job.cancel();
+    bitmap_out->valid = false;
   }
 
 };
-
-
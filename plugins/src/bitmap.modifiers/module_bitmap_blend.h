@@ -22,7 +22,7 @@
 */
 
 #include <bitmap/vsx_bitmap.h>
-#include <thread>
+#include <module/vsx_module_job.h>
 
 typedef unsigned char uint8;
 
@@ -112,7 +112,7 @@ public:
   // internal
   uint64_t bitm_timestamp = -1;
 
-  std::thread worker_thread;
+  vsx_module_job job;
 
   int p_updates = 0;
   uint64_t timestamp_1 = -1;
@@ -124,7 +124,7 @@ public:
 
   void* to_delete_data = 0;
 
-  // our worker thread, to keep the tough generating work off the main loop
+  // our worker job, to keep the tough generating work off the main loop
   // this is a fairly simple operation, but when you want to generate fractals
   // and decode film, you could run into several seconds of processing time.
   void worker()
@@ -320,9 +320,8 @@ public:
       to_delete_data = 0;
     }
 
-    if (bitmap.data_ready && worker_thread.joinable())
+    if (job.collect())
     {
-      worker_thread.join();
       //bitmap.data_ready = 0;
       bitm_timestamp = bitmap.timestamp;
       bitmap_out->set(&bitmap);
@@ -339,7 +338,7 @@ public:
     req(bitmap_source_2);
     req(bitmap_source_1->data_ready);
     req(bitmap_source_2->data_ready);
-    req(!worker_thread.joinable());
+    req(!job.is_busy());
     req(
           bitmap_source_1->timestamp != timestamp_1
         ||
@@ -366,13 +365,12 @@ public:
       bitmap.height = (unsigned int)target_size_in->get(1);
     }
 
-    worker_thread = std::thread( [this](){worker();} );
+    job.submit(engine_state, vsx_module_job_system::priority_frame, [this](){worker();} );
   }
 
   void on_delete()
   {
-    if (worker_thread.joinable())
-      worker_thread.join();
+    job.cancel();
   }
 
 };
@@ -63,6 +63,7 @@ public:
 
     particles.timestamp = 0;
     particles.particles = new vsx_ma_vector< vsx_particle<> >;
+    particles.particles_soa = new vsx_particle_soa<>;
     loading_done = true;
     first = true;
     p_updates = param_updates;
@@ -99,6 +100,9 @@ public:
 
     bitmap = *(bitmap_in->get_addr());
 
+    // pick up what modifiers did to the particles last frame
+    particles.get_aos();
+
     if (p_updates != param_updates)
     {
       first = true;
@@ -155,6 +159,7 @@ public:
   ~module_bitmap_to_particlesystem()
   {
     delete particles.particles;
+    delete particles.particles_soa;
   }
 
 };
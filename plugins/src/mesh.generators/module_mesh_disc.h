@@ -59,6 +59,9 @@ public:
 
     info->component_class =
       "mesh";
+
+    info->thread_safe = true;
+    info->init_thread_safe = true;
   }
 
   void declare_params(vsx_module_param_list& in_parameters, vsx_module_param_list& out_parameters)
@@ -1,9 +1,7 @@
 #include "cal3d/cal3d.h"
 #define VSXU_DEBUG 1
-#if (PLATFORM == PLATFORM_LINUX)
-  #include <sys/prctl.h>
-#endif
 #include <time/vsx_timer.h>
+#include <module/vsx_module_job.h>
 
 #include <profiler/vsx_profiler_manager.h>
 
@@ -32,11 +30,6 @@ typedef struct {
   vsx_module_param_float* weight;
 } morph_info;
 
-typedef struct {
-  std::atomic_uint_fast64_t is_thread;
-  void* class_pointer;
-} cal3d_thread_info;
-
 class module_mesh_cal3d_import : public vsx_module {
 public:
 	VSXP_CLASS_DECLARE
@@ -74,19 +67,14 @@ public:
     vsx_nw_vector<morph_info> morphs;
 
     // threading stuff
-    std::thread worker_thread;
+    vsx_module_job job;
     vsx_mesh<>* mesh = 0x0; // locked by the mesh
 
     int p_updates;
-    bool              worker_running;
-    bool              thread_created;
-    int               thread_state;
     uint64_t               times_run;
-    cal3d_thread_info thread_info;
 
     std::atomic_uint_fast64_t worker_produce;
     std::atomic_uint_fast64_t param_produce;
-    std::atomic_uint_fast64_t thread_exit;
 
     float time_to_animate = 1.0f / 120.0f;
 
@@ -106,21 +94,13 @@ public:
 
     m_model = 0;
     c_model = 0;
-    thread_state = 0;
-    thread_exit = 0;
-    worker_running = false;
-    thread_created = false;
     p_updates = -1;
 
     // signalling
     worker_produce = 0;
     param_produce = 0;
-    thread_exit = 0;
 
     times_run = 0;
-
-    thread_info.class_pointer = 0x0;
-    thread_info.is_thread = 0;
   }
 
   bool init()
@@ -130,20 +110,7 @@ public:
 
   void on_delete()
   {
-    if (thread_created)
-    {
-      thread_exit.fetch_add(1);
-
-      // make thread do a dry run if not already running
-      if (!param_produce.load())
-          param_produce.fetch_add(1);
-
-      if (param_produce.load()) // we have sent some work to the thread
-        while ( param_produce.load() && !worker_produce.load())
-        {}
-
-      worker_thread.join();
-    }
+    job.cancel();
 
     if (c_model) {
       delete (CalCoreModel*)c_model;
@@ -248,6 +215,7 @@ public:
     wait_for_thread = (vsx_module_param_int*)in_parameters.create(VSX_MODULE_PARAM_ID_INT,"wait_for_thread");
     wait_for_thread->set(0);
 
+    // unused since the worker runs as a job, kept for existing states
     thread_sync_strategy = (vsx_module_param_int*)in_parameters.create(VSX_MODULE_PARAM_ID_INT,"thread_sync_strategy");
     thread_sync_strategy->set(0);
 
@@ -312,14 +280,12 @@ public:
     redeclare_out_params(out_parameters);
     first_run = true;
     c_model = 0;
-    thread_info.class_pointer = (void*)this;
   }
 
   void param_set_notify(const vsx_string<>& name)
   {
-    if (param_produce.load())
-      while (param_produce.load())
-      {}
+    // the worker job uses the model
+    job.wait();
 
 
     if (name == "filename") {
@@ -464,218 +430,177 @@ public:
     int first_rendering = 0;
 
     vsx_timer timer;
-    #if (PLATFORM == PLATFORM_LINUX)
-      if (thread_info.is_thread.load())
-      {
-        const char* cal = "cal3d::worker";
-        prctl(PR_SET_NAME,cal);
-      }
-    #endif
-
-    forever
-    {
-      if (thread_info.is_thread.load())
-      {
-        if (thread_sync_strategy->get() == 0)
-          while (!param_produce.load())
-            std::this_thread::sleep_for(std::chrono::microseconds(1));
-
-        if (thread_sync_strategy->get() == 1)
-          while (!param_produce.load())
-            #if (PLATFORM == PLATFORM_LINUX)
-              sched_yield();
-            #else
-              Sleep(0);
-            #endif
-
-        if (thread_sync_strategy->get() == 2)
-          while (!param_produce.load())
-          {}
-      }
+    timer.start();
 
-      timer.start();
+    CalSkeleton* m_skeleton = m_model->getSkeleton();
+    m_skeleton->calculateState();
 
-      CalSkeleton* m_skeleton = m_model->getSkeleton();
-      m_skeleton->calculateState();
+    CalRenderer *pCalRenderer;
+    pCalRenderer = m_model->getRenderer();
+    pCalRenderer->beginRendering();
+    int meshCount;
+    meshCount = pCalRenderer->getMeshCount();
 
-      CalRenderer *pCalRenderer;
-      pCalRenderer = m_model->getRenderer();
-      pCalRenderer->beginRendering();
-      int meshCount;
-      meshCount = pCalRenderer->getMeshCount();
+    int meshId;
+    for(meshId = 0; meshId < meshCount; meshId++)
+    {
+      // get the number of submeshes
+      int submeshCount;
+      submeshCount = pCalRenderer->getSubmeshCount(meshId);
 
-      int meshId;
-      for(meshId = 0; meshId < meshCount; meshId++)
+      // loop through all submeshes of the mesh
+      int submeshId;
+      for(submeshId = 0; submeshId < submeshCount; submeshId++)
       {
-        // get the number of submeshes
-        int submeshCount;
-        submeshCount = pCalRenderer->getSubmeshCount(meshId);
-
-        // loop through all submeshes of the mesh
-        int submeshId;
-        for(submeshId = 0; submeshId < submeshCount; submeshId++)
+        // select mesh and submesh for further data access
+        if(pCalRenderer->selectMeshSubmesh(meshId, submeshId))
         {
-          // select mesh and submesh for further data access
-          if(pCalRenderer->selectMeshSubmesh(meshId, submeshId))
-          {
-            mesh->data->vertices[pCalRenderer->getVertexCount()+1] = vsx_vector3<>(0,0,0);
-            pCalRenderer->getVertices(&mesh->data->vertices[0].x);
+          mesh->data->vertices[pCalRenderer->getVertexCount()+1] = vsx_vector3<>(0,0,0);
+          pCalRenderer->getVertices(&mesh->data->vertices[0].x);
 
-            mesh->data->vertex_normals[pCalRenderer->getVertexCount()+1] = vsx_vector3<>(0,0,0);
-            pCalRenderer->getNormals(&mesh->data->vertex_normals[0].x);
-
-            if (pCalRenderer->isTangentsEnabled(0))
-            {
-              //mesh->data->vertex_tangents[pCalRenderer->getVertexCount()+1].x = 0;// = vsx_vector(0,0,0);
-              //int num_tagentspaces = pCalRenderer->getTangentSpaces(0,&mesh->data->vertex_tangents[0].x);
-            }
+          mesh->data->vertex_normals[pCalRenderer->getVertexCount()+1] = vsx_vector3<>(0,0,0);
+          pCalRenderer->getNormals(&mesh->data->vertex_normals[0].x);
 
+          if (pCalRenderer->isTangentsEnabled(0))
+          {
+            //mesh->data->vertex_tangents[pCalRenderer->getVertexCount()+1].x = 0;// = vsx_vector(0,0,0);
+            //int num_tagentspaces = pCalRenderer->getTangentSpaces(0,&mesh->data->vertex_tangents[0].x);
+          }
 
-            if (first_rendering < 4)
-            {
-              mesh->data->vertex_tex_coords[pCalRenderer->getVertexCount()+1].s = 0;
-              pCalRenderer->getTextureCoordinates(0,&mesh->data->vertex_tex_coords[0].s);
 
-              int faceCount = pCalRenderer->getFaceCount();
-              (mesh)->data->faces.allocate(faceCount*3);
-              pCalRenderer->getFaces((int*)&(mesh)->data->faces[0].a);
-              (mesh)->data->faces.reset_used(faceCount);
-              first_rendering++;
-            }
+          if (first_rendering < 4)
+          {
+            mesh->data->vertex_tex_coords[pCalRenderer->getVertexCount()+1].s = 0;
+            pCalRenderer->getTextureCoordinates(0,&mesh->data->vertex_tex_coords[0].s);
+
+            int faceCount = pCalRenderer->getFaceCount();
+            (mesh)->data->faces.allocate(faceCount*3);
+            pCalRenderer->getFaces((int*)&(mesh)->data->faces[0].a);
+            (mesh)->data->faces.reset_used(faceCount);
+            first_rendering++;
           }
         }
       }
+    }
 
-      // end the rendering of the model
-      pCalRenderer->endRendering();
+    // end the rendering of the model
+    pCalRenderer->endRendering();
 
-      // ********************************************************************
-      // perform transforms
+    // ********************************************************************
+    // perform transforms
 
-      post_rot_translate_vec += rot_center;
+    post_rot_translate_vec += rot_center;
 
-      pre_rotation_mat = pre_rotation_quaternion.matrix();
-      rotation_mat = rotation_quaternion.matrix();
+    pre_rotation_mat = pre_rotation_quaternion.matrix();
+    rotation_mat = rotation_quaternion.matrix();
 
-      unsigned long end = (mesh)->data->vertices.size();
-      vsx_vector3<>* vs_v = &(mesh)->data->vertices[0];
-      vsx_vector3<>* vs_n = &(mesh)->data->vertex_normals[0];
+    unsigned long end = (mesh)->data->vertices.size();
+    vsx_vector3<>* vs_v = &(mesh)->data->vertices[0];
+    vsx_vector3<>* vs_n = &(mesh)->data->vertex_normals[0];
 
 
-      for (unsigned long i = 0; i < end; i++)
-      {
-        // pre rotation
-        vs_v->multiply_matrix_other_vec
-        (
-          &pre_rotation_mat.m[0],
-          *vs_v - pre_rot_center
-        );
-        (*vs_v) += pre_rot_center;
-        vsx_vector3<> n = *vs_n;
-        vs_n->multiply_matrix_other_vec(
-          &pre_rotation_mat.m[0],
-          n
-        );
-
-
-        // post rotation
-        vs_v->multiply_matrix_other_vec
-        (
-          &rotation_mat.m[0],
-          *vs_v - rot_center
-        );
-        // vertex offset
-        (*vs_v) += post_rot_translate_vec;
-        // normal rotation
-        n = *vs_n;
-        vs_n->multiply_matrix_other_vec(
-          &rotation_mat.m[0],
-          n
-        );
-        vs_v++;
-        vs_n++;
-      }
+    for (unsigned long i = 0; i < end; i++)
+    {
+      // pre rotation
+      vs_v->multiply_matrix_other_vec
+      (
+        &pre_rotation_mat.m[0],
+        *vs_v - pre_rot_center
+      );
+      (*vs_v) += pre_rot_center;
+      vsx_vector3<> n = *vs_n;
+      vs_n->multiply_matrix_other_vec(
+        &pre_rotation_mat.m[0],
+        n
+      );
 
-      // ********************************************************************
-      // calculate tangent space coordinates
 
-      mesh->data->vertex_colors.allocate( mesh->data->vertices.size() );
-      mesh->data->vertex_colors.memory_clear();
+      // post rotation
+      vs_v->multiply_matrix_other_vec
+      (
+        &rotation_mat.m[0],
+        *vs_v - rot_center
+      );
+      // vertex offset
+      (*vs_v) += post_rot_translate_vec;
+      // normal rotation
+      n = *vs_n;
+      vs_n->multiply_matrix_other_vec(
+        &rotation_mat.m[0],
+        n
+      );
+      vs_v++;
+      vs_n++;
+    }
 
-      vsx_quaternion<>* vec_d = (vsx_quaternion<>*)mesh->data->vertex_colors.get_pointer();
+    // ********************************************************************
+    // calculate tangent space coordinates
 
-      for (unsigned long a = 0; a < mesh->data->faces.size(); a++)
-      {
-        long i1 = mesh->data->faces[a].a;
-        long i2 = mesh->data->faces[a].b;
-        long i3 = mesh->data->faces[a].c;
-
-        const vsx_vector3<>& v1 = mesh->data->vertices[i1];
-        const vsx_vector3<>& v2 = mesh->data->vertices[i2];
-        const vsx_vector3<>& v3 = mesh->data->vertices[i3];
-
-        const vsx_tex_coord2f& w1 = mesh->data->vertex_tex_coords[i1];
-        const vsx_tex_coord2f& w2 = mesh->data->vertex_tex_coords[i2];
-        const vsx_tex_coord2f& w3 = mesh->data->vertex_tex_coords[i3];
-
-        float x1 = v2.x - v1.x;
-        float x2 = v3.x - v1.x;
-        float y1 = v2.y - v1.y;
-        float y2 = v3.y - v1.y;
-        float z1 = v2.z - v1.z;
-        float z2 = v3.z - v1.z;
-
-        float s1 = w2.s - w1.s;
-        float s2 = w3.s - w1.s;
-        float t1 = w2.t - w1.t;
-        float t2 = w3.t - w1.t;
-
-        float r = 1.0f / (s1 * t2 - s2 * t1);
-        vsx_quaternion<> sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
-        //vsx_vector sdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r,(s1 * z2 - s2 * z1) * r);
-
-        vec_d[i1] += sdir;
-        vec_d[i2] += sdir;
-        vec_d[i3] += sdir;
-
-        //tan2[i1] += tdir;
-        //tan2[i2] += tdir;
-        //tan2[i3] += tdir;
-      }
-      for (unsigned long a = 0; a < mesh->data->vertices.size(); a++)
-      {
-          vsx_vector3<>& n = mesh->data->vertex_normals[a];
-          vsx_quaternion<>& t = vec_d[a];
+    mesh->data->vertex_colors.allocate( mesh->data->vertices.size() );
+    mesh->data->vertex_colors.memory_clear();
 
-          // Gram-Schmidt orthogonalize
-          //vec_d[a] = (t - n * t.dot_product(&n) );
-          vec_d[a] = (t - n * t.dot_product(&n) );
-          vec_d[a].normalize();
-          vec_d[a].w = 1.0f;//(float)a;
+    vsx_quaternion<>* vec_d = (vsx_quaternion<>*)mesh->data->vertex_colors.get_pointer();
 
-          // Calculate handedness
-          //tangent[a].w = (Dot(Cross(n, t), tan2[a]) < 0.0F) ? -1.0F : 1.0F;
-      }
+    for (unsigned long a = 0; a < mesh->data->faces.size(); a++)
+    {
+      long i1 = mesh->data->faces[a].a;
+      long i2 = mesh->data->faces[a].b;
+      long i3 = mesh->data->faces[a].c;
+
+      const vsx_vector3<>& v1 = mesh->data->vertices[i1];
+      const vsx_vector3<>& v2 = mesh->data->vertices[i2];
+      const vsx_vector3<>& v3 = mesh->data->vertices[i3];
+
+      const vsx_tex_coord2f& w1 = mesh->data->vertex_tex_coords[i1];
+      const vsx_tex_coord2f& w2 = mesh->data->vertex_tex_coords[i2];
+      const vsx_tex_coord2f& w3 = mesh->data->vertex_tex_coords[i3];
+
+      float x1 = v2.x - v1.x;
+      float x2 = v3.x - v1.x;
+      float y1 = v2.y - v1.y;
+      float y2 = v3.y - v1.y;
+      float z1 = v2.z - v1.z;
+      float z2 = v3.z - v1.z;
+
+      float s1 = w2.s - w1.s;
+      float s2 = w3.s - w1.s;
+      float t1 = w2.t - w1.t;
+      float t2 = w3.t - w1.t;
+
+      float r = 1.0f / (s1 * t2 - s2 * t1);
+      vsx_quaternion<> sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
+      //vsx_vector sdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r,(s1 * z2 - s2 * z1) * r);
+
+      vec_d[i1] += sdir;
+      vec_d[i2] += sdir;
+      vec_d[i3] += sdir;
+
+      //tan2[i1] += tdir;
+      //tan2[i2] += tdir;
+      //tan2[i3] += tdir;
+    }
+    for (unsigned long a = 0; a < mesh->data->vertices.size(); a++)
+    {
+        vsx_vector3<>& n = mesh->data->vertex_normals[a];
+        vsx_quaternion<>& t = vec_d[a];
 
-      update_bones_output();
+        // Gram-Schmidt orthogonalize
+        //vec_d[a] = (t - n * t.dot_product(&n) );
+        vec_d[a] = (t - n * t.dot_product(&n) );
+        vec_d[a].normalize();
+        vec_d[a].w = 1.0f;//(float)a;
 
-      worker_produce.fetch_add(1);
-      if (param_produce.load())
-        param_produce.fetch_sub(1);
+        // Calculate handedness
+        //tangent[a].w = (Dot(Cross(n, t), tan2[a]) < 0.0F) ? -1.0F : 1.0F;
+    }
 
-      time_to_animate = timer.dtime();
+    update_bones_output();
 
-      // if we're not supposed to run in a thread
-      if (0 == thread_info.is_thread.load())
-        return;
+    worker_produce.fetch_add(1);
+    if (param_produce.load())
+      param_produce.fetch_sub(1);
 
-      // see if the exit flag is set (user changed from threaded to non-threaded mode)
-      if (thread_exit.load())
-      {
-        thread_exit = 0;
-        return;
-      }
-    }
+    time_to_animate = timer.dtime();
   }
 
 
@@ -742,59 +667,21 @@ VSXP_CLASS_LOCAL_INIT
 
 VSXP_S_BEGIN("cal3d run");
 
-    // deal with changes in threading use
-
-    if (thread_created && use_thread->get() == 0)
-    {
-      // this means the thread is running. kill it off.
-      thread_exit.fetch_add(1);
-
-      // make thread do a dry run if not already running
-      if (!param_produce.load())
-        param_produce.fetch_add(1);
-
-      if (param_produce.load()) // we have sent some work to the thread
-        while (param_produce.load() && !worker_produce.load() )
-        {}
-
-      worker_thread.join();
-      thread_created = false;
-      thread_info.is_thread = 0;
-    }
-
-    if (!thread_created && use_thread->get() == 1)
-    {
-      thread_info.is_thread.fetch_add(1);
-      worker_thread = std::thread( [this](){worker();} );
-      thread_created = true;
-    }
-
     if (0 == use_thread->get())
     {
-      thread_info.is_thread = 0;
-      worker();
+      // a job submitted while we were threaded delivers this frame,
+      // otherwise run in-line
+      job.wait();
+      if (!job.collect())
+        worker();
     }
 
-    if (thread_info.is_thread.load())
+    if (use_thread->get())
       if ( wait_for_thread->get() )
         if (times_run++ > 60 && engine_state->dtime > 0.01)
-        {
-          if (thread_sync_strategy->get() == 0)
-            while (!worker_produce.load())
-              std::this_thread::sleep_for(std::chrono::microseconds(1));
-
-          if (thread_sync_strategy->get() == 1)
-            while (!worker_produce.load())
-              #if (PLATFORM == PLATFORM_LINUX)
-                sched_yield();
-              #else
-                Sleep(0);
-              #endif
-
-          if (thread_sync_strategy->get() == 2)
-            while (!worker_produce.load() && param_produce.load())
-            {}
-        }
+          job.wait();
+
+    job.collect();
 
     if (worker_produce.load() == 1)
     {
@@ -882,6 +769,9 @@ VSXP_S_BEGIN("cal3d run");
 
       p_updates = param_updates;
       param_produce.fetch_add(1);
+
+      if (use_thread->get())
+        job.submit(engine_state, vsx_module_job_system::priority_frame, [this](){worker();} );
     }
     VSXP_S_END
   }
@@ -27,6 +27,7 @@
 #include <module/vsx_module.h>
 #include <math/vsx_float_array.h>
 #include <math/quaternion/vsx_quaternion.h>
+#include <math/vector/vsx_vector3_batch.h>
 
 // TODO: optimize the mesh_quat_rotate to also use volatile arrays for speed
 // TODO: optimize the inflation mesh modifier to use volatile arrays for passthru arrays
@@ -65,6 +65,9 @@ public:
 
     info->component_class =
       "mesh";
+
+    info->thread_safe = true;
+    info->init_thread_safe = true;
   }
 
   void declare_params(vsx_module_param_list& in_parameters, vsx_module_param_list& out_parameters)
@@ -113,14 +116,15 @@ public:
       mesh->data->vertex_colors.reset_used(0);
       mesh->data->faces.reset_used(0);
 
-      for (unsigned int i = 0; i < (*p)->data->vertices.size(); i++)
-      {
-        mesh->data->vertices[i] = mat.multiply_vector((*p)->data->vertices[i]);
-      }
-      for (unsigned int i = 0; i < (*p)->data->vertex_normals.size(); i++)
-      {
-        mesh->data->vertex_normals[i] = mat.multiply_vector((*p)->data->vertex_normals[i]);
-      }
+      unsigned long end = (*p)->data->vertices.size();
+      mesh->data->vertices.allocate(end);
+      mesh->data->vertices.reset_used(end);
+      vsx_vector3_batch::transform(mat, (*p)->data->vertices.get_pointer(), mesh->data->vertices.get_pointer(), end);
+
+      end = (*p)->data->vertex_normals.size();
+      mesh->data->vertex_normals.allocate(end);
+      mesh->data->vertex_normals.reset_used(end);
+      vsx_vector3_batch::transform(mat, (*p)->data->vertex_normals.get_pointer(), mesh->data->vertex_normals.get_pointer(), end);
 /*
       vsx_ma_vector<vsx_vector> vertices;
       vsx_ma_vector<vsx_vector> vertex_normals;
@@ -127,13 +127,14 @@ public:
       mesh->data->vertices.reset_used(end);
       vsx_vector3<>* vs_d = mesh->data->vertices.get_pointer();
 
-
-
-      for (unsigned long i = 0; i < end; i++)
-      {
-        vs_d[i].multiply_matrix_other_vec(&mat.m[0],vs_p[i] - neg_vec);// = mat.multiply_vector((*p)->data->vertices[i]);
-        vs_d[i] += ofs_vec;
-      }
+      // rotation around neg_vec followed by the offset, as one affine transform:
+      // mat * (v - neg_vec) + ofs_vec = mat * v + (ofs_vec - mat * neg_vec)
+      vsx_matrix<float> transform = mat;
+      vsx_vector3<> rotated_neg_vec = mat.multiply_vector(neg_vec);
+      transform.m[3] = ofs_vec.x - rotated_neg_vec.x;
+      transform.m[7] = ofs_vec.y - rotated_neg_vec.y;
+      transform.m[11] = ofs_vec.z - rotated_neg_vec.z;
+      vsx_vector3_batch::transform(transform, vs_p, vs_d, end);
 
       end = (*p)->data->vertex_normals.size();
       mesh->data->vertex_normals.allocate(end);
@@ -141,10 +142,7 @@ public:
       vs_d = mesh->data->vertex_normals.get_pointer();
       vs_p = (*p)->data->vertex_normals.get_pointer();
 
-      for (unsigned long i = 0; i < end; i++)
-      {
-        vs_d[i].multiply_matrix_other_vec(&mat.m[0],vs_p[i]);// = mat.multiply_vector((*p)->data->vertex_normals[i]);
-      }
+      vsx_vector3_batch::transform(mat, vs_p, vs_d, end);
 /*
       vsx_ma_vector<vsx_vector> vertices;
       vsx_ma_vector<vsx_vector> vertex_normals;
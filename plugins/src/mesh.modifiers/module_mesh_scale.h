@@ -62,6 +62,9 @@ public:
 
     info->component_class =
       "mesh";
+
+    info->thread_safe = true;
+    info->init_thread_safe = true;
   }
 
   void declare_params(vsx_module_param_list& in_parameters, vsx_module_param_list& out_parameters)
@@ -101,11 +104,7 @@ public:
       mesh->data->vertices.reset_used(end);
       vsx_vector3<>* vs_d = mesh->data->vertices.get_pointer();
 
-
-      for (unsigned int i = 0; i < end; i++)
-      {
-        vs_d[i] = vs_p[i] * v;
-      }
+      vsx_vector3_batch::scale(v, vs_p, vs_d, end);
 /*
       vsx_ma_vector<vsx_vector> vertices;
       vsx_ma_vector<vsx_vector> vertex_normals;
@@ -128,11 +128,13 @@ public:
       float zmove = -minima.z * scaling;
 
 
+      // scale and move in one pass
+      vsx_matrix<float> transform;
+      transform.m[0] = scaling;   transform.m[3] = xmove;
+      transform.m[5] = scaling;   transform.m[7] = ymove;
+      transform.m[10] = scaling;  transform.m[11] = zmove;
       vs_p = &(*p)->data->vertices[0];
-      for (unsigned int i = 0; i < end; i++)
-      {
-        vs_d[i] = vs_p[i] * scaling + vsx_vector3<>(xmove, ymove, zmove);
-      }
+      vsx_vector3_batch::transform(transform, vs_p, vs_d, end);
       //vsx_ma_vector<vsx_vector> vertices;
       //vsx_ma_vector<vsx_vector> vertex_normals;
       //vsx_ma_vector<vsx_color> vertex_colors;
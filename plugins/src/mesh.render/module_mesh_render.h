@@ -753,6 +753,7 @@ public:
     {
       // sanity checks
       if (!particles->particles) { render_result->set(0); return; }
+      particles->sync_aos();
 
       // make sure vbo is set to static draw
       //maintain_vbo_type(GL_STATIC_DRAW_ARB);
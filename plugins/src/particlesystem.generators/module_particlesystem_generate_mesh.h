@@ -189,6 +189,7 @@ public:
     particles_count->set(100);
     //particles.num_particles = 100;
     particles.particles = new vsx_ma_vector<vsx_particle<> >;
+    particles.particles_soa = new vsx_particle_soa<>;
     //particles.particles->allocation_increment = 1000;
     particles.timestamp = 0;
 
@@ -198,6 +199,7 @@ public:
   void on_delete()
   {
     delete particles.particles;
+    delete particles.particles_soa;
   }
 
   void run() {
@@ -214,6 +216,8 @@ public:
     vsx_mesh<>** our_mesh;
     our_mesh = mesh_in->get_addr();
     if (our_mesh) {
+      // pick up what modifiers did to the particles last frame
+      particles.get_aos();
 
       size_t particle_count = (size_t)particles_count->get();
 
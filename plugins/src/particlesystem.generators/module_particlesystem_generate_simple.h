@@ -150,6 +150,7 @@ public:
     particles_count->set(100);
     particles.timestamp = 0;
     particles.particles = new vsx_ma_vector< vsx_particle<> >;
+    particles.particles_soa = new vsx_particle_soa<>;
     //result_particlesystem->set_p(particles);
     first = true;
 
@@ -172,22 +173,22 @@ public:
       ddtime = engine_state->dtime;
     }
 
+    vsx_particle_soa<>* soa = particles.get_soa();
+
     if (first || (ddtime < 0))
     {
-      for (i = 0; i < particles_count->get(); ++i)
+      size_t count = (size_t)ceil(particles_count->get());
+      soa->resize(count);
+      for (size_t j = 0; j < count; ++j)
       {
-        (*particles.particles)[i].color = vsx_color<>(1,1,1,1);
-        (*particles.particles)[i].orig_size = (*particles.particles)[i].size = 0;
-        (*particles.particles)[i].pos.x = 0;
-        (*particles.particles)[i].pos.y = 0;
-        (*particles.particles)[i].pos.z = 0;
-        (*particles.particles)[i].creation_pos = (*particles.particles)[i].pos;
-        (*particles.particles)[i].speed.x = 0;
-        (*particles.particles)[i].speed.y = 0;
-        (*particles.particles)[i].speed.z = 0;
-        (*particles.particles)[i].time = 3;
-        (*particles.particles)[i].lifetime = 2;
-        (*particles.particles)[i].rotation_dir = vsx_quaternion<>(0,0,0,0);
+        soa->color_r[j] = soa->color_g[j] = soa->color_b[j] = soa->color_a[j] = 1.0f;
+        soa->orig_size[j] = soa->size[j] = 0;
+        soa->pos_x[j] = soa->pos_y[j] = soa->pos_z[j] = 0;
+        soa->creation_pos_x[j] = soa->creation_pos_y[j] = soa->creation_pos_z[j] = 0;
+        soa->speed_x[j] = soa->speed_y[j] = soa->speed_z[j] = 0;
+        soa->time[j] = 3;
+        soa->lifetime[j] = 2;
+        soa->rotation_dir_x[j] = soa->rotation_dir_y[j] = soa->rotation_dir_z[j] = soa->rotation_dir_w[j] = 0;
       }
       first = false;
       return;
@@ -222,13 +223,12 @@ public:
     bb = color->get(2);
     aa = color->get(3);
     // get number of active particles from the user
-    nump = (long)particles_count->get();
+    nump = particles_count->get();
     // some out of bounds-checks
     if (nump < 0) nump = 0;
-  //  if (nump > 2000) nump = 2000;
     // update the particle system with the new count so the renderer (and modifiers) can read it
-    if (nump < particles.particles->size())
-    particles.particles->reset_used((unsigned long)ceil(nump));
+    size_t count = (size_t)ceil(nump);
+    soa->resize(count);
     long p_to_go;
     if (particles_per_second->get() < 0.0f)
     p_to_go = 100000000;
@@ -243,64 +243,101 @@ public:
     c_rotation_dir.normalize();
 
     float c_lifetime = lifetime_base - half_lifetime_random_weight;
+    int c_speed_type = speed_type->get();
 
-    // go through all particles
-    for (i = 0; i < nump; ++i)
+    // age the particles, re-initialize the ones that got over their lifetime
+    // while there are particles left to emit this frame
+    float* p_time = soa->time;
+    float* p_lifetime = soa->lifetime;
+    for (size_t j = 0; j < count; ++j)
     {
-      // add the delta-time to the time of the particle
-      (*particles.particles)[i].time += ddtime;
-      // if the time got over the maximum lifetime of the particle, re-initialize it
-      if (
-          p_to_go > 1
-          &&
-          (*particles.particles)[i].time > (*particles.particles)[i].lifetime)
-      {
-        (*particles.particles)[i].size = (*particles.particles)[i].orig_size = size_base+rand.frand()*size_random_weight-size_random_weight*0.5f;
-        (*particles.particles)[i].color = vsx_color<>(rr,gg,bb,aa);
-        switch (speed_type->get()) {
-          case 0:
-            (*particles.particles)[i].speed.x = spd_x * rand.frand() - half_spd_x;
-            (*particles.particles)[i].speed.y = spd_y * rand.frand() - half_spd_y;
-            (*particles.particles)[i].speed.z = spd_z * rand.frand() - half_spd_z;
-          break;
-          case 1:
-            (*particles.particles)[i].speed.x = spd_x;
-            (*particles.particles)[i].speed.y = spd_y;
-            (*particles.particles)[i].speed.z = spd_z;
-          break;
-        } // switch
-
-        (*particles.particles)[i].rotation.x = rand.frand()*2.0f-1.0f;
-        (*particles.particles)[i].rotation.y = rand.frand()*2.0f-1.0f;
-        (*particles.particles)[i].rotation.z = rand.frand()*2.0f-1.0f;
-        (*particles.particles)[i].rotation.w = rand.frand()*2.0f-1.0f;
-        (*particles.particles)[i].rotation.normalize();
-
-        (*particles.particles)[i].rotation_dir = c_rotation_dir;
-
-        (*particles.particles)[i].pos.x = px;
-        (*particles.particles)[i].pos.y = py;
-        (*particles.particles)[i].pos.z = pz;
-        (*particles.particles)[i].creation_pos = (*particles.particles)[i].pos;
-        (*particles.particles)[i].time = 0.0f;
-        (*particles.particles)[i].lifetime = c_lifetime + rand.frand() * lifetime_random_weight;
-        (*particles.particles)[i].one_div_lifetime = 1.0f / (*particles.particles)[i].lifetime;
-        --p_to_go;
-      }
-      // add the speed component to the particles
-      (*particles.particles)[i].pos.x += (*particles.particles)[i].speed.x * ddtime;
-      (*particles.particles)[i].pos.y += (*particles.particles)[i].speed.y * ddtime;
-      (*particles.particles)[i].pos.z += (*particles.particles)[i].speed.z * ddtime;
-
-      if (random_number_index > 8000) random_number_index = 0;
-
-      q_out = &(*particles.particles)[i].rotation;
-      q1 = (*particles.particles)[i].rotation_dir;
+      p_time[j] += ddtime;
+      if (p_to_go <= 1 || p_time[j] <= p_lifetime[j])
+        continue;
+
+      soa->size[j] = soa->orig_size[j] = size_base+rand.frand()*size_random_weight-size_random_weight*0.5f;
+      soa->color_r[j] = rr;
+      soa->color_g[j] = gg;
+      soa->color_b[j] = bb;
+      soa->color_a[j] = aa;
+      switch (c_speed_type) {
+        case 0:
+          soa->speed_x[j] = spd_x * rand.frand() - half_spd_x;
+          soa->speed_y[j] = spd_y * rand.frand() - half_spd_y;
+          soa->speed_z[j] = spd_z * rand.frand() - half_spd_z;
+        break;
+        case 1:
+          soa->speed_x[j] = spd_x;
+          soa->speed_y[j] = spd_y;
+          soa->speed_z[j] = spd_z;
+        break;
+      } // switch
+
+      q1.x = rand.frand()*2.0f-1.0f;
+      q1.y = rand.frand()*2.0f-1.0f;
+      q1.z = rand.frand()*2.0f-1.0f;
+      q1.w = rand.frand()*2.0f-1.0f;
       q1.normalize();
-      q_out->mul(*q_out, q1);
+      soa->rotation_x[j] = q1.x;
+      soa->rotation_y[j] = q1.y;
+      soa->rotation_z[j] = q1.z;
+      soa->rotation_w[j] = q1.w;
+
+      soa->rotation_dir_x[j] = c_rotation_dir.x;
+      soa->rotation_dir_y[j] = c_rotation_dir.y;
+      soa->rotation_dir_z[j] = c_rotation_dir.z;
+      soa->rotation_dir_w[j] = c_rotation_dir.w;
+
+      soa->pos_x[j] = soa->creation_pos_x[j] = px;
+      soa->pos_y[j] = soa->creation_pos_y[j] = py;
+      soa->pos_z[j] = soa->creation_pos_z[j] = pz;
+      p_time[j] = 0.0f;
+      p_lifetime[j] = c_lifetime + rand.frand() * lifetime_random_weight;
+      soa->one_div_lifetime[j] = 1.0f / p_lifetime[j];
+      --p_to_go;
     }
 
-    (*particles.particles)[particles.particles->size()-1].color.a = nump-(float)floor(nump);
+    // move and spin
+    soa->for_each_chunk(
+      [soa, ddtime](size_t begin, size_t end)
+      {
+        float* pos_x = soa->pos_x;
+        float* pos_y = soa->pos_y;
+        float* pos_z = soa->pos_z;
+        const float* speed_x = soa->speed_x;
+        const float* speed_y = soa->speed_y;
+        const float* speed_z = soa->speed_z;
+        for (size_t j = begin; j < end; ++j)
+        {
+          pos_x[j] += speed_x[j] * ddtime;
+          pos_y[j] += speed_y[j] * ddtime;
+          pos_z[j] += speed_z[j] * ddtime;
+        }
+
+        // rotation = rotation * normalized rotation_dir
+        float* rx = soa->rotation_x;
+        float* ry = soa->rotation_y;
+        float* rz = soa->rotation_z;
+        float* rw = soa->rotation_w;
+        const float* dx = soa->rotation_dir_x;
+        const float* dy = soa->rotation_dir_y;
+        const float* dz = soa->rotation_dir_z;
+        const float* dw = soa->rotation_dir_w;
+        for (size_t j = begin; j < end; ++j)
+        {
+          float len = 1.0f / sqrtf(dx[j] * dx[j] + dy[j] * dy[j] + dz[j] * dz[j] + dw[j] * dw[j]);
+          float bx = dx[j] * len, by = dy[j] * len, bz = dz[j] * len, bw = dw[j] * len;
+          float ax = rx[j], ay = ry[j], az = rz[j], aw = rw[j];
+          rx[j] =  ax * bw + ay * bz - az * by + aw * bx;
+          ry[j] = -ax * bz + ay * bw + az * bx + aw * by;
+          rz[j] =  ax * by - ay * bx + az * bw + aw * bz;
+          rw[j] = -ax * bx - ay * by - az * bz + aw * bw;
+        }
+      }
+    );
+
+    if (count)
+      soa->color_a[count - 1] = nump-(float)floor(nump);
 
 
     // in case some modifier has decided to base some mesh or whatever on the particle system
@@ -319,5 +356,6 @@ public:
 
   void on_delete() {
     delete particles.particles;
+    delete particles.particles_soa;
   }
 };
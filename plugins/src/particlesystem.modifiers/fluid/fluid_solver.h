@@ -0,0 +1,266 @@
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <thread>
+#include <tools/vsx_thread_pool.h>
+
+/*
+  Stable fluids velocity solver (Jos Stam, "Real-Time Fluid Dynamics for Games")
+  on an n x n grid with a one cell border, index (i, j) = i + (n + 2) * j.
+
+  The grid is split in bands of rows that run on the thread pool, the calling
+  thread works on bands too. The linear solver is red-black Gauss-Seidel, all
+  cells of one color only read cells of the other, so bands can be solved in any
+  order and the result doesn't depend on the thread count. Small grids run on
+  the calling thread.
+
+  Red-black is not the row by row sweep of the original solver: both converge
+  towards the same solution, but after a fixed number of iterations the fields
+  differ slightly, so the motion is close to, not identical with, the old
+  single threaded modifier.
+*/
+class fluid_solver
+{
+  int n = 0;
+  int stride = 0;
+
+  int band_rows = 0;
+  size_t band_count = 1;
+
+  float* block = 0x0;
+
+  inline size_t index(int i, int j)
+  {
+    return (size_t)i + (size_t)stride * (size_t)j;
+  }
+
+  // calls f(j_begin, j_end) for bands of rows covering 1..n
+  template<typename F>
+  void for_each_band(F f)
+  {
+    if (band_count < 2)
+    {
+      f(1, n + 1);
+      return;
+    }
+
+    int rows = band_rows;
+    int last = n + 1;
+    vsx_thread_pool<>::instance()->parallel_for(0, band_count, 1,
+      [&f, rows, last](size_t band_begin, size_t band_end)
+      {
+        int begin = 1 + (int)band_begin * rows;
+        int end = 1 + (int)band_end * rows;
+        if (end > last)
+          end = last;
+        f(begin, end);
+      }
+    );
+  }
+
+  void set_bnd(int b, float* x)
+  {
+    for (int i = 1; i <= n; i++)
+    {
+      x[index(0, i)] = b == 1 ? -x[index(1, i)] : x[index(1, i)];
+      x[index(n + 1, i)] = b == 1 ? -x[index(n, i)] : x[index(n, i)];
+      x[index(i, 0)] = b == 2 ? -x[index(i, 1)] : x[index(i, 1)];
+      x[index(i, n + 1)] = b == 2 ? -x[index(i, n)] : x[index(i, n)];
+    }
+    x[index(0, 0)] = 0.5f * (x[index(1, 0)] + x[index(0, 1)]);
+    x[index(0, n + 1)] = 0.5f * (x[index(1, n + 1)] + x[index(0, n)]);
+    x[index(n + 1, 0)] = 0.5f * (x[index(n, 0)] + x[index(n + 1, 1)]);
+    x[index(n + 1, n + 1)] = 0.5f * (x[index(n, n + 1)] + x[index(n + 1, n)]);
+  }
+
+  void lin_solve(int b, float* x, const float* x0, float a, float c)
+  {
+    float c_inv = 1.0f / c;
+    for (int k = 0; k < iterations; k++)
+    {
+      // cells with (i + j) & 1 == color
+      for (int color = 0; color < 2; color++)
+      {
+        for_each_band(
+          [=](int j_begin, int j_end)
+          {
+            for (int j = j_begin; j < j_end; j++)
+            {
+              float* row = x + index(0, j);
+              const float* up = row - stride;
+              const float* down = row + stride;
+              const float* source = x0 + index(0, j);
+              for (int i = 1 + ((1 + j + color) & 1); i <= n; i += 2)
+                row[i] = (source[i] + a * (row[i - 1] + row[i + 1] + up[i] + down[i])) * c_inv;
+            }
+          }
+        );
+      }
+      set_bnd(b, x);
+    }
+  }
+
+  void diffuse(int b, float* x, const float* x0, float diff, float dt)
+  {
+    float a = dt * diff * n * n;
+    lin_solve(b, x, x0, a, 1.0f + 4.0f * a);
+  }
+
+  void advect(int b, float* d, const float* d0, const float* u, const float* v, float dt)
+  {
+    float dt0 = dt * n;
+    float low = 0.5f;
+    float high = (float)n + 0.5f;
+    for_each_band(
+      [=](int j_begin, int j_end)
+      {
+        for (int j = j_begin; j < j_end; j++)
+        {
+          size_t row = index(0, j);
+          // clamps written as selects so the loop has no branches
+          for (int i = 1; i <= n; i++)
+          {
+            float x = (float)i - dt0 * u[row + i];
+            float y = (float)j - dt0 * v[row + i];
+            x = x < low ? low : x;
+            x = x > high ? high : x;
+            y = y < low ? low : y;
+            y = y > high ? high : y;
+            int i0 = (int)x;
+            int j0 = (int)y;
+            float s1 = x - (float)i0;
+            float s0 = 1.0f - s1;
+            float t1 = y - (float)j0;
+            float t0 = 1.0f - t1;
+            const float* r0 = d0 + index(i0, j0);
+            const float* r1 = r0 + stride;
+            d[row + i] = s0 * (t0 * r0[0] + t1 * r1[0]) + s1 * (t0 * r0[1] + t1 * r1[1]);
+          }
+        }
+      }
+    );
+    set_bnd(b, d);
+  }
+
+  void project(float* u, float* v, float* p, float* div)
+  {
+    float n_inv = 1.0f / (float)n;
+    for_each_band(
+      [=](int j_begin, int j_end)
+      {
+        for (int j = j_begin; j < j_end; j++)
+        {
+          size_t row = index(0, j);
+          for (int i = 1; i <= n; i++)
+          {
+            div[row + i] = -0.5f * (u[row + i + 1] - u[row + i - 1] + v[row + i + stride] - v[row + i - stride]) * n_inv;
+            p[row + i] = 0.0f;
+          }
+        }
+      }
+    );
+    set_bnd(0, div);
+    set_bnd(0, p);
+
+    lin_solve(0, p, div, 1.0f, 4.0f);
+
+    float half_n = 0.5f * (float)n;
+    for_each_band(
+      [=](int j_begin, int j_end)
+      {
+        for (int j = j_begin; j < j_end; j++)
+        {
+          size_t row = index(0, j);
+          for (int i = 1; i <= n; i++)
+          {
+            u[row + i] -= half_n * (p[row + i + 1] - p[row + i - 1]);
+            v[row + i] -= half_n * (p[row + i + stride] - p[row + i - stride]);
+          }
+        }
+      }
+    );
+    set_bnd(1, u);
+    set_bnd(2, v);
+  }
+
+public:
+
+  // velocity field and scratch fields of the same size
+  float* u = 0x0;
+  float* v = 0x0;
+  float* u_prev = 0x0;
+  float* v_prev = 0x0;
+
+  int iterations = 20;
+
+  fluid_solver()
+  {
+  }
+
+  fluid_solver(const fluid_solver&) = delete;
+  fluid_solver& operator=(const fluid_solver&) = delete;
+
+  ~fluid_solver()
+  {
+    free(block);
+  }
+
+  inline int get_size()
+  {
+    return n;
+  }
+
+  inline size_t get_cell_count()
+  {
+    return (size_t)stride * (size_t)stride;
+  }
+
+  inline size_t get_index(int i, int j)
+  {
+    return index(i, j);
+  }
+
+  // reallocates and clears the grid
+  void resize(int new_n)
+  {
+    n = new_n;
+    stride = n + 2;
+
+    size_t cells = get_cell_count();
+    free(block);
+    block = (float*)calloc(cells * 4, sizeof(float));
+    u = block;
+    v = u + cells;
+    u_prev = v + cells;
+    v_prev = u_prev + cells;
+
+    // bands of at least 16 rows, about one per thread
+    size_t threads = std::thread::hardware_concurrency();
+    if (!threads)
+      threads = 1;
+    band_rows = (int)((n + threads - 1) / threads);
+    if (band_rows < 16)
+      band_rows = 16;
+    band_count = (size_t)((n + band_rows - 1) / band_rows);
+  }
+
+  void step(float visc, float dt)
+  {
+    float* u0 = u_prev;
+    float* v0 = v_prev;
+    memset(u0, 0, sizeof(float) * get_cell_count());
+    memset(v0, 0, sizeof(float) * get_cell_count());
+
+    // diffuse into the scratch fields
+    diffuse(1, u0, u, visc, dt);
+    diffuse(2, v0, v, visc, dt);
+    project(u0, v0, u, v);
+
+    // advect back into u, v
+    advect(1, u, u0, u0, v0, dt);
+    advect(2, v, v0, u0, v0, dt);
+    project(u, v, u0, v0);
+  }
+};
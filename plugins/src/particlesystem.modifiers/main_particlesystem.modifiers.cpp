@@ -27,6 +27,7 @@
 #include "vsx_param.h"
 #include <module/vsx_module.h>
 #include <math/quaternion/vsx_quaternion.h>
+#include "fluid/fluid_solver.h"
 
 
 
@@ -7,10 +7,7 @@ class module_particlesystem_modifier_2d_rotator : public vsx_module
   // out
   vsx_module_param_particlesystem* result_particlesystem;
 
-  vsx_ma_vector< vsx_quaternion<> > rotation;
-  vsx_ma_vector< vsx_quaternion<> > rotation_delta;
   vsx_quaternion<> q1;
-  vsx_quaternion<>* q_out;
 public:
 
   void module_info(vsx_module_specification* info)
@@ -31,6 +28,9 @@ public:
 
     info->component_class =
       "particlesystem";
+
+    info->thread_safe = true;
+    info->init_thread_safe = true;
   }
 
   void declare_params(vsx_module_param_list& in_parameters, vsx_module_param_list& out_parameters)
@@ -52,30 +52,44 @@ public:
   void run() {
     particles = in_particlesystem->get_addr();
     if (particles) {
-      if (rotation.size() != particles->particles->size())
-      {
-        rotation.reset_used();
-        rotation_delta.reset_used();
-        rotation.allocate(particles->particles->size());
-        rotation_delta.allocate(particles->particles->size());
-      }
-      for (unsigned long i = 0; i < particles->particles->size(); ++i)
-      {
-        q_out = &(*particles->particles)[i].rotation;
-        q1.x = 0.0f;
-        q1.w = 1.0f;
-        q1.y = rotation_dir->get(0) * engine_state->dtime;
-        q1.z = 0.0f;
-        q1.normalize();
-        q_out->mul(*q_out, q1);
-
-        q1.x = 0.0f;
-        q1.w = 1.0f;
-        q1.y = 0.0f;
-        q1.z = rotation_dir->get(0) * engine_state->dtime;
-        q1.normalize();
-        q_out->mul(*q_out, q1);
-      }
+      vsx_particle_soa<>* soa = particles->get_soa();
+      if (!soa)
+        VSX_ERROR_RETURN("particlesystem without soa arrays");
+
+      // the two rotations applied to every particle, combined into one
+      vsx_quaternion<> q2;
+      q1.x = 0.0f;
+      q1.w = 1.0f;
+      q1.y = rotation_dir->get(0) * engine_state->dtime;
+      q1.z = 0.0f;
+      q1.normalize();
+
+      q2.x = 0.0f;
+      q2.w = 1.0f;
+      q2.y = 0.0f;
+      q2.z = rotation_dir->get(0) * engine_state->dtime;
+      q2.normalize();
+
+      vsx_quaternion<> b;
+      b.mul(q1, q2);
+
+      soa->for_each_chunk(
+        [=](size_t begin, size_t end)
+        {
+          float* rx = soa->rotation_x;
+          float* ry = soa->rotation_y;
+          float* rz = soa->rotation_z;
+          float* rw = soa->rotation_w;
+          for (size_t i = begin; i < end; ++i)
+          {
+            float ax = rx[i], ay = ry[i], az = rz[i], aw = rw[i];
+            rx[i] =  ax * b.w + ay * b.z - az * b.y + aw * b.x;
+            ry[i] = -ax * b.z + ay * b.w + az * b.x + aw * b.y;
+            rz[i] =  ax * b.y - ay * b.x + az * b.w + aw * b.z;
+            rw[i] = -ax * b.x - ay * b.y - az * b.z + aw * b.w;
+          }
+        }
+      );
       // get positions from the user
       /*float px = wind->get(0);
       float py = wind->get(1);
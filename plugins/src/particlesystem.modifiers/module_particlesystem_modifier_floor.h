@@ -24,7 +24,6 @@ public:
   int i;
   vsx_particlesystem<>* particles;
   vsx_ma_vector<float> f_randpool;
-  float* f_randpool_pointer;
 
 
   void module_info(vsx_module_specification* info)
@@ -131,70 +130,94 @@ public:
       float yl = 1.0f-y_loss->get()*0.01f;
       float zl = 1.0f-z_loss->get()*0.01f;
 
-      unsigned long nump = particles->particles->size();
-      if (nump != f_randpool.size() * 10)
+      vsx_particle_soa<>* soa = particles->get_soa();
+      if (!soa)
+        VSX_ERROR_RETURN("particlesystem without soa arrays");
+
+      unsigned long nump = soa->get_count();
+      if (!nump)
+      {
+        result_particlesystem->set_p(*particles);
+        return;
+      }
+
+      if (f_randpool.size() < nump * 10)
       {
-        for (unsigned long i = f_randpool.size() * 10; i < nump * 10; i++)
+        for (unsigned long i = f_randpool.size(); i < nump * 10; i++)
         {
           f_randpool[i] = ((float)(rand()%1000000)*0.000001f);
         }
       }
-      f_randpool_pointer = f_randpool.get_pointer() + rand()%nump;
-
-      vsx_particle<>* pp = particles->particles->get_pointer();
-      for (unsigned long i = 0; i < nump; ++i) {
-        if (xf) {
-          if ((*pp).pos.x < fx) {
-            (*pp).pos.x = fx;
-            if (xb) {
-              (*pp).speed.x = -(*particles->particles)[i].speed.x*xl*(*(f_randpool_pointer++));
-              if (refraction->get()) {
-                (*pp).speed.y += refraction_amount->get(1)*((  (*(f_randpool_pointer++)) - 0.5f));
-                (*pp).speed.z += refraction_amount->get(2)*((  (*(f_randpool_pointer++)) - 0.5f));
+
+      // up to 3 random numbers per particle, from 3 separate runs of the pool
+      const float* random_0 = f_randpool.get_pointer() + rand()%nump;
+      const float* random_1 = random_0 + nump;
+      const float* random_2 = random_1 + nump;
+
+      bool refract = refraction->get() != 0;
+      float rx = refraction_amount->get(0);
+      float ry = refraction_amount->get(1);
+      float rz = refraction_amount->get(2);
+
+      soa->for_each_chunk(
+        [=](size_t begin, size_t end)
+        {
+          float* pos_x = soa->pos_x;
+          float* pos_y = soa->pos_y;
+          float* pos_z = soa->pos_z;
+          float* speed_x = soa->speed_x;
+          float* speed_y = soa->speed_y;
+          float* speed_z = soa->speed_z;
+          for (size_t i = begin; i < end; ++i)
+          {
+            if (xf)
+            {
+              bool below = pos_x[i] < fx;
+              pos_x[i] = below ? fx : pos_x[i];
+              float bounced = xb ? -speed_x[i] * xl * random_0[i] : 0.0f;
+              speed_x[i] = below ? bounced : speed_x[i];
+              if (xb && refract)
+              {
+                speed_y[i] += below ? ry * (random_1[i] - 0.5f) : 0.0f;
+                speed_z[i] += below ? rz * (random_2[i] - 0.5f) : 0.0f;
               }
-            } else {
-              (*pp).speed.x = 0.0f;
             }
-          }
-        }
-        if (yf) {
-          if ((*pp).pos.y < fy)
-          {
-            (*pp).pos.y = fy;
-            if (yb)
+
+            if (yf)
             {
-              if ( fabs((*pp).speed.y) > 0.00001f )
+              bool below = pos_y[i] < fy;
+              pos_y[i] = below ? fy : pos_y[i];
+              if (yb)
               {
-                (*pp).speed.y = -( (*pp).speed.y*yl)*(*(f_randpool_pointer++));
-                if (refraction->get())
+                bool bounce = below && fabsf(speed_y[i]) > 0.00001f;
+                float sy = bounce ? -(speed_y[i] * yl) * random_0[i] : speed_y[i];
+                speed_y[i] = sy;
+                if (refract)
                 {
-                  (*pp).speed.x += refraction_amount->get(0)*(( (*(f_randpool_pointer++))-0.5f));
-                  (*pp).speed.x *= (*pp).speed.y*0.1f;
-                  (*pp).speed.z += refraction_amount->get(2)*(( (*(f_randpool_pointer++))-0.5f));
-                  (*pp).speed.z *= (*pp).speed.y*0.1f;
+                  float sx = (speed_x[i] + rx * (random_1[i] - 0.5f)) * (sy * 0.1f);
+                  float sz = (speed_z[i] + rz * (random_2[i] - 0.5f)) * (sy * 0.1f);
+                  speed_x[i] = bounce ? sx : speed_x[i];
+                  speed_z[i] = bounce ? sz : speed_z[i];
                 }
-              }
-            } else {
-              (*pp).speed.y = 0.0f;
+              } else
+                speed_y[i] = below ? 0.0f : speed_y[i];
             }
-          }
-        }
-        if (zf) {
-          if ( (*pp).pos.z < fz) {
-            (*pp).pos.z = fz;
-            if (zb) {
-              (*pp).speed.z = -(*pp).speed.z*zl*(*(f_randpool_pointer++));
-              if (refraction->get()) {
-                (*pp).speed.x += refraction_amount->get(0)*(( (*(f_randpool_pointer++))-0.5f));
-                (*pp).speed.y += refraction_amount->get(1)*(( (*(f_randpool_pointer++))-0.5f));
+
+            if (zf)
+            {
+              bool below = pos_z[i] < fz;
+              pos_z[i] = below ? fz : pos_z[i];
+              float bounced = zb ? -speed_z[i] * zl * random_0[i] : 0.0f;
+              speed_z[i] = below ? bounced : speed_z[i];
+              if (zb && refract)
+              {
+                speed_x[i] += below ? rx * (random_1[i] - 0.5f) : 0.0f;
+                speed_y[i] += below ? ry * (random_2[i] - 0.5f) : 0.0f;
               }
-            } else {
-              (*pp).speed.z = 0.0f;
             }
           }
         }
-        ++pp;
-      }
+      );
       result_particlesystem->set_p(*particles);
       return;
     }
@@ -43,6 +43,9 @@ public:
 
     info->component_class =
       "particlesystem";
+
+    info->thread_safe = true;
+    info->init_thread_safe = true;
   }
 
   void declare_params(vsx_module_param_list& in_parameters, vsx_module_param_list& out_parameters)
@@ -89,53 +92,45 @@ public:
       float cy = center->get(1);
       float cz = center->get(2);
 
-      // go through all particles
-      float orig_size;
+      vsx_particle_soa<>* soa = particles->get_soa();
+      if (!soa)
+        VSX_ERROR_RETURN("particlesystem without soa arrays");
+
       float fricx = 1.0f-friction->get(0) * ddtime;
       float fricy = 1.0f-friction->get(1) * ddtime;
       float fricz = 1.0f-friction->get(2) * ddtime;
       float ax = amount->get(0)*ddtime;
       float ay = amount->get(1)*ddtime;
       float az = amount->get(2)*ddtime;
-      if (mass_type->get() == 0) {
-        unsigned long nump = particles->particles->size();
-        vsx_particle<>* pp = particles->particles->get_pointer();
-        for (unsigned long i = 0; i <  nump; ++i) {
-          if ((*pp).time < (*pp).lifetime) {
-            // add the delta-time to the time of the particle
-            orig_size = 1.0f / (*pp).orig_size;
-            //printf("orig size: %f\n", orig_size);
-            (*pp).speed.x += ax*((cx - (*pp).pos.x) * orig_size);
-            (*pp).speed.x *= fricx;
-
-            (*pp).speed.y += ay*((cy - (*pp).pos.y) * orig_size);
-            (*pp).speed.y *= fricy;
-
-            (*pp).speed.z += az*((cz - (*pp).pos.z) * orig_size);
-            (*pp).speed.z *= fricz;
-          }
-          pp++;
-        }
-      } else
-      {
-        orig_size = 1.0f / uniform_mass->get();
-        unsigned long nump = particles->particles->size();
-        vsx_particle<>* pp = particles->particles->get_pointer();
-        for (unsigned long i = 0; i <  nump; ++i) {
-          if ((*pp).time < (*pp).lifetime) {
-            // add the delta-time to the time of the particle
-            (*pp).speed.x += ax*((cx - (*pp).pos.x) * orig_size);
-            (*pp).speed.x *= fricx;
-
-            (*pp).speed.y += ay*((cy - (*pp).pos.y) * orig_size);
-            (*pp).speed.y *= fricy;
-
-            (*pp).speed.z += az*((cz - (*pp).pos.z) * orig_size);
-            (*pp).speed.z *= fricz;
+      bool individual_mass = mass_type->get() == 0;
+      float uniform_mass_inv = 1.0f / uniform_mass->get();
+
+      // go through all living particles
+      soa->for_each_chunk(
+        [=](size_t begin, size_t end)
+        {
+          const float* pos_x = soa->pos_x;
+          const float* pos_y = soa->pos_y;
+          const float* pos_z = soa->pos_z;
+          float* speed_x = soa->speed_x;
+          float* speed_y = soa->speed_y;
+          float* speed_z = soa->speed_z;
+          const float* time = soa->time;
+          const float* lifetime = soa->lifetime;
+          const float* orig_size = soa->orig_size;
+          for (size_t i = begin; i < end; ++i)
+          {
+            float mass_inv = individual_mass ? 1.0f / orig_size[i] : uniform_mass_inv;
+            bool alive = time[i] < lifetime[i];
+            float sx = (speed_x[i] + ax * ((cx - pos_x[i]) * mass_inv)) * fricx;
+            float sy = (speed_y[i] + ay * ((cy - pos_y[i]) * mass_inv)) * fricy;
+            float sz = (speed_z[i] + az * ((cz - pos_z[i]) * mass_inv)) * fricz;
+            speed_x[i] = alive ? sx : speed_x[i];
+            speed_y[i] = alive ? sy : speed_y[i];
+            speed_z[i] = alive ? sz : speed_z[i];
           }
-          pp++;
         }
-      }
+      );
 
       // set the resulting value
       result_particlesystem->set_p(*particles);
@@ -28,6 +28,9 @@ public:
 
     info->component_class =
       "particlesystem";
+
+    info->thread_safe = true;
+    info->init_thread_safe = true;
   }
 
   void declare_params(vsx_module_param_list& in_parameters, vsx_module_param_list& out_parameters)
@@ -50,22 +53,29 @@ public:
   void run() {
     particles = in_particlesystem->get_addr();
     if (particles) {
-      float sx = strength->get(0);
+      vsx_particle_soa<>* soa = particles->get_soa();
+      if (!soa)
+        VSX_ERROR_RETURN("particlesystem without soa arrays");
 
-      unsigned long nump = particles->particles->size();
-      if (size_type->get()) {
-        vsx_particle<>* pp = particles->particles->get_pointer();
+      float sx = strength->get(0);
+      bool additive = size_type->get() != 0;
 
-        for (unsigned long i = 0; i <  nump; ++i) {
-          (*pp).size = (*pp).orig_size + sx;
+      soa->for_each_chunk(
+        [=](size_t begin, size_t end)
+        {
+          float* size = soa->size;
+          const float* orig_size = soa->orig_size;
+          if (additive)
+          {
+            for (size_t i = begin; i < end; ++i)
+              size[i] = orig_size[i] + sx;
+            return;
+          }
+          for (size_t i = begin; i < end; ++i)
+            size[i] = orig_size[i] * sx;
         }
-      } else {
-        vsx_particle<>* pp = particles->particles->get_pointer();
-        for (unsigned long i = 0; i <  nump; ++i) {
-          (*pp).size = (*pp).orig_size * sx;
-          pp++;
-        }
-      }
+      );
+
       result_particlesystem->set_p(*particles);
       return;
     }
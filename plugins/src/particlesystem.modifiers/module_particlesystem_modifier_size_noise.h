@@ -11,7 +11,6 @@ class module_particlesystem_modifier_size_noise : public vsx_module
   vsx_module_param_particlesystem* result_particlesystem;
   vsx_rand rand;
   vsx_ma_vector<float> f_randpool;
-  float* f_randpool_pointer;
 public:
 
   void module_info(vsx_module_specification* info)
@@ -55,30 +54,45 @@ public:
   void run() {
     particles = in_particlesystem->get_addr();
     if (particles) {
+      vsx_particle_soa<>* soa = particles->get_soa();
+      if (!soa)
+        VSX_ERROR_RETURN("particlesystem without soa arrays");
+
       float sx = strength->get(0);
 
-      unsigned long nump = particles->particles->size();
-      if (nump != f_randpool.size()<<1)
+      unsigned long nump = soa->get_count();
+      if (!nump)
+      {
+        result_particlesystem->set_p(*particles);
+        return;
+      }
+
+      if (f_randpool.size() < nump<<1)
       {
-        for (unsigned long i = f_randpool.size()<<1; i < nump<<1; i++)
+        for (unsigned long i = f_randpool.size(); i < nump<<1; i++)
         {
           f_randpool[i] = rand.frand();
         }
       }
-      f_randpool_pointer = f_randpool.get_pointer() + rand.rand()%nump;
-      if (size_type->get()) {
-        vsx_particle<>* pp = particles->particles->get_pointer();
+      const float* pool = f_randpool.get_pointer() + rand.rand()%nump;
+      bool additive = size_type->get() != 0;
 
-        for (unsigned long i = 0; i <  nump; ++i) {
-          (*pp).size = (*pp).orig_size + ( (*(f_randpool_pointer++)) *sx);
-        }
-      } else {
-        vsx_particle<>* pp = particles->particles->get_pointer();
-        for (unsigned long i = 0; i <  nump; ++i) {
-          (*pp).size = (*pp).orig_size * ( (*(f_randpool_pointer++)) *sx);
-          pp++;
+      soa->for_each_chunk(
+        [=](size_t begin, size_t end)
+        {
+          float* size = soa->size;
+          const float* orig_size = soa->orig_size;
+          if (additive)
+          {
+            for (size_t i = begin; i < end; ++i)
+              size[i] = orig_size[i] + pool[i] * sx;
+            return;
+          }
+          for (size_t i = begin; i < end; ++i)
+            size[i] = orig_size[i] * (pool[i] * sx);
         }
-      }
+      );
+
       result_particlesystem->set_p(*particles);
       return;
     }
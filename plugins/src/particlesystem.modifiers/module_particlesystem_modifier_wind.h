@@ -29,6 +29,9 @@ public:
 
     info->component_class =
       "particlesystem";
+
+    info->thread_safe = true;
+    info->init_thread_safe = true;
   }
 
   void declare_params(vsx_module_param_list& in_parameters, vsx_module_param_list& out_parameters)
@@ -59,14 +62,29 @@ public:
     float py = wind->get(1);
     float pz = wind->get(2);
 
+    vsx_particle_soa<>* soa = particles->get_soa();
+    if (!soa)
+      VSX_ERROR_RETURN("particlesystem without soa arrays");
+
+    float dx = px * engine_state->dtime;
+    float dy = py * engine_state->dtime;
+    float dz = pz * engine_state->dtime;
+
     // go through all particles
-    for (unsigned long i = 0; i <  particles->particles->size(); ++i)
-    {
-      // add the delta-time to the time of the particle
-      (*particles->particles)[i].pos.x += px*engine_state->dtime;
-      (*particles->particles)[i].pos.y += py*engine_state->dtime;
-      (*particles->particles)[i].pos.z += pz*engine_state->dtime;
-    }
+    soa->for_each_chunk(
+      [=](size_t begin, size_t end)
+      {
+        float* pos_x = soa->pos_x;
+        float* pos_y = soa->pos_y;
+        float* pos_z = soa->pos_z;
+        for (size_t i = begin; i < end; ++i)
+        {
+          pos_x[i] += dx;
+          pos_y[i] += dy;
+          pos_z[i] += dz;
+        }
+      }
+    );
     // in case some modifier has decided to base some mesh or whatever on the particle system
     // increase the timsetamp so that module can know that it has to copy the particle system all
     // over again.
@@ -251,6 +251,7 @@ public:
     tex = tex_inf->get_addr();
     if (!particles)
       return;
+    particles->sync_aos();
 
     if (!tex)
       return;
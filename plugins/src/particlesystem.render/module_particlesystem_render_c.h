@@ -70,6 +70,7 @@ public:
       render_result->set(0);
       return;
     }
+    particles->sync_aos();
     float local_alpha = alpha->get();
 
     float cx = position->get(0);
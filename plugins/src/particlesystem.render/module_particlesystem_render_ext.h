@@ -308,6 +308,7 @@ public:
     {
       return;
     }
+    particles->sync_aos();
 
     calc_sizes();
 
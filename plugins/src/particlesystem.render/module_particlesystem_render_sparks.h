@@ -69,6 +69,7 @@ public:
     particles = particles_in->get_addr();
     if (particles)
     {
+      particles->sync_aos();
       data = float_array_in->get_addr();
       if (!data) {
         render_result->set(0);
@@ -101,6 +101,7 @@ public:
     VSX_UNUSED(param);
     particles = in_particlesystem->get_addr();
     if (!particles) return;
+    particles->sync_aos();
 
     if (prev_num_particles != particles->particles->size())
     {
@@ -48,19 +48,6 @@
 int rtaudio_type = 0;
 
 
-typedef struct
-{
-    float l_mul;
-    vsx_float_array spectrum[2];
-    vsx_float_array wave[2];    // 512 L 512 R BANZAI!
-    //float spectrum[2][512];
-    float vu[2];
-    float octaves[2][8];
-} vsx_audio_record_buf;
-
-vsx_audio_record_buf pa_audio_data;
-
-
 #include "rtaudio_play.h"
 #include "rtaudio_record.h"
 
@@ -0,0 +1,358 @@
+#ifndef RTAUDIO_ANALYSIS_H
+#define RTAUDIO_ANALYSIS_H
+
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <math/vsx_math.h>
+#include <container/vsx_ma_vector.h>
+#include <tools/vsx_fifo_mt.h>
+#include <tools/vsx_semaphore.h>
+#include <tools/vsx_align.h>
+#include <audio/vsx_audio_constants.h>
+
+/*
+  Audio input analysis, off the audio thread.
+
+  The RtAudio record callback only copies the 16-bit stereo frames into a
+  lock free ring and posts a semaphore (push), the analysis thread sleeps on
+  that, takes the frames from the ring and every 512 frames:
+  - runs a Hann windowed 512 point FFT per channel (86 per second at 44.1k)
+  - and a larger one (hq_size, default 2048) every other time when enabled
+  - bins those into the 512 value spectrum, vu and octaves the listener
+    outputs, and detects onsets from the spectral flux
+
+  The results are written to the back buffer, then swapped with the front
+  buffer the listener copies from (read), so a listener never sees half an
+  update. Neither side of the swap is the audio thread.
+
+  All values are unscaled, the listener applies its multiplier.
+*/
+
+#define VSX_AUDIO_ANALYSIS_BINS 512
+#define VSX_AUDIO_ANALYSIS_HOP 512
+#define VSX_AUDIO_ANALYSIS_HQ_MAX 8192
+
+struct vsx_audio_analysis_frame
+{
+  int16_t left;
+  int16_t right;
+};
+
+struct vsx_audio_analysis_result
+{
+  float wave[2][VSX_AUDIO_ANALYSIS_BINS];
+  float spectrum[2][VSX_AUDIO_ANALYSIS_BINS];
+  float spectrum_hq[2][VSX_AUDIO_ANALYSIS_BINS];
+  float vu[2];
+  float octaves[2][8];
+
+  // spectral flux of the last hop
+  float onset;
+
+  // 1 on a detected beat, decaying towards 0
+  float beat;
+
+  // increments with every analysis pass
+  uint64_t sequence;
+};
+
+
+class vsx_audio_spectrum
+{
+  size_t size;
+  FFTReal fft;
+  vsx_ma_vector<float> window;
+  vsx_ma_vector<float> windowed;
+  vsx_ma_vector<float> transformed;
+  vsx_ma_vector<float> magnitudes;
+
+public:
+
+  explicit vsx_audio_spectrum(size_t n)
+    :
+    size(n),
+    fft((long)n)
+  {
+    window.allocate(size - 1);
+    windowed.allocate(size - 1);
+    transformed.allocate(size - 1);
+    magnitudes.allocate(size / 2 - 1);
+
+    // a Hann window has a coherent gain of 0.5, scaled back to the levels
+    // of the unwindowed FFT the listener used to run
+    for (size_t i = 0; i < size; i++)
+      window[i] = 1.0f - cosf(2.0f * (float)PI * (float)i / (float)size);
+  }
+
+  size_t get_size()
+  {
+    return size;
+  }
+
+  size_t get_magnitude_count()
+  {
+    return size / 2;
+  }
+
+  float* get_magnitudes()
+  {
+    return magnitudes.get_pointer();
+  }
+
+  // samples: size values, oldest first
+  void analyze(const float* samples)
+  {
+    float* w = window.get_pointer();
+    float* in = windowed.get_pointer();
+    for (size_t i = 0; i < size; i++)
+      in[i] = samples[i] * w[i];
+
+    float* out = transformed.get_pointer();
+    fft.do_fft(out, in);
+
+    size_t half = size / 2;
+    float scale = 1.0f / (float)half;
+    float* m = magnitudes.get_pointer();
+    for (size_t i = 0; i < half; i++)
+      m[i] = sqrtf(out[i] * out[i] + out[i + half] * out[i + half]) * scale;
+  }
+
+  // Resamples the magnitudes to VSX_AUDIO_ANALYSIS_BINS values weighted
+  // towards the treble. Returns the vu, the sum of the magnitudes in 512
+  // point FFT units.
+  float get_bins(float* bins)
+  {
+    size_t half = size / 2;
+    size_t per_value = half / VSX_AUDIO_ANALYSIS_BINS;
+    float* m = magnitudes.get_pointer();
+
+    float vu = 0.0f;
+    for (size_t i = 0; i < half; i++)
+      vu += m[i];
+    vu *= 256.0f / (float)half;
+
+    for (size_t i = 0; i < VSX_AUDIO_ANALYSIS_BINS; i++)
+    {
+      // smaller transforms repeat magnitudes, larger ones average them
+      float magnitude = 0.0f;
+      if (per_value < 2)
+        magnitude = m[i * half / VSX_AUDIO_ANALYSIS_BINS];
+      else
+      {
+        for (size_t j = i * per_value; j < (i + 1) * per_value; j++)
+          magnitude += m[j];
+        magnitude /= (float)per_value;
+      }
+      bins[i] = magnitude * 3.0f * logf(10.0f + 44100.0f * ((float)i * one_div_512));
+    }
+    return vu;
+  }
+};
+
+
+// the ring is 64 byte aligned, so is the analysis
+class vsx_audio_analysis
+    : public vsx::aligned_new_delete<512>
+{
+  // frames from the audio thread, posted for each push
+  vsx_fifo_mt<vsx_audio_analysis_frame, 16384> input;
+  vsx_semaphore input_posted;
+
+  // the last VSX_AUDIO_ANALYSIS_HQ_MAX frames per channel, oldest first
+  float history[2][VSX_AUDIO_ANALYSIS_HQ_MAX];
+  vsx_audio_analysis_frame incoming[VSX_AUDIO_ANALYSIS_HOP];
+  size_t incoming_count = 0;
+
+  vsx_audio_spectrum* spectrum[2];
+  vsx_audio_spectrum* spectrum_hq[2];
+  float spectrum_hq_bins[2][VSX_AUDIO_ANALYSIS_BINS];
+
+  // onset detection
+  vsx_ma_vector<float> previous_magnitudes;
+  float flux_history[43]; // half a second
+  size_t flux_index = 0;
+  size_t hops_since_beat = 0;
+  float beat = 0.0f;
+
+  vsx_audio_analysis_result results[2];
+  size_t front = 0;
+  std::mutex swap_mutex;
+
+  uint64_t sequence = 0;
+  std::atomic<bool> running;
+  std::thread worker;
+
+  void detect_onset(vsx_audio_analysis_result& result)
+  {
+    size_t count = spectrum[0]->get_magnitude_count();
+    float* previous = previous_magnitudes.get_pointer();
+    float flux = 0.0f;
+    for (size_t c = 0; c < 2; c++)
+    {
+      float* m = spectrum[c]->get_magnitudes();
+      for (size_t i = 0; i < count; i++)
+      {
+        float rise = m[i] - previous[c * count + i];
+        if (rise > 0.0f)
+          flux += rise;
+        previous[c * count + i] = m[i];
+      }
+    }
+
+    float mean = 0.0f;
+    for (size_t i = 0; i < 43; i++)
+      mean += flux_history[i];
+    mean *= 1.0f / 43.0f;
+
+    flux_history[flux_index] = flux;
+    flux_index = (flux_index + 1) % 43;
+
+    // at least ~90 ms between beats
+    hops_since_beat++;
+    beat *= 0.85f;
+    if (flux > mean * 1.5f && flux > 0.01f && hops_since_beat > 8)
+    {
+      beat = 1.0f;
+      hops_since_beat = 0;
+    }
+
+    result.onset = flux;
+    result.beat = beat;
+  }
+
+  void analyze()
+  {
+    // de-interleave the new hop onto the end of the history
+    for (size_t c = 0; c < 2; c++)
+    {
+      float* h = history[c];
+      memmove(h, h + VSX_AUDIO_ANALYSIS_HOP, sizeof(float) * (VSX_AUDIO_ANALYSIS_HQ_MAX - VSX_AUDIO_ANALYSIS_HOP));
+      float* d = h + VSX_AUDIO_ANALYSIS_HQ_MAX - VSX_AUDIO_ANALYSIS_HOP;
+      for (size_t i = 0; i < VSX_AUDIO_ANALYSIS_HOP; i++)
+        d[i] = (float)(c ? incoming[i].right : incoming[i].left) * one_div_32768;
+    }
+
+    vsx_audio_analysis_result& result = results[front ^ 1];
+
+    // recreate the hq transform if its size was changed
+    size_t size_hq = hq_size;
+    if (size_hq > VSX_AUDIO_ANALYSIS_HQ_MAX)
+      size_hq = VSX_AUDIO_ANALYSIS_HQ_MAX;
+    if (hq_enabled && spectrum_hq[0]->get_size() != size_hq)
+      for (size_t c = 0; c < 2; c++)
+      {
+        delete spectrum_hq[c];
+        spectrum_hq[c] = new vsx_audio_spectrum(size_hq);
+      }
+
+    for (size_t c = 0; c < 2; c++)
+    {
+      float* h = history[c];
+      memcpy(result.wave[c], h + VSX_AUDIO_ANALYSIS_HQ_MAX - VSX_AUDIO_ANALYSIS_BINS, sizeof(float) * VSX_AUDIO_ANALYSIS_BINS);
+
+      spectrum[c]->analyze(h + VSX_AUDIO_ANALYSIS_HQ_MAX - spectrum[c]->get_size());
+      result.vu[c] = spectrum[c]->get_bins(result.spectrum[c]);
+
+      if (hq_enabled && !(sequence & 1))
+      {
+        spectrum_hq[c]->analyze(h + VSX_AUDIO_ANALYSIS_HQ_MAX - spectrum_hq[c]->get_size());
+        spectrum_hq[c]->get_bins(spectrum_hq_bins[c]);
+      }
+      memcpy(result.spectrum_hq[c], spectrum_hq_bins[c], sizeof(float) * VSX_AUDIO_ANALYSIS_BINS);
+
+      // bass to treble, 50 bins each
+      for (size_t o = 0; o < 8; o++)
+      {
+        float sum = 0.0f;
+        for (size_t i = o ? o * 50 : 10; i < (o + 1) * 50; i++)
+          sum += result.spectrum[c][i];
+        result.octaves[c][o] = sum * (1.0f / 50.0f);
+      }
+    }
+
+    detect_onset(result);
+    result.sequence = ++sequence;
+
+    std::lock_guard<std::mutex> lock(swap_mutex);
+    front ^= 1;
+  }
+
+  void run()
+  {
+    #if (PLATFORM == PLATFORM_LINUX)
+      prctl(PR_SET_NAME, "sound.analysis");
+    #endif
+
+    while (running)
+    {
+      size_t wanted = VSX_AUDIO_ANALYSIS_HOP - incoming_count;
+      incoming_count += input.consume(incoming + incoming_count, wanted);
+
+      // until the next callback, or the destructor
+      if (incoming_count < VSX_AUDIO_ANALYSIS_HOP)
+      {
+        input_posted.wait();
+        continue;
+      }
+
+      analyze();
+      incoming_count = 0;
+    }
+  }
+
+public:
+
+  std::atomic<bool> hq_enabled;
+  std::atomic<size_t> hq_size;
+
+  vsx_audio_analysis()
+  {
+    memset(history, 0, sizeof(history));
+    memset(spectrum_hq_bins, 0, sizeof(spectrum_hq_bins));
+    memset(flux_history, 0, sizeof(flux_history));
+    memset(results, 0, sizeof(results));
+    hq_enabled = false;
+    hq_size = 2048;
+    for (size_t c = 0; c < 2; c++)
+    {
+      spectrum[c] = new vsx_audio_spectrum(VSX_AUDIO_ANALYSIS_BINS);
+      spectrum_hq[c] = new vsx_audio_spectrum(hq_size);
+    }
+    previous_magnitudes.allocate(spectrum[0]->get_magnitude_count() * 2 - 1);
+    memset(previous_magnitudes.get_pointer(), 0, previous_magnitudes.get_sizeof());
+
+    running = true;
+    worker = std::thread([this](){ run(); });
+  }
+
+  ~vsx_audio_analysis()
+  {
+    running = false;
+    input_posted.post();
+    worker.join();
+    for (size_t c = 0; c < 2; c++)
+    {
+      delete spectrum[c];
+      delete spectrum_hq[c];
+    }
+  }
+
+  // audio thread: lock free, drops frames if the analysis falls behind
+  void push(const int16_t* interleaved, size_t frame_count)
+  {
+    input.produce((const vsx_audio_analysis_frame*)interleaved, frame_count);
+    input_posted.post();
+  }
+
+  // copies the latest results
+  void read(vsx_audio_analysis_result& result)
+  {
+    std::lock_guard<std::mutex> lock(swap_mutex);
+    memcpy(&result, &results[front], sizeof(vsx_audio_analysis_result));
+  }
+};
+
+#endif // RTAUDIO_ANALYSIS_H
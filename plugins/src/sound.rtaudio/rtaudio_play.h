@@ -35,13 +35,7 @@ int play_callback
   //vsx_printf(L"buffer frames: %d latency: %d\n", nBufferFrames, padc_play->getStreamLatency());
 
   // Write interleaved audio data.
-  for ( unsigned int i=0; i < nBufferFrames; i++ )
-  {
-    *buffer = (int16_t)main_mixer.consume_left();
-    buffer++;
-    *buffer = (int16_t)main_mixer.consume_right();
-    buffer++;
-  }
+  main_mixer.consume_block(buffer, nBufferFrames);
   return 0;
 }
 
@@ -5,9 +5,7 @@
 #include <vsx_argvector.h>
 #include<RtAudio/RtAudio.h>
 
-float fftbuf[1024];
-size_t fftbuf_it = 0;
-
+#include "rtaudio_analysis.h"
 
 // rt audio instance
 RtAudio* padc_record = 0x0;
@@ -15,8 +13,8 @@ RtAudio* padc_record = 0x0;
 // reference counter
 size_t rt_record_refcounter = 0;
 
-FFTReal* fftr = 0x0;
-
+// spectrum, octaves etc. computed off the audio thread
+vsx_audio_analysis* audio_analysis = 0x0;
 
 
 
@@ -24,7 +22,6 @@ int record( void *outputBuffer, void *inputBuffer, unsigned int nBufferFrames,
          double streamTime, RtAudioStreamStatus status, void *userData )
 {
   (void)outputBuffer;
-  (void)nBufferFrames;
   (void)streamTime;
   (void)userData;
   if ( status )
@@ -32,106 +29,8 @@ int record( void *outputBuffer, void *inputBuffer, unsigned int nBufferFrames,
     printf("Stream overflow detected!\n");
   }
 
-  #if (PLATFORM == PLATFORM_LINUX)
-    const char* cal = "sound.rtaudio";
-    prctl(PR_SET_NAME,cal);
-  #endif
-
-  int16_t* buf = (int16_t*)inputBuffer;
-
-  vsx_audio_record_buf* pa_d = &pa_audio_data;
-
-  int j = 0;
-  // nab left channel for spectrum data
-  for (size_t i = 0; i < 512; i++)
-  {
-    const float &f = (float)buf[j] * one_div_32768;
-
-    (*(pa_d->wave[0].data))[i] = f * pa_d->l_mul;
-    fftbuf[fftbuf_it++] = f;
-    j++;
-    j++;
-  }
-  fftbuf_it = fftbuf_it % 1024;
-
-  j = 1;
-
-  for (size_t i = 0; i < 512; i++)
-  {
-    (*(pa_d->wave[1].data))[i] = (float)buf[j] * one_div_32768 * pa_d->l_mul;
-    j++;
-    j++;
-  }
-  // do some FFT's
-  float spectrum[1024];
-  float spectrum_dest[512];
-  fftr->do_fft( (float*)&spectrum, (float*) &fftbuf[0]);
-  float re, im;
-
-  for(int ii = 0; ii < 256; ii++)
-  {
-    re = spectrum[ii];
-    im = spectrum[ii + 256];
-    spectrum_dest[ii] = (float)sqrt(re * re + im * im) * one_div_256 * pa_d->l_mul;
-  }
-
-  // calc vu
-  float vu = 0.0f;
-  for (int ii = 0; ii < 256; ii++)
-  {
-    vu += spectrum_dest[ii];
-  }
-  pa_d->vu[0] = vu;
-  pa_d->vu[1] = vu;
-
-  for (size_t ii = 0; ii < 512; ii++)
-  {
-    (*(pa_d->spectrum[0].data))[ii] =
-        spectrum_dest[ii >> 1]
-                            *
-                            3.0f
-                            *
-                            pow(
-                              log(
-                                10.0f
-                                +
-                                44100.0f * ( (float)ii * one_div_512 )
-                                ),
-                              1.0f
-                              );
-  }
-
-
-
-  //normalize_fft( (float*)spectrum_dest, pa_d->spectrum[0]);
-
-  /*for (size_t ii = 0; ii < 512; ii++)
-  {
-    //float f = log( 2.0f + 8.0f * (ii / 512.0f) );
-    (*(pa_d->spectrum[0].data))[ii] *= pow(log( 2.0f + 8.0f * (ii / 512.0f)) ,3.0f);
-  }*/
-
-
-  const float one_div_50 = 1.0f / 50.0f;
-
-
-  #define spec_calc(cur_val, start, offset) \
-    cur_val = 0.0f;\
-    for (int ii = start * 50 + offset; ii < (start+1)*50; ii++) {\
-      cur_val += (*(pa_d->spectrum[0].data))[ii];\
-    }\
-    cur_val = (cur_val * one_div_50)
-
-  spec_calc(pa_d->octaves[0][0], 0, 10);
-  spec_calc(pa_d->octaves[0][1], 1, 0);
-  spec_calc(pa_d->octaves[0][2], 2, 0);
-  spec_calc(pa_d->octaves[0][3], 3, 0);
-  spec_calc(pa_d->octaves[0][4], 4, 0);
-  spec_calc(pa_d->octaves[0][5], 5, 0);
-  spec_calc(pa_d->octaves[0][6], 6, 0);
-  spec_calc(pa_d->octaves[0][7], 7, 0);
-
-  #undef spec_calc
+  // nothing here may block or take long, hand over to the analysis thread
+  audio_analysis->push( (int16_t*)inputBuffer, nBufferFrames );
 
   return 0;
 }
@@ -148,7 +47,7 @@ vsx_string<> setup_rtaudio_record()
   else
   {
     padc_record = new RtAudio((RtAudio::Api)rtaudio_type);
-    fftr = new FFTReal(512);
+    audio_analysis = new vsx_audio_analysis;
     rt_record_refcounter++;
     #if (PLATFORM == PLATFORM_WINDOWS)
     rt_record_refcounter++;
@@ -158,19 +57,6 @@ vsx_string<> setup_rtaudio_record()
   if ( padc_record->getDeviceCount() < 1 )
     return "ERROR: No audio devices found!";
 
-  vsx_audio_record_buf* pa_d = &pa_audio_data;
-
-  pa_d->wave[0].data = new vsx_ma_vector<float>;
-  pa_d->wave[1].data = new vsx_ma_vector<float>;
-  for (int i = 0; i < 512; ++i) pa_d->wave[0].data->push_back(0);
-  for (int i = 0; i < 512; ++i) pa_d->wave[1].data->push_back(0);
-
-  pa_d->spectrum[0].data = new vsx_ma_vector<float>;
-  pa_d->spectrum[1].data = new vsx_ma_vector<float>;
-  for (int i = 0; i < 512; ++i) pa_d->spectrum[0].data->push_back(0);
-  for (int i = 0; i < 512; ++i) pa_d->spectrum[1].data->push_back(0);
-
-
   RtAudio::StreamParameters parameters;
   parameters.deviceId = padc_record->getDefaultInputDevice();
 
@@ -236,8 +122,9 @@ void shutdown_rtaudio_record()
     catch (...)
     {}
     delete padc_record;
-    delete fftr;
+    delete audio_analysis;
     padc_record = 0;
+    audio_analysis = 0x0;
   }
 }
 
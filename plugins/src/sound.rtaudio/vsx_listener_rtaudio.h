@@ -27,6 +27,7 @@
 class vsx_listener_pulse : public vsx_module {
   // in
   vsx_module_param_int* quality;
+  vsx_module_param_int* hq_size;
   // out
   vsx_module_param_float* multiplier;
 
@@ -50,6 +51,8 @@ class vsx_listener_pulse : public vsx_module {
   vsx_module_param_float* octaves_r_7_p;
   vsx_module_param_float_array* wave_p;
   vsx_float_array wave;
+  vsx_module_param_float* onset_p;
+  vsx_module_param_float* beat_p;
 
 
   // normal engine
@@ -66,6 +69,10 @@ class vsx_listener_pulse : public vsx_module {
 
   float old_mult;
 
+  // latest results from the analysis thread
+  vsx_audio_analysis_result analysis;
+  uint64_t analysis_sequence;
+
 public:
 
 void module_info(vsx_module_specification* info)
@@ -94,6 +101,14 @@ void module_info(vsx_module_specification* info)
         "the normal one."
       "`"
     ","
+    "hq_size:enum?1024|2048|4096|8192"
+    "&help="
+      "`"
+        "Length of the HQ FFT in samples.\n"
+        "Longer gives finer frequency\n"
+        "resolution but reacts slower."
+      "`"
+    ","
     "multiplier:float"
   ;
 
@@ -136,6 +151,11 @@ void module_info(vsx_module_specification* info)
     "hq:complex"
     "{"
       "spectrum_hq:float_array"
+    "},"
+    "onset:complex"
+    "{"
+      "onset:float,"
+      "beat:float"
     "}"
   ;
 
@@ -150,6 +170,9 @@ void declare_params(vsx_module_param_list& in_parameters, vsx_module_param_list&
   quality = (vsx_module_param_int*)in_parameters.create(VSX_MODULE_PARAM_ID_INT,"quality");
   quality->set(0);
 
+  hq_size = (vsx_module_param_int*)in_parameters.create(VSX_MODULE_PARAM_ID_INT,"hq_size");
+  hq_size->set(1);
+
   multiplier = (vsx_module_param_float*)in_parameters.create(VSX_MODULE_PARAM_ID_FLOAT,"multiplier");
   multiplier->set(1);
 
@@ -206,6 +229,13 @@ void declare_params(vsx_module_param_list& in_parameters, vsx_module_param_list&
   spectrum_p->set_p(spectrum);
   spectrum_p_hq->set_p(spectrum_hq);
 
+  onset_p = (vsx_module_param_float*)out_parameters.create(VSX_MODULE_PARAM_ID_FLOAT,"onset");
+  beat_p = (vsx_module_param_float*)out_parameters.create(VSX_MODULE_PARAM_ID_FLOAT,"beat");
+  onset_p->set(0);
+  beat_p->set(0);
+
+  analysis_sequence = 0;
+  old_mult = 0.0f;
   loading_done = true;
 }
 
@@ -216,7 +246,9 @@ bool init() {
 
 void on_delete() {
   shutdown_rtaudio_record();
+  delete wave.data;
   delete spectrum.data;
+  delete spectrum_hq.data;
 }
 
 int echo_log(const char* message, int a) {
@@ -230,31 +262,55 @@ int i;
 
 void run()
 {
-  pa_audio_data.l_mul = multiplier->get()*engine_state->amp;
-  wave_p->set_p(pa_audio_data.wave[0]);
-  spectrum_p->set_p(pa_audio_data.spectrum[0]);
-  spectrum_p_hq->set_p(pa_audio_data.spectrum[0]);
-  vu_l_p->set(pa_audio_data.vu[0]);
-  vu_r_p->set(pa_audio_data.vu[1]);
-
-  octaves_l_0_p->set(pa_audio_data.octaves[0][0]);
-  octaves_l_1_p->set(pa_audio_data.octaves[0][1]);
-  octaves_l_2_p->set(pa_audio_data.octaves[0][2]);
-  octaves_l_3_p->set(pa_audio_data.octaves[0][3]);
-  octaves_l_4_p->set(pa_audio_data.octaves[0][4]);
-  octaves_l_5_p->set(pa_audio_data.octaves[0][5]);
-  octaves_l_6_p->set(pa_audio_data.octaves[0][6]);
-  octaves_l_7_p->set(pa_audio_data.octaves[0][7]);
-
-  octaves_r_0_p->set(pa_audio_data.octaves[0][0]);
-  octaves_r_1_p->set(pa_audio_data.octaves[0][1]);
-  octaves_r_2_p->set(pa_audio_data.octaves[0][2]);
-  octaves_r_3_p->set(pa_audio_data.octaves[0][3]);
-  octaves_r_4_p->set(pa_audio_data.octaves[0][4]);
-  octaves_r_5_p->set(pa_audio_data.octaves[0][5]);
-  octaves_r_6_p->set(pa_audio_data.octaves[0][6]);
-  octaves_r_7_p->set(pa_audio_data.octaves[0][7]);
+  req(audio_analysis);
+
+  audio_analysis->hq_enabled = quality->get() != 0;
+  audio_analysis->hq_size = (size_t)1024 << hq_size->get();
+
+  float l_mul = multiplier->get() * engine_state->amp;
+  audio_analysis->read(analysis);
+
+  if (analysis.sequence == analysis_sequence && l_mul == old_mult)
+    return;
+  analysis_sequence = analysis.sequence;
+  old_mult = l_mul;
+
+  float* wave_data = wave.data->get_pointer();
+  float* spectrum_data = spectrum.data->get_pointer();
+  float* spectrum_hq_data = spectrum_hq.data->get_pointer();
+  for (size_t i = 0; i < VSX_AUDIO_ANALYSIS_BINS; i++)
+  {
+    wave_data[i] = analysis.wave[0][i] * l_mul;
+    spectrum_data[i] = analysis.spectrum[0][i] * l_mul;
+    spectrum_hq_data[i] = analysis.spectrum_hq[0][i] * l_mul;
+  }
+  wave_p->set_p(wave);
+  spectrum_p->set_p(spectrum);
+  spectrum_p_hq->set_p(spectrum_hq);
+
+  vu_l_p->set(analysis.vu[0] * l_mul);
+  vu_r_p->set(analysis.vu[1] * l_mul);
+
+  octaves_l_0_p->set(analysis.octaves[0][0] * l_mul);
+  octaves_l_1_p->set(analysis.octaves[0][1] * l_mul);
+  octaves_l_2_p->set(analysis.octaves[0][2] * l_mul);
+  octaves_l_3_p->set(analysis.octaves[0][3] * l_mul);
+  octaves_l_4_p->set(analysis.octaves[0][4] * l_mul);
+  octaves_l_5_p->set(analysis.octaves[0][5] * l_mul);
+  octaves_l_6_p->set(analysis.octaves[0][6] * l_mul);
+  octaves_l_7_p->set(analysis.octaves[0][7] * l_mul);
+
+  octaves_r_0_p->set(analysis.octaves[1][0] * l_mul);
+  octaves_r_1_p->set(analysis.octaves[1][1] * l_mul);
+  octaves_r_2_p->set(analysis.octaves[1][2] * l_mul);
+  octaves_r_3_p->set(analysis.octaves[1][3] * l_mul);
+  octaves_r_4_p->set(analysis.octaves[1][4] * l_mul);
+  octaves_r_5_p->set(analysis.octaves[1][5] * l_mul);
+  octaves_r_6_p->set(analysis.octaves[1][6] * l_mul);
+  octaves_r_7_p->set(analysis.octaves[1][7] * l_mul);
 
+  onset_p->set(analysis.onset * l_mul);
+  beat_p->set(analysis.beat);
 }
 };
 
@@ -22,17 +22,19 @@
 */
 
 #include "vsx_sample_ogg.h"
+#include <audio/vsx_sample_ogg_stream.h>
 
 class vsx_module_ogg_sample_play : public vsx_module
 {
   // in
   vsx_module_param_resource* filename;
   vsx_module_param_int* format;
+  vsx_module_param_int* timeline_waveform;
 
   // out
 
   // private
-  vsx_sample_ogg main_sample;
+  vsx_sample_ogg_stream main_sample;
 
   vsx_module_engine_float_array full_pcm_data_l;
   vsx_module_engine_float_array full_pcm_data_r;
@@ -46,12 +48,14 @@ public:
 
     info->description =
       "Plays 16-bit signed int PCM\n"
-      "OGG vorbis files; mono or stereo."
+      "OGG vorbis files; mono or stereo.\n"
+      "The file is decoded while playing."
     ;
 
     info->in_param_spec =
       "filename:resource,"
-      "format:enum?mono|stereo"
+      "format:enum?mono|stereo,"
+      "timeline_waveform:enum?no|yes"
     ;
 
     info->out_param_spec =
@@ -72,6 +76,9 @@ public:
 
     format = (vsx_module_param_int*)in_parameters.create(VSX_MODULE_PARAM_ID_INT,"format");
 
+    timeline_waveform = (vsx_module_param_int*)in_parameters.create(VSX_MODULE_PARAM_ID_INT,"timeline_waveform");
+    timeline_waveform->set(0);
+
     loading_done = true;
   }
 
@@ -83,26 +90,40 @@ public:
     return true;
   }
 
+  // the whole file as float arrays for the artiste timeline, 8 bytes per
+  // frame, so only when asked for
+  void load_waveform()
+  {
+    full_pcm_data_l.array.reset_used(0);
+    full_pcm_data_r.array.reset_used(0);
+    req(timeline_waveform->get());
+
+    vsx_sample_ogg_stream_decoder decoder;
+    req(decoder.open(engine_state->filesystem, filename->get()));
+
+    const float one_div_32767 = 1.0 / 32767.0;
+    int16_t buffer[VSX_SAMPLE_STREAM_CHUNK_FRAMES * 2];
+    size_t index = 0;
+    size_t frames;
+    while ( (frames = decoder.decode(buffer, VSX_SAMPLE_STREAM_CHUNK_FRAMES)) )
+      for (size_t i = 0; i < frames; i++)
+      {
+        full_pcm_data_l.array[index] = (float)buffer[i * 2] * one_div_32767;
+        full_pcm_data_r.array[index] = (float)buffer[i * 2 + 1] * one_div_32767;
+        index++;
+      }
+  }
+
   void param_set_notify(const vsx_string<>& name)
   {
     if (name == "filename")
     {
       main_sample.set_filesystem( engine_state->filesystem );
       main_sample.load_filename( filename->get() );
-
-      // store the sample data in float array
-      //full_pcm_data_l.array[index]
-      const float one_div_32767 = 1.0 / 32767.0;
-      vsx_ma_vector<int16_t>* data = main_sample.get_data();
-      size_t index_data = 0;
-      for (size_t i = 0; i < (data->size() >> 1); i++)
-      {
-        full_pcm_data_l.array[i] = (float)(*data)[index_data] * one_div_32767;
-        index_data++;
-        full_pcm_data_r.array[i] = (float)(*data)[index_data] * one_div_32767;
-        index_data++;
-      }
     }
+
+    if (name == "filename" || name == "timeline_waveform")
+      load_waveform();
   }
 
   void on_delete()
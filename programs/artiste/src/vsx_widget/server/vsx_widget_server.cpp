@@ -1141,6 +1141,7 @@ void vsx_widget_server::command_process_back_queue(vsx_command_s *t) {
     else
     if (t->cmd == "macro_create_real") {
       t->cmd = "macro_create";
+      t->cmd_id = vsx_command_id_find(t->cmd);
       t->parts[0] = "macro_create";
       t->raw = vsx_string_helper::str_replace<char>("macro_create_real", "macro_create",t->raw);
       cmd_out->add( t );
@@ -0,0 +1,51 @@
+/**
+* Project: VSXu: Realtime modular visual programming language, music/audio visualizer.
+*
+* This file is part of Vovoid VSXu.
+*
+* @author Jonatan Wallmander, Robert Wenzel, Vovoid Media Technologies AB Copyright (C) 2003-2013
+* @see The GNU Public License (GPL)
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// Heap allocations made by the whole process, counted by the allocation
+// functions main.cpp replaces: malloc and friends on glibc, operator new
+// elsewhere.
+class bench_allocation_counter
+{
+public:
+
+  static std::atomic<uint64_t>& get()
+  {
+    static std::atomic<uint64_t> count(0);
+    return count;
+  }
+
+  static inline void add()
+  {
+    get().fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static inline uint64_t load()
+  {
+    return get().load(std::memory_order_relaxed);
+  }
+};
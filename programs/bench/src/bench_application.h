@@ -0,0 +1,441 @@
+/**
+* Project: VSXu: Realtime modular visual programming language, music/audio visualizer.
+*
+* This file is part of Vovoid VSXu.
+*
+* @author Jonatan Wallmander, Robert Wenzel, Vovoid Media Technologies AB Copyright (C) 2003-2013
+* @see The GNU Public License (GPL)
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#pragma once
+
+#include <math.h>
+#include <algorithm>
+#include <list>
+#include <map>
+#include <vector>
+
+#include <vsx_version.h>
+#include "vsx_application.h"
+#include <vsx_application_control.h>
+#include <vsx_engine_helper.h>
+#include <vsx_module_list_factory.h>
+#include <vsx_module_list_manager.h>
+#include <filesystem/vsx_filesystem_helper.h>
+#include <string/vsx_string_helper.h>
+#include <string/vsx_json_helper.h>
+#include <perf/vsx_perf.h>
+#include <time/vsx_timer.h>
+#include "bench_allocation_counter.h"
+
+/*
+  Loads each state, renders it until loaded, runs warmup frames and then
+  measures a fixed number of frames with constant frame progression and
+  synthetic sound input, so runs on different commits see the same input.
+
+  Results are written as JSON, keys sorted, and optionally compared to the
+  results of an earlier run.
+*/
+class bench_application
+    : public vsx_application
+{
+  enum phase_type
+  {
+    phase_load,
+    phase_warmup,
+    phase_measure
+  };
+
+  class module_time
+  {
+  public:
+    vsx_string<> identifier;
+    double run = 0.0;
+    double output = 0.0;
+  };
+
+  // settings
+  size_t frame_count = 600;
+  size_t warmup_frame_count = 60;
+  size_t max_load_frames = 3000;
+  float frame_step = 1.0f / 60.0f;
+  vsx_string<> output_filename = "vsx_bench.json";
+  vsx_string<> baseline_filename;
+  double regression_threshold = 10.0;
+
+  std::vector< vsx_string<> > states;
+  size_t state_index = 0;
+  bool finished = false;
+
+  // current state
+  vsx_engine_helper* helper = 0x0;
+  phase_type phase = phase_load;
+  size_t phase_frame = 0;
+  size_t total_frame = 0;
+  vsx_timer load_timer;
+  vsx_timer frame_timer;
+  double load_time = 0.0;
+  uint64_t allocations = 0;
+  std::vector<double> frame_times;
+  std::map< vsx_string<>, module_time > module_times;
+  std::vector<vsx_engine_component_timing> timings;
+  bool peak_reset = false;
+  size_t peak_rss_run = 0;
+
+  vsx_module_engine_float_array sound_wave;
+  vsx_module_engine_float_array sound_freq;
+
+  vsx::json::object results;
+  vsx_perf perf;
+
+  void add_states(vsx_string<> path)
+  {
+    if (vsx::filesystem_helper::is_file(path))
+    {
+      states.push_back(path);
+      return;
+    }
+
+    std::list< vsx_string<> > file_list;
+    vsx::filesystem_helper::get_files_recursive(path, &file_list, ".vsx", "");
+    std::vector< vsx_string<> > found;
+    for (auto it = file_list.begin(); it != file_list.end(); ++it)
+      if (vsx_string_helper::verify_filesuffix(*it, "vsx"))
+        found.push_back(*it);
+
+    std::sort(found.begin(), found.end());
+    states.insert(states.end(), found.begin(), found.end());
+  }
+
+  // same input every run: a moving sine wave and a falling spectrum
+  void update_sound()
+  {
+    float t = (float)total_frame * frame_step;
+    for (size_t i = 0; i < 513; i++)
+    {
+      sound_wave.array[i] = 0.5f * sinf((float)i * 0.05f + t * 20.0f);
+      sound_freq.array[i] = (0.6f + 0.4f * sinf(t * 3.0f + (float)i * 0.02f)) / (1.0f + (float)i * 0.05f);
+    }
+    total_frame++;
+  }
+
+  static double percentile(std::vector<double>& sorted, double p)
+  {
+    if (!sorted.size())
+      return 0.0;
+    size_t rank = (size_t)ceil(p / 100.0 * (double)sorted.size());
+    if (rank < 1)
+      rank = 1;
+    return sorted[rank - 1];
+  }
+
+  void begin_state()
+  {
+    vsx_printf(L"vsx_bench: %hs\n", states[state_index].c_str());
+    // the peak resident set size only grows, so unless it can be reset
+    // it is reported for the whole run only
+    peak_reset = perf.memory_peak_reset();
+    load_timer.start();
+    helper = new vsx_engine_helper(states[state_index], vsx_module_list_manager::get()->module_list);
+    helper->engine->set_constant_frame_progression(frame_step);
+    helper->engine->set_float_array_param(0, &sound_wave);
+    helper->engine->set_float_array_param(1, &sound_freq);
+
+    phase = phase_load;
+    phase_frame = 0;
+    total_frame = 0;
+    allocations = 0;
+    frame_times.clear();
+    module_times.clear();
+  }
+
+  void end_state(vsx_string<> error)
+  {
+    vsx::json::object result;
+
+    if (error.size())
+      result["error"] = error.c_str();
+    else
+    {
+      std::vector<double> sorted = frame_times;
+      std::sort(sorted.begin(), sorted.end());
+      double sum = 0.0;
+      foreach (sorted, i)
+        sum += sorted[i];
+
+      result["frame_time_ms"] = vsx::json::object{
+        {"mean", sum / (double)sorted.size() * 1000.0},
+        {"p50", percentile(sorted, 50.0) * 1000.0},
+        {"p90", percentile(sorted, 90.0) * 1000.0},
+        {"p99", percentile(sorted, 99.0) * 1000.0},
+        {"max", sorted.back() * 1000.0}
+      };
+      result["allocations_per_frame"] = (double)allocations / (double)frame_times.size();
+      result["load_time_s"] = load_time;
+
+      vsx::json::object modules;
+      for (auto it = module_times.begin(); it != module_times.end(); ++it)
+        modules[it->first.c_str()] = vsx::json::object{
+          {"module", it->second.identifier.c_str()},
+          {"run_ms", it->second.run / (double)frame_times.size() * 1000.0},
+          {"output_ms", it->second.output / (double)frame_times.size() * 1000.0}
+        };
+      result["modules"] = modules;
+    }
+    size_t peak_rss = perf.memory_peak_used_bytes();
+    peak_rss_run = std::max(peak_rss_run, peak_rss);
+    if (peak_reset)
+      result["peak_rss_bytes"] = (double)peak_rss;
+
+    results[states[state_index].c_str()] = result;
+
+    delete helper;
+    helper = 0x0;
+    state_index++;
+  }
+
+  void render_frame()
+  {
+    update_sound();
+
+    if (phase != phase_measure)
+    {
+      helper->render();
+      return;
+    }
+
+    uint64_t allocations_before = bench_allocation_counter::load();
+    frame_timer.start();
+    helper->render();
+    // the frame isn't done until the GPU is
+    glFinish();
+    frame_times.push_back(frame_timer.dtime());
+    allocations += bench_allocation_counter::load() - allocations_before;
+
+    helper->engine->get_component_timing(timings);
+    foreach (timings, i)
+    {
+      module_time& time = module_times[timings[i].name];
+      time.identifier = timings[i].identifier;
+      time.run += timings[i].time_run;
+      time.output += timings[i].time_output;
+    }
+  }
+
+  void step()
+  {
+    if (!helper)
+      begin_state();
+
+    render_frame();
+    phase_frame++;
+
+    switch (phase)
+    {
+      case phase_load:
+        if (helper->engine->get_engine_state() != VSX_ENGINE_LOADING)
+        {
+          load_time = load_timer.dtime();
+          phase = phase_warmup;
+          phase_frame = 0;
+        }
+        else
+        if (phase_frame > max_load_frames)
+          end_state("state did not finish loading");
+        break;
+
+      case phase_warmup:
+        if (phase_frame >= warmup_frame_count)
+        {
+          phase = phase_measure;
+          phase_frame = 0;
+        }
+        break;
+
+      case phase_measure:
+        if (phase_frame >= frame_count)
+          end_state("");
+        break;
+    }
+  }
+
+  bool compare_value(vsx_string<> label, double before, double after)
+  {
+    if (before <= 0.0)
+      return false;
+
+    double change = (after - before) / before * 100.0;
+    if (change <= regression_threshold)
+      return false;
+
+    vsx_printf(L"vsx_bench: REGRESSION %hs: %.3f -> %.3f ms (+%.1f%%)\n", label.c_str(), before, after, change);
+    return true;
+  }
+
+  // only modules taking at least this much per frame are compared, below it
+  // timer noise dominates
+  const double module_noise_floor_ms = 0.01;
+
+  size_t compare(vsx::json& current, vsx::json& baseline)
+  {
+    size_t regressions = 0;
+    const vsx::json::object& current_states = current["states"].object_items();
+    for (auto it = current_states.begin(); it != current_states.end(); ++it)
+    {
+      const vsx::json& before = baseline["states"][it->first];
+      const vsx::json& after = it->second;
+      if (before.is_null() || !after["error"].is_null() || !before["error"].is_null())
+        continue;
+
+      vsx_string<> state = it->first.c_str();
+      regressions += compare_value(state + " p50", before["frame_time_ms"]["p50"].number_value(), after["frame_time_ms"]["p50"].number_value());
+      regressions += compare_value(state + " p99", before["frame_time_ms"]["p99"].number_value(), after["frame_time_ms"]["p99"].number_value());
+
+      const vsx::json::object& modules = after["modules"].object_items();
+      for (auto m = modules.begin(); m != modules.end(); ++m)
+      {
+        const vsx::json& module_before = before["modules"][m->first];
+        if (module_before.is_null())
+          continue;
+
+        double time_before = module_before["run_ms"].number_value() + module_before["output_ms"].number_value();
+        double time_after = m->second["run_ms"].number_value() + m->second["output_ms"].number_value();
+        if (time_before < module_noise_floor_ms)
+          continue;
+
+        regressions += compare_value(state + " " + m->first.c_str() + " (" + m->second["module"].string_value().c_str() + ")", time_before, time_after);
+      }
+    }
+    return regressions;
+  }
+
+  void finish()
+  {
+    finished = true;
+    peak_rss_run = std::max(peak_rss_run, perf.memory_peak_used_bytes());
+
+    vsx::json report = vsx::json::object{
+      {"version", VSXU_VER},
+      {"frames", (int)frame_count},
+      {"warmup_frames", (int)warmup_frame_count},
+      {"frame_step_s", frame_step},
+      {"peak_rss_bytes", (double)peak_rss_run},
+      {"states", results}
+    };
+
+    vsx::json_helper::save_json_to_file(output_filename, report);
+    vsx_printf(L"vsx_bench: wrote %hs\n", output_filename.c_str());
+
+    if (baseline_filename.size())
+    {
+      vsx::json baseline = vsx::json_helper::load_json_from_file(baseline_filename, vsx::filesystem::get_instance());
+      size_t regressions = compare(report, baseline);
+      vsx_printf(L"vsx_bench: %d regressions against %hs\n", (int)regressions, baseline_filename.c_str());
+      if (regressions)
+        exit_code = 1;
+    }
+
+    vsx_application_control::get_instance()->shutdown_request();
+  }
+
+public:
+
+  int exit_code = 0;
+
+  bench_application()
+  {
+    window_title = "VSXu Bench";
+    sound_wave.array.allocate(512);
+    sound_freq.array.allocate(512);
+  }
+
+  void print_help()
+  {
+    vsx_application::print_help();
+    vsx_printf(
+      L"    -i [file|dir],...         States or directories to run, default\n"
+       "                              example-visuals and visuals_player\n"
+       "    -n [frames]               Frames to measure per state (600)\n"
+       "    -w [frames]               Warmup frames per state (60)\n"
+       "    -o [file]                 Output JSON (vsx_bench.json)\n"
+       "    -b [file]                 Baseline JSON to compare against\n"
+       "    -t [percent]              Regression threshold (10)\n"
+    );
+  }
+
+  void init_graphics()
+  {
+    vsx_argvector* args = vsx_argvector::get_instance();
+
+    if (args->has_param_with_value("n"))
+      frame_count = (size_t)vsx_string_helper::s2i(args->get_param_value("n"));
+    if (frame_count < 1)
+      frame_count = 1;
+
+    if (args->has_param_with_value("w"))
+      warmup_frame_count = (size_t)vsx_string_helper::s2i(args->get_param_value("w"));
+
+    if (args->has_param_with_value("o"))
+      output_filename = args->get_param_value("o");
+
+    if (args->has_param_with_value("b"))
+      baseline_filename = args->get_param_value("b");
+
+    if (args->has_param_with_value("t"))
+      regression_threshold = vsx_string_helper::s2f(args->get_param_value("t"));
+
+    if (args->has_param_with_value("i"))
+    {
+      vsx_nw_vector< vsx_string<> > parts;
+      vsx_string<> deli = ",";
+      vsx_string_helper::explode(args->get_param_value("i"), deli, parts);
+      foreach (parts, i)
+        add_states(parts[i]);
+    }
+    else
+    {
+      add_states(PLATFORM_SHARED_FILES + "example-visuals");
+      add_states(PLATFORM_SHARED_FILES + "visuals_player");
+    }
+
+    vsx_printf(L"vsx_bench: %d states, %d frames each\n", (int)states.size(), (int)frame_count);
+
+    vsx_module_list_manager::get()->module_list = vsx_module_list_factory_create();
+  }
+
+  void draw()
+  {
+    req(!finished);
+
+    if (state_index == states.size())
+    {
+      finish();
+      return;
+    }
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    step();
+  }
+
+  void uninit_graphics()
+  {
+    if (helper)
+      delete helper;
+    helper = 0x0;
+    vsx_module_list_factory_destroy(vsx_module_list_manager::get()->module_list);
+  }
+};
@@ -0,0 +1,108 @@
+/**
+* Project: VSXu: Realtime modular visual programming language, music/audio visualizer.
+*
+* This file is part of Vovoid VSXu.
+*
+* @author Jonatan Wallmander, Robert Wenzel, Vovoid Media Technologies AB Copyright (C) 2003-2013
+* @see The GNU Public License (GPL)
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include <vsx_version.h>
+#include <vsx_platform.h>
+
+#include <stdlib.h>
+#include <new>
+
+#include "bench_application.h"
+
+#include <vsx_application_manager.h>
+#include <vsx_application_run.h>
+#include <math/vsx_rand_singleton.h>
+#include <vsx_data_path.h>
+
+// count every heap allocation in the process, including the engine and plugins
+#if defined(__GLIBC__)
+
+extern "C"
+{
+  void* __libc_malloc(size_t size);
+  void* __libc_calloc(size_t count, size_t size);
+  void* __libc_realloc(void* pointer, size_t size);
+
+  void* malloc(size_t size) noexcept
+  {
+    bench_allocation_counter::add();
+    return __libc_malloc(size);
+  }
+
+  void* calloc(size_t count, size_t size) noexcept
+  {
+    bench_allocation_counter::add();
+    return __libc_calloc(count, size);
+  }
+
+  void* realloc(void* pointer, size_t size) noexcept
+  {
+    bench_allocation_counter::add();
+    return __libc_realloc(pointer, size);
+  }
+}
+
+#else
+
+void* operator new(size_t size)
+{
+  bench_allocation_counter::add();
+  void* pointer = malloc(size ? size : 1);
+  if (!pointer)
+    throw std::bad_alloc();
+  return pointer;
+}
+
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+  free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+  free(pointer);
+}
+
+#endif
+
+int main(int argc, char* argv[])
+{
+  vsx_argvector::get_instance()->init_from_argc_argv(argc, argv);
+
+  // no visible window, no vsync
+  if (!vsx_argvector::get_instance()->has_param("hidden"))
+    vsx_argvector::get_instance()->push_back("-hidden");
+
+  // same random sequence every run
+  vsx_rand_singleton::get()->rand.srand( 0 );
+  vsx_data_path::get_instance()->init();
+  bench_application application;
+  vsx_application_manager::get_instance()->application_set(&application);
+  vsx_application_run::run();
+  return application.exit_code;
+}
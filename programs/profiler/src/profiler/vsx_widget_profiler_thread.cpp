@@ -31,7 +31,7 @@ void vsx_widget_profiler_thread::init()
 void vsx_widget_profiler_thread::load_thread(uint64_t id)
 {
   vsx_printf(L"load profile thread %ld\n", id);
-  vsx_profiler_consumer::get_instance()->get_thread(0.0, 5.0, id, consumer_chunks);
+  vsx_profiler_consumer::get_instance()->get_thread(0.0, vsx_profiler_consumer::get_instance()->get_max_time(), id, consumer_chunks);
   update();
 }
 
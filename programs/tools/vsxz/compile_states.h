@@ -0,0 +1,35 @@
+#pragma once
+
+#include <container/vsx_nw_vector.h>
+#include <string/vsx_string.h>
+#include <vsx_argvector.h>
+#include <command/vsx_command_state_binary.h>
+#include <filesystem/vsx_filesystem_helper.h>
+#include <filesystem/archive/vsx_filesystem_archive_writer_base.h>
+
+// adds a compiled copy of each state given with -cs, as [state filename].vsxb
+void compile_states(vsx::filesystem_archive_writer_base& archive)
+{
+  req(vsx_argvector::get_instance()->has_param_with_value("cs"));
+
+  vsx_nw_vector< vsx_string<> > state_filenames;
+  vsx_string<> deli = ":";
+  vsx_string_helper::explode(vsx_argvector::get_instance()->get_param_value("cs"), deli, state_filenames);
+
+  foreach (state_filenames, i)
+  {
+    req_continue(state_filenames[i].size());
+
+    if (access(state_filenames[i].c_str(), R_OK))
+      VSX_ERROR_EXIT( ( vsx_string<>("Error accessing state file: ") + state_filenames[i]).c_str()  ,1);
+
+    vsx_ma_vector<unsigned char> text = vsx::filesystem_helper::read(state_filenames[i]);
+
+    vsx_command_state_binary_writer writer;
+    writer.add_state( vsx_string<>((char*)text.get_pointer(), text.size()) );
+    vsx_ma_vector<unsigned char> compiled = writer.get_data();
+
+    vsx_printf(L"* adding compiled state: %hs.vsxb (%d bytes, text %d bytes)\n", state_filenames[i].c_str(), (int)compiled.size(), (int)text.size() );
+    archive.add_string( state_filenames[i] + ".vsxb", vsx_string<>((char*)compiled.get_pointer(), compiled.size()), true);
+  }
+}
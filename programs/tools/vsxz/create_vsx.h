@@ -1,6 +1,7 @@
 #include <filesystem/archive/vsx/vsx_filesystem_archive_vsx_writer.h>
 
 #include "filenames.h"
+#include "compile_states.h"
 
 void create_vsx()
 {
@@ -20,6 +21,8 @@ void create_vsx()
     archive.add_file( filenames[i], "", true);
   }
 
+  compile_states(archive);
+
   archive.close();
 
   vsx_printf(L"-- successfully created the archive: %hs\n", archive_filename.c_str());
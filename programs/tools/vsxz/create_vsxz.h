@@ -1,6 +1,7 @@
 #include <filesystem/archive/vsxz/vsx_filesystem_archive_vsxz_writer.h>
 
 #include "filenames.h"
+#include "compile_states.h"
 
 void create_vsxz()
 {
@@ -31,8 +32,14 @@ void create_vsxz()
     archive.add_file( filenames[i], "", true);
   }
 
+  compile_states(archive);
+
   archive.close();
 
+  vsx_nw_vector< vsx_string<> > statistics;
+  archive.get_statistics(statistics);
+  foreach (statistics, i)
+    vsx_printf(L"  %hs\n", statistics[i].c_str());
 
   vsx_printf(L"-- successfully created the archive: %hs\n", archive_filename.c_str());
 
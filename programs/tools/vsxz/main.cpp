@@ -83,6 +83,8 @@ int main(int argc, char* argv[])
     "       -z pack archive as vsxz                  (optional)\n"
     "       -nc when creating vsxz, don't compress   (optional)\n"
     "       -nrc no ratio calculation                (optional)\n"
+    "       -cs state1:state2 also add the states    (optional)\n"
+    "           compiled, for faster loading\n"
     "\n"
     "Information:\n"
     "  vsxz -info [archive filename]                 show meta data about archive\n"